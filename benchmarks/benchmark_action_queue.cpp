@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/dispatch/action_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <poll.h>
+
+namespace md = mir::dispatch;
+
+namespace
+{
+bool wait_until_readable(int fd)
+{
+    struct pollfd poller {
+        fd,
+        POLLIN,
+        0
+    };
+    return poll(&poller, 1, 10) > 0;
+}
+}
+
+// Producers enqueue small actions as fast as they can while a single
+// consumer dispatches the queue, as a client's RPC channel does
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of producer threads> <actions per producer>"<<std::endl;
+        exit(1);
+    }
+
+    int const producer_count = std::atoi(argv[1]);
+    uint64_t const actions_per_producer = std::atoll(argv[2]);
+    uint64_t const action_count = producer_count * actions_per_producer;
+
+    md::ActionQueue queue;
+    uint64_t executed{0};
+    uint64_t wakeups{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < producer_count; ++i)
+    {
+        producers.emplace_back([&queue, &executed, actions_per_producer]
+        {
+            for (uint64_t j = 0; j < actions_per_producer; ++j)
+            {
+                queue.enqueue([&executed] { ++executed; });
+            }
+        });
+    }
+
+    while (executed < action_count)
+    {
+        if (wait_until_readable(queue.watch_fd()))
+        {
+            ++wakeups;
+            queue.dispatch(md::FdEvent::readable);
+        }
+    }
+
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    std::cout<<"Running "<<action_count<<" actions from "<<producer_count<<" threads took "
+             <<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns ("
+             <<double(wakeups) / action_count<<" wakeups per action)"<<std::endl;
+    exit(0);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Renders desktops of many small surfaces (windows with separate title
+ * bars, and tooltips) to an offscreen output, drawing renderable by
+ * renderable and then with --batch-gl-draws, and compares the draw calls
+ * and time per frame.
+ *
+ * Run it wherever EGL can make surfaceless or pbuffer contexts, e.g. with
+ * EGL_PLATFORM=surfaceless on Mesa.
+ */
+
+#include "src/server/graphics/offscreen/display_buffer.h"
+#include "src/renderers/gl/renderer.h"
+
+#include "mir/graphics/buffer_basic.h"
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/surfaceless_egl_context.h"
+#include "mir/renderer/gl/texture_source.h"
+
+#include MIR_SERVER_GL_H
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mgo = mir::graphics::offscreen;
+namespace mrg = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const output{{0, 0}, {1920, 1080}};
+
+class PixelBuffer : public mg::BufferBasic,
+                    public mg::NativeBufferBase,
+                    public mir::renderer::gl::TextureSource
+{
+public:
+    PixelBuffer(geom::Size const& size, uint32_t colour)
+        : size_{size},
+          pixels(size.width.as_int() * size.height.as_int(), colour)
+    {
+    }
+
+    std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override { return {}; }
+    geom::Size size() const override { return size_; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_abgr_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return this; }
+
+    void gl_bind_to_texture() override { bind(); }
+    void bind() override
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size_.width.as_int(), size_.height.as_int(),
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+    void secure_for_render() override {}
+
+private:
+    geom::Size const size_;
+    std::vector<uint32_t> const pixels;
+};
+
+// A surface that redraws all of itself every frame
+class Surface : public mg::Renderable
+{
+public:
+    Surface(geom::Rectangle const& position, float alpha, bool shaped, uint32_t colour)
+        : position{position},
+          alpha_{alpha},
+          shaped_{shaped},
+          buffer_{std::make_shared<PixelBuffer>(position.size, colour)}
+    {
+    }
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return buffer_; }
+    geom::Rectangle screen_position() const override { return position; }
+    geom::Rectangles damage() const override { return {{{0, 0}, position.size}}; }
+    float alpha() const override { return alpha_; }
+    glm::mat4 transformation() const override { return glm::mat4(1); }
+    bool shaped() const override { return shaped_; }
+    geom::Region opaque_region() const override { return {}; }
+    unsigned int swap_interval() const override { return 1; }
+
+private:
+    geom::Rectangle const position;
+    float const alpha_;
+    bool const shaped_;
+    std::shared_ptr<PixelBuffer> const buffer_;
+};
+
+// Windows of a title bar and an opaque body, cascading down the output, with
+// a translucent tooltip over every third one
+mg::RenderableList desktop_of(int renderables)
+{
+    mg::RenderableList desktop;
+    desktop.push_back(std::make_shared<Surface>(output, 1.0f, false, 0xff303030));
+
+    for (int window = 0; static_cast<int>(desktop.size()) < renderables; ++window)
+    {
+        geom::Point const top_left{
+            (window * 97) % (output.size.width.as_int() - 320),
+            (window * 61) % (output.size.height.as_int() - 240)};
+
+        desktop.push_back(std::make_shared<Surface>(
+            geom::Rectangle{top_left, {320, 30}}, 1.0f, true, 0xc0402010));
+        desktop.push_back(std::make_shared<Surface>(
+            geom::Rectangle{top_left + geom::Displacement{0, 30}, {320, 200}}, 1.0f, false, 0xffe0e0e0));
+
+        if (window % 3 == 0)
+        {
+            desktop.push_back(std::make_shared<Surface>(
+                geom::Rectangle{top_left + geom::Displacement{40, 60}, {160, 24}}, 0.9f, false, 0xff80ffff));
+        }
+    }
+
+    desktop.resize(renderables);
+    return desktop;
+}
+
+struct Result
+{
+    unsigned draw_calls;
+    double milliseconds_per_frame;
+};
+
+Result render(mgo::DisplayBuffer& display_buffer, mg::RenderableList const& desktop, int frames, bool batched)
+{
+    mrg::Renderer renderer{display_buffer, batched};
+    renderer.set_viewport(output);
+
+    renderer.render(desktop);  // Warm up: upload textures and tessellate
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i != frames; ++i)
+        renderer.render(desktop);
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    return {renderer.draw_calls(), std::chrono::duration<double, std::milli>(duration).count() / frames};
+}
+}
+
+int main(int argc, char const* argv[])
+{
+    int const frames = argc > 1 ? std::atoi(argv[1]) : 100;
+
+    EGLDisplay const egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, nullptr, nullptr))
+    {
+        std::cerr << "Failed to initialise EGL" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    {
+        eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
+        mg::SurfacelessEGLContext const shared_context{egl_display, EGL_NO_CONTEXT};
+        shared_context.make_current();
+
+        eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
+        mgo::DisplayBuffer display_buffer{mg::SurfacelessEGLContext{egl_display, shared_context}, output};
+
+        for (int const renderables : {10, 100, 500})
+        {
+            auto const desktop = desktop_of(renderables);
+            auto const immediate = render(display_buffer, desktop, frames, false);
+            auto const batched = render(display_buffer, desktop, frames, true);
+
+            std::cout << renderables << " renderables: "
+                      << immediate.draw_calls << " draw calls and "
+                      << immediate.milliseconds_per_frame << "ms per frame unbatched, "
+                      << batched.draw_calls << " draw calls and "
+                      << batched.milliseconds_per_frame << "ms per frame batched" << std::endl;
+        }
+    }
+
+    eglTerminate(egl_display);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_builders.h"
+#include "mir/events/event_private.h"
+#include "mir/geometry/displacement.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+// Counts every heap allocation, including the segments capnproto allocates
+// with calloc(), by interposing on glibc's allocator
+namespace
+{
+std::atomic<unsigned long> allocations{0};
+}
+
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+namespace
+{
+struct Stage
+{
+    char const* const name;
+    unsigned long allocations;
+    std::chrono::steady_clock::duration time;
+};
+
+template<typename Action>
+void measure(Stage& stage, Action const& action)
+{
+    auto const allocations_before = allocations.load();
+    auto const start = std::chrono::steady_clock::now();
+    action();
+    stage.time += std::chrono::steady_clock::now() - start;
+    stage.allocations += allocations.load() - allocations_before;
+}
+}
+
+// Follows each pointer motion through the stages of the server's input
+// pipeline that copy or convert events
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <event count>"<<std::endl;
+        exit(1);
+    }
+
+    int const event_count = std::atoi(argv[1]);
+
+    Stage made{"made by the device", 0, {}};
+    Stage shared{"shared with dispatchers", 0, {}};
+    Stage cloned{"cloned for the surface", 0, {}};
+    Stage serialized{"serialized for the client", 0, {}};
+    Stage dropped{"dropped", 0, {}};
+
+    for (int i = 0; i != event_count; ++i)
+    {
+        mir::EventUPtr event{nullptr, nullptr};
+        std::shared_ptr<MirEvent> dispatched;
+        mir::EventUPtr delivered{nullptr, nullptr};
+        std::string bytes;
+
+        measure(made, [&]
+            {
+                event = mev::make_event(
+                    MirInputDeviceId{1}, std::chrono::nanoseconds{i}, std::vector<uint8_t>{},
+                    mir_input_event_modifier_none, mir_pointer_action_motion, 0,
+                    float(i % 1920), float(i % 1080), 0.0f, 0.0f, 1.0f, 1.0f);
+            });
+        measure(shared, [&] { dispatched = std::move(event); });
+        measure(cloned, [&]
+            {
+                delivered = mev::clone_event(*dispatched);
+                mev::transform_positions(*delivered, geom::Displacement{100, 100});
+            });
+        measure(serialized, [&] { bytes = MirEvent::serialize(delivered.get()); });
+        measure(dropped, [&]
+            {
+                delivered.reset();
+                dispatched.reset();
+                std::string{}.swap(bytes);
+            });
+    }
+
+    std::cout<<"Per pointer event, over "<<event_count<<" events:"<<std::endl;
+    for (auto const& stage : {made, shared, cloned, serialized, dropped})
+    {
+        std::cout<<"  "<<stage.name<<": "
+                 <<double(stage.allocations) / event_count<<" allocations, "
+                 <<std::chrono::duration<double, std::nano>(stage.time).count() / event_count<<"ns"
+                 <<std::endl;
+    }
+}
@@ -18,6 +18,7 @@
 
 #include "mir/dispatch/multiplexing_dispatchable.h"
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -28,6 +29,8 @@
 
 namespace md = mir::dispatch;
 
+namespace
+{
 class TestDispatchable : public md::Dispatchable
 {
 public:
@@ -56,8 +59,7 @@ public:
     }
     bool dispatch(md::FdEvents) override
     {
-        ++dispatch_count;
-        return (dispatch_count < dispatch_limit);
+        return (++dispatch_count < dispatch_limit);
     }
     md::FdEvents relevant_events() const override
     {
@@ -65,13 +67,11 @@ public:
     }
 
 private:
-    static thread_local uint64_t dispatch_count;
+    std::atomic<uint64_t> dispatch_count{0};
     uint64_t const dispatch_limit;
     mir::Fd read_fd, write_fd;
 };
 
-thread_local uint64_t TestDispatchable::dispatch_count = 0;
-
 bool fd_is_readable(int fd)
 {
     struct pollfd poller {
@@ -82,29 +82,28 @@ bool fd_is_readable(int fd)
     return poll(&poller, 1, 0);
 }
 
-int main(int argc, char** argv)
+// Dispatches until every dispatchable has been dispatched its share of the events
+void run(int thread_count, uint64_t dispatch_count, int dispatchable_count, unsigned events_per_dispatch)
 {
-    if (argc != 3)
+    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>(events_per_dispatch);
+    for (int i = 0; i < dispatchable_count; ++i)
     {
-        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
-        exit(1);
+        dispatcher->add_watch(
+            std::make_shared<TestDispatchable>(dispatch_count / dispatchable_count),
+            md::DispatchReentrancy::reentrant);
     }
 
-    int const thread_count = std::atoi(argv[1]);
-    uint64_t const dispatch_count = std::atoll(argv[2]);
-
-    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-    dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatch_count / thread_count), md::DispatchReentrancy::reentrant);
-
+    std::atomic<uint64_t> wakeups{0};
     auto start = std::chrono::steady_clock::now();
 
     std::vector<std::thread> thread_loops;
     for (int i = 0; i < thread_count; ++i)
     {
-        thread_loops.emplace_back([](md::Dispatchable& dispatch)
+        thread_loops.emplace_back([&wakeups](md::Dispatchable& dispatch)
         {
             while(fd_is_readable(dispatch.watch_fd()))
             {
+                ++wakeups;
                 dispatch.dispatch(md::FdEvent::readable);
             }
         }, std::ref(*dispatcher));
@@ -116,6 +115,27 @@ int main(int argc, char** argv)
     }
 
     auto duration = std::chrono::steady_clock::now() - start;
-    std::cout<<"Dispatching "<<dispatch_count<<" times took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns"<<std::endl;
+    std::cout<<"Dispatching "<<dispatch_count<<" times, up to "<<events_per_dispatch<<" per wakeup, took "
+             <<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns ("
+             <<double(wakeups) / dispatch_count<<" wakeups per event)"<<std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count> [<number of dispatchables>]"<<std::endl;
+        exit(1);
+    }
+
+    int const thread_count = std::atoi(argv[1]);
+    uint64_t const dispatch_count = std::atoll(argv[2]);
+    int const dispatchable_count = argc == 4 ? std::atoi(argv[3]) : 1;
+
+    for (unsigned const events_per_dispatch : {1u, 8u, md::MultiplexingDispatchable::max_events_per_dispatch_limit})
+    {
+        run(thread_count, dispatch_count, dispatchable_count, events_per_dispatch);
+    }
     exit(0);
 }
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/rectangle.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/graphics/renderable.h"
+#include "occlusion.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const screen{{0, 0}, {1920, 1080}};
+
+class Window : public mg::Renderable
+{
+public:
+    Window(geom::Rectangle const& position, bool shaped)
+        : position{position},
+          shaped_{shaped},
+          opaque{geom::Rectangle{
+              position.top_left + geom::Displacement{8, 8},
+              {position.size.width.as_int() - 16, position.size.height.as_int() - 16}}}
+    {
+    }
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return {}; }
+    geom::Rectangle screen_position() const override { return position; }
+    geom::Rectangles damage() const override { return {}; }
+    float alpha() const override { return 1.0f; }
+    glm::mat4 transformation() const override { return glm::mat4(1); }
+    bool shaped() const override { return shaped_; }
+    geom::Region opaque_region() const override { return opaque; }
+    unsigned int swap_interval() const override { return 1; }
+
+private:
+    geom::Rectangle const position;
+    bool const shaped_;
+    geom::Region const opaque;  // as for a client-side decorated window with a drop shadow
+};
+
+class Element : public mc::SceneElement
+{
+public:
+    Element(std::shared_ptr<mg::Renderable> const& renderable) : renderable_{renderable} {}
+
+    std::shared_ptr<mg::Renderable> renderable() const override { return renderable_; }
+    void rendered() override {}
+    void occluded() override {}
+
+private:
+    std::shared_ptr<mg::Renderable> const renderable_;
+};
+
+// Side by side tiles, several workspaces' worth stacked on top of each other
+mc::SceneElementSequence tiled_scene(int windows)
+{
+    int const per_row = 4;
+    int const per_screen = per_row * 2;
+    geom::Size const tile{screen.size.width.as_int() / per_row, screen.size.height.as_int() / 2};
+
+    mc::SceneElementSequence scene;
+    for (int i = 0; i != windows; ++i)
+    {
+        int const slot = i % per_screen;
+        geom::Point const top_left{(slot % per_row) * tile.width.as_int(), (slot / per_row) * tile.height.as_int()};
+        scene.push_back(std::make_shared<Element>(std::make_shared<Window>(geom::Rectangle{top_left, tile}, false)));
+    }
+    return scene;
+}
+
+// Overlapping windows of assorted sizes, some with translucent shadows around an opaque region
+mc::SceneElementSequence random_scene(int windows)
+{
+    std::mt19937 random{static_cast<std::mt19937::result_type>(windows)};
+    std::uniform_int_distribution<int> width{200, 1200};
+    std::uniform_int_distribution<int> height{150, 800};
+    std::uniform_int_distribution<int> coin{0, 1};
+
+    mc::SceneElementSequence scene;
+    for (int i = 0; i != windows; ++i)
+    {
+        geom::Size const size{width(random), height(random)};
+        std::uniform_int_distribution<int> x{-100, screen.size.width.as_int() - size.width.as_int() + 100};
+        std::uniform_int_distribution<int> y{-100, screen.size.height.as_int() - size.height.as_int() + 100};
+        geom::Rectangle const position{{x(random), y(random)}, size};
+        scene.push_back(std::make_shared<Element>(std::make_shared<Window>(position, coin(random))));
+    }
+    return scene;
+}
+
+void run(char const* name, mc::SceneElementSequence (*make_scene)(int))
+{
+    for (int const windows : {10, 25, 50, 100, 250, 500})
+    {
+        auto const scene = make_scene(windows);
+        int const iterations = 200000 / windows;
+        size_t culled = 0;
+
+        auto const start = std::chrono::steady_clock::now();
+        for (int i = 0; i != iterations; ++i)
+        {
+            auto elements = scene;
+            culled = mc::filter_occlusions_from(elements, screen).size();
+        }
+        auto const duration = std::chrono::steady_clock::now() - start;
+        auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / iterations;
+
+        std::cout << name << ": " << windows << " windows, " << culled << " culled, "
+                  << ns / 1000.0 << "us per frame" << std::endl;
+    }
+}
+}
+
+int main()
+{
+    run("tiled", tiled_scene);
+    run("random", random_scene);
+}
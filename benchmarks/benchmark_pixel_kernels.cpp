@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Times each pixel kernel with every instruction set this machine has, on
+ * screen sized images (as snapshots and screencasts convert) and cursor
+ * sized ones (as the KMS cursor rotates).
+ */
+
+#include "mir/graphics/pixel_kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace mgp = mir::graphics::pixel;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Size const screen{1920, 1080};
+geom::Size const cursor{64, 64};
+
+char const* name_of(mgp::InstructionSet isa)
+{
+    switch (isa)
+    {
+    case mgp::InstructionSet::scalar: return "scalar";
+    case mgp::InstructionSet::sse2: return "sse2";
+    case mgp::InstructionSet::avx2: return "avx2";
+    case mgp::InstructionSet::neon: return "neon";
+    }
+    return "?";
+}
+
+size_t pixels_in(geom::Size const& size)
+{
+    return size.width.as_uint32_t() * size.height.as_uint32_t();
+}
+
+geom::Stride stride_of(geom::Size const& size)
+{
+    return geom::Stride{size.width.as_uint32_t() * 4};
+}
+
+void time(char const* name, geom::Size const& size, std::function<void()> const& kernel)
+{
+    // About the same number of pixels for every image size
+    int const iterations = std::max<size_t>(20, 200000000 / pixels_in(size));
+
+    kernel();
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i != iterations; ++i)
+        kernel();
+    auto const duration = std::chrono::steady_clock::now() - start;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / double(iterations);
+
+    std::cout << "  " << std::left << std::setw(28) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << ns / 1000.0 << "us  "
+              << std::setw(8) << pixels_in(size) * 1000.0 / ns << " Mpixel/s" << std::endl;
+}
+
+void run(mgp::InstructionSet isa)
+{
+    mgp::use_instruction_set(isa);
+    std::cout << name_of(isa) << ":" << std::endl;
+
+    std::vector<uint32_t> src(pixels_in(screen), 0x80402010);
+    std::vector<uint32_t> dst(pixels_in(screen));
+    std::vector<uint16_t> rgb565(pixels_in(screen), 0x8410);
+    auto const count = pixels_in(screen);
+
+    time("argb -> abgr 1920x1080", screen,
+        [&] { mgp::convert_row(mir_pixel_format_argb_8888, src.data(), mir_pixel_format_abgr_8888, dst.data(), count); });
+    time("xrgb -> argb 1920x1080", screen,
+        [&] { mgp::convert_row(mir_pixel_format_xrgb_8888, src.data(), mir_pixel_format_argb_8888, dst.data(), count); });
+    time("rgb565 -> argb 1920x1080", screen,
+        [&] { mgp::convert_row(mir_pixel_format_rgb_565, rgb565.data(), mir_pixel_format_argb_8888, dst.data(), count); });
+    time("flip abgr -> argb 1920x1080", screen,
+        [&] { mgp::flip_vertically(dst.data(), screen, stride_of(screen), mir_pixel_format_abgr_8888, mir_pixel_format_argb_8888); });
+
+    for (auto const& image : {screen, cursor})
+    {
+        geom::Stride const sideways_stride{image.height.as_uint32_t() * 4};
+        std::string const dimensions =
+            std::to_string(image.width.as_int()) + "x" + std::to_string(image.height.as_int());
+
+        time(("rotate left " + dimensions).c_str(), image,
+            [&] { mgp::rotate(src.data(), stride_of(image), image, dst.data(), sideways_stride, mir_orientation_left); });
+        time(("rotate right " + dimensions).c_str(), image,
+            [&] { mgp::rotate(src.data(), stride_of(image), image, dst.data(), sideways_stride, mir_orientation_right); });
+        time(("rotate inverted " + dimensions).c_str(), image,
+            [&] { mgp::rotate(src.data(), stride_of(image), image, dst.data(), stride_of(image), mir_orientation_inverted); });
+    }
+}
+}
+
+int main()
+{
+    for (auto const isa :
+         {mgp::InstructionSet::scalar, mgp::InstructionSet::sse2, mgp::InstructionSet::avx2, mgp::InstructionSet::neon})
+    {
+        if (mgp::supports(isa))
+            run(isa);
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/client/rpc/stream_socket_transport.h"
+
+#include <endian.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace mclr = mir::client::rpc;
+namespace md = mir::dispatch;
+
+namespace
+{
+// Reads length-prefixed messages as the client's RPC channel does
+struct MessageReader : mclr::StreamTransport::Observer
+{
+    MessageReader(mclr::StreamTransport& transport) : transport(transport) {}
+
+    void on_data_available() override
+    {
+        uint16_t size;
+        transport.receive_data(&size, sizeof size);
+        body.resize(be16toh(size));
+        transport.receive_data(body.data(), body.size());
+        ++messages;
+    }
+
+    void on_disconnected() override
+    {
+        disconnected = true;
+    }
+
+    mclr::StreamTransport& transport;
+    std::vector<char> body;
+    uint64_t messages{0};
+    bool disconnected{false};
+};
+
+double thread_cpu_seconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+}
+
+// A server thread sends messages the size of an input event as fast as it
+// can, and we measure how many the client reads per second of its CPU time
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of messages> <message size>"<<std::endl;
+        exit(1);
+    }
+
+    uint64_t const message_count = std::atoll(argv[1]);
+    uint16_t const message_size = std::atoi(argv[2]);
+
+    int socket_fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds) < 0)
+    {
+        std::cout<<"Failed to create socket pair"<<std::endl;
+        exit(1);
+    }
+
+    mir::Fd const server_fd{socket_fds[0]};
+    auto const transport = std::make_shared<mclr::StreamSocketTransport>(mir::Fd{socket_fds[1]});
+    auto const reader = std::make_shared<MessageReader>(*transport);
+    transport->register_observer(reader);
+
+    std::thread server{[&]
+        {
+            std::vector<char> message(sizeof(uint16_t) + message_size);
+            uint16_t const size = htobe16(message_size);
+            std::copy(reinterpret_cast<char const*>(&size), reinterpret_cast<char const*>(&size + 1), message.begin());
+
+            for (uint64_t i = 0; i != message_count; ++i)
+            {
+                if (send(server_fd, message.data(), message.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(message.size()))
+                    break;
+            }
+        }};
+
+    uint64_t dispatches{0};
+    auto const start = thread_cpu_seconds();
+
+    while (reader->messages < message_count && !reader->disconnected)
+    {
+        pollfd readable{transport->watch_fd(), POLLIN, 0};
+        if (poll(&readable, 1, 1000) > 0)
+        {
+            ++dispatches;
+            transport->dispatch(md::FdEvent::readable);
+        }
+    }
+
+    auto const cpu_time = thread_cpu_seconds() - start;
+
+    server.join();
+
+    std::cout<<"Read "<<reader->messages<<" messages of "<<message_size<<" bytes in "
+             <<cpu_time<<"s of CPU time: "<<reader->messages / cpu_time<<" messages per second per core ("
+             <<double(dispatches) / reader->messages<<" dispatches per message)"<<std::endl;
+    exit(0);
+}
@@ -65,6 +65,16 @@ struct StubDisplaySyncGroup : mg::DisplaySyncGroup
     {
         return std::chrono::milliseconds::zero();
     }
+
+    mg::Frame last_frame() const override
+    {
+        return {};
+    }
+
+    std::chrono::nanoseconds frame_interval() const override
+    {
+        return std::chrono::nanoseconds::zero();
+    }
     
     double const vsync_rate_in_hz;
 
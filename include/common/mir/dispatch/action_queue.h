@@ -22,31 +22,64 @@
 #include "mir/fd.h"
 #include "mir/dispatch/dispatchable.h"
 
-#include <list>
+#include <atomic>
+#include <deque>
 #include <mutex>
 #include <functional>
+#include <memory>
 
 namespace mir
 {
 namespace dispatch
 {
 
+/**
+ * \brief A queue of actions to be run by whichever thread dispatches it
+ *
+ * Any number of threads may enqueue actions without blocking one another.
+ * The watch fd is only signalled when the queue stops being empty, and each
+ * dispatch() runs every action enqueued before it started, in order. The
+ * actions run without any lock held, so they may enqueue more actions or
+ * dispatch the queue themselves.
+ */
 class ActionQueue : public Dispatchable
 {
 public:
     ActionQueue();
+    ~ActionQueue() noexcept;
     Fd watch_fd() const override;
 
     void enqueue(std::function<void()> const& action);
+    void enqueue(std::function<void()>&& action);
 
     bool dispatch(FdEvents events) override;
     FdEvents relevant_events() const override;
 private:
+    ActionQueue(ActionQueue const&) = delete;
+    ActionQueue& operator=(ActionQueue const&) = delete;
+
+    struct Node
+    {
+        std::atomic<Node*> next;
+        std::function<void()> action;
+    };
+
+    void push(Node* node);
+    Node* pop();
     bool consume();
     void wake();
     mir::Fd event_fd;
-    std::mutex list_lock;
-    std::list<std::function<void()>> actions;
+
+    // An intrusive multi-producer, single-consumer list: producers append at
+    // head, and the consumer takes from tail
+    Node stub;
+    std::atomic<Node*> head;
+    Node* tail;
+    // The number of actions fully enqueued and not yet taken by a dispatch
+    std::atomic<uint64_t> pending;
+    std::mutex consumer_lock;
+    // Actions taken by a dispatch and not yet run, oldest first
+    std::deque<std::unique_ptr<Node>> deferred;
 };
 }
 }
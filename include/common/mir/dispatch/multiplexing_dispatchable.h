@@ -22,6 +22,7 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <list>
@@ -55,6 +56,17 @@ class MultiplexingDispatchable final : public Dispatchable
 public:
     MultiplexingDispatchable();
     MultiplexingDispatchable(std::initializer_list<std::shared_ptr<Dispatchable>> dispatchees);
+    /**
+     * \brief Create an adaptor that handles several ready dispatchables per dispatch()
+     *
+     * Each call to dispatch() harvests up to \p max_events_per_dispatch ready
+     * dispatchables with a single wait, and dispatches them in the order they were
+     * reported. This saves a wakeup of the thread calling dispatch() per event when
+     * many dispatchables are busy.
+     *
+     * \param [in] max_events_per_dispatch Between 1 and max_events_per_dispatch_limit
+     */
+    explicit MultiplexingDispatchable(unsigned max_events_per_dispatch);
     virtual ~MultiplexingDispatchable() noexcept;
 
     MultiplexingDispatchable& operator=(MultiplexingDispatchable const&) = delete;
@@ -94,11 +106,18 @@ public:
      * \param [in] fd   File descriptor of watch to remove.
      */
     void remove_watch(Fd const& fd);
+
+    static unsigned const max_events_per_dispatch_limit = 64;
 private:
+    bool is_watched(std::shared_ptr<Dispatchable> const& dispatchee);
+
     PosixRWMutex lifetime_mutex;
     std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
 
     Fd epoll_fd;
+    unsigned const max_events_per_dispatch;
+    // Counts remove_watch() calls, so that a batch can tell when it may hold a removed dispatchable
+    std::atomic<unsigned> removals;
 };
 }
 }
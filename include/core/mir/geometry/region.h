@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/displacement.h"
+
+#include <vector>
+#include <initializer_list>
+#include <iosfwd>
+
+namespace mir
+{
+namespace geometry
+{
+
+/**
+ * A set of points, supporting union, difference and intersection.
+ *
+ * Unlike Rectangles, a Region never holds overlapping rectangles: it is kept
+ * as horizontal bands, each a sorted list of disjoint spans, with vertically
+ * adjacent bands of identical spans merged. So equal sets of points compare
+ * equal, and asking whether a Region covers a rectangle is cheap however
+ * many rectangles were united to build it.
+ */
+class Region
+{
+public:
+    Region();
+    Region(Rectangle const& rect);
+    Region(std::initializer_list<Rectangle> const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    bool empty() const;
+    /// True if every point of rect is in the region (trivially so for an empty rect)
+    bool contains(Rectangle const& rect) const;
+    bool contains(Point const& point) const;
+    /// True if some point of rect is in the region (never so for an empty rect)
+    bool overlaps(Rectangle const& rect) const;
+    Rectangle bounding_rectangle() const;
+
+    /// The region as disjoint rectangles, ordered top to bottom then left to right
+    std::vector<Rectangle> rectangles() const;
+
+    void unite(Rectangle const& rect);
+    void unite(Region const& other);
+    void subtract(Rectangle const& rect);
+    void subtract(Region const& other);
+    void intersect(Rectangle const& rect);
+    void intersect(Region const& other);
+    void translate(Displacement const& displacement);
+    void clear();
+
+    bool operator==(Region const& other) const;
+    bool operator!=(Region const& other) const;
+
+private:
+    struct Span
+    {
+        int left;
+        int right;
+    };
+
+    struct Band
+    {
+        int top;
+        int bottom;
+        std::vector<Span> spans;
+    };
+
+    template<typename Op>
+    static std::vector<Band> combine(std::vector<Band> const& a, std::vector<Band> const& b, Op op);
+
+    std::vector<Band> bands;
+};
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
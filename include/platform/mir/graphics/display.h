@@ -86,6 +86,32 @@ public:
      */
     virtual std::chrono::milliseconds recommended_sleep() const = 0;
 
+    /**
+     * The vsync at which the most recently post()ed content reached the
+     * screen, or is predicted to reach it if post() returned before the
+     * flip completed. Only meaningful if frame_interval() is non-zero.
+     */
+    virtual Frame last_frame() const = 0;
+
+    /**
+     * The time between vsyncs, which together with last_frame() tells the
+     * compositor when the next frames will be shown. Zero if unknown (or if
+     * the group's outputs don't share a vsync), in which case the compositor
+     * falls back to recommended_sleep().
+     */
+    virtual std::chrono::nanoseconds frame_interval() const = 0;
+
+    /**
+     * Calls presented with the vsync at which the most recently post()ed
+     * content reached the screen, once it has. Platforms whose post()
+     * returns before then call it later from another thread; the default,
+     * for those whose post() waits, calls it at once with last_frame().
+     */
+    virtual void when_presented(std::function<void(Frame const&)> const& presented)
+    {
+        presented(last_frame());
+    }
+
     virtual ~DisplaySyncGroup() = default;
 protected:
     DisplaySyncGroup() = default;
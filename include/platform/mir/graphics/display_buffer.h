@@ -68,6 +68,21 @@ public:
     **/
     virtual bool overlay(RenderableList const& renderlist) = 0;
 
+    /** As overlay(), but the hardware may take just part of the list,
+     *  showing it above whatever the caller renders.
+     *  \param [in,out] renderlist
+     *      On return, the renderables the caller must still render (using a
+     *      graphics library such as OpenGL) before posting. The hardware
+     *      shows the others.
+     *  \returns
+     *      True if the hardware has shown the whole list, leaving nothing
+     *      to render.
+    **/
+    virtual bool overlay_partially(RenderableList& renderlist)
+    {
+        return overlay(renderlist);
+    }
+
     /**
      * Returns a transformation that the renderer must apply to all rendering.
      * There is usually no transformation required (just the identity matrix)
@@ -20,6 +20,8 @@
 #define MIR_GRAPHICS_RENDERABLE_H_
 
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
+#include <mir/geometry/region.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -50,6 +52,16 @@ public:
 
     virtual geometry::Rectangle screen_position() const = 0;
 
+    /**
+     * Return the region of buffer(), in buffer coordinates, whose content
+     * differs from the buffer this renderable's source last provided to the
+     * same compositor. The whole buffer is returned if this is not known.
+     *
+     * A consumer that does not hold the previous content for this id() must
+     * treat the whole buffer as damaged.
+     */
+    virtual geometry::Rectangles damage() const = 0;
+
     // These are from the old CompositingCriteria. There is a little bit
     // of function overlap with the above functions still.
     virtual float alpha() const = 0;
@@ -70,6 +82,13 @@ public:
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
+    /**
+     * Return the parts of screen_position() known to be drawn fully opaque
+     * even though the buffer is shaped() (e.g. a client's declared opaque
+     * region). Empty if nothing more is known than shaped() says.
+     */
+    virtual geometry::Region opaque_region() const = 0;
+
     virtual unsigned int swap_interval() const = 0;
 protected:
     Renderable() = default;
@@ -38,6 +38,7 @@ public:
     virtual void set_output_transform(glm::mat2 const&) = 0;
     virtual void render(graphics::RenderableList const&) const = 0;
     virtual void suspend() = 0; // called when render() is skipped
+    virtual float repainted_fraction() const = 0; // of the viewport, by the last render()
 
 protected:
     Renderer() = default;
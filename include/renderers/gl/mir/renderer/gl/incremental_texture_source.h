@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_INCREMENTAL_TEXTURE_SOURCE_H_
+#define MIR_RENDERER_GL_INCREMENTAL_TEXTURE_SOURCE_H_
+
+#include "mir/geometry/rectangles.h"
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+
+/// A TextureSource whose pixels are copied into the texture, so a texture can be updated piecemeal
+class IncrementalTextureSource
+{
+public:
+    virtual ~IncrementalTextureSource() = default;
+
+    /**
+     * Updates the bound texture, which must already hold an earlier buffer of
+     * the same size and pixel format, by uploading only the damaged region.
+     *
+     * \param [in] damage   the parts of the buffer (in buffer coordinates)
+     *                      that differ from the texture's current content
+     */
+    virtual void bind_damaged(geometry::Rectangles const& damage) = 0;
+
+protected:
+    IncrementalTextureSource() = default;
+    IncrementalTextureSource(IncrementalTextureSource const&) = delete;
+    IncrementalTextureSource& operator=(IncrementalTextureSource const&) = delete;
+};
+
+}
+}
+}
+
+#endif /* MIR_RENDERER_GL_INCREMENTAL_TEXTURE_SOURCE_H_ */
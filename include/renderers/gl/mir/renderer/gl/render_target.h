@@ -45,6 +45,14 @@ public:
      * in preparation for drawing.
      */
     virtual void bind() = 0;
+    /**
+     * The age of the contents of the buffer about to be drawn, in frames,
+     * as defined by EGL_EXT_buffer_age: 1 if it holds the previous frame,
+     * 2 the frame before that, and so on. 0 means the contents are
+     * undefined and everything has to be redrawn.
+     * Only meaningful after bind().
+     */
+    virtual int buffer_age() = 0;
 
 protected:
     RenderTarget() = default;
@@ -21,6 +21,8 @@
 
 #include "mir/graphics/renderable.h"
 
+#include <chrono>
+
 namespace mir
 {
 namespace compositor
@@ -34,7 +36,14 @@ public:
     virtual void began_frame(SubCompositorId id) = 0;
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
+    /// Proportion of the display buffer's pixels (0 to 1) redrawn by the rendered frame
+    virtual void repainted_fraction(SubCompositorId id, float fraction) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// Time the compositor budgeted for rendering a frame, and the time it actually took.
+    /// Reported once the frame has been posted.
+    virtual void render_time(SubCompositorId id,
+                             std::chrono::nanoseconds predicted,
+                             std::chrono::nanoseconds actual) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
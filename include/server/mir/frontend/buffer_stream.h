@@ -22,6 +22,8 @@
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
 #include <functional>
 #include <memory>
 
@@ -42,7 +44,21 @@ public:
     virtual ~BufferStream() = default;
     
     virtual void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /**
+     * Submit a buffer along with the region (in buffer coordinates) in which it
+     * differs from the previously submitted buffer. An empty damage region means
+     * the changes are unknown, and the whole buffer is considered damaged.
+     */
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) = 0;
     virtual void resize(geometry::Size const& size) = 0;
+    /**
+     * Set the region (in buffer coordinates) the client promises to draw
+     * fully opaque, even if the pixel format has alpha. Applies to buffers
+     * submitted from now on.
+     */
+    virtual void set_opaque_region(geometry::Region const& region) = 0;
 
     virtual void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) = 0;
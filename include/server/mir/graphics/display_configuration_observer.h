@@ -19,6 +19,7 @@
 #ifndef MIR_GRAPHICS_DISPLAY_CONFIGURATION_OBSERVER_
 #define MIR_GRAPHICS_DISPLAY_CONFIGURATION_OBSERVER_
 
+#include <chrono>
 #include <exception>
 #include <memory>
 
@@ -32,6 +33,18 @@ namespace graphics
 {
 class DisplayConfiguration;
 
+/// How long each step of applying a display configuration took
+struct DisplayConfigurationTimings
+{
+    /// Trying to apply the configuration without changing any display buffers
+    std::chrono::nanoseconds preserving_display_buffers{0};
+    /// Whether that failed, so the compositor was stopped to reconfigure the display
+    bool compositor_stopped{false};
+    std::chrono::nanoseconds stopping_compositor{0};
+    std::chrono::nanoseconds configuring_display{0};
+    std::chrono::nanoseconds starting_compositor{0};
+};
+
 class DisplayConfigurationObserver
 {
 public:
@@ -54,6 +67,16 @@ public:
      */
     virtual void configuration_applied(std::shared_ptr<DisplayConfiguration const> const& config) = 0;
 
+    /**
+     * Notification of how long applying a display configuration took.
+     *
+     * This is called after configuration_applied(), once per successful
+     * display configuration.
+     *
+     * \param [in] timings  The time spent on each step of applying it.
+     */
+    virtual void configuration_timings(DisplayConfigurationTimings const& /*timings*/) {}
+
     /**
      * Notification after updating base display configuration.
      *
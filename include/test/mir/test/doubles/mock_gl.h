@@ -98,6 +98,9 @@ public:
     MOCK_METHOD9(glTexImage2D,
                  void(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum,
                       GLenum,const GLvoid*));
+    MOCK_METHOD9(glTexSubImage2D,
+                 void(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum,
+                      GLenum, const GLvoid*));
     MOCK_METHOD3(glTexParameteri, void(GLenum, GLenum, GLenum));
     MOCK_METHOD2(glUniform1f, void(GLint, GLfloat));
     MOCK_METHOD3(glUniform2f, void(GLint, GLfloat, GLfloat));
@@ -109,6 +112,7 @@ public:
                  void(GLuint, GLint, GLenum, GLboolean, GLsizei,
                       const GLvoid *));
     MOCK_METHOD4(glViewport, void(GLint, GLint, GLsizei, GLsizei));
+    MOCK_METHOD4(glScissor, void(GLint, GLint, GLsizei, GLsizei));
     MOCK_METHOD1(glGenerateMipmap, void(GLenum target));
     MOCK_METHOD4(glDrawElements, void(GLenum, GLsizei, GLenum, const GLvoid*));
 };
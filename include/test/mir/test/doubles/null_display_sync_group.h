@@ -60,6 +60,16 @@ public:
         return std::chrono::milliseconds::zero();
     }
 
+    graphics::Frame last_frame() const override
+    {
+        return {};
+    }
+
+    std::chrono::nanoseconds frame_interval() const override
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
 private:
     std::vector<geometry::Rectangle> const output_rects;
     std::vector<StubDisplayBuffer> display_buffers;
@@ -82,6 +92,16 @@ struct NullDisplaySyncGroup : graphics::DisplaySyncGroup
         return std::chrono::milliseconds::zero();
     }
 
+    graphics::Frame last_frame() const override
+    {
+        return {};
+    }
+
+    std::chrono::nanoseconds frame_interval() const override
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
     NullDisplayBuffer db;
 };
 
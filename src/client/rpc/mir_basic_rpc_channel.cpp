@@ -161,6 +161,7 @@ mir::protobuf::wire::Invocation mclr::MirBasicRpcChannel::invocation_for(
     invoke.set_parameters(buffer.data(), buffer.size());
     invoke.set_protocol_version(protocol_version);
     invoke.set_side_channel_fds(num_side_channel_fds);
+    invoke.set_large_results(true);
 
     return invoke;
 }
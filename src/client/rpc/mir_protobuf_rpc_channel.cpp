@@ -33,6 +33,7 @@
 #include "../mir_error.h"
 #include "mir/input/input_devices.h"
 #include "mir/variable_length_array.h"
+#include "mir/raii.h"
 #include "mir/events/event_builders.h"
 #include "mir/events/event_private.h"
 #include "mir/events/surface_placement_event.h"
@@ -44,8 +45,11 @@
 #include <boost/bind.hpp>
 #include <boost/throw_exception.hpp>
 #include <endian.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <stdexcept>
+#include <system_error>
 #include <cstring>
 
 namespace mf = mir::frontend;
@@ -70,6 +74,7 @@ mclr::MirProtobufRpcChannel::MirProtobufRpcChannel(
     rpc_report(rpc_report),
     pending_calls(rpc_report),
     input_report(input_report),
+    event_sequence{mcl::make_protobuf_object<mp::EventSequence>()},
     surface_map(surface_map),
     buffer_factory(buffer_factory),
     display_configuration(disp_config),
@@ -96,6 +101,8 @@ mclr::MirProtobufRpcChannel::MirProtobufRpcChannel(
     this->transport->register_observer(std::shared_ptr<mclr::StreamTransport::Observer>{this, NullDeleter()});
 }
 
+mclr::MirProtobufRpcChannel::~MirProtobufRpcChannel() = default;
+
 void mclr::MirProtobufRpcChannel::notify_disconnected()
 {
     if (!disconnected.exchange(true))
@@ -292,7 +299,7 @@ void mclr::MirProtobufRpcChannel::send_message(
 
 void mclr::MirProtobufRpcChannel::process_event_sequence(std::string const& event)
 {
-    mp::EventSequence seq;
+    auto& seq = *event_sequence;
 
     seq.ParseFromString(event);
 
@@ -480,7 +487,10 @@ void mclr::MirProtobufRpcChannel::on_data_available()
      */
     std::lock_guard<decltype(read_mutex)> lock(read_mutex);
 
-    auto result = mcl::make_protobuf_object<mp::wire::Result>();
+    // A result we had to keep for later is replaced; otherwise we reuse it
+    if (!result)
+        result = mcl::make_protobuf_object<mp::wire::Result>();
+
     try
     {
         uint16_t message_size;
@@ -492,6 +502,9 @@ void mclr::MirProtobufRpcChannel::on_data_available()
 
         result->ParseFromArray(body_bytes.data(), message_size);
 
+        if (result->has_out_of_line_size())
+            receive_out_of_line_result();
+
         rpc_report->result_receipt_succeeded(*result);
     }
     catch (std::exception const& x)
@@ -550,6 +563,28 @@ void mclr::MirProtobufRpcChannel::on_data_available()
     }
 }
 
+void mclr::MirProtobufRpcChannel::receive_out_of_line_result()
+{
+    size_t const size = result->out_of_line_size();
+
+    char dummy;
+    std::vector<mir::Fd> fds(1);
+    transport->receive_data(&dummy, sizeof dummy, fds);
+
+    struct stat payload_stat;
+    if (fstat(fds[0], &payload_stat) < 0 || static_cast<size_t>(payload_stat.st_size) < size)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Server sent a truncated out of line result"));
+
+    auto const payload = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fds[0], 0);
+    if (payload == MAP_FAILED)
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to map out of line result"));
+
+    auto const unmap = mir::raii::deleter_for(payload, [size](void* mapping) { munmap(mapping, size); });
+
+    if (!result->ParseFromArray(payload, size))
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to parse out of line result"));
+}
+
 void mclr::MirProtobufRpcChannel::on_disconnected()
 {
     notify_disconnected();
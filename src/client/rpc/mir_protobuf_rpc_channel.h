@@ -35,6 +35,7 @@
 
 namespace mir
 {
+namespace protobuf { class EventSequence; }
 
 namespace input
 {
@@ -76,7 +77,7 @@ public:
                           std::shared_ptr<ErrorHandler> const& error_handler,
                           std::shared_ptr<EventSink> const& event_sink);
 
-    ~MirProtobufRpcChannel() = default;
+    ~MirProtobufRpcChannel();
 
     // StreamTransport::Observer
     void on_data_available() override;
@@ -122,6 +123,11 @@ private:
     detail::SendBuffer header_bytes;
     detail::SendBuffer body_bytes;
 
+    // Kept between messages (under read_mutex) so that, once they've grown
+    // to fit, parsing reuses their storage instead of allocating
+    std::unique_ptr<mir::protobuf::wire::Result> result;
+    std::unique_ptr<mir::protobuf::EventSequence> const event_sequence;
+
     void receive_file_descriptors(google::protobuf::MessageLite* response);
     template<class MessageType>
     void receive_any_file_descriptors_for(MessageType* response);
@@ -130,6 +136,7 @@ private:
                       std::vector<mir::Fd>& fds);
 
     void read_message();
+    void receive_out_of_line_result();
     void process_event_sequence(std::string const& event);
 
     void notify_disconnected();
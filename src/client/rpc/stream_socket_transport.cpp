@@ -21,6 +21,8 @@
 #include "mir/thread_name.h"
 #include "mir/fd_socket_transmission.h"
 
+#include <algorithm>
+#include <cstring>
 #include <system_error>
 
 #include <errno.h>
@@ -67,41 +69,110 @@ void mclr::StreamSocketTransport::unregister_observer(std::shared_ptr<Observer>
 
 void mclr::StreamSocketTransport::receive_data(void* buffer, size_t bytes_requested)
 {
-    /*
-     * Explicitly implement this, rather than delegating to receive_data(buffer, size, fds)
-     * so that we can catch when we discard file descriptors.
-     *
-     * See comment for DISABLED_ReceivingMoreFdsThanExpectedInMultipleChunksRaisesException
-     * test in test_stream_transport.cpp for details.
-     */
+    if (!take_buffered_data(buffer, bytes_requested).empty())
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Unexpectedly received fds"));
+    }
+}
+
+void mclr::StreamSocketTransport::receive_data(void* buffer, size_t bytes_requested, std::vector<mir::Fd>& fds)
+{
+    size_t fds_read{0};
+    for (auto const& batch : take_buffered_data(buffer, bytes_requested))
+    {
+        /*
+         * Once we have all we asked for, further fds are dropped: see the comment for
+         * DISABLED_receiving_more_fds_than_expected_in_multiple_chunks_raises_exception
+         * in test_stream_transport.cpp for why they might turn up.
+         */
+        if (fds_read == fds.size())
+            break;
+
+        if (batch.size() > fds.size() - fds_read)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Received more fds than expected"));
+        }
+
+        std::copy(batch.begin(), batch.end(), fds.begin() + fds_read);
+        fds_read += batch.size();
+    }
+
+    if (fds_read < fds.size())
+    {
+        fds.clear();
+        BOOST_THROW_EXCEPTION(std::runtime_error("Received fewer fds than expected"));
+    }
+}
+
+auto mclr::StreamSocketTransport::take_buffered_data(void* buffer, size_t bytes_requested)
+    -> std::vector<std::vector<mir::Fd>>
+{
     if (bytes_requested == 0)
     {
         BOOST_THROW_EXCEPTION(std::logic_error("Attempted to receive 0 bytes"));
     }
-    size_t bytes_read{0};
-    while(bytes_read < bytes_requested)
+
+    fill_read_buffer(bytes_requested);
+
+    memcpy(buffer, read_buffer.data() + read_start, bytes_requested);
+    read_start += bytes_requested;
+    bytes_taken += bytes_requested;
+
+    std::vector<std::vector<mir::Fd>> fds;
+    while (!received_fds.empty() && received_fds.front().first < bytes_taken)
+    {
+        fds.push_back(std::move(received_fds.front().second));
+        received_fds.pop_front();
+    }
+    return fds;
+}
+
+void mclr::StreamSocketTransport::fill_read_buffer(size_t bytes_needed)
+{
+    // Big enough for a whole message and its header, and then some
+    static size_t const read_size{64 * 1024};
+    // SCM_MAX_FD: the kernel won't send more in one control message
+    static size_t const max_fds{253};
+
+    if (read_end - read_start >= bytes_needed)
+    {
+        return;
+    }
+
+    std::copy(read_buffer.begin() + read_start, read_buffer.begin() + read_end, read_buffer.begin());
+    read_end -= read_start;
+    read_start = 0;
+    read_buffer.resize(std::max(read_size, bytes_needed));
+
+    while (read_end < bytes_needed)
     {
-        // Store the data in the buffer requested
         struct iovec iov;
-        iov.iov_base = static_cast<uint8_t*>(buffer) + bytes_read;
-        iov.iov_len = bytes_requested - bytes_read;
+        iov.iov_base = read_buffer.data() + read_end;
+        iov.iov_len = read_buffer.size() - read_end;
+
+        union
+        {
+            struct cmsghdr align;
+            char data[CMSG_SPACE(max_fds * sizeof(int))];
+        } control;
 
-        // Message to read
         struct msghdr header;
         header.msg_name = NULL;
         header.msg_namelen = 0;
         header.msg_iov = &iov;
         header.msg_iovlen = 1;
-        header.msg_controllen = 0;
-        header.msg_control = nullptr;
+        header.msg_controllen = sizeof control.data;
+        header.msg_control = control.data;
         header.msg_flags = 0;
 
-        ssize_t const result = recvmsg(socket_fd, &header, MSG_NOSIGNAL | MSG_WAITALL);
+        // The kernel ends the read after any data that fds were sent with,
+        // so fds always belong to the last byte we get
+        ssize_t const result = recvmsg(socket_fd, &header, MSG_NOSIGNAL);
 
         if (result == 0)
         {
             observers.on_disconnected();
-            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to read message from server: server has shutdown"));
+            BOOST_THROW_EXCEPTION(socket_disconnected_error("Failed to read message from server: server has shutdown"));
         }
         if (result < 0)
         {
@@ -122,26 +193,32 @@ void mclr::StreamSocketTransport::receive_data(void* buffer, size_t bytes_reques
                              << boost::errinfo_errno(errno));
         }
 
-        if (header.msg_flags & MSG_CTRUNC)
+        read_end += result;
+
+        for (auto cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg))
         {
-            BOOST_THROW_EXCEPTION(std::runtime_error("Unexpectedly received fds"));
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            {
+                BOOST_THROW_EXCEPTION(fd_reception_error("Invalid control message for receiving file descriptors"));
+            }
+
+            int const* const data = reinterpret_cast<int const*>(CMSG_DATA(cmsg));
+            auto const nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+            std::vector<mir::Fd> fds;
+            for (size_t i = 0; i != nfds; ++i)
+                fds.push_back(mir::Fd{mir::IntOwnedFd{data[i]}});
+
+            received_fds.emplace_back(bytes_taken + read_end - 1, std::move(fds));
         }
 
-        bytes_read += result;
+        if (header.msg_flags & MSG_CTRUNC)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Received more fds than expected"));
+        }
     }
 }
 
-void mclr::StreamSocketTransport::receive_data(void* buffer, size_t bytes_requested, std::vector<mir::Fd>& fds)
-try
-{
-    mir::receive_data(socket_fd, buffer, bytes_requested, fds);
-}
-catch (socket_disconnected_error &e)
-{
-    observers.on_disconnected();
-    throw e;
-}
-
 void mclr::StreamSocketTransport::send_message(
     std::vector<uint8_t> const& buffer,
     std::vector<mir::Fd> const& fds)
@@ -196,7 +273,7 @@ bool mclr::StreamSocketTransport::dispatch(md::FdEvents events)
             int dummy;
             if (recv(socket_fd, &dummy, sizeof(dummy), MSG_PEEK | MSG_NOSIGNAL) > 0)
             {
-                observers.on_data_available();
+                notify_data_available();
                 return true;
             }
         }
@@ -205,11 +282,24 @@ bool mclr::StreamSocketTransport::dispatch(md::FdEvents events)
     }
     else if (events & md::FdEvent::readable)
     {
-        observers.on_data_available();
+        notify_data_available();
     }
     return true;
 }
 
+void mclr::StreamSocketTransport::notify_data_available()
+{
+    // What we've already read won't make the socket readable again, so keep
+    // notifying while observers are taking it
+    uint64_t taken;
+    do
+    {
+        taken = bytes_taken;
+        observers.on_data_available();
+    }
+    while (read_end != read_start && bytes_taken != taken);
+}
+
 md::FdEvents mclr::StreamSocketTransport::relevant_events() const
 {
     return md::FdEvent::readable | md::FdEvent::remote_closed;
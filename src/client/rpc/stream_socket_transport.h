@@ -24,8 +24,12 @@
 #include "mir/fd.h"
 #include "mir/basic_observers.h"
 
+#include <cstdint>
+#include <deque>
 #include <thread>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
@@ -45,6 +49,12 @@ public:
     void on_disconnected() override;
 };
 
+/**
+ * Reads from the server in as few syscalls as possible: each read takes
+ * everything the server has sent so far, and later receive_data() calls
+ * are served from that until it runs out. dispatch() keeps notifying
+ * observers while there's buffered data, as watch_fd() won't.
+ */
 class StreamSocketTransport : public StreamTransport
 {
 public:
@@ -64,8 +74,20 @@ public:
 private:
     Fd open_socket(std::string const& path);
 
+    void fill_read_buffer(size_t bytes_needed);
+    // Returns the fds received along with the data, in the batches they were sent
+    auto take_buffered_data(void* buffer, size_t bytes_requested) -> std::vector<std::vector<Fd>>;
+    void notify_data_available();
+
     Fd const socket_fd;
 
+    std::vector<uint8_t> read_buffer;
+    size_t read_start{0};
+    size_t read_end{0};
+    uint64_t bytes_taken{0};
+    // Fds received, by the stream offset of the last byte received with them
+    std::deque<std::pair<uint64_t, std::vector<Fd>>> received_fds;
+
     TransportObservers observers;
 };
 
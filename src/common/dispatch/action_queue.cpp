@@ -21,8 +21,15 @@
 #include <boost/throw_exception.hpp>
 #include <sys/eventfd.h>
 
+#include <memory>
+#include <thread>
+
 mir::dispatch::ActionQueue::ActionQueue()
-    : event_fd{eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK|EFD_SEMAPHORE)}
+    : event_fd{eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK)},
+      stub{{nullptr}, {}},
+      head{&stub},
+      tail{&stub},
+      pending{0}
 {
     if (event_fd < 0)
         BOOST_THROW_EXCEPTION((std::system_error{errno,
@@ -30,6 +37,12 @@ mir::dispatch::ActionQueue::ActionQueue()
                                                  "Failed to create event fd for action queue"}));
 }
 
+mir::dispatch::ActionQueue::~ActionQueue() noexcept
+{
+    while (auto const node = pop())
+        delete node;
+}
+
 mir::Fd mir::dispatch::ActionQueue::watch_fd() const
 {
     return event_fd;
@@ -37,9 +50,17 @@ mir::Fd mir::dispatch::ActionQueue::watch_fd() const
 
 void mir::dispatch::ActionQueue::enqueue(std::function<void()> const& action)
 {
-    std::unique_lock<std::mutex> lock(list_lock);
-    actions.push_back(action);
-    wake();
+    enqueue(std::function<void()>{action});
+}
+
+void mir::dispatch::ActionQueue::enqueue(std::function<void()>&& action)
+{
+    push(new Node{{nullptr}, std::move(action)});
+
+    // Only the action that makes the queue non-empty needs to wake the
+    // consumer; the others will be run in the same dispatch
+    if (pending.fetch_add(1) == 0)
+        wake();
 }
 
 bool mir::dispatch::ActionQueue::dispatch(FdEvents events)
@@ -47,22 +68,63 @@ bool mir::dispatch::ActionQueue::dispatch(FdEvents events)
     if (events&FdEvent::error)
         return false;
 
-    if (!consume())
     {
-        // Another thread has won the race to process this event
-        // That's OK, just bail.
-        return true;
-    }
+        std::lock_guard<std::mutex> lock{consumer_lock};
+
+        if (!consume())
+        {
+            // Another thread has won the race to process this event
+            // That's OK, just bail.
+            return true;
+        }
 
-    std::function<void()> action_to_process;
+        // Actions enqueued from here on are left for the next dispatch
+        auto const count = pending.load();
+        for (uint64_t taken = 0; taken != count; ++taken)
+        {
+            Node* node;
+            while (!(node = pop()))
+            {
+                // A producer is between appending its node and linking it
+                std::this_thread::yield();
+            }
+            deferred.emplace_back(node);
+        }
 
-    {
-        std::unique_lock<std::mutex> lock(list_lock);
-        action_to_process = actions.front();
-        actions.pop_front();
+        // Actions enqueued since we counted didn't wake us, as the queue
+        // wasn't empty
+        if (pending.fetch_sub(count) != count)
+            wake();
     }
 
-    action_to_process();
+    // Actions run without the lock, as one may dispatch this queue itself.
+    // Taking them one at a time means such a dispatch carries on with this
+    // batch before anything enqueued since.
+    for (;;)
+    {
+        std::unique_ptr<Node> node;
+        {
+            std::lock_guard<std::mutex> lock{consumer_lock};
+            if (deferred.empty())
+                break;
+
+            node = std::move(deferred.front());
+            deferred.pop_front();
+        }
+
+        try
+        {
+            node->action();
+        }
+        catch (...)
+        {
+            // Leave the rest of the batch for the next dispatch
+            std::lock_guard<std::mutex> lock{consumer_lock};
+            if (!deferred.empty())
+                wake();
+            throw;
+        }
+    }
 
     return true;
 }
@@ -72,6 +134,50 @@ mir::dispatch::FdEvents mir::dispatch::ActionQueue::relevant_events() const
     return FdEvent::readable;
 }
 
+void mir::dispatch::ActionQueue::push(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    auto const previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+auto mir::dispatch::ActionQueue::pop() -> Node*
+{
+    auto first = tail;
+    auto next = first->next.load(std::memory_order_acquire);
+
+    if (first == &stub)
+    {
+        if (!next)
+            return nullptr;
+
+        tail = next;
+        first = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+        tail = next;
+        return first;
+    }
+
+    if (first != head.load(std::memory_order_acquire))
+        return nullptr;
+
+    // first is the last node: put the stub behind it so it can be taken
+    push(&stub);
+
+    next = first->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        tail = next;
+        return first;
+    }
+
+    return nullptr;
+}
+
 bool mir::dispatch::ActionQueue::consume()
 {
     uint64_t num_actions;
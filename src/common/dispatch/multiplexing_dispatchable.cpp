@@ -31,6 +31,8 @@
 #include <string.h>
 #include <system_error>
 #include <algorithm>
+#include <array>
+#include <stdexcept>
 
 namespace md = mir::dispatch;
 
@@ -72,9 +74,21 @@ private:
 }
 
 md::MultiplexingDispatchable::MultiplexingDispatchable()
+    : MultiplexingDispatchable(1u)
+{
+}
+
+md::MultiplexingDispatchable::MultiplexingDispatchable(unsigned max_events_per_dispatch)
     : lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
-      epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}}
+      epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}},
+      max_events_per_dispatch{max_events_per_dispatch},
+      removals{0}
 {
+    if (max_events_per_dispatch < 1 || max_events_per_dispatch > max_events_per_dispatch_limit)
+    {
+        BOOST_THROW_EXCEPTION((std::invalid_argument{"Invalid number of events per dispatch"}));
+    }
+
     if (epoll_fd == mir::Fd::invalid)
     {
         BOOST_THROW_EXCEPTION((std::system_error{errno,
@@ -108,43 +122,65 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    struct Ready
+    {
+        std::shared_ptr<md::Dispatchable> source;
+        bool rearm_source;
+        epoll_event event;
+    };
+    std::array<epoll_event, max_events_per_dispatch_limit> events_ready;
+    std::array<Ready, max_events_per_dispatch_limit> ready;
+    int ready_count;
+    unsigned removals_seen;
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        ready_count = epoll_wait(epoll_fd, events_ready.data(), max_events_per_dispatch, 0);
 
-        if (result < 0)
+        if (ready_count < 0)
         {
             BOOST_THROW_EXCEPTION((std::system_error{errno,
                                                      std::system_category(),
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        // If nothing is ready some other thread must have stolen the event we
+        // were woken for; that's ok, just return.
+        for (int i = 0; i != ready_count; ++i)
         {
-            // Some other thread must have stolen the event we were woken for;
-            // that's ok, just return.
-            return true;
-        }
+            auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(events_ready[i].data.ptr);
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
+            ready[i] = Ready{event_source->first, event_source->second, events_ready[i]};
+        }
 
-        source = event_source->first;
-        rearm_source = event_source->second;
+        removals_seen = removals;
     }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
+    for (int i = 0; i != ready_count; ++i)
     {
-        remove_watch(source);
-    }
-    else if (rearm_source)
-    {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        auto& source = ready[i].source;
+
+        // Dispatching the events ahead of this one might have removed its source
+        if (i > 0 && removals != removals_seen)
+        {
+            removals_seen = removals;
+            if (!is_watched(source))
+            {
+                continue;
+            }
+        }
+
+        if (!source->dispatch(epoll_to_fd_event(ready[i].event)))
+        {
+            remove_watch(source);
+        }
+        else if (ready[i].rearm_source)
+        {
+            auto& event = ready[i].event;
+            event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        }
     }
 
     return true;
@@ -227,4 +263,15 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
     {
         return candidate.first->watch_fd() == fd;
     });
+    ++removals;
+}
+
+bool md::MultiplexingDispatchable::is_watched(std::shared_ptr<Dispatchable> const& dispatchee)
+{
+    std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+    return std::any_of(dispatchee_holder.begin(), dispatchee_holder.end(),
+        [&dispatchee](std::pair<std::shared_ptr<Dispatchable>,bool> const& candidate)
+        {
+            return candidate.first == dispatchee;
+        });
 }
@@ -25,6 +25,7 @@
 #include "mir/events/input_event.h"
 #include "mir/events/keyboard_event.h"
 #include "mir/events/keymap_event.h"
+#include "mir/events/pointer_event.h"
 #include "mir/events/touch_event.h"
 #include "mir/events/orientation_event.h"
 #include "mir/events/prompt_session_event.h"
@@ -36,9 +37,94 @@
 
 #include <capnp/serialize.h>
 
+#include <mutex>
+#include <new>
 
 namespace ml = mir::logging;
 
+namespace
+{
+// Every kind of event shares the layout of MirEvent, so they can share a pool
+static_assert(sizeof(MirInputEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirKeyboardEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirTouchEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirPointerEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirWindowEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirResizeEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirPromptSessionEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirOrientationEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirCloseWindowEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirKeymapEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirWindowOutputEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirInputDeviceStateEvent) == sizeof(MirEvent), "events must not add data members");
+static_assert(sizeof(MirWindowPlacementEvent) == sizeof(MirEvent), "events must not add data members");
+
+class EventPool
+{
+public:
+    void* allocate()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (auto const block = spare)
+            {
+                spare = block->next;
+                --spares;
+                return block;
+            }
+        }
+        return ::operator new(sizeof(MirEvent));
+    }
+
+    void release(void* event) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (spares < max_spares)
+            {
+                spare = new (event) Block{spare};
+                ++spares;
+                return;
+            }
+        }
+        ::operator delete(event);
+    }
+
+private:
+    struct Block { Block* next; };
+
+    // Enough to cover the events in flight during a burst of input
+    static unsigned const max_spares = 64;
+
+    std::mutex mutex;
+    Block* spare = nullptr;
+    unsigned spares = 0;
+};
+
+// Never destroyed, as events may outlive static destruction
+EventPool& event_pool()
+{
+    static auto const pool = new EventPool;
+    return *pool;
+}
+}
+
+void* MirEvent::operator new(std::size_t size)
+{
+    if (size != sizeof(MirEvent))
+        return ::operator new(size);
+
+    return event_pool().allocate();
+}
+
+void MirEvent::operator delete(void* event, std::size_t size) noexcept
+{
+    if (size != sizeof(MirEvent))
+        return ::operator delete(event);
+
+    event_pool().release(event);
+}
+
 MirEvent::MirEvent(MirEvent const& e)
 {
     auto reader = e.event.asReader();
@@ -0,0 +1,307 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+int const unbounded = std::numeric_limits<int>::max();
+
+bool in_either(bool a, bool b) { return a || b; }
+bool in_first_only(bool a, bool b) { return a && !b; }
+bool in_both(bool a, bool b) { return a && b; }
+}
+
+/*
+ * Sweeps both regions from top to bottom and, within each band, from left
+ * to right, keeping the points for which op(in_a, in_b) holds. Each output
+ * band is built fresh, so spans and bands come out sorted, disjoint and
+ * coalesced without a separate normalisation pass.
+ */
+template<typename Op>
+auto geom::Region::combine(std::vector<Band> const& a, std::vector<Band> const& b, Op op) -> std::vector<Band>
+{
+    std::vector<Band> result;
+    std::vector<Span> spans;
+    std::vector<Span> const no_spans;
+
+    auto ia = a.begin();
+    auto ib = b.begin();
+    int y = std::min(ia != a.end() ? ia->top : unbounded, ib != b.end() ? ib->top : unbounded);
+
+    while (ia != a.end() || ib != b.end())
+    {
+        bool const a_here = ia != a.end() && ia->top <= y;
+        bool const b_here = ib != b.end() && ib->top <= y;
+        int const a_next = ia == a.end() ? unbounded : a_here ? ia->bottom : ia->top;
+        int const b_next = ib == b.end() ? unbounded : b_here ? ib->bottom : ib->top;
+        int const y_next = std::min(a_next, b_next);
+
+        auto const& a_spans = a_here ? ia->spans : no_spans;
+        auto const& b_spans = b_here ? ib->spans : no_spans;
+
+        spans.clear();
+        auto sa = a_spans.begin();
+        auto sb = b_spans.begin();
+        int x = std::min(sa != a_spans.end() ? sa->left : unbounded, sb != b_spans.end() ? sb->left : unbounded);
+
+        while (sa != a_spans.end() || sb != b_spans.end())
+        {
+            bool const in_a = sa != a_spans.end() && sa->left <= x;
+            bool const in_b = sb != b_spans.end() && sb->left <= x;
+            int const xa_next = sa == a_spans.end() ? unbounded : in_a ? sa->right : sa->left;
+            int const xb_next = sb == b_spans.end() ? unbounded : in_b ? sb->right : sb->left;
+            int const x_next = std::min(xa_next, xb_next);
+
+            if (op(in_a, in_b))
+            {
+                if (!spans.empty() && spans.back().right == x)
+                    spans.back().right = x_next;
+                else
+                    spans.push_back({x, x_next});
+            }
+
+            x = x_next;
+            if (sa != a_spans.end() && sa->right == x) ++sa;
+            if (sb != b_spans.end() && sb->right == x) ++sb;
+        }
+
+        if (!spans.empty())
+        {
+            auto const same_spans = [&](std::vector<Span> const& other)
+                {
+                    return std::equal(spans.begin(), spans.end(), other.begin(), other.end(),
+                        [](Span const& l, Span const& r) { return l.left == r.left && l.right == r.right; });
+                };
+
+            if (!result.empty() && result.back().bottom == y && same_spans(result.back().spans))
+                result.back().bottom = y_next;
+            else
+                result.push_back({y, y_next, spans});
+        }
+
+        y = y_next;
+        if (ia != a.end() && ia->bottom == y) ++ia;
+        if (ib != b.end() && ib->bottom == y) ++ib;
+    }
+
+    return result;
+}
+
+geom::Region::Region() = default;
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (rect.size.width > Width{0} && rect.size.height > Height{0})
+    {
+        bands.push_back(
+            {rect.top().as_int(), rect.bottom().as_int(), {{rect.left().as_int(), rect.right().as_int()}}});
+    }
+}
+
+geom::Region::Region(std::initializer_list<Rectangle> const& rects)
+{
+    for (auto const& rect : rects)
+        unite(rect);
+}
+
+bool geom::Region::empty() const
+{
+    return bands.empty();
+}
+
+bool geom::Region::contains(Rectangle const& rect) const
+{
+    if (rect.size.width <= Width{0} || rect.size.height <= Height{0})
+        return true;
+
+    int const top = rect.top().as_int();
+    int const bottom = rect.bottom().as_int();
+    int const left = rect.left().as_int();
+    int const right = rect.right().as_int();
+
+    auto band = std::find_if(bands.begin(), bands.end(), [top](Band const& b) { return b.bottom > top; });
+    int y = top;
+
+    // The bands must cover [top, bottom) without a gap, each with one span covering [left, right)
+    for (; band != bands.end() && y < bottom; ++band)
+    {
+        if (band->top > y)
+            return false;
+
+        auto const covering = std::find_if(band->spans.begin(), band->spans.end(),
+            [left](Span const& s) { return s.right > left; });
+
+        if (covering == band->spans.end() || covering->left > left || covering->right < right)
+            return false;
+
+        y = band->bottom;
+    }
+
+    return y >= bottom;
+}
+
+bool geom::Region::contains(Point const& point) const
+{
+    return contains(Rectangle{point, {1, 1}});
+}
+
+bool geom::Region::overlaps(Rectangle const& rect) const
+{
+    if (rect.size.width <= Width{0} || rect.size.height <= Height{0})
+        return false;
+
+    int const top = rect.top().as_int();
+    int const bottom = rect.bottom().as_int();
+    int const left = rect.left().as_int();
+    int const right = rect.right().as_int();
+
+    for (auto const& band : bands)
+    {
+        if (band.top >= bottom)
+            break;
+        if (band.bottom <= top)
+            continue;
+
+        for (auto const& span : band.spans)
+        {
+            if (span.left < right && span.right > left)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+geom::Rectangle geom::Region::bounding_rectangle() const
+{
+    if (bands.empty())
+        return {};
+
+    int left = unbounded;
+    int right = std::numeric_limits<int>::min();
+
+    for (auto const& band : bands)
+    {
+        left = std::min(left, band.spans.front().left);
+        right = std::max(right, band.spans.back().right);
+    }
+
+    int const top = bands.front().top;
+    int const bottom = bands.back().bottom;
+
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+std::vector<geom::Rectangle> geom::Region::rectangles() const
+{
+    std::vector<Rectangle> result;
+
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+            result.push_back({{span.left, band.top}, {span.right - span.left, band.bottom - band.top}});
+    }
+
+    return result;
+}
+
+void geom::Region::unite(Rectangle const& rect)
+{
+    unite(Region(rect));
+}
+
+void geom::Region::unite(Region const& other)
+{
+    if (other.empty())
+        return;
+
+    if (empty())
+        bands = other.bands;
+    else
+        bands = combine(bands, other.bands, in_either);
+}
+
+void geom::Region::subtract(Rectangle const& rect)
+{
+    if (overlaps(rect))
+        subtract(Region(rect));
+}
+
+void geom::Region::subtract(Region const& other)
+{
+    if (!empty() && !other.empty())
+        bands = combine(bands, other.bands, in_first_only);
+}
+
+void geom::Region::intersect(Rectangle const& rect)
+{
+    intersect(Region(rect));
+}
+
+void geom::Region::intersect(Region const& other)
+{
+    if (other.empty())
+        bands.clear();
+    else if (!empty())
+        bands = combine(bands, other.bands, in_both);
+}
+
+void geom::Region::translate(Displacement const& displacement)
+{
+    int const dx = displacement.dx.as_int();
+    int const dy = displacement.dy.as_int();
+
+    for (auto& band : bands)
+    {
+        band.top += dy;
+        band.bottom += dy;
+
+        for (auto& span : band.spans)
+        {
+            span.left += dx;
+            span.right += dx;
+        }
+    }
+}
+
+void geom::Region::clear()
+{
+    bands.clear();
+}
+
+bool geom::Region::operator==(Region const& other) const
+{
+    // The representation is canonical, so equal regions have identical bands
+    return std::equal(bands.begin(), bands.end(), other.bands.begin(), other.bands.end(),
+        [](Band const& l, Band const& r)
+        {
+            return l.top == r.top && l.bottom == r.bottom &&
+                std::equal(l.spans.begin(), l.spans.end(), r.spans.begin(), r.spans.end(),
+                    [](Span const& ls, Span const& rs) { return ls.left == rs.left && ls.right == rs.right; });
+        });
+}
+
+bool geom::Region::operator!=(Region const& other) const
+{
+    return !(*this == other);
+}
@@ -20,6 +20,7 @@
 #include "recently_used_cache.h"
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir/renderer/gl/incremental_texture_source.h"
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
@@ -42,9 +43,21 @@ std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const&
 
     if ((texture.last_bound_buffer != buffer_id) || (!texture.valid_binding))
     {
-        texture_source->bind();
+        auto const size = buffer->size();
+        auto const format = buffer->pixel_format();
+        auto const incremental = dynamic_cast<mrgl::IncrementalTextureSource*>(texture_source);
+
+        // The damage is relative to the previous buffer from this renderable, which
+        // a valid binding means is what the texture holds
+        if (incremental && texture.valid_binding && texture.size == size && texture.format == format)
+            incremental->bind_damaged(renderable.damage());
+        else
+            texture_source->bind();
+
         texture.resource = buffer;
         texture.last_bound_buffer = buffer_id;
+        texture.size = size;
+        texture.format = format;
     }
     texture_source->secure_for_render();
 
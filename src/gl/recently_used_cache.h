@@ -24,6 +24,8 @@
 #include "mir/gl/texture.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/renderable.h"
+#include "mir/geometry/size.h"
+#include "mir_toolkit/common.h"
 #include <unordered_map>
 
 namespace mir
@@ -48,6 +50,8 @@ private:
         graphics::BufferID last_bound_buffer;
         bool used{true};
         bool valid_binding{false};
+        geometry::Size size;
+        MirPixelFormat format{mir_pixel_format_invalid};
         std::shared_ptr<graphics::Buffer> resource;
     };
 
@@ -25,6 +25,7 @@
 
 #include <capnp/message.h>
 
+#include <cstddef>
 #include <cstring>
 
 struct MirEvent
@@ -73,10 +74,20 @@ struct MirEvent
     static mir::EventUPtr deserialize(std::string const& bytes);
     static std::string serialize(MirEvent const* event);
 
+    // Events are recycled rather than returned to the heap, as input
+    // events are made and dropped at the rate devices report them
+    static void* operator new(std::size_t size);
+    static void operator delete(void* event, std::size_t size) noexcept;
+
 protected:
     MirEvent() = default;
 
-    ::capnp::MallocMessageBuilder message;
+    // Enough for any input event (even with every touch contact) to be
+    // built without the message allocating segments of its own
+    static std::size_t const inline_words = 128;
+    ::capnp::word inline_segment[inline_words]{};
+
+    ::capnp::MallocMessageBuilder message{kj::arrayPtr(inline_segment, inline_words)};
     mir::capnp::Event::Builder event{message.initRoot<mir::capnp::Event>()};
 };
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_CURSOR_IMAGE_CACHE_H_
+#define MIR_GRAPHICS_CURSOR_IMAGE_CACHE_H_
+
+#include "mir/geometry/size.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class CursorImage;
+
+/// A copy of the pixels of a cursor image
+struct CursorPixels
+{
+    geometry::Size size;
+    std::vector<uint8_t> argb8888;
+};
+
+/**
+ * The pixels of the last few distinct cursor images shown.
+ *
+ * Showing an image that is still cached gives back the same CursorPixels,
+ * so whatever a cursor prepared from them can be reused. Images are looked
+ * up by a hash of their pixels, and only then compared.
+ *
+ * Not thread safe: cursors use it under their own locks.
+ */
+class CursorImageCache
+{
+public:
+    explicit CursorImageCache(size_t capacity);
+
+    std::shared_ptr<CursorPixels const> pixels_of(CursorImage const& image);
+
+private:
+    struct Entry
+    {
+        size_t hash;
+        std::shared_ptr<CursorPixels const> pixels;
+    };
+
+    size_t const capacity;
+    std::vector<Entry> entries;     // The most recently shown last
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_CURSOR_IMAGE_CACHE_H_ */
@@ -0,0 +1,35 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_EXTENSION_LIST_H_
+#define MIR_GRAPHICS_EXTENSION_LIST_H_
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * Whether extension is one of the space separated names in extensions, as
+ * returned by eglQueryString() or glGetString(). Only whole names match, so
+ * "EGL_EXT_buffer_age" is not found in "EGL_EXT_buffer_age_foo".
+ *
+ * A null list (as returned on error) contains no extensions.
+ */
+bool has_extension(char const* extensions, char const* extension);
+}
+}
+
+#endif /* MIR_GRAPHICS_EXTENSION_LIST_H_ */
@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_PIXEL_KERNELS_H_
+#define MIR_GRAPHICS_PIXEL_KERNELS_H_
+
+#include "mir/geometry/dimensions.h"
+#include "mir/geometry/size.h"
+#include "mir_toolkit/common.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * Converting, flipping and rotating pixels on the CPU.
+ *
+ * The kernels are vectorised for the instruction sets the CPU has, picked
+ * when first used. 32-bit pixels are handled as native-endian words, as
+ * MirPixelFormat describes them.
+ */
+namespace pixel
+{
+enum class InstructionSet
+{
+    scalar,
+    sse2,
+    avx2,
+    neon
+};
+
+/// The instruction set the kernels are running with
+InstructionSet instruction_set();
+/// Whether this build of Mir, on this CPU, has kernels for isa
+bool supports(InstructionSet isa);
+/**
+ * Runs the kernels with isa from now on, rather than the best the CPU has.
+ * For tests and benchmarks.
+ *
+ * \throws std::invalid_argument if !supports(isa)
+ */
+void use_instruction_set(InstructionSet isa);
+
+/**
+ * Converts count pixels from one format to another.
+ *
+ * Between the 32-bit formats and from rgb_565 to any of them. Pixels from
+ * a format without alpha become opaque in one with it. src may be dst, if
+ * the formats are the same size.
+ *
+ * \return false, without touching dst, if there is no such conversion
+ */
+bool convert_row(MirPixelFormat from, void const* src, MirPixelFormat to, void* dst, size_t count);
+
+/**
+ * Turns an image upside down in place, converting its pixels as for
+ * convert_row() on the way.
+ *
+ * \throws std::invalid_argument if the formats are not both 32-bit
+ */
+void flip_vertically(
+    void* pixels,
+    geometry::Size const& size,
+    geometry::Stride const& stride,
+    MirPixelFormat from,
+    MirPixelFormat to);
+
+/**
+ * Copies a 32-bit image, rotated as it needs to be scanned out by an output
+ * of the given orientation: mir_orientation_left turns it a quarter
+ * anticlockwise, mir_orientation_right a quarter clockwise.
+ *
+ * \param [in] size     Of src. dst is size.height wide when rotated sideways
+ */
+void rotate(
+    void const* src,
+    geometry::Stride const& src_stride,
+    geometry::Size const& size,
+    void* dst,
+    geometry::Stride const& dst_stride,
+    MirOrientation orientation);
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_PIXEL_KERNELS_H_ */
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_PIXEL_UPLOAD_H_
+#define MIR_GRAPHICS_PIXEL_UPLOAD_H_
+
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/dimensions.h"
+
+#include MIR_SERVER_GL_H
+
+#include <functional>
+#include <vector>
+#include <cstddef>
+
+namespace mir
+{
+namespace graphics
+{
+
+/// A rectangle of pixels to copy from a buffer into a texture
+struct PixelUpload
+{
+    geometry::Rectangle area;   ///< In buffer coordinates
+    size_t offset;              ///< Of the first pixel of area, in bytes from the start of the buffer
+};
+
+/**
+ * Works out what needs copying to bring a texture holding an earlier buffer
+ * up to date with the damaged parts of a new buffer of the same size.
+ *
+ * With GL_UNPACK_ROW_LENGTH (see unpack_row_length_supported()) each damaged
+ * rectangle is copied on its own. Without it only whole rows of a tightly
+ * packed buffer can be copied, so the damage is widened to complete rows.
+ * If neither is possible, the whole buffer is copied.
+ */
+std::vector<PixelUpload> pixel_uploads_for(
+    geometry::Rectangles const& damage,
+    geometry::Size const& size,
+    geometry::Stride const& stride,
+    int bytes_per_pixel,
+    bool row_length_supported);
+
+/**
+ * Brings the bound GL_TEXTURE_2D, which holds an earlier buffer of the same
+ * size, up to date with the damaged parts of pixels (as pixel_uploads_for()
+ * works them out for the current GL context).
+ */
+void upload_damaged_pixels(
+    geometry::Rectangles const& damage,
+    geometry::Size const& size,
+    geometry::Stride const& stride,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    unsigned char const* pixels);
+
+/**
+ * As above, but with the pixels of each upload provided by packed_pixels_of()
+ * in rows of their own, such as after converting them to another format.
+ * Any rectangle can then be uploaded without a row length.
+ */
+void upload_damaged_pixels(
+    geometry::Rectangles const& damage,
+    geometry::Size const& size,
+    geometry::Stride const& stride,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    std::function<void const*(PixelUpload const& upload)> const& packed_pixels_of);
+
+/// Whether the current GL context can take a row length for pixel uploads
+bool unpack_row_length_supported();
+
+/// Whether the current GL context can take pixels in GL_BGRA_EXT order
+bool bgra_texture_format_supported();
+
+}
+}
+
+#endif /* MIR_GRAPHICS_PIXEL_UPLOAD_H_ */
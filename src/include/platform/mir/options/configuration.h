@@ -28,6 +28,7 @@ namespace mir
 namespace options
 {
 extern char const* const wayland_socket_name_opt;
+extern char const* const wayland_shm_direct_opt;
 extern char const* const server_socket_opt;
 extern char const* const prompt_socket_opt;
 extern char const* const no_server_socket_opt;
@@ -52,6 +53,7 @@ extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
 extern char const* const composite_delay_opt;
+extern char const* const batch_gl_draws_opt;
 extern char const* const enable_key_repeat_opt;
 extern char const* const x11_display_opt;
 
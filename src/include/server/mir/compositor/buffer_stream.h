@@ -44,6 +44,16 @@ public:
 
     virtual std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) = 0;
+    /**
+     * The region (in buffer coordinates) of the buffer most recently locked by
+     * user_id that differs from the buffer user_id locked before it.
+     */
+    virtual geometry::Rectangles damage_for_compositor(void const* user_id) const = 0;
+    /**
+     * The opaque region (in buffer coordinates) that was set when the buffer
+     * most recently locked by user_id was submitted.
+     */
+    virtual geometry::Region opaque_region_for_compositor(void const* user_id) const = 0;
     virtual geometry::Size stream_size() = 0;
     virtual int buffers_ready_for_compositor(void const* user_id) const = 0;
     virtual void drop_old_buffers() = 0;
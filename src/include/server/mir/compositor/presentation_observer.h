@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_PRESENTATION_OBSERVER_H_
+#define MIR_COMPOSITOR_PRESENTATION_OBSERVER_H_
+
+#include "mir/graphics/frame.h"
+
+#include <chrono>
+
+namespace mir
+{
+namespace compositor
+{
+/// Identifies a display sync group to PresentationObservers. Only good for comparison.
+typedef void const* DisplayGroupId;
+
+class PresentationObserver
+{
+public:
+    /**
+     * Notification that a group of outputs has put a newly composited frame
+     * on screen.
+     *
+     * This is called once per post() of each display sync group, once the
+     * group reports the frame on screen. That may be after the compositor
+     * has gone on to the next frame, and on another thread.
+     *
+     * \param [in] group    The group whose outputs show the frame
+     * \param [in] frame    The vsync at which the frame reached the screen.
+     *                      If the group's timing is unknown, this is instead
+     *                      when the group reported it.
+     * \param [in] refresh  The time between vsyncs, or zero if unknown.
+     */
+    virtual void frame_presented(
+        DisplayGroupId group,
+        graphics::Frame const& frame,
+        std::chrono::nanoseconds refresh) = 0;
+
+protected:
+    PresentationObserver() = default;
+    virtual ~PresentationObserver() = default;
+    PresentationObserver(PresentationObserver const&) = delete;
+    PresentationObserver& operator=(PresentationObserver const&) = delete;
+};
+
+/**
+ * The group whose frames the calling thread composites, or null if it
+ * isn't a compositor thread.
+ *
+ * Code run as a buffer is consumed can use this to tell which group's
+ * frame_presented() will show it.
+ */
+DisplayGroupId compositing_group();
+}
+}
+
+#endif /* MIR_COMPOSITOR_PRESENTATION_OBSERVER_H_ */
@@ -56,6 +56,7 @@ class Drawer;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class PresentationObserver;
 }
 namespace frontend
 {
@@ -235,6 +236,8 @@ public:
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> the_display_buffer_compositor_factory();
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> wrap_display_buffer_compositor_factory(
         std::shared_ptr<compositor::DisplayBufferCompositorFactory> const& wrapped);
+    std::shared_ptr<ObserverRegistrar<compositor::PresentationObserver>>
+        the_presentation_observer_registrar();
     /** @} */
 
     /** @name compositor configuration - dependencies
@@ -361,6 +364,7 @@ protected:
     std::shared_ptr<graphics::DisplayConfigurationObserver> the_display_configuration_observer();
     std::shared_ptr<input::SeatObserver> the_seat_observer();
     std::shared_ptr<frontend::SessionMediatorObserver> the_session_mediator_observer();
+    std::shared_ptr<compositor::PresentationObserver> the_presentation_observer();
 
     virtual std::shared_ptr<scene::MediatingDisplayChanger> the_mediating_display_changer();
     virtual std::shared_ptr<frontend::ProtobufIpcFactory> new_ipc_factory(
@@ -461,6 +465,8 @@ private:
         seat_observer_multiplexer;
     CachedPtr<ObserverMultiplexer<frontend::SessionMediatorObserver>>
         session_mediator_observer_multiplexer;
+    CachedPtr<ObserverMultiplexer<compositor::PresentationObserver>>
+        presentation_observer_multiplexer;
 
     virtual std::string the_socket_file() const;
 
@@ -62,6 +62,8 @@ void miral::DisplayConfigurationListeners::catastrophic_configuration_error(
 {
 }
 
+void miral::DisplayConfigurationListeners::configuration_timings(mir::graphics::DisplayConfigurationTimings const&) {}
+
 void miral::DisplayConfigurationListeners::base_configuration_updated(std::shared_ptr<mir::graphics::DisplayConfiguration const> const& ) {}
 
 void miral::DisplayConfigurationListeners::session_configuration_applied(std::shared_ptr<mir::frontend::Session> const&,
@@ -51,6 +51,7 @@ private:
         std::shared_ptr<mir::graphics::DisplayConfiguration const> const&,
         std::exception const&) override;
 
+    void configuration_timings(mir::graphics::DisplayConfigurationTimings const&) override;
     void base_configuration_updated(std::shared_ptr<mir::graphics::DisplayConfiguration const> const&) override;
 
     void session_configuration_applied(std::shared_ptr<mir::frontend::Session> const&,
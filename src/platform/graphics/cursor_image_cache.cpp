@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/cursor_image_cache.h"
+#include "mir/graphics/cursor_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mg = mir::graphics;
+
+namespace
+{
+// FNV-1a, a word at a time: cheap, and a collision only costs a comparison
+size_t hash_of(uint8_t const* bytes, size_t count)
+{
+    uint64_t hash = 14695981039346656037ull;
+    uint64_t const prime = 1099511628211ull;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof word);
+        hash = (hash ^ word) * prime;
+    }
+
+    for (; i != count; ++i)
+        hash = (hash ^ bytes[i]) * prime;
+
+    return hash;
+}
+}
+
+mg::CursorImageCache::CursorImageCache(size_t capacity)
+    : capacity{std::max<size_t>(capacity, 1)}
+{
+}
+
+auto mg::CursorImageCache::pixels_of(CursorImage const& image) -> std::shared_ptr<CursorPixels const>
+{
+    auto const size = image.size();
+    auto const argb8888 = static_cast<uint8_t const*>(image.as_argb_8888());
+    size_t const count = size.width.as_uint32_t() * size.height.as_uint32_t() * 4;
+    auto const hash = hash_of(argb8888, count);
+
+    auto const cached = std::find_if(entries.begin(), entries.end(),
+        [&](Entry const& entry)
+        {
+            return entry.hash == hash &&
+                   entry.pixels->size == size &&
+                   memcmp(entry.pixels->argb8888.data(), argb8888, count) == 0;
+        });
+
+    if (cached != entries.end())
+    {
+        std::rotate(cached, cached + 1, entries.end());
+        return entries.back().pixels;
+    }
+
+    if (entries.size() == capacity)
+        entries.erase(entries.begin());
+
+    entries.push_back({hash, std::make_shared<CursorPixels const>(CursorPixels{size, {argb8888, argb8888 + count}})});
+    return entries.back().pixels;
+}
@@ -0,0 +1,766 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_kernels.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MIR_PIXEL_KERNELS_AVX2 1
+#endif
+#if defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#define MIR_PIXEL_KERNELS_NEON 1
+#endif
+
+namespace mgp = mir::graphics::pixel;
+namespace geom = mir::geometry;
+
+namespace
+{
+uint32_t const opaque = 0xff000000;
+
+/*
+ * Each instruction set has a table of these. The conversions may run in
+ * place; the rotations take byte strides and the size of the source.
+ */
+struct Kernels
+{
+    mgp::InstructionSet isa;
+    // dst = src with red and blue exchanged, | fill
+    void (*swap_red_blue)(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill);
+    // dst = src | fill
+    void (*fill)(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill);
+    void (*expand_rgb565)(uint16_t const* src, uint32_t* dst, size_t count);
+    void (*rotate_half)(
+        uint8_t const* src, size_t src_stride, int width, int height,
+        uint8_t* dst, size_t dst_stride);
+    void (*rotate_quarter)(
+        uint8_t const* src, size_t src_stride, int width, int height,
+        uint8_t* dst, size_t dst_stride, bool clockwise);
+};
+
+inline uint32_t swap_red_blue(uint32_t p)
+{
+    return (p & 0xff00ff00) |           /* A and G remain at the same position */
+           ((p << 16) & 0x00ff0000) |   /* Move B to R's position */
+           ((p >> 16) & 0x000000ff);    /* Move R to B's position */
+}
+
+inline uint32_t expand_rgb565(uint16_t p)
+{
+    // Replicating the high bits into the low ones maps full intensity to 0xff
+    uint32_t const r = (p >> 11) & 0x1f;
+    uint32_t const g = (p >> 5) & 0x3f;
+    uint32_t const b = p & 0x1f;
+
+    return opaque | ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+}
+
+inline uint8_t const* pixel_at(uint8_t const* image, size_t stride, int x, int y)
+{
+    return image + y * stride + x * 4;
+}
+
+inline uint8_t* pixel_at(uint8_t* image, size_t stride, int x, int y)
+{
+    return image + y * stride + x * 4;
+}
+
+/*
+ * Rotates the destination rows [row_begin, row_end) and columns
+ * [col_begin, col_end) a pixel at a time. The vectorised rotations use this
+ * for the edges that don't fill a whole block.
+ */
+void rotate_region(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride, MirOrientation orientation,
+    int row_begin, int row_end, int col_begin, int col_end)
+{
+    for (int row = row_begin; row < row_end; ++row)
+    {
+        for (int col = col_begin; col < col_end; ++col)
+        {
+            int x, y;
+            switch (orientation)
+            {
+            case mir_orientation_left:
+                x = width - 1 - row;
+                y = col;
+                break;
+            case mir_orientation_right:
+                x = row;
+                y = height - 1 - col;
+                break;
+            case mir_orientation_inverted:
+                x = width - 1 - col;
+                y = height - 1 - row;
+                break;
+            default:
+                x = col;
+                y = row;
+                break;
+            }
+
+            memcpy(pixel_at(dst, dst_stride, col, row), pixel_at(src, src_stride, x, y), 4);
+        }
+    }
+}
+
+inline MirOrientation quarter(bool clockwise)
+{
+    return clockwise ? mir_orientation_right : mir_orientation_left;
+}
+
+void swap_red_blue_scalar(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    for (size_t n = 0; n != count; ++n)
+        dst[n] = swap_red_blue(src[n]) | fill;
+}
+
+void fill_scalar(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    for (size_t n = 0; n != count; ++n)
+        dst[n] = src[n] | fill;
+}
+
+void expand_rgb565_scalar(uint16_t const* src, uint32_t* dst, size_t count)
+{
+    for (size_t n = 0; n != count; ++n)
+        dst[n] = expand_rgb565(src[n]);
+}
+
+void rotate_half_scalar(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride)
+{
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, mir_orientation_inverted,
+        0, height, 0, width);
+}
+
+void rotate_quarter_scalar(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride, bool clockwise)
+{
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, quarter(clockwise),
+        0, width, 0, height);
+}
+
+Kernels const scalar_kernels{
+    mgp::InstructionSet::scalar,
+    &swap_red_blue_scalar,
+    &fill_scalar,
+    &expand_rgb565_scalar,
+    &rotate_half_scalar,
+    &rotate_quarter_scalar};
+
+/*
+ * Rotates a quarter turn in blocks of 4x4 pixels, each transposed by
+ * transpose(src_rows, dst_rows) from four rows of four source pixels.
+ *
+ * Rotating anticlockwise takes the source rows top down and writes the
+ * transposed rows bottom up; clockwise the other way around.
+ */
+template<void (*transpose)(uint8_t const* const src_rows[4], uint8_t* const dst_rows[4])>
+void rotate_quarter_blocks(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride, bool clockwise)
+{
+    int const rows = width;
+    int const cols = height;
+    int const block_rows = rows & ~3;
+    int const block_cols = cols & ~3;
+
+    for (int row = 0; row != block_rows; row += 4)
+    {
+        for (int col = 0; col != block_cols; col += 4)
+        {
+            uint8_t const* src_rows[4];
+            uint8_t* dst_rows[4];
+
+            for (int i = 0; i != 4; ++i)
+            {
+                if (clockwise)
+                {
+                    src_rows[i] = pixel_at(src, src_stride, row, height - 1 - col - i);
+                    dst_rows[i] = pixel_at(dst, dst_stride, col, row + i);
+                }
+                else
+                {
+                    src_rows[i] = pixel_at(src, src_stride, width - 4 - row, col + i);
+                    dst_rows[i] = pixel_at(dst, dst_stride, col, row + 3 - i);
+                }
+            }
+
+            transpose(src_rows, dst_rows);
+        }
+    }
+
+    auto const orientation = quarter(clockwise);
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, orientation,
+        0, block_rows, block_cols, cols);
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, orientation,
+        block_rows, rows, 0, cols);
+}
+
+#if defined(__SSE2__)
+void swap_red_blue_sse2(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    __m128i const alpha_green = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+    __m128i const red = _mm_set1_epi32(0x00ff0000);
+    __m128i const blue = _mm_set1_epi32(0x000000ff);
+    __m128i const fill_v = _mm_set1_epi32(static_cast<int>(fill));
+
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128i const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n));
+
+        __m128i q = _mm_and_si128(p, alpha_green);
+        q = _mm_or_si128(q, _mm_and_si128(_mm_slli_epi32(p, 16), red));
+        q = _mm_or_si128(q, _mm_and_si128(_mm_srli_epi32(p, 16), blue));
+        q = _mm_or_si128(q, fill_v);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), q);
+    }
+
+    swap_red_blue_scalar(src + n, dst + n, count - n, fill);
+}
+
+void fill_sse2(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    __m128i const fill_v = _mm_set1_epi32(static_cast<int>(fill));
+
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128i const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), _mm_or_si128(p, fill_v));
+    }
+
+    fill_scalar(src + n, dst + n, count - n, fill);
+}
+
+inline __m128i expand_rgb565_sse2(__m128i p)
+{
+    __m128i const r = _mm_srli_epi32(p, 11);
+    __m128i const g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x3f));
+    __m128i const b = _mm_and_si128(p, _mm_set1_epi32(0x1f));
+
+    __m128i const r8 = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+    __m128i const g8 = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4));
+    __m128i const b8 = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+
+    __m128i q = _mm_set1_epi32(static_cast<int>(opaque));
+    q = _mm_or_si128(q, _mm_slli_epi32(r8, 16));
+    q = _mm_or_si128(q, _mm_slli_epi32(g8, 8));
+    return _mm_or_si128(q, b8);
+}
+
+void expand_rgb565_sse2(uint16_t const* src, uint32_t* dst, size_t count)
+{
+    __m128i const zero = _mm_setzero_si128();
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        __m128i const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n));
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + n),
+            expand_rgb565_sse2(_mm_unpacklo_epi16(p, zero)));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + n + 4),
+            expand_rgb565_sse2(_mm_unpackhi_epi16(p, zero)));
+    }
+
+    expand_rgb565_scalar(src + n, dst + n, count - n);
+}
+
+void rotate_half_sse2(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride)
+{
+    int const block_cols = width & ~3;
+
+    for (int row = 0; row != height; ++row)
+    {
+        for (int col = 0; col != block_cols; col += 4)
+        {
+            __m128i const p = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(pixel_at(src, src_stride, width - 4 - col, height - 1 - row)));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(pixel_at(dst, dst_stride, col, row)),
+                _mm_shuffle_epi32(p, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+    }
+
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, mir_orientation_inverted,
+        0, height, block_cols, width);
+}
+
+void transpose_sse2(uint8_t const* const src_rows[4], uint8_t* const dst_rows[4])
+{
+    __m128i const a0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src_rows[0]));
+    __m128i const a1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src_rows[1]));
+    __m128i const a2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src_rows[2]));
+    __m128i const a3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src_rows[3]));
+
+    __m128i const t0 = _mm_unpacklo_epi32(a0, a1);
+    __m128i const t1 = _mm_unpacklo_epi32(a2, a3);
+    __m128i const t2 = _mm_unpackhi_epi32(a0, a1);
+    __m128i const t3 = _mm_unpackhi_epi32(a2, a3);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[0]), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[1]), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[2]), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_rows[3]), _mm_unpackhi_epi64(t2, t3));
+}
+
+Kernels const sse2_kernels{
+    mgp::InstructionSet::sse2,
+    &swap_red_blue_sse2,
+    &fill_sse2,
+    &expand_rgb565_sse2,
+    &rotate_half_sse2,
+    &rotate_quarter_blocks<&transpose_sse2>};
+#endif
+
+#if defined(MIR_PIXEL_KERNELS_AVX2)
+__attribute__((target("avx2")))
+void swap_red_blue_avx2(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    // Each pixel is stored B, G, R, A: exchange the first and third bytes
+    __m256i const order = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    __m256i const fill_v = _mm256_set1_epi32(static_cast<int>(fill));
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256i const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + n));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(dst + n),
+            _mm256_or_si256(_mm256_shuffle_epi8(p, order), fill_v));
+    }
+
+    swap_red_blue_scalar(src + n, dst + n, count - n, fill);
+}
+
+__attribute__((target("avx2")))
+void fill_avx2(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    __m256i const fill_v = _mm256_set1_epi32(static_cast<int>(fill));
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256i const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + n));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), _mm256_or_si256(p, fill_v));
+    }
+
+    fill_scalar(src + n, dst + n, count - n, fill);
+}
+
+__attribute__((target("avx2")))
+void expand_rgb565_avx2(uint16_t const* src, uint32_t* dst, size_t count)
+{
+    __m256i const green_mask = _mm256_set1_epi32(0x3f);
+    __m256i const blue_mask = _mm256_set1_epi32(0x1f);
+    __m256i const alpha = _mm256_set1_epi32(static_cast<int>(opaque));
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        __m256i const p = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n)));
+
+        __m256i const r = _mm256_srli_epi32(p, 11);
+        __m256i const g = _mm256_and_si256(_mm256_srli_epi32(p, 5), green_mask);
+        __m256i const b = _mm256_and_si256(p, blue_mask);
+
+        __m256i const r8 = _mm256_or_si256(_mm256_slli_epi32(r, 3), _mm256_srli_epi32(r, 2));
+        __m256i const g8 = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 4));
+        __m256i const b8 = _mm256_or_si256(_mm256_slli_epi32(b, 3), _mm256_srli_epi32(b, 2));
+
+        __m256i q = _mm256_or_si256(alpha, _mm256_slli_epi32(r8, 16));
+        q = _mm256_or_si256(q, _mm256_slli_epi32(g8, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), _mm256_or_si256(q, b8));
+    }
+
+    expand_rgb565_scalar(src + n, dst + n, count - n);
+}
+
+__attribute__((target("avx2")))
+void rotate_half_avx2(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride)
+{
+    __m256i const reversed = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    int const block_cols = width & ~7;
+
+    for (int row = 0; row != height; ++row)
+    {
+        for (int col = 0; col != block_cols; col += 8)
+        {
+            __m256i const p = _mm256_loadu_si256(
+                reinterpret_cast<__m256i const*>(pixel_at(src, src_stride, width - 8 - col, height - 1 - row)));
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(pixel_at(dst, dst_stride, col, row)),
+                _mm256_permutevar8x32_epi32(p, reversed));
+        }
+    }
+
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, mir_orientation_inverted,
+        0, height, block_cols, width);
+}
+
+/*
+ * An 8x8 transpose takes as many shuffles per pixel as SSE2's 4x4 does, and
+ * quarter turns are only made of cursor sized images, so AVX2 reuses it.
+ */
+Kernels const avx2_kernels{
+    mgp::InstructionSet::avx2,
+    &swap_red_blue_avx2,
+    &fill_avx2,
+    &expand_rgb565_avx2,
+    &rotate_half_avx2,
+    &rotate_quarter_blocks<&transpose_sse2>};
+#endif
+
+#if defined(MIR_PIXEL_KERNELS_NEON)
+void swap_red_blue_neon(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    uint8x16_t const alpha = vdupq_n_u8(fill >> 24);
+
+    size_t n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        // De-interleaved into planes of B, G, R and A
+        uint8x16x4_t p = vld4q_u8(reinterpret_cast<uint8_t const*>(src + n));
+
+        uint8x16_t const b = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = b;
+        p.val[3] = vorrq_u8(p.val[3], alpha);
+
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + n), p);
+    }
+
+    swap_red_blue_scalar(src + n, dst + n, count - n, fill);
+}
+
+void fill_neon(uint32_t const* src, uint32_t* dst, size_t count, uint32_t fill)
+{
+    uint32x4_t const fill_v = vdupq_n_u32(fill);
+
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+        vst1q_u32(dst + n, vorrq_u32(vld1q_u32(src + n), fill_v));
+
+    fill_scalar(src + n, dst + n, count - n, fill);
+}
+
+void expand_rgb565_neon(uint16_t const* src, uint32_t* dst, size_t count)
+{
+    uint16x8_t const green_mask = vdupq_n_u16(0x3f);
+    uint16x8_t const blue_mask = vdupq_n_u16(0x1f);
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        uint16x8_t const p = vld1q_u16(src + n);
+
+        uint16x8_t const r = vshrq_n_u16(p, 11);
+        uint16x8_t const g = vandq_u16(vshrq_n_u16(p, 5), green_mask);
+        uint16x8_t const b = vandq_u16(p, blue_mask);
+
+        uint8x8x4_t q;
+        q.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+        q.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+        q.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+        q.val[3] = vdup_n_u8(0xff);
+
+        vst4_u8(reinterpret_cast<uint8_t*>(dst + n), q);
+    }
+
+    expand_rgb565_scalar(src + n, dst + n, count - n);
+}
+
+void rotate_half_neon(
+    uint8_t const* src, size_t src_stride, int width, int height,
+    uint8_t* dst, size_t dst_stride)
+{
+    int const block_cols = width & ~3;
+
+    for (int row = 0; row != height; ++row)
+    {
+        for (int col = 0; col != block_cols; col += 4)
+        {
+            uint32x4_t const p = vrev64q_u32(vld1q_u32(reinterpret_cast<uint32_t const*>(
+                pixel_at(src, src_stride, width - 4 - col, height - 1 - row))));
+            vst1q_u32(
+                reinterpret_cast<uint32_t*>(pixel_at(dst, dst_stride, col, row)),
+                vcombine_u32(vget_high_u32(p), vget_low_u32(p)));
+        }
+    }
+
+    rotate_region(
+        src, src_stride, width, height, dst, dst_stride, mir_orientation_inverted,
+        0, height, block_cols, width);
+}
+
+void transpose_neon(uint8_t const* const src_rows[4], uint8_t* const dst_rows[4])
+{
+    uint32x4_t const a0 = vld1q_u32(reinterpret_cast<uint32_t const*>(src_rows[0]));
+    uint32x4_t const a1 = vld1q_u32(reinterpret_cast<uint32_t const*>(src_rows[1]));
+    uint32x4_t const a2 = vld1q_u32(reinterpret_cast<uint32_t const*>(src_rows[2]));
+    uint32x4_t const a3 = vld1q_u32(reinterpret_cast<uint32_t const*>(src_rows[3]));
+
+    uint32x4x2_t const t01 = vtrnq_u32(a0, a1);
+    uint32x4x2_t const t23 = vtrnq_u32(a2, a3);
+
+    vst1q_u32(
+        reinterpret_cast<uint32_t*>(dst_rows[0]),
+        vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+    vst1q_u32(
+        reinterpret_cast<uint32_t*>(dst_rows[1]),
+        vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+    vst1q_u32(
+        reinterpret_cast<uint32_t*>(dst_rows[2]),
+        vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+    vst1q_u32(
+        reinterpret_cast<uint32_t*>(dst_rows[3]),
+        vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+}
+
+Kernels const neon_kernels{
+    mgp::InstructionSet::neon,
+    &swap_red_blue_neon,
+    &fill_neon,
+    &expand_rgb565_neon,
+    &rotate_half_neon,
+    &rotate_quarter_blocks<&transpose_neon>};
+#endif
+
+Kernels const* kernels_for(mgp::InstructionSet isa)
+{
+    switch (isa)
+    {
+    case mgp::InstructionSet::scalar:
+        return &scalar_kernels;
+#if defined(__SSE2__)
+    case mgp::InstructionSet::sse2:
+        return &sse2_kernels;
+#endif
+#if defined(MIR_PIXEL_KERNELS_AVX2)
+    case mgp::InstructionSet::avx2:
+        return __builtin_cpu_supports("avx2") ? &avx2_kernels : nullptr;
+#endif
+#if defined(MIR_PIXEL_KERNELS_NEON)
+    case mgp::InstructionSet::neon:
+        return &neon_kernels;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+Kernels const* best_kernels()
+{
+    for (auto isa : {mgp::InstructionSet::avx2, mgp::InstructionSet::sse2, mgp::InstructionSet::neon})
+    {
+        if (auto const kernels = kernels_for(isa))
+            return kernels;
+    }
+
+    return &scalar_kernels;
+}
+
+std::atomic<Kernels const*> active_kernels{nullptr};
+
+Kernels const& kernels()
+{
+    auto result = active_kernels.load(std::memory_order_relaxed);
+
+    // Racing threads would all pick the same
+    if (!result)
+    {
+        result = best_kernels();
+        active_kernels.store(result, std::memory_order_relaxed);
+    }
+
+    return *result;
+}
+
+bool is_rgb_order(MirPixelFormat format)
+{
+    return format == mir_pixel_format_argb_8888 || format == mir_pixel_format_xrgb_8888;
+}
+
+bool is_bgr_order(MirPixelFormat format)
+{
+    return format == mir_pixel_format_abgr_8888 || format == mir_pixel_format_xbgr_8888;
+}
+
+bool has_alpha(MirPixelFormat format)
+{
+    return format == mir_pixel_format_argb_8888 || format == mir_pixel_format_abgr_8888;
+}
+}
+
+mgp::InstructionSet mgp::instruction_set()
+{
+    return kernels().isa;
+}
+
+bool mgp::supports(InstructionSet isa)
+{
+    return kernels_for(isa) != nullptr;
+}
+
+void mgp::use_instruction_set(InstructionSet isa)
+{
+    auto const chosen = kernels_for(isa);
+    if (!chosen)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Pixel kernels not available for instruction set"));
+
+    active_kernels.store(chosen, std::memory_order_relaxed);
+}
+
+bool mgp::convert_row(MirPixelFormat from, void const* src, MirPixelFormat to, void* dst, size_t count)
+{
+    auto const& k = kernels();
+    auto const dst_pixels = static_cast<uint32_t*>(dst);
+
+    if (from == mir_pixel_format_rgb_565 && (is_rgb_order(to) || is_bgr_order(to)))
+    {
+        k.expand_rgb565(static_cast<uint16_t const*>(src), dst_pixels, count);
+        if (is_bgr_order(to))
+            k.swap_red_blue(dst_pixels, dst_pixels, count, 0);
+        return true;
+    }
+
+    bool const from_rgb = is_rgb_order(from);
+    if (!(from_rgb || is_bgr_order(from)) || !(is_rgb_order(to) || is_bgr_order(to)))
+        return false;
+
+    auto const src_pixels = static_cast<uint32_t const*>(src);
+    uint32_t const fill = !has_alpha(from) && has_alpha(to) ? opaque : 0;
+
+    if (from_rgb != is_rgb_order(to))
+        k.swap_red_blue(src_pixels, dst_pixels, count, fill);
+    else if (fill)
+        k.fill(src_pixels, dst_pixels, count, fill);
+    else if (src != dst)
+        memmove(dst, src, count * 4);
+
+    return true;
+}
+
+void mgp::flip_vertically(
+    void* pixels,
+    geom::Size const& size,
+    geom::Stride const& stride,
+    MirPixelFormat from,
+    MirPixelFormat to)
+{
+    if (MIR_BYTES_PER_PIXEL(from) != 4 || MIR_BYTES_PER_PIXEL(to) != 4)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Can only flip 32-bit pixels"));
+
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_int();
+    auto const stride_bytes = stride.as_uint32_t();
+    auto const base = static_cast<uint8_t*>(pixels);
+
+    std::vector<uint32_t> line(width);
+
+    for (int top = 0, bottom = height - 1; top < bottom; ++top, --bottom)
+    {
+        auto const top_line = base + top * stride_bytes;
+        auto const bottom_line = base + bottom * stride_bytes;
+
+        if (!convert_row(from, bottom_line, to, line.data(), width))
+            BOOST_THROW_EXCEPTION(std::invalid_argument("Unsupported pixel format conversion"));
+        convert_row(from, top_line, to, bottom_line, width);
+        memcpy(top_line, line.data(), width * 4);
+    }
+
+    // The middle line of an odd height only needs converting
+    if (height % 2 == 1)
+    {
+        auto const middle_line = base + (height / 2) * stride_bytes;
+        if (!convert_row(from, middle_line, to, middle_line, width))
+            BOOST_THROW_EXCEPTION(std::invalid_argument("Unsupported pixel format conversion"));
+    }
+}
+
+void mgp::rotate(
+    void const* src,
+    geom::Stride const& src_stride,
+    geom::Size const& size,
+    void* dst,
+    geom::Stride const& dst_stride,
+    MirOrientation orientation)
+{
+    auto const& k = kernels();
+    auto const src_bytes = static_cast<uint8_t const*>(src);
+    auto const dst_bytes = static_cast<uint8_t*>(dst);
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+
+    switch (orientation)
+    {
+    case mir_orientation_left:
+    case mir_orientation_right:
+        k.rotate_quarter(
+            src_bytes, src_stride.as_uint32_t(), width, height,
+            dst_bytes, dst_stride.as_uint32_t(), orientation == mir_orientation_right);
+        break;
+
+    case mir_orientation_inverted:
+        k.rotate_half(
+            src_bytes, src_stride.as_uint32_t(), width, height,
+            dst_bytes, dst_stride.as_uint32_t());
+        break;
+
+    default:
+        for (int row = 0; row != height; ++row)
+        {
+            memcpy(
+                dst_bytes + row * dst_stride.as_uint32_t(),
+                src_bytes + row * src_stride.as_uint32_t(),
+                width * 4);
+        }
+        break;
+    }
+}
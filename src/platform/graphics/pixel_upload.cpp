@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_upload.h"
+#include "mir/graphics/extension_list.h"
+
+#include MIR_SERVER_GL_H
+#include MIR_SERVER_GLEXT_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH GL_UNPACK_ROW_LENGTH_EXT
+#endif
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Beyond this the per-call overhead outweighs uploading the pixels in between
+size_t const max_uploads = 8;
+
+void upload(geom::Rectangle const& area, GLenum format, GLenum type, void const* pixels)
+{
+    // The texture storage is reused, only the changed pixels are replaced
+    glTexSubImage2D(GL_TEXTURE_2D, 0,
+                    area.left().as_int(), area.top().as_int(),
+                    area.size.width.as_int(), area.size.height.as_int(),
+                    format, type, pixels);
+}
+}
+
+std::vector<mg::PixelUpload> mg::pixel_uploads_for(
+    geom::Rectangles const& damage,
+    geom::Size const& size,
+    geom::Stride const& stride,
+    int bytes_per_pixel,
+    bool row_length_supported)
+{
+    geom::Rectangle const whole_buffer{{}, size};
+
+    geom::Rectangles areas;
+    for (auto const& rect : damage)
+    {
+        auto const area = rect.intersection_with(whole_buffer);
+        if (area.size.width.as_int() > 0 && area.size.height.as_int() > 0)
+            areas.add(area);
+    }
+
+    if (areas.size() == 0)
+        return {};
+
+    if (areas.size() > max_uploads)
+        areas = {areas.bounding_rectangle()};
+
+    auto const stride_bytes = stride.as_int();
+    std::vector<PixelUpload> uploads;
+
+    if (row_length_supported && stride_bytes % bytes_per_pixel == 0)
+    {
+        for (auto const& area : areas)
+        {
+            uploads.push_back({
+                area,
+                size_t(area.top().as_int()) * stride_bytes +
+                size_t(area.left().as_int()) * bytes_per_pixel});
+        }
+    }
+    else if (stride_bytes == size.width.as_int() * bytes_per_pixel)
+    {
+        std::vector<std::pair<int, int>> rows;
+        for (auto const& area : areas)
+            rows.emplace_back(area.top().as_int(), area.bottom().as_int());
+
+        std::sort(rows.begin(), rows.end());
+
+        for (auto const& span : rows)
+        {
+            if (!uploads.empty() && span.first <= uploads.back().area.bottom().as_int())
+            {
+                auto& last = uploads.back().area;
+                auto const bottom = std::max(last.bottom().as_int(), span.second);
+                last.size.height = geom::Height{bottom - last.top().as_int()};
+            }
+            else
+            {
+                uploads.push_back({
+                    {{0, span.first}, {size.width, geom::Height{span.second - span.first}}},
+                    size_t(span.first) * stride_bytes});
+            }
+        }
+    }
+    else
+    {
+        uploads.push_back({whole_buffer, 0});
+    }
+
+    return uploads;
+}
+
+void mg::upload_damaged_pixels(
+    geom::Rectangles const& damage,
+    geom::Size const& size,
+    geom::Stride const& stride,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    unsigned char const* pixels)
+{
+    auto const row_length = unpack_row_length_supported();
+    auto const uploads = pixel_uploads_for(damage, size, stride, bytes_per_pixel, row_length);
+
+    /*
+     * Strides are whole multiples of pixels, but not always of the 4 bytes
+     * OpenGL expects by default.
+     */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (row_length)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, stride.as_int() / bytes_per_pixel);
+
+    for (auto const& u : uploads)
+        upload(u.area, format, type, pixels + u.offset);
+
+    if (row_length)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void mg::upload_damaged_pixels(
+    geom::Rectangles const& damage,
+    geom::Size const& size,
+    geom::Stride const& stride,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    std::function<void const*(PixelUpload const& upload)> const& packed_pixels_of)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (auto const& u : pixel_uploads_for(damage, size, stride, bytes_per_pixel, true))
+        upload(u.area, format, type, packed_pixels_of(u));
+}
+
+bool mg::unpack_row_length_supported()
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (!version)
+        return false;
+
+    // Desktop GL has always had it; GLES gained it in 3.0
+    static char const gles_prefix[] = "OpenGL ES ";
+    if (strncmp(version, gles_prefix, sizeof(gles_prefix) - 1) != 0 ||
+        atoi(version + sizeof(gles_prefix) - 1) >= 3)
+    {
+        return true;
+    }
+
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    return mg::has_extension(extensions, "GL_EXT_unpack_subimage");
+}
+
+bool mg::bgra_texture_format_supported()
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+
+    // Desktop GL has always had it, and without a context to ask we keep to that
+    static char const gles_prefix[] = "OpenGL ES ";
+    if (!version || strncmp(version, gles_prefix, sizeof(gles_prefix) - 1) != 0)
+        return true;
+
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    return mg::has_extension(extensions, "GL_EXT_texture_format_BGRA8888");
+}
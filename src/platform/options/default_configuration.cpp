@@ -28,6 +28,7 @@
 namespace mo = mir::options;
 
 char const* const mo::wayland_socket_name_opt     = "wayland-socket-name";
+char const* const mo::wayland_shm_direct_opt      = "wayland-shm-direct";
 char const* const mo::server_socket_opt           = "file,f";
 char const* const mo::prompt_socket_opt           = "prompt-file,p";
 char const* const mo::no_server_socket_opt        = "no-file";
@@ -54,6 +55,7 @@ char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
+char const* const mo::batch_gl_draws_opt          = "batch-gl-draws";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
 char const* const mo::x11_display_opt             = "display";
 
@@ -145,6 +147,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
     add_options()
         (wayland_socket_name_opt, po::value<std::string>(),
          "Overrides the default socket name used for communicating with clients")
+        (wayland_shm_direct_opt, po::value<bool>()->default_value(false),
+         "Read Wayland shm buffers from the client's memory as they are composited, "
+         "instead of copying each one when it is committed")
         (host_socket_opt, po::value<std::string>(),
             "Host socket filename")
         (server_socket_opt, po::value<std::string>()->default_value(::mir::default_server_socket),
@@ -152,6 +157,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (no_server_socket_opt, "Do not provide a socket filename for client connections")
         (arw_server_socket_opt, "Make socket filename globally rw (equivalent to chmod a=rw)")
         (prompt_socket_opt, "Provide a \"..._trusted\" filename for prompt helper connections")
+        (frontend_threads_opt, po::value<int>()->default_value(1),
+            "Number of threads handling client IPC. Each client is only ever "
+            "handled on one of them.")
         (platform_graphics_lib, po::value<std::string>(),
             "Library to use for platform graphics support (default: autodetect)")
         (platform_input_lib, po::value<std::string>(),
@@ -187,6 +195,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "frames from clients before compositing). Higher values result in "
             "lower latency but risk causing frame skipping. "
             "Default: A negative value means decide automatically.")
+        (batch_gl_draws_opt, po::value<bool>()->default_value(false),
+            "Draw each frame from one vertex buffer, in as few GL draw calls as "
+            "the stacking of surfaces allows, instead of one or more per surface")
         (name_opt, po::value<std::string>(),
             "When nested, the name Mir uses when registering with the host.")
         (nested_passthrough_opt, po::value<bool>()->default_value(true),
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms_plane.h"
+#include "drm_mode_resources.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace mgk = mir::graphics::kms;
+
+namespace
+{
+mgk::Plane::Type type_of(int drm_fd, mgk::DRMModePlaneUPtr const& plane)
+{
+    mgk::ObjectProperties const properties{drm_fd, plane};
+
+    // Without universal planes every plane the kernel shows us is an overlay
+    if (!properties.has_property("type"))
+        return mgk::Plane::Type::overlay;
+
+    switch (properties["type"])
+    {
+    case DRM_PLANE_TYPE_PRIMARY:
+        return mgk::Plane::Type::primary;
+    case DRM_PLANE_TYPE_CURSOR:
+        return mgk::Plane::Type::cursor;
+    default:
+        return mgk::Plane::Type::overlay;
+    }
+}
+}
+
+bool mgk::Plane::can_be_used_on(int crtc_index) const
+{
+    return crtc_index >= 0 && crtc_index < 32 && (possible_crtcs & (1u << crtc_index));
+}
+
+bool mgk::Plane::supports(uint32_t format) const
+{
+    return std::find(formats.begin(), formats.end(), format) != formats.end();
+}
+
+std::vector<mgk::Plane> mgk::enumerate_planes(int drm_fd)
+{
+    /*
+     * Failing this just means we only get to see the overlay planes;
+     * they're still usable.
+     */
+    drmSetClientCap(drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+
+    std::vector<Plane> planes;
+    try
+    {
+        PlaneResources const resources{drm_fd};
+
+        for (auto& plane : resources.planes())
+        {
+            planes.push_back(Plane{
+                plane->plane_id,
+                type_of(drm_fd, plane),
+                plane->possible_crtcs,
+                {plane->formats, plane->formats + plane->count_formats}});
+        }
+    }
+    catch (std::exception const&)
+    {
+        // Planes are an optimisation; without them everything is composited
+        planes.clear();
+    }
+
+    return planes;
+}
+
+int mgk::crtc_index(int drm_fd, uint32_t crtc_id)
+{
+    DRMModeResources const resources{drm_fd};
+
+    int index = 0;
+    int found = -1;
+    resources.for_each_crtc(
+        [&](DRMModeCrtcUPtr crtc)
+        {
+            if (crtc->crtc_id == crtc_id)
+                found = index;
+            ++index;
+        });
+
+    return found;
+}
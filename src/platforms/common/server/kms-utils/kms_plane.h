@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_COMMON_KMS_UTILS_KMS_PLANE_H_
+#define MIR_GRAPHICS_COMMON_KMS_UTILS_KMS_PLANE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace kms
+{
+
+/**
+ * A hardware plane, as described by the universal planes API.
+ */
+struct Plane
+{
+    enum class Type
+    {
+        overlay,
+        primary,
+        cursor
+    };
+
+    uint32_t id;
+    Type type;
+    uint32_t possible_crtcs;        ///< Bitmask of CRTC indices (not IDs) this plane can be used on
+    std::vector<uint32_t> formats;  ///< DRM fourcc formats this plane can scan out
+
+    bool can_be_used_on(int crtc_index) const;
+    bool supports(uint32_t format) const;
+};
+
+/**
+ * Lists every plane of the DRM device, including the primary and cursor
+ * planes that are implicit in the legacy modesetting API.
+ *
+ * This enables DRM_CLIENT_CAP_UNIVERSAL_PLANES on drm_fd.
+ *
+ * \return  The planes, or an empty list if the kernel or driver can't
+ *          describe them.
+ */
+std::vector<Plane> enumerate_planes(int drm_fd);
+
+/**
+ * Finds the index of a CRTC in the device's resources, as used by the
+ * possible_crtcs masks of planes and encoders.
+ *
+ * \return  The index, or -1 if crtc_id isn't a CRTC of this device.
+ */
+int crtc_index(int drm_fd, uint32_t crtc_id);
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_COMMON_KMS_UTILS_KMS_PLANE_H_ */
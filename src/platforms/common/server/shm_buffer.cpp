@@ -18,6 +18,8 @@
  */
 
 #include "mir/graphics/gl_format.h"
+#include "mir/graphics/pixel_kernels.h"
+#include "mir/graphics/pixel_upload.h"
 #include "mir/shm_file.h"
 #include "shm_buffer.h"
 #include "buffer_texture_binder.h"
@@ -36,6 +38,15 @@ namespace mg=mir::graphics;
 namespace mgc = mir::graphics::common;
 namespace geom = mir::geometry;
 
+namespace
+{
+// GLES only takes BGRA pixels with an extension, without it they are swizzled on the CPU
+bool needs_rgba_conversion(GLenum gl_format)
+{
+    return gl_format == GL_BGRA_EXT && !mg::bgra_texture_format_supported();
+}
+}
+
 bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
                          GLenum& gl_format, GLenum& gl_type)
 {
@@ -136,12 +147,40 @@ void mgc::ShmBuffer::gl_bind_to_texture()
          */
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        glTexImage2D(GL_TEXTURE_2D, 0, format,
-                     size_.width.as_int(), size_.height.as_int(),
-                     0, format, type, pixels);
+        if (needs_rgba_conversion(format))
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                         size_.width.as_int(), size_.height.as_int(),
+                         0, GL_RGBA, type, converted_to_rgba({{}, size_}, 0));
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, format,
+                         size_.width.as_int(), size_.height.as_int(),
+                         0, format, type, pixels);
+        }
     }
 }
 
+void const* mgc::ShmBuffer::converted_to_rgba(geom::Rectangle const& area, size_t offset)
+{
+    auto const width = area.size.width.as_int();
+    auto const height = area.size.height.as_int();
+    auto const src = static_cast<unsigned char const*>(pixels) + offset;
+
+    rgba_pixels.resize(width * height);
+
+    for (int row = 0; row != height; ++row)
+    {
+        mg::pixel::convert_row(
+            pixel_format_, src + row * stride_.as_int(),
+            mir_pixel_format_abgr_8888, rgba_pixels.data() + row * width,
+            width);
+    }
+
+    return rgba_pixels.data();
+}
+
 std::shared_ptr<MirBufferPackage> mgc::ShmBuffer::to_mir_buffer_package() const
 {
     auto native_buffer = std::make_shared<MirNativeBuffer>();
@@ -184,6 +223,28 @@ void mgc::ShmBuffer::secure_for_render()
 {
 }
 
+void mgc::ShmBuffer::bind_damaged(geom::Rectangles const& damage)
+{
+    GLenum format, type;
+
+    if (mg::get_gl_pixel_format(pixel_format_, format, type))
+    {
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format_);
+
+        if (needs_rgba_conversion(format))
+        {
+            mg::upload_damaged_pixels(
+                damage, size_, stride_, bytes_per_pixel, GL_RGBA, type,
+                [this](mg::PixelUpload const& upload) { return converted_to_rgba(upload.area, upload.offset); });
+        }
+        else
+        {
+            mg::upload_damaged_pixels(
+                damage, size_, stride_, bytes_per_pixel, format, type, static_cast<unsigned char const*>(pixels));
+        }
+    }
+}
+
 void mir::graphics::common::ShmBuffer::bind_for_write()
 {
     gl_bind_to_texture();
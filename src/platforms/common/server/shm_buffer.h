@@ -25,10 +25,13 @@
 #include "mir/geometry/size.h"
 #include "mir_toolkit/common.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir/renderer/gl/incremental_texture_source.h"
 #include "mir/renderer/gl/texture_target.h"
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 
+#include <vector>
+
 namespace mir
 {
 class ShmFile;
@@ -41,6 +44,7 @@ namespace common
 
 class ShmBuffer : public BufferBasic, public NativeBufferBase,
                   public renderer::gl::TextureSource,
+                  public renderer::gl::IncrementalTextureSource,
                   public renderer::gl::TextureTarget,
                   public renderer::software::PixelSource
 {
@@ -55,6 +59,7 @@ public:
     void gl_bind_to_texture() override;
     void bind() override;
     void secure_for_render() override;
+    void bind_damaged(geometry::Rectangles const& damage) override;
     void write(unsigned char const* data, size_t size) override;
     void read(std::function<void(unsigned char const*)> const& do_with_pixels) override;
     NativeBufferBase* native_buffer_base() override;
@@ -76,11 +81,15 @@ private:
     ShmBuffer(ShmBuffer const&) = delete;
     ShmBuffer& operator=(ShmBuffer const&) = delete;
 
+    /// The pixels of area, starting offset bytes in, as tightly packed abgr_8888
+    void const* converted_to_rgba(geometry::Rectangle const& area, size_t offset);
+
     std::unique_ptr<ShmFile> const shm_file;
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
     geometry::Stride const stride_;
     void* const pixels;
+    std::vector<uint32_t> rgba_pixels;
 };
 
 }
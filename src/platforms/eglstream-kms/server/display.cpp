@@ -225,11 +225,28 @@ public:
     {
     }
 
+    int buffer_age() override
+    {
+        // Stream producer surfaces don't promise to preserve previous frames
+        return 0;
+    }
+
     std::chrono::milliseconds recommended_sleep() const override
     {
         return std::chrono::milliseconds{0};
     }
 
+    mg::Frame last_frame() const override
+    {
+        return {};
+    }
+
+    std::chrono::nanoseconds frame_interval() const override
+    {
+        // The EGLStream consumer does the flipping, so we don't see vsync
+        return std::chrono::nanoseconds::zero();
+    }
+
 private:
     EGLDisplay dpy;
     EGLContext ctx;
@@ -27,6 +27,7 @@
 #include "mir/libname.h"
 #include "mir/log.h"
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/extension_list.h"
 #include "one_shot_device_observer.h"
 
 #include <boost/throw_exception.hpp>
@@ -62,11 +63,7 @@ EGLDeviceEXT find_device()
         [](EGLDeviceEXT device)
         {
             auto device_extensions = eglQueryDeviceStringEXT(device, EGL_EXTENSIONS);
-            if (device_extensions)
-            {
-                return strstr(device_extensions, "EGL_EXT_device_drm") != NULL;
-            }
-            return false;
+            return mg::has_extension(device_extensions, "EGL_EXT_device_drm");
         });
 
     if (device == (devices.get() + device_count))
@@ -168,9 +165,7 @@ mg::PlatformPriority probe_graphics_platform(
             {
                 mir::log_debug("Found EGLDeviceEXT with device extensions: %s",
                                device_extensions);
-                // TODO: This test is not strictly correct (will incorrectly match
-                // EGL_EXT_device_drmish_but_not_drm)
-                if (strstr(device_extensions, "EGL_EXT_device_drm") != NULL)
+                if (mg::has_extension(device_extensions, "EGL_EXT_device_drm"))
                 {
                     // Check we can acquire the device...
                     mir::Fd drm_fd;
@@ -78,7 +78,11 @@ public:
 
     void gl_bind_to_texture() override
     {
-        ensure_egl_image();
+        {
+            // Outputs composited in parallel may bind the same buffer at once
+            std::lock_guard<std::mutex> lock{egl_image_mutex};
+            ensure_egl_image();
+        }
 
         egl_extensions->glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, egl_image);
     }
@@ -86,6 +90,7 @@ public:
 protected:
     virtual void ensure_egl_image() = 0;
 
+    std::mutex egl_image_mutex;
     std::shared_ptr<gbm_bo> const bo;
     std::shared_ptr<mg::EGLExtensions> const egl_extensions;
     EGLDisplay egl_display;
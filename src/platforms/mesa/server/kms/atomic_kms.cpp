@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_kms.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <xf86drm.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace mgm = mir::graphics::mesa;
+namespace mgk = mir::graphics::kms;
+
+bool mgm::enable_atomic_kms(int drm_fd)
+{
+#if DRM_EVENT_CONTEXT_VERSION >= 3 && defined(DRM_CAP_CRTC_IN_VBLANK_EVENT)
+    uint64_t crtc_in_event = 0;
+    if (drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, &crtc_in_event) || !crtc_in_event)
+        return false;
+
+    return drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0;
+#else
+    (void)drm_fd;
+    return false;
+#endif
+}
+
+mgm::PropertyCache::PropertyCache(int drm_fd)
+    : drm_fd{drm_fd}
+{
+}
+
+uint32_t mgm::PropertyCache::id_for(uint32_t object_id, uint32_t object_type, char const* property_name)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // KMS object IDs are unique across all types of object
+    auto& properties = objects[object_id];
+    if (!properties)
+        properties = std::make_unique<kms::ObjectProperties>(drm_fd, object_id, object_type);
+
+    return properties->id_for(property_name);
+}
+
+mgm::AtomicUpdate::AtomicUpdate(int drm_fd, std::shared_ptr<PropertyCache> const& properties)
+    : drm_fd_{drm_fd},
+      properties{properties},
+      request{drmModeAtomicAlloc(), &drmModeAtomicFree}
+{
+    if (!request)
+        BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+}
+
+mgm::AtomicUpdate::~AtomicUpdate()
+{
+    // Any commit holds its own references to the blobs
+    for (auto blob : blobs)
+        drmModeDestroyPropertyBlob(drm_fd_, blob);
+}
+
+int mgm::AtomicUpdate::drm_fd() const
+{
+    return drm_fd_;
+}
+
+void mgm::AtomicUpdate::set(
+    uint32_t object_id,
+    uint32_t object_type,
+    char const* property_name,
+    uint64_t value)
+{
+    auto const property_id = properties->id_for(object_id, object_type, property_name);
+
+    if (drmModeAtomicAddProperty(request.get(), object_id, property_id, value) < 0)
+        BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+}
+
+uint32_t mgm::AtomicUpdate::mode_blob(drmModeModeInfo const& mode)
+{
+    uint32_t blob_id;
+    if (drmModeCreatePropertyBlob(drm_fd_, &mode, sizeof mode, &blob_id))
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{errno, std::system_category(), "Failed to create DRM mode blob"}));
+    }
+
+    blobs.push_back(blob_id);
+    return blob_id;
+}
+
+void mgm::AtomicUpdate::add_flip(uint32_t crtc_id, uint32_t connector_id)
+{
+    flips_.push_back({crtc_id, connector_id});
+}
+
+auto mgm::AtomicUpdate::flips() const -> std::vector<Flip> const&
+{
+    return flips_;
+}
+
+bool mgm::AtomicUpdate::test(uint32_t flags) const
+{
+    return commit(flags | DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+int mgm::AtomicUpdate::commit(uint32_t flags, void* user_data) const
+{
+    if (drmModeAtomicCommit(drm_fd_, request.get(), flags, user_data))
+        return errno ? -errno : -EINVAL;
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_ATOMIC_KMS_H_
+#define MIR_GRAPHICS_MESA_ATOMIC_KMS_H_
+
+#include "kms-utils/drm_mode_resources.h"
+
+#include <xf86drmMode.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+/**
+ * Enables atomic modesetting on drm_fd, if the kernel, driver and the
+ * libdrm we were built against all support it.
+ *
+ * Atomic page flips complete with an event per CRTC, so this also requires
+ * the kernel to tell us which CRTC each event is for.
+ *
+ * \return  true if atomic updates can be used on drm_fd
+ */
+bool enable_atomic_kms(int drm_fd);
+
+/**
+ * The property IDs of the KMS objects of a device.
+ *
+ * These don't change while the device is open, so each object's are only
+ * looked up once.
+ */
+class PropertyCache
+{
+public:
+    PropertyCache(int drm_fd);
+
+    /// \throws std::out_of_range if the object has no such property
+    uint32_t id_for(uint32_t object_id, uint32_t object_type, char const* property_name);
+
+private:
+    int const drm_fd;
+    std::mutex mutex;
+    std::unordered_map<uint32_t, std::unique_ptr<kms::ObjectProperties>> objects;
+};
+
+/**
+ * A set of property changes to KMS objects, applied all at once by an
+ * atomic commit.
+ */
+class AtomicUpdate
+{
+public:
+    AtomicUpdate(int drm_fd, std::shared_ptr<PropertyCache> const& properties);
+    ~AtomicUpdate();
+
+    AtomicUpdate(AtomicUpdate const&) = delete;
+    AtomicUpdate& operator=(AtomicUpdate const&) = delete;
+
+    int drm_fd() const;
+
+    /// \throws std::out_of_range if the object has no such property
+    void set(uint32_t object_id, uint32_t object_type, char const* property_name, uint64_t value);
+    /// A property blob for mode, valid for the lifetime of this update
+    uint32_t mode_blob(drmModeModeInfo const& mode);
+
+    /// Records that committing this update flips crtc_id, which drives connector_id
+    void add_flip(uint32_t crtc_id, uint32_t connector_id);
+    struct Flip
+    {
+        uint32_t crtc_id;
+        uint32_t connector_id;
+    };
+    std::vector<Flip> const& flips() const;
+
+    /// Asks the driver whether it would accept this update, without applying it
+    bool test(uint32_t flags) const;
+    /// \return 0 on success, or a negative errno value
+    int commit(uint32_t flags, void* user_data) const;
+
+private:
+    int const drm_fd_;
+    std::shared_ptr<PropertyCache> const properties;
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)> const request;
+    std::vector<uint32_t> blobs;
+    std::vector<Flip> flips_;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_ATOMIC_KMS_H_ */
@@ -23,11 +23,13 @@
 #include "kms_display_configuration.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/graphics/cursor_image.h"
+#include "mir/graphics/pixel_kernels.h"
 
 #include <xf86drm.h>
 
 #include <boost/exception/errinfo_errno.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 
@@ -40,6 +42,11 @@ namespace
 const uint64_t fallback_cursor_size = 64;
 char const* const mir_drm_cursor_64x64 = "MIR_DRM_CURSOR_64x64";
 
+// Enough for the cursors an application switches between, such as the
+// pointer and text cursors, in a couple of orientations
+size_t const cached_cursor_images = 16;
+size_t const max_cursor_buffers = 8;
+
 // Transforms a relative position within the display bounds described by \a rect which is rotated with \a orientation
 geom::Displacement transform(geom::Rectangle const& rect, geom::Displacement const& vector, MirOrientation orientation)
 {
@@ -97,51 +104,100 @@ gbm_device* gbm_create_device_checked(int fd)
     }
     return device;
 }
+
+gbm_bo* gbm_bo_create_checked(gbm_device* device, uint32_t width, uint32_t height)
+{
+    auto buffer = gbm_bo_create(
+        device,
+        width,
+        height,
+        GBM_FORMAT_ARGB8888,
+        GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE);
+    if (!buffer)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("failed to create gbm buffer"));
+    }
+    return buffer;
+}
 }
 
 mgm::Cursor::GBMBOWrapper::GBMBOWrapper(int fd, MirOrientation orientation) :
     device{gbm_create_device_checked(fd)},
-    buffer{
-        gbm_bo_create(
-            device,
-            get_drm_cursor_width(fd),
-            get_drm_cursor_height(fd),
-            GBM_FORMAT_ARGB8888,
-            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)},
-    current_orientation{orientation}
+    width(get_drm_cursor_width(fd)),
+    height(get_drm_cursor_height(fd))
 {
-    if (!buffer) BOOST_THROW_EXCEPTION(std::runtime_error("failed to create gbm buffer"));
+    try
+    {
+        slots.push_back({gbm_bo_create_checked(device, width, height), nullptr, orientation});
+    }
+    catch (...)
+    {
+        gbm_device_destroy(device);
+        throw;
+    }
 }
 
 inline mgm::Cursor::GBMBOWrapper::operator gbm_bo*()
 {
-    return buffer;
+    return slots.back().buffer;
 }
 
 inline mgm::Cursor::GBMBOWrapper::~GBMBOWrapper()
 {
+    for (auto const& slot : slots)
+        gbm_bo_destroy(slot.buffer);
     if (device)
         gbm_device_destroy(device);
-    if (buffer)
-        gbm_bo_destroy(buffer);
 }
 
 mgm::Cursor::GBMBOWrapper::GBMBOWrapper(GBMBOWrapper&& from)
     : device{from.device},
-      buffer{from.buffer},
-      current_orientation{from.current_orientation}
+      width{from.width},
+      height{from.height},
+      slots{std::move(from.slots)}
 {
-    from.buffer = nullptr;
+    from.slots.clear();
     from.device = nullptr;
 }
 
-auto mir::graphics::mesa::Cursor::GBMBOWrapper::change_orientation(MirOrientation new_orientation) -> bool
+auto mgm::Cursor::GBMBOWrapper::select(
+    std::shared_ptr<CursorPixels const> const& image,
+    MirOrientation orientation) -> Selection
 {
-    if (current_orientation == new_orientation)
-        return false;
+    auto const holds_image = [&](Slot const& slot)
+        {
+            return slot.image == image && slot.orientation == orientation;
+        };
+
+    if (holds_image(slots.back()))
+        return Selection::unchanged;
 
-    current_orientation = new_orientation;
-    return true;
+    auto slot = std::find_if(slots.begin(), slots.end(), holds_image);
+    if (slot != slots.end())
+    {
+        std::rotate(slot, slot + 1, slots.end());
+        return Selection::cached;
+    }
+
+    // Use a buffer that has never been written, else a new one, else the least recently selected
+    slot = std::find_if(slots.begin(), slots.end(), [](Slot const& slot) { return !slot.image; });
+    if (slot == slots.end())
+    {
+        if (slots.size() < max_cursor_buffers)
+        {
+            slots.push_back({gbm_bo_create_checked(device, width, height), nullptr, orientation});
+            slot = slots.end() - 1;
+        }
+        else
+        {
+            slot = slots.begin();
+        }
+    }
+
+    slot->image = image;
+    slot->orientation = orientation;
+    std::rotate(slot, slot + 1, slots.end());
+    return Selection::needs_writing;
 }
 
 mgm::Cursor::Cursor(
@@ -149,6 +205,8 @@ mgm::Cursor::Cursor(
     std::shared_ptr<CurrentConfiguration> const& current_configuration) :
         output_container(output_container),
         current_position(),
+        images{cached_cursor_images},
+        image{std::make_shared<CursorPixels const>()},
         last_set_failed(false),
         min_buffer_width{std::numeric_limits<uint32_t>::max()},
         min_buffer_height{std::numeric_limits<uint32_t>::max()},
@@ -194,85 +252,31 @@ void mgm::Cursor::pad_and_write_image_data_locked(
     std::lock_guard<std::mutex> const& lg,
     GBMBOWrapper& buffer)
 {
+    auto const& image = *buffer.image();
     auto const orientation = buffer.orientation();
     bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
 
     auto const min_width  = sideways ? min_buffer_width : min_buffer_height;
     auto const min_height = sideways ? min_buffer_height : min_buffer_width;
 
-    auto const image_width = std::min(min_width, size.width.as_uint32_t());
-    auto const image_height = std::min(min_height, size.height.as_uint32_t());
-    auto const image_stride = size.width.as_uint32_t() * 4;
+    auto const image_width = std::min(min_width, image.size.width.as_uint32_t());
+    auto const image_height = std::min(min_height, image.size.height.as_uint32_t());
+    auto const image_stride = image.size.width.as_uint32_t() * 4;
 
     auto const buffer_stride = std::max(min_width*4, gbm_bo_get_stride(buffer));  // in bytes
     auto const buffer_height = std::max(min_height, gbm_bo_get_height(buffer));
     size_t const padded_size = buffer_stride * buffer_height;
 
-    auto padded = std::unique_ptr<uint8_t[]>(new uint8_t[padded_size]);
-    size_t rhs_padding = buffer_stride - 4*image_width;
-
-    auto const filler = 0; // 0x3f; is useful to make buffer visible for debugging
-    uint8_t const* src = argb8888.data();
-    uint8_t* dest = &padded[0];
-
-    switch (orientation)
-    {
-    case mir_orientation_normal:
-        for (unsigned int y = 0; y < image_height; y++)
-        {
-            memcpy(dest, src, 4*image_width);
-            memset(dest + 4*image_width, filler, rhs_padding);
-            dest += buffer_stride;
-            src += image_stride;
-        }
-
-        memset(dest, 0, buffer_stride * (buffer_height - image_height));
-        break;
-
-    case mir_orientation_inverted:
-        for (unsigned int row = 0; row != image_height; ++row)
-        {
-            memset(dest+row*buffer_stride+4*image_width, filler, rhs_padding);
-
-            for (unsigned int col = 0; col != image_width; ++col)
-            {
-                memcpy(dest+row*buffer_stride+4*col, src + ((image_height-1)-row)*image_stride + 4*((image_width-1)-col), 4);
-            }
-        }
-
-        memset(dest+image_height*buffer_stride, filler, buffer_stride * (buffer_height - image_height));
-        break;
-
-    case mir_orientation_left:
-        for (unsigned int row = 0; row != image_width; ++row)
-        {
-            memset(dest+row*buffer_stride+4*image_height, filler, rhs_padding);
-
-            for (unsigned int col = 0; col != image_height; ++col)
-            {
-                memcpy(dest+row*buffer_stride+4*col, src + ((image_width-1)-row)*4 + image_stride*col, 4);
-            }
-        }
-
-        memset(dest+image_width*buffer_stride, filler, buffer_stride * (buffer_height - image_width));
-        break;
+    // Zero filled, so the padding is transparent
+    std::vector<uint8_t> padded(padded_size, 0);
 
-    case mir_orientation_right:
-        for (unsigned int row = 0; row != image_width; ++row)
-        {
-            memset(dest+row*buffer_stride+4*image_height, filler, rhs_padding);
+    mg::pixel::rotate(
+        image.argb8888.data(), geom::Stride{image_stride},
+        {image_width, image_height},
+        padded.data(), geom::Stride{buffer_stride},
+        orientation);
 
-            for (unsigned int col = 0; col != image_height; ++col)
-            {
-                memcpy(dest+row*buffer_stride+4*col, src + row*4 + image_stride*((image_height-1)-col), 4);
-            }
-        }
-
-        memset(dest+image_width*buffer_stride, filler, buffer_stride * (buffer_height - image_width));
-        break;
-    }
-
-    write_buffer_data_locked(lg, buffer, &padded[0], padded_size);
+    write_buffer_data_locked(lg, buffer, padded.data(), padded_size);
 }
 
 void mgm::Cursor::show()
@@ -290,17 +294,16 @@ void mgm::Cursor::show(CursorImage const& cursor_image)
 {
     std::lock_guard<std::mutex> lg(guard);
 
-    size = cursor_image.size();
-
-    argb8888.resize(size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
-    memcpy(argb8888.data(), cursor_image.as_argb_8888(), argb8888.size());
-
+    // A cursor shown recently is still written to buffers, which only need selecting
+    image = images.pixels_of(cursor_image);
     hotspot = cursor_image.hotspot();
     {
         auto locked_buffers = buffers.lock();
         for (auto& pair : *locked_buffers)
         {
-            pad_and_write_image_data_locked(lg, pair.second);
+            auto& buffer = pair.second;
+            if (buffer.select(image, buffer.orientation()) == Selection::needs_writing)
+                pad_and_write_image_data_locked(lg, buffer);
         }
     }
 
@@ -387,7 +390,7 @@ void mgm::Cursor::place_cursor_at_locked(
         if (output_rect.contains(position))
         {
             auto dp = transform(output_rect, position - output_rect.top_left, orientation);
-            auto hs = transform(geom::Rectangle{{0,0}, size}, hotspot, orientation);
+            auto hs = transform(geom::Rectangle{{0,0}, image->size}, hotspot, orientation);
 
             // It's a little strange that we implement hotspot this way as there is
             // drmModeSetCursor2 with hotspot support. However it appears to not actually
@@ -396,12 +399,12 @@ void mgm::Cursor::place_cursor_at_locked(
             output.move_cursor(geom::Point{} + dp - hs);
             auto& buffer = buffer_for_output(output);
 
-            auto const changed_orientation = buffer.change_orientation(orientation);
+            auto const selection = buffer.select(image, orientation);
 
-            if (changed_orientation)
+            if (selection == Selection::needs_writing)
                 pad_and_write_image_data_locked(lg, buffer);
 
-            if (force_state || !output.has_cursor() || changed_orientation)
+            if (force_state || !output.has_cursor() || selection != Selection::unchanged)
             {
                 if (!output.set_cursor(buffer) || !output.has_cursor())
                     set_on_all_outputs = false;
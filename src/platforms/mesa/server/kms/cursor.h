@@ -21,6 +21,7 @@
 #define MIR_GRAPHICS_MESA_CURSOR_H_
 
 #include "mir/graphics/cursor.h"
+#include "mir/graphics/cursor_image_cache.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
 
@@ -85,6 +86,7 @@ public:
 
 private:
     enum ForceCursorState { UpdateState, ForceState };
+    enum class Selection { unchanged, cached, needs_writing };
     struct GBMBOWrapper;
     void for_each_used_output(std::function<void(KMSOutput&, geometry::Rectangle const&, MirOrientation orientation)> const& f);
     void place_cursor_at(geometry::Point position, ForceCursorState force_state);
@@ -106,27 +108,43 @@ private:
     KMSOutputContainer& output_container;
     geometry::Point current_position;
     geometry::Displacement hotspot;
-    geometry::Size size;
-    std::vector<uint8_t> argb8888;
+    CursorImageCache images;
+    std::shared_ptr<CursorPixels const> image;
 
     bool visible;
     bool last_set_failed;
 
+    /*
+     * The cursor buffers of a device. Each holds an image turned for an
+     * output orientation, so showing it again is only a matter of selecting
+     * that buffer.
+     */
     struct GBMBOWrapper
     {
         GBMBOWrapper(int fd, MirOrientation orientation);
-        operator gbm_bo*();
+        operator gbm_bo*();     // The selected buffer
 
-        auto orientation() const -> MirOrientation { return current_orientation; }
-        auto change_orientation(MirOrientation new_orientation) -> bool;
+        auto orientation() const -> MirOrientation { return slots.back().orientation; }
+        auto image() const -> std::shared_ptr<CursorPixels const> const& { return slots.back().image; }
+
+        /// Selects the buffer with image turned for orientation, or one to write it to
+        auto select(std::shared_ptr<CursorPixels const> const& image, MirOrientation orientation) -> Selection;
 
         ~GBMBOWrapper();
 
         GBMBOWrapper(GBMBOWrapper&& from);
     private:
+        struct Slot
+        {
+            gbm_bo* buffer;
+            std::shared_ptr<CursorPixels const> image;  // null until written
+            MirOrientation orientation;
+        };
+
         gbm_device* device;
-        gbm_bo* buffer;
-        MirOrientation current_orientation;
+        uint32_t width;
+        uint32_t height;
+        std::vector<Slot> slots;    // The selected one last
         GBMBOWrapper(GBMBOWrapper const&) = delete;
         GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
     };
@@ -23,6 +23,7 @@
 #include "kms_display_configuration.h"
 #include "kms_output.h"
 #include "kms_page_flipper.h"
+#include "atomic_kms.h"
 #include "mir/console_services.h"
 #include "mir/graphics/overlapping_output_grouping.h"
 #include "mir/graphics/event_handler_register.h"
@@ -193,7 +194,12 @@ mgm::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& dr
                   auto& flipper = flippers[drm_fd];
                   if (!flipper)
                   {
-                      flipper = std::make_shared<KMSPageFlipper>(drm_fd, listener);
+                      auto const atomic_properties = enable_atomic_kms(drm_fd) ?
+                          std::make_shared<PropertyCache>(drm_fd) : nullptr;
+                      if (atomic_properties)
+                          mir::log_info("Using atomic modesetting on DRM device fd %d", drm_fd);
+
+                      flipper = std::make_shared<KMSPageFlipper>(drm_fd, listener, atomic_properties);
                   }
                   return flipper;
               })},
@@ -216,11 +222,24 @@ mgm::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& dr
     shared_egl.make_current();
 }
 
-// please don't remove this empty destructor, it's here for the
-// unique ptr!! if you accidentally remove it you will get a not
-// so relevant linker error about some missing headers
 mgm::Display::~Display()
 {
+    /*
+     * post() doesn't wait for its page flips, so the last frames may still
+     * be on their way to the screen. Let them land before their buffers
+     * are released.
+     */
+    for (auto& db : display_buffers)
+    {
+        try
+        {
+            db->wait_for_page_flip();
+        }
+        catch (std::exception const& e)
+        {
+            mir::log_warning("Failed waiting for final page flip: %s", e.what());
+        }
+    }
 }
 
 void mgm::Display::for_each_display_sync_group(
@@ -481,6 +500,76 @@ void mgm::Display::configure_locked(
         compatible(kms_conf, current_display_configuration)};
     std::vector<std::unique_ptr<DisplayBuffer>> display_buffers_new;
 
+    /*
+     * An output whose configuration hasn't changed can keep its display
+     * buffer, as long as that still drives the same outputs at the same size.
+     * Building one (a scanout surface, an EGL context and a modeset) is what
+     * makes reconfiguring slow, so we only do that for what has changed.
+     */
+    std::unordered_map<int, DisplayConfigurationOutput> previous_outputs;
+    if (&kms_conf != &current_display_configuration)
+    {
+        current_display_configuration.for_each_output(
+            [&](DisplayConfigurationOutput const& conf_output)
+            {
+                previous_outputs.emplace(conf_output.id.as_value(), conf_output);
+            });
+    }
+
+    struct Group
+    {
+        geom::Rectangle bounding_rect;
+        glm::mat2 transformation;
+        uint32_t width;
+        uint32_t height;
+        bool unchanged;
+        std::vector<DisplayConfigurationOutput> conf_outputs;
+        // Each vector<KMSOutput> is a single GPU memory domain
+        std::vector<std::vector<std::shared_ptr<KMSOutput>>> kms_output_groups;
+        // The existing display buffer for each of kms_output_groups, if it can be kept
+        std::vector<std::unique_ptr<DisplayBuffer>> kept;
+    };
+    std::vector<Group> groups;
+
+    OverlappingOutputGrouping grouping{kms_conf};
+
+    grouping.for_each_group(
+        [&](OverlappingOutputGroup const& output_group)
+        {
+            Group group;
+            group.bounding_rect = output_group.bounding_rectangle();
+            group.unchanged = true;
+
+            output_group.for_each_output(
+                [&](DisplayConfigurationOutput const& conf_output)
+                {
+                    auto const previous = previous_outputs.find(conf_output.id.as_value());
+                    group.unchanged = group.unchanged &&
+                        previous != previous_outputs.end() && compatible(previous->second, conf_output);
+
+                    group.conf_outputs.push_back(conf_output);
+                    add_to_drm_device_group(
+                        group.kms_output_groups,
+                        current_display_configuration.get_output_for(conf_output.id));
+
+                    /*
+                     * Presently OverlappingOutputGroup guarantees all grouped
+                     * outputs have the same transformation.
+                     */
+                    group.transformation = conf_output.transformation();
+                });
+
+            glm::vec2 const logical_size{
+                group.bounding_rect.size.width.as_uint32_t(),
+                group.bounding_rect.size.height.as_uint32_t()};
+
+            auto const physical_size = group.transformation * logical_size;
+            group.width = abs(int(physical_size.x));
+            group.height = abs(int(physical_size.y));
+
+            groups.push_back(std::move(group));
+        });
+
     if (!comp)
     {
         /*
@@ -494,102 +583,124 @@ void mgm::Display::configure_locked(
         for (auto& db : display_buffers)
             db->wait_for_page_flip();
 
-        /* Reset the state of all outputs */
+        std::vector<std::shared_ptr<KMSOutput>> kept_outputs;
+        for (auto& group : groups)
+        {
+            for (auto const& outputs : group.kms_output_groups)
+            {
+                geom::Size const size{group.width, group.height};
+                auto const reusable = std::find_if(
+                    display_buffers.begin(), display_buffers.end(),
+                    [&](std::unique_ptr<DisplayBuffer> const& db)
+                    {
+                        return db && db->drives(outputs, size);
+                    });
+
+                if (group.unchanged && reusable != display_buffers.end())
+                {
+                    group.kept.push_back(std::move(*reusable));
+                    kept_outputs.insert(kept_outputs.end(), outputs.begin(), outputs.end());
+                }
+                else
+                {
+                    group.kept.push_back(nullptr);
+                }
+            }
+        }
+
+        /* Reset the state of all outputs that are getting a new display buffer */
         kms_conf.for_each_output(
             [&](DisplayConfigurationOutput const& conf_output)
             {
                 auto kms_output = current_display_configuration.get_output_for(conf_output.id);
-                kms_output->clear_cursor();
-                kms_output->reset();
+                if (std::find(kept_outputs.begin(), kept_outputs.end(), kms_output) == kept_outputs.end())
+                {
+                    kms_output->clear_cursor();
+                    kms_output->reset();
+                }
             });
     }
 
     /* Set up used outputs */
-    OverlappingOutputGrouping grouping{kms_conf};
     auto group_idx = 0;
+    auto rebuilt = 0;
 
-    grouping.for_each_group(
-        [&](OverlappingOutputGroup const& group)
+    for (auto& group : groups)
+    {
+        for (auto const& conf_output : group.conf_outputs)
         {
-            auto bounding_rect = group.bounding_rectangle();
-            // Each vector<KMSOutput> is a single GPU memory domain
-            std::vector<std::vector<std::shared_ptr<KMSOutput>>> kms_output_groups;
-            glm::mat2 transformation;
+            auto kms_output = current_display_configuration.get_output_for(conf_output.id);
 
-            group.for_each_output(
-                [&](DisplayConfigurationOutput const& conf_output)
-                {
-                    auto kms_output = current_display_configuration.get_output_for(conf_output.id);
+            auto const mode_index = kms_conf.get_kms_mode_index(conf_output.id,
+                                                          conf_output.current_mode_index);
+            kms_output->configure(conf_output.top_left - group.bounding_rect.top_left, mode_index);
+            if (!comp)
+            {
+                kms_output->set_power_mode(conf_output.power_mode);
+                kms_output->set_gamma(conf_output.gamma);
+            }
+        }
 
-                    auto const mode_index = kms_conf.get_kms_mode_index(conf_output.id,
-                                                                  conf_output.current_mode_index);
-                    kms_output->configure(conf_output.top_left - bounding_rect.top_left, mode_index);
-                    if (!comp)
-                    {
-                        kms_output->set_power_mode(conf_output.power_mode);
-                        kms_output->set_gamma(conf_output.gamma);
-                        add_to_drm_device_group(kms_output_groups, std::move(kms_output));
-                    }
+        if (comp)
+        {
+            display_buffers[group_idx++]->set_transformation(group.transformation,
+                                                             group.bounding_rect);
+            continue;
+        }
 
-                    /*
-                     * Presently OverlappingOutputGroup guarantees all grouped
-                     * outputs have the same transformation.
-                     */
-                    transformation = conf_output.transformation();
-                });
+        for (auto i = 0u; i != group.kms_output_groups.size(); ++i)
+        {
+            auto const& outputs = group.kms_output_groups[i];
 
-            if (comp)
+            if (auto& db = group.kept[i])
             {
-                display_buffers[group_idx++]->set_transformation(transformation,
-                                                                 bounding_rect);
+                db->set_transformation(group.transformation, group.bounding_rect);
+                display_buffers_new.push_back(std::move(db));
+                continue;
             }
-            else
-            {
-                glm::vec2 const logical_size{
-                    bounding_rect.size.width.as_uint32_t(),
-                    bounding_rect.size.height.as_uint32_t()};
 
-                auto const physical_size = transformation * logical_size;
-                uint32_t width = abs(int(physical_size.x));
-                uint32_t height = abs(int(physical_size.y));
+            /*
+             * In a hybrid setup a scanout surface needs to be allocated differently if it
+             * needs to be able to be shared across GPUs. This likely reduces performance.
+             *
+             * As a first cut, assume every scanout buffer in a hybrid setup might need
+             * to be shared.
+             */
+            auto surface = gbm->create_scanout_surface(group.width, group.height, drm.size() != 1);
+            auto const raw_surface = surface.get();
+
+            auto db = std::make_unique<DisplayBuffer>(
+                bypass_option,
+                listener,
+                outputs,
+                GBMOutputSurface{
+                    outputs.front()->drm_fd(),
+                    std::move(surface),
+                    group.width, group.height,
+                    helpers::EGLHelper{
+                        *gl_config,
+                        *gbm,
+                        raw_surface,
+                        shared_egl.context()
+                    }
+                },
+                group.bounding_rect,
+                group.transformation);
 
-                for (auto const& group : kms_output_groups)
-                {
-                    /*
-                     * In a hybrid setup a scanout surface needs to be allocated differently if it
-                     * needs to be able to be shared across GPUs. This likely reduces performance.
-                     *
-                     * As a first cut, assume every scanout buffer in a hybrid setup might need
-                     * to be shared.
-                     */
-                    auto surface = gbm->create_scanout_surface(width, height, drm.size() != 1);
-                    auto const raw_surface = surface.get();
-
-                    auto db = std::make_unique<DisplayBuffer>(
-                        bypass_option,
-                        listener,
-                        group,
-                        GBMOutputSurface{
-                            group.front()->drm_fd(),
-                            std::move(surface),
-                            width, height,
-                            helpers::EGLHelper{
-                                *gl_config,
-                                *gbm,
-                                raw_surface,
-                                shared_egl.context()
-                            }
-                        },
-                        bounding_rect,
-                        transformation);
-
-                    display_buffers_new.push_back(std::move(db));
-                }
-            }
-        });
+            display_buffers_new.push_back(std::move(db));
+            ++rebuilt;
+        }
+    }
 
     if (!comp)
+    {
+        if (!display_buffers.empty())
+        {
+            mir::log_info("Reconfigured displays: kept %zu display buffer(s), rebuilt %d",
+                          display_buffers_new.size() - rebuilt, rebuilt);
+        }
         display_buffers = std::move(display_buffers_new);
+    }
 
     /* Store applied configuration */
     current_display_configuration = kms_conf;
@@ -18,6 +18,7 @@
 
 #include "display_buffer.h"
 #include "kms_output.h"
+#include "atomic_kms.h"
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
 #include "bypass.h"
@@ -39,6 +40,7 @@
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <cstring>
 
 namespace mg = mir::graphics;
 namespace mgm = mir::graphics::mesa;
@@ -164,6 +166,34 @@ bool needs_bounce_buffer(mgm::KMSOutput const& destination, gbm_bo* source)
     return destination.buffer_requires_migration(source);
 }
 
+gbm_bo* scanout_bo(mgm::KMSOutput const& output, mg::Renderable const& renderable)
+{
+    auto const buffer = renderable.buffer();
+    if (!buffer)
+        return nullptr;
+
+    auto const native = std::dynamic_pointer_cast<mgm::NativeBuffer>(buffer->native_buffer_handle());
+    if (!native || !(native->flags & mir_buffer_flag_can_scanout) || needs_bounce_buffer(output, native->bo))
+        return nullptr;
+
+    return native->bo;
+}
+
+uint32_t scanout_format(mgm::KMSOutput const& output, mg::Renderable const& renderable)
+{
+    auto const bo = scanout_bo(output, renderable);
+    if (!bo)
+        return 0;
+
+    // As in KMSOutput::fb_for(), planes want fourcc formats
+    auto const format = gbm_bo_get_format(bo);
+    if (format == GBM_BO_FORMAT_XRGB8888)
+        return GBM_FORMAT_XRGB8888;
+    else if (format == GBM_BO_FORMAT_ARGB8888)
+        return GBM_FORMAT_ARGB8888;
+    return format;
+}
+
 const GLchar* const vshader =
     {
         "attribute vec4 position;\n"
@@ -497,6 +527,7 @@ mgm::DisplayBuffer::DisplayBuffer(
       area(area),
       transform{transformation},
       needs_set_crtc{false},
+      atomic_kms{true},
       page_flips_pending{false}
 {
     listener->report_successful_setup_of_native_resources();
@@ -546,7 +577,20 @@ mgm::DisplayBuffer::DisplayBuffer(
         }
     }
 
-    set_crtc(*outputs.front()->fb_for(visible_composite_frame));
+    auto const initial_fb = outputs.front()->fb_for(visible_composite_frame);
+    auto const atomic_modeset = commit_atomic(*initial_fb, true);
+    if (!atomic_modeset)
+        set_crtc(*initial_fb);
+    last_composited_fb = initial_fb;
+
+    /*
+     * Planes only make sense when there's a single CRTC to put them on;
+     * we can only ask for them once it's been set. And only an atomic update
+     * changes them in step with the primary plane: drmModeSetPlane() takes
+     * effect whenever it's called, not at the flip.
+     */
+    if (bypass_option == mgm::BypassOption::allowed && outputs.size() == 1 && atomic_modeset)
+        planner = std::make_unique<OverlayPlanner>(outputs.front()->planes());
 
     release_current();
 
@@ -561,6 +605,9 @@ mgm::DisplayBuffer::DisplayBuffer(
 
 mgm::DisplayBuffer::~DisplayBuffer()
 {
+    // Don't leave surfaces on top of whatever takes over the CRTC
+    for (auto plane_id : active_planes)
+        outputs.front()->clear_plane(plane_id);
 }
 
 geom::Rectangle mgm::DisplayBuffer::view_area() const
@@ -579,12 +626,35 @@ void mgm::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
     area = a;
 }
 
+bool mgm::DisplayBuffer::drives(
+    std::vector<std::shared_ptr<KMSOutput>> const& outputs,
+    geometry::Size const& size) const
+{
+    return this->outputs == outputs && surface.size() == size;
+}
+
 bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    auto composited = renderable_list;
+    if (overlay_partially(composited))
+        return true;
+
+    // The caller composites the whole list, so nothing may be shown above it
+    plane_frames.clear();
+    return false;
+}
+
+bool mgm::DisplayBuffer::overlay_partially(RenderableList& renderable_list)
+{
+    plane_frames.clear();
+
     glm::mat2 static const no_transformation(1);
     if (transform == no_transformation &&
        (bypass_option == mgm::BypassOption::allowed))
     {
+        if (planner && planner->has_planes())
+            return overlay_on_planes(renderable_list);
+
         mgm::BypassMatch bypass_match(area);
         auto bypass_it = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
         if (bypass_it != renderable_list.rend())
@@ -610,6 +680,176 @@ bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
     return false;
 }
 
+bool mgm::DisplayBuffer::overlay_on_planes(RenderableList& renderable_list)
+{
+    bypass_buf = nullptr;
+    bypass_bufobj = nullptr;
+
+    auto const& output = *outputs.front();
+    auto const plan = planner->plan(
+        area,
+        renderable_list,
+        [&output](Renderable const& renderable) { return scanout_format(output, renderable); });
+
+    if (!plan.primary && plan.overlays.empty())
+        return false;
+
+    // The planner only scans out a primary when there's nothing left to composite
+    FBHandle* primary_bufobj{nullptr};
+    if (plan.primary && !(primary_bufobj = output.fb_for(scanout_bo(output, *plan.primary))))
+        return false;
+
+    std::vector<PlaneLayout> layout;
+    if (plan.primary)
+        layout.push_back({0, scanout_format(output, *plan.primary), plan.primary->buffer()->size(), {}});
+    else
+        layout.push_back({0, 0, surface.size(), {}});
+
+    for (auto const& assignment : plan.overlays)
+    {
+        auto const& renderable = *assignment.renderable;
+        auto const plane_bufobj = output.fb_for(scanout_bo(output, renderable));
+        if (!plane_bufobj)
+        {
+            plane_frames.clear();
+            return false;
+        }
+
+        auto const position = renderable.screen_position();
+        geom::Rectangle const destination{geom::Point{} + (position.top_left - area.top_left), position.size};
+        plane_frames.push_back({assignment.plane_id, renderable.buffer(), plane_bufobj, destination});
+        layout.push_back({
+            assignment.plane_id,
+            scanout_format(output, renderable),
+            renderable.buffer()->size(),
+            destination});
+    }
+
+    // Until the frame is rendered, the last composited one (of the same size and format) stands in for it
+    if (!planes_pass_test(primary_bufobj ? *primary_bufobj : *last_composited_fb, std::move(layout)))
+    {
+        plane_frames.clear();
+        return false;
+    }
+
+    if (primary_bufobj)
+    {
+        bypass_buf = plan.primary->buffer();
+        bypass_bufobj = primary_bufobj;
+        return true;
+    }
+
+    // The caller composites the rest into the primary plane, below the overlays
+    renderable_list = plan.composited;
+    return false;
+}
+
+void mgm::DisplayBuffer::abandon_planes()
+{
+    if (planner)
+    {
+        mir::log_warning("Hardware planes can't be updated atomically; disabling overlay planes");
+        planner.reset();
+    }
+
+    for (auto plane_id : active_planes)
+        outputs.front()->clear_plane(plane_id);
+
+    active_planes.clear();
+    plane_frames.clear();
+    tested_layout.clear();
+}
+
+std::unique_ptr<mgm::AtomicUpdate> mgm::DisplayBuffer::atomic_update(FBHandle const& bufobj, bool modeset)
+{
+    if (!atomic_kms)
+        return nullptr;
+
+    auto update = outputs.front()->begin_atomic_update();
+    if (!update)
+        return nullptr;
+
+    for (auto const& output : outputs)
+    {
+        // A commit can only cover the outputs of one device
+        if (output->drm_fd() != update->drm_fd() || !output->add_to_update(*update, bufobj, modeset))
+            return nullptr;
+    }
+
+    try
+    {
+        auto const& output = outputs.front();
+        for (auto const& frame : plane_frames)
+            output->add_plane_to_update(*update, frame.plane_id, frame.bufobj, frame.destination);
+
+        for (auto plane_id : active_planes)
+        {
+            auto const still_active = std::find_if(plane_frames.begin(), plane_frames.end(),
+                [plane_id](PlaneFrame const& frame) { return frame.plane_id == plane_id; });
+            if (still_active == plane_frames.end())
+                output->add_plane_to_update(*update, plane_id, nullptr, {});
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Can't update hardware planes atomically (%s); using the legacy API", e.what());
+        atomic_kms = false;
+        return nullptr;
+    }
+
+    return update;
+}
+
+bool mgm::DisplayBuffer::commit_atomic(FBHandle const& bufobj, bool modeset)
+{
+    auto const update = atomic_update(bufobj, modeset);
+    if (!update)
+        return false;
+
+    if (modeset)
+    {
+        if (auto const error = update->commit(DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+        {
+            mir::log_warning("Atomic modeset failed (%s); using the legacy API", strerror(-error));
+            atomic_kms = false;
+            return false;
+        }
+    }
+    else
+    {
+        if (!outputs.front()->schedule_page_flip(*update))
+        {
+            mir::log_warning("Atomic page flip failed; using the legacy API");
+            atomic_kms = false;
+            return false;
+        }
+        page_flips_pending = true;
+    }
+
+    std::vector<uint32_t> now_active;
+    for (auto const& frame : plane_frames)
+    {
+        now_active.push_back(frame.plane_id);
+        scheduled_plane_frames.push_back(frame.buffer);
+    }
+
+    active_planes = std::move(now_active);
+    plane_frames.clear();
+    return true;
+}
+
+bool mgm::DisplayBuffer::planes_pass_test(FBHandle const& primary, std::vector<PlaneLayout>&& layout)
+{
+    // A test commit is a round trip through the driver, and a steady scene would repeat it every frame
+    if (layout == tested_layout)
+        return tested_layout_passed;
+
+    auto const update = atomic_update(primary, false);
+    tested_layout_passed = update && update->test(0);
+    tested_layout = std::move(layout);
+    return tested_layout_passed;
+}
+
 void mgm::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -662,14 +902,21 @@ void mgm::DisplayBuffer::post()
         bufobj = outputs.front()->fb_for(scheduled_composite_frame);
         if (!bufobj)
             fatal_error("Failed to get front buffer object");
+        last_composited_fb = bufobj;
     }
 
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*bufobj))
-        needs_set_crtc = true;
+    bool atomic{false};
+    if (!needs_set_crtc)
+    {
+        atomic = commit_atomic(*bufobj, false);
+        if (!atomic && !schedule_page_flip(*bufobj))
+            needs_set_crtc = true;
+    }
+    flip_scheduled_at = mir::time::PosixTimestamp::now(outputs.front()->last_frame().ust.clock_id);
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
@@ -677,10 +924,25 @@ void mgm::DisplayBuffer::post()
      */
     if (needs_set_crtc)
     {
-        set_crtc(*bufobj);
+        atomic = commit_atomic(*bufobj, true);
+        if (!atomic)
+            set_crtc(*bufobj);
         needs_set_crtc = false;
+
+        // The driver may judge planes differently in the new mode
+        tested_layout.clear();
     }
 
+    /*
+     * An atomic update has already changed the planes along with everything
+     * else. If the driver has refused one the planes can't be kept in step
+     * with the primary plane, so stop using them. (This frame loses whatever
+     * was planned for them.)
+     */
+    if (!atomic && !atomic_kms)
+        abandon_planes();
+    plane_frames.clear();
+
     using namespace std;  // For operator""ms()
 
     // Predicted worst case render time for the next frame...
@@ -707,14 +969,11 @@ void mgm::DisplayBuffer::post()
     else
     {
         /*
-         * Not in clone mode? We can afford to wait for the page flip then,
-         * making us double-buffered (noticeably less laggy than the triple
-         * buffering that clone mode requires).
-         */
-        if (outputs.size() == 1)
-            wait_for_page_flip();
-
-        /*
+         * Composited frames don't wait for their flips here, in clone mode
+         * or not: the page flip completes on the DRM event thread while we
+         * render the next frame, and last_frame() predicts the vsync it will
+         * land on.
+         *
          * TODO: If you're optimistic about your GPU performance and/or
          *       measure it carefully you may wish to set predicted_render_time
          *       to a lower value here for lower latency.
@@ -742,6 +1001,57 @@ std::chrono::milliseconds mgm::DisplayBuffer::recommended_sleep() const
     return recommend_sleep;
 }
 
+mg::Frame mgm::DisplayBuffer::last_frame() const
+{
+    auto frame = outputs.front()->last_frame();
+
+    /*
+     * If post() hasn't waited for its flip yet the output still reports the
+     * previous one. We waited for that before scheduling, so the new flip
+     * lands on the first vsync after it was scheduled.
+     */
+    auto const interval = frame_interval();
+    if (page_flips_pending &&
+        interval > std::chrono::nanoseconds::zero() &&
+        frame.ust.nanoseconds > std::chrono::nanoseconds::zero())
+    {
+        auto const vsyncs = (flip_scheduled_at - frame.ust) / interval + 1;
+        frame.msc += vsyncs;
+        frame.ust = frame.ust + vsyncs * interval;
+    }
+
+    return frame;
+}
+
+std::chrono::nanoseconds mgm::DisplayBuffer::frame_interval() const
+{
+    /*
+     * In clone mode the outputs flip independently and post() doesn't wait
+     * for them, so there's no single vsync to aim for.
+     */
+    if (outputs.size() != 1)
+        return std::chrono::nanoseconds::zero();
+
+    auto const refresh_rate = outputs.front()->max_refresh_rate();
+    if (refresh_rate <= 0)
+        return std::chrono::nanoseconds::zero();
+
+    return std::chrono::nanoseconds{std::chrono::seconds{1}} / refresh_rate;
+}
+
+void mgm::DisplayBuffer::when_presented(std::function<void(Frame const&)> const& presented)
+{
+    /*
+     * last_frame() only predicts the vsync of a flip post() hasn't waited
+     * for, so wait for the flip itself. In clone mode the first output's
+     * flip stands for them all, as in last_frame().
+     */
+    if (page_flips_pending)
+        outputs.front()->when_page_flipped(presented);
+    else
+        presented(last_frame());
+}
+
 bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
 {
     /*
@@ -777,6 +1087,9 @@ void mgm::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        visible_plane_frames = std::move(scheduled_plane_frames);
+        scheduled_plane_frames.clear();
     }
 }
 
@@ -790,6 +1103,11 @@ void mgm::DisplayBuffer::bind()
     surface.bind();
 }
 
+int mgm::DisplayBuffer::buffer_age()
+{
+    return surface.buffer_age();
+}
+
 void mgm::DisplayBuffer::release_current()
 {
     surface.release_current();
@@ -853,6 +1171,11 @@ void mgm::GBMOutputSurface::bind()
 
 }
 
+int mgm::GBMOutputSurface::buffer_age()
+{
+    return egl.buffer_age();
+}
+
 auto mgm::GBMOutputSurface::lock_front() -> FrontBuffer
 {
     return FrontBuffer{surface.get()};
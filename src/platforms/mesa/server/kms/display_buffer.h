@@ -25,6 +25,7 @@
 #include "display_helpers.h"
 #include "egl_helper.h"
 #include "platform_common.h"
+#include "overlay_planner.h"
 
 #include <vector>
 #include <memory>
@@ -44,6 +45,7 @@ namespace mesa
 class Platform;
 class FBHandle;
 class KMSOutput;
+class AtomicUpdate;
 class NativeBuffer;
 
 class GBMOutputSurface : public renderer::gl::RenderTarget
@@ -82,6 +84,7 @@ public:
     void release_current() override;
     void swap_buffers() override;
     void bind() override;
+    int buffer_age() override;
 
     FrontBuffer lock_front();
     void report_egl_configuration(std::function<void(EGLDisplay, EGLConfig)> const& to);
@@ -112,27 +115,72 @@ public:
     void release_current() override;
     void swap_buffers() override;
     bool overlay(RenderableList const& renderlist) override;
+    bool overlay_partially(RenderableList& renderlist) override;
     void bind() override;
+    int buffer_age() override;
 
     void for_each_display_buffer(
         std::function<void(graphics::DisplayBuffer&)> const& f) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    Frame last_frame() const override;
+    std::chrono::nanoseconds frame_interval() const override;
+    void when_presented(std::function<void(Frame const&)> const& presented) override;
 
     glm::mat2 transformation() const override;
     NativeDisplayBuffer* native_display_buffer() override;
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
+    /// Whether this is showing exactly these outputs, on a surface of this size
+    bool drives(std::vector<std::shared_ptr<KMSOutput>> const& outputs, geometry::Size const& size) const;
     void schedule_set_crtc();
     void wait_for_page_flip();
 
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    /// An update showing bufobj and plane_frames on the outputs, or null if they can't be updated atomically
+    std::unique_ptr<AtomicUpdate> atomic_update(FBHandle const& bufobj, bool modeset);
+    bool commit_atomic(FBHandle const& bufobj, bool modeset);
+    bool overlay_on_planes(RenderableList& renderlist);
+    /// Clears the planes and stops using them
+    void abandon_planes();
+
+    struct PlaneFrame
+    {
+        uint32_t plane_id;
+        std::shared_ptr<Buffer> buffer;
+        FBHandle* bufobj;
+        geometry::Rectangle destination;
+    };
+
+    /// What a plane test depends on: any buffers of the same format and size pass or fail alike
+    struct PlaneLayout
+    {
+        uint32_t plane_id;
+        uint32_t format;    ///< 0 for the composited frame
+        geometry::Size size;
+        geometry::Rectangle destination;
+
+        bool operator==(PlaneLayout const& other) const
+        {
+            return plane_id == other.plane_id && format == other.format &&
+                size == other.size && destination == other.destination;
+        }
+    };
+    /// Whether the driver accepts plane_frames over primary, laid out as layout
+    bool planes_pass_test(FBHandle const& primary, std::vector<PlaneLayout>&& layout);
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     FBHandle* bypass_bufobj{nullptr};
+    FBHandle* last_composited_fb{nullptr};
+    std::vector<std::shared_ptr<graphics::Buffer>> visible_plane_frames, scheduled_plane_frames;
+    std::vector<PlaneFrame> plane_frames;
+    std::vector<uint32_t> active_planes;
+    std::vector<PlaneLayout> tested_layout;     ///< Empty until a layout is tested, or after a modeset
+    bool tested_layout_passed{false};
+    std::unique_ptr<OverlayPlanner> planner;
     std::shared_ptr<DisplayReport> const listener;
     BypassOption bypass_option;
 
@@ -153,8 +201,10 @@ private:
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
+    bool atomic_kms;    ///< Until the driver refuses an atomic update
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+    mir::time::PosixTimestamp flip_scheduled_at;
 };
 
 }
@@ -19,6 +19,8 @@
 #include "egl_helper.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/extension_list.h"
+#include <EGL/eglext.h>
 #include <boost/exception/errinfo_errno.hpp>
 #include <boost/throw_exception.hpp>
 
@@ -34,7 +36,8 @@ mgmh::EGLHelper::EGLHelper(GLConfig const& gl_config)
       stencil_buffer_bits{gl_config.stencil_buffer_bits()},
       egl_display{EGL_NO_DISPLAY}, egl_config{0},
       egl_context{EGL_NO_CONTEXT}, egl_surface{EGL_NO_SURFACE},
-      should_terminate_egl{false}
+      should_terminate_egl{false},
+      supports_buffer_age{false}
 {
 }
 
@@ -55,7 +58,8 @@ mgmh::EGLHelper::EGLHelper(EGLHelper&& from)
       egl_config{from.egl_config},
       egl_context{from.egl_context},
       egl_surface{from.egl_surface},
-      should_terminate_egl{from.should_terminate_egl}
+      should_terminate_egl{from.should_terminate_egl},
+      supports_buffer_age{from.supports_buffer_age}
 {
     from.should_terminate_egl = false;
     from.egl_display = EGL_NO_DISPLAY;
@@ -161,6 +165,17 @@ bool mgmh::EGLHelper::release_current() const
     return (ret == EGL_TRUE);
 }
 
+int mgmh::EGLHelper::buffer_age() const
+{
+    EGLint age = 0;
+    if (!supports_buffer_age ||
+        eglQuerySurface(egl_display, egl_surface, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+    {
+        return 0;
+    }
+    return age;
+}
+
 namespace
 {
 std::vector<EGLConfig> get_matching_configs(EGLDisplay dpy, EGLint const attr[])
@@ -226,6 +241,8 @@ void mgmh::EGLHelper::setup_internal(GBMHelper const& gbm, bool initialize, EGLi
         should_terminate_egl = true;
     }
 
+    supports_buffer_age = mg::has_extension(eglQueryString(egl_display, EGL_EXTENSIONS), "EGL_EXT_buffer_age");
+
     for (auto const& config : get_matching_configs(egl_display, config_attr))
     {
         EGLint id;
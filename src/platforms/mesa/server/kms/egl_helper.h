@@ -54,6 +54,7 @@ public:
     bool swap_buffers();
     bool make_current() const;
     bool release_current() const;
+    int buffer_age() const;
 
     EGLContext context() { return egl_context; }
 
@@ -68,6 +69,7 @@ private:
     EGLContext egl_context;
     EGLSurface egl_surface;
     bool should_terminate_egl;
+    bool supports_buffer_age;
 };
 }
 }
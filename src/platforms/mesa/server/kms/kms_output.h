@@ -22,11 +22,17 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir_toolkit/common.h"
 
 #include "kms-utils/drm_mode_resources.h"
+#include "kms-utils/kms_plane.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include <gbm.h>
 
@@ -40,6 +46,7 @@ namespace mesa
 {
 
 class FBHandle;
+class AtomicUpdate;
 
 class KMSOutput
 {
@@ -68,12 +75,57 @@ public:
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
+    /**
+     * Calls flipped with the frame on which the pending page flip lands,
+     * once it has, from another thread. If no flip is pending it is called
+     * at once, with last_frame().
+     */
+    virtual void when_page_flipped(std::function<void(Frame const&)> const& flipped) = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
     virtual bool clear_cursor() = 0;
     virtual bool has_cursor() const = 0;
 
+    /**
+     * The overlay and cursor planes that can be used on this output's CRTC.
+     * Empty if the output has no CRTC or the driver doesn't expose planes.
+     */
+    virtual std::vector<kms::Plane> planes() const = 0;
+    virtual void clear_plane(uint32_t plane_id) = 0;
+
+    /**
+     * Starts an atomic update of this output's device.
+     *
+     * \return  The update, or null if the device only supports the legacy
+     *          API or the output is powered down.
+     */
+    virtual std::unique_ptr<AtomicUpdate> begin_atomic_update() = 0;
+    /**
+     * Adds showing fb on this output's primary plane to an atomic update,
+     * and setting the output's mode if modeset is true.
+     *
+     * \return  false if this output can't be updated atomically
+     */
+    virtual bool add_to_update(AtomicUpdate& update, FBHandle const& fb, bool modeset) = 0;
+    /**
+     * Adds showing fb, unscaled, on a plane of this output's CRTC to an
+     * atomic update, or clearing the plane if fb is null.
+     *
+     * \param [in] destination  Where to show fb, relative to the top left of the CRTC
+     */
+    virtual void add_plane_to_update(
+        AtomicUpdate& update,
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination) = 0;
+    /**
+     * Commits an update flipping this and any other outputs of the device,
+     * without waiting for it. Call wait_for_page_flip() on each of them as
+     * for schedule_page_flip().
+     */
+    virtual bool schedule_page_flip(AtomicUpdate const& update) = 0;
+
     virtual void set_power_mode(MirPowerMode mode) = 0;
     virtual void set_gamma(GammaCurves const& gamma) = 0;
     virtual Frame last_frame() const = 0;
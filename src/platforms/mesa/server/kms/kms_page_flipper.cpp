@@ -17,6 +17,7 @@
  */
 
 #include "kms_page_flipper.h"
+#include "atomic_kms.h"
 #include "mir/graphics/display_report.h"
 
 #include <stdexcept>
@@ -28,6 +29,11 @@
 #include <chrono>
 #include <cstring>
 
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 namespace mg = mir::graphics;
 namespace mgm = mir::graphics::mesa;
 
@@ -44,21 +50,72 @@ void page_flip_handler(int /*fd*/, unsigned int seq,
                                               seq, ns);
 }
 
+#if DRM_EVENT_CONTEXT_VERSION >= 3
+/*
+ * An atomic commit sends an event for each CRTC it flips, all with the same
+ * user data, so we need to be told which CRTC each is for.
+ */
+void page_flip_handler2(int /*fd*/, unsigned int seq,
+                        unsigned int sec, unsigned int usec,
+                        unsigned int crtc_id, void* data)
+{
+    auto page_flip_data = static_cast<mgm::PageFlipEventData*>(data);
+    std::chrono::nanoseconds ns{sec*1000000000LL + usec*1000LL};
+
+    // Kernels older than 4.12 don't say, but then we don't use atomic commits
+    // and the user data is the flip's own
+    if (!crtc_id)
+        crtc_id = page_flip_data->crtc_id;
+
+    page_flip_data->flipper->notify_page_flip(crtc_id, seq, ns);
+}
+#endif
+
 }
 
 mgm::KMSPageFlipper::KMSPageFlipper(
     int drm_fd,
-    std::shared_ptr<DisplayReport> const& report) :
+    std::shared_ptr<DisplayReport> const& report,
+    std::shared_ptr<PropertyCache> const& atomic_properties) :
     drm_fd{drm_fd},
     report{report},
+    atomic_properties{atomic_properties},
+    atomic_flip_data{0, 0, this},
     pending_page_flips(),
-    worker_tid()
+    stopping{false},
+    wakeup_fd{eventfd(0, EFD_CLOEXEC)}
 {
+    if (wakeup_fd < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            boost::enable_error_info(
+                std::runtime_error("Failed to create page-flip wakeup fd")) << boost::errinfo_errno(errno));
+    }
+
     uint64_t mono = 0;
     if (drmGetCap(drm_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &mono) || !mono)
         clock_id = CLOCK_REALTIME;
     else
         clock_id = CLOCK_MONOTONIC;
+
+    event_thread = std::thread{[this] { handle_events(); }};
+}
+
+mgm::KMSPageFlipper::~KMSPageFlipper()
+{
+    {
+        std::lock_guard<std::mutex> lock{pf_mutex};
+        stopping = true;
+    }
+    pf_cv.notify_all();
+
+    /* Interrupt poll(). This only fails if the eventfd is already readable */
+    uint64_t const wakeup{1};
+    if (write(wakeup_fd, &wakeup, sizeof wakeup) != sizeof wakeup)
+    {
+    }
+
+    event_thread.join();
 }
 
 bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
@@ -84,89 +141,165 @@ bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
 
     if (ret)
         pending_page_flips.erase(crtc_id);
+    else
+        pf_cv.notify_all();     // Wake the event thread, if it's idle
 
     return (ret == 0);
 }
 
-mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
+std::unique_ptr<mgm::AtomicUpdate> mgm::KMSPageFlipper::begin_atomic_update()
 {
-    drmEventContext evctx;
-    memset(&evctx, 0, sizeof evctx);
-    evctx.version = 2;  // We only support the old v2 page_flip_handler
-    evctx.page_flip_handler = &page_flip_handler;
+    if (!atomic_properties)
+        return nullptr;
+
+    return std::make_unique<AtomicUpdate>(drm_fd, atomic_properties);
+}
+
+bool mgm::KMSPageFlipper::schedule_flip(AtomicUpdate const& update)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
 
-    static std::thread::id const invalid_tid;
+    auto const& flips = update.flips();
+    if (flips.empty())
+        BOOST_THROW_EXCEPTION(std::logic_error("Atomic update doesn't flip any crtc"));
 
+    for (auto const& flip : flips)
     {
-        std::unique_lock<std::mutex> lock{pf_mutex};
+        if (pending_page_flips.find(flip.crtc_id) != pending_page_flips.end())
+            BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+    }
 
-        /*
-         * While another thread is the worker (it is controlling the
-         * page flip event loop) and our event has not arrived, wait.
-         */
-        while (worker_tid != invalid_tid && !page_flip_is_done(crtc_id))
-            pf_cv.wait(lock);
+    for (auto const& flip : flips)
+        pending_page_flips[flip.crtc_id] = PageFlipEventData{flip.crtc_id, flip.connector_id, this};
 
-        /* If the page flip we are waiting for has arrived we are done. */
-        if (page_flip_is_done(crtc_id))
-            return completed_page_flips[crtc_id];
+    // Each CRTC's event erases its pending flip, so they can't share one as user data
+    auto ret = update.commit(DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK,
+                             const_cast<PageFlipEventData*>(&atomic_flip_data));
 
-        /* ...otherwise we become the worker */
-        worker_tid = std::this_thread::get_id();
+    if (ret)
+    {
+        for (auto const& flip : flips)
+            pending_page_flips.erase(flip.crtc_id);
+    }
+    else
+    {
+        pf_cv.notify_all();     // Wake the event thread, if it's idle
     }
 
-    /* Only the worker thread reaches this point */
-    bool done{false};
+    return (ret == 0);
+}
 
-    while (!done)
+mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    pf_cv.wait(lock, [&] { return page_flip_is_done(crtc_id) || event_error; });
+
+    if (!page_flip_is_done(crtc_id))
+        std::rethrow_exception(event_error);
+
+    return completed_page_flips[crtc_id];
+}
+
+void mgm::KMSPageFlipper::when_flipped(uint32_t crtc_id, std::function<void(Frame const&)> const& flipped)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    if (!page_flip_is_done(crtc_id))
+    {
+        flip_handlers.emplace(crtc_id, flipped);
+        return;
+    }
+
+    auto const frame = completed_page_flips[crtc_id];
+    lock.unlock();
+
+    flipped(frame);
+}
+
+void mgm::KMSPageFlipper::handle_events()
+{
+    pthread_setname_np(pthread_self(), "Mir/DRM");
+
+    drmEventContext evctx;
+    memset(&evctx, 0, sizeof evctx);
+    evctx.version = 2;
+    evctx.page_flip_handler = &page_flip_handler;
+#if DRM_EVENT_CONTEXT_VERSION >= 3
+    evctx.version = 3;
+    evctx.page_flip_handler2 = &page_flip_handler2;
+#endif
+
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    while (true)
     {
-        fd_set fds;
-        FD_ZERO(&fds);
-        FD_SET(drm_fd, &fds);
+        /* Only watch the DRM fd while there are flips to complete */
+        pf_cv.wait(lock, [this] { return stopping || !pending_page_flips.empty(); });
+        if (stopping)
+            return;
 
-        /*
-         * Wait for a page flip event. When we get a page flip event,
-         * page_flip_handler(), called through drmHandleEvent(), will update
-         * the pending_page_flips map.
-         */
-        auto ret = select(drm_fd + 1, &fds, nullptr, nullptr, nullptr);
+        pollfd fds[] = {{drm_fd, POLLIN, 0}, {wakeup_fd, POLLIN, 0}};
 
+        lock.unlock();
+        auto const ret = poll(fds, 2, -1);
+        auto const poll_errno = errno;
+        lock.lock();
+
+        if (ret < 0 && poll_errno != EINTR)
+        {
+            std::string const msg("Error while waiting for page-flip event");
+            event_error = std::make_exception_ptr(
+                boost::enable_error_info(
+                    std::runtime_error(msg)) << boost::errinfo_errno(poll_errno));
+        }
+        else if (ret > 0 && (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)))
         {
-            std::unique_lock<std::mutex> lock{pf_mutex};
+            std::string const msg("DRM device failed while waiting for page-flip event");
+            event_error = std::make_exception_ptr(std::runtime_error(msg));
+        }
+        else if (ret > 0 && (fds[0].revents & POLLIN))
+        {
+            /*
+             * When we get a page flip event, page_flip_handler(), called
+             * through drmHandleEvent(), will update the pending_page_flips map.
+             *
+             * Only a failure to read the fd is fatal: an interrupted read
+             * leaves the event to be read next time round, and a short one
+             * has nothing more in it for us.
+             */
+            errno = 0;
+            auto const handled = drmHandleEvent(drm_fd, &evctx);
+            auto const handle_errno = errno;
 
-            if (ret > 0)
+            if (handled < 0 && handle_errno != 0 && handle_errno != EINTR && handle_errno != EAGAIN)
             {
-                drmHandleEvent(drm_fd, &evctx);
-            }
-            else if (ret < 0 && errno != EINTR)
-            {
-                std::string const msg("Error while waiting for page-flip event");
-                BOOST_THROW_EXCEPTION(
+                std::string const msg("Error while handling page-flip event");
+                event_error = std::make_exception_ptr(
                     boost::enable_error_info(
-                        std::runtime_error(msg)) << boost::errinfo_errno(errno));
+                        std::runtime_error(msg)) << boost::errinfo_errno(handle_errno));
             }
+        }
 
-            done = page_flip_is_done(crtc_id);
-            /* Give up loop control if we are done */
-            if (done)
-                worker_tid = invalid_tid;
+        /* Tell those who asked that their flips have landed, without holding up the waiters */
+        if (!ready_handlers.empty())
+        {
+            auto const handlers = std::move(ready_handlers);
+            ready_handlers.clear();
+
+            lock.unlock();
+            for (auto const& handler : handlers)
+                handler();
+            lock.lock();
         }
 
-        /*
-         * Wake up other (non-worker) threads, so they can check whether
-         * their page-flip events have arrived, or whether they can become
-         * the worker (see pf_cv.wait(lock) above).
-         */
+        /* Wake the threads waiting for flips, to see whether theirs are done */
         pf_cv.notify_all();
-    }
-    return completed_page_flips[crtc_id];
-}
 
-std::thread::id mgm::KMSPageFlipper::debug_get_worker_tid()
-{
-    std::unique_lock<std::mutex> lock{pf_mutex};
-
-    return worker_tid;
+        /* Waiters rethrow the error; without a working fd there's nothing more to handle */
+        if (event_error)
+            return;
+    }
 }
 
 /* This method should be called with the 'pf_mutex' locked */
@@ -186,5 +319,10 @@ void mgm::KMSPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc,
         frame.ust = {clock_id, ust};
         report->report_vsync(pending->second.connector_id, frame);
         pending_page_flips.erase(pending);
+
+        auto const handlers = flip_handlers.equal_range(crtc_id);
+        for (auto i = handlers.first; i != handlers.second; ++i)
+            ready_handlers.emplace_back([handler = std::move(i->second), frame] { handler(frame); });
+        flip_handlers.erase(handlers.first, handlers.second);
     }
 }
@@ -20,9 +20,13 @@
 #define MIR_GRAPHICS_MESA_KMS_PAGE_FLIPPER_H_
 
 #include "page_flipper.h"
+#include "mir/fd.h"
 
 #include <unordered_map>
+#include <functional>
+#include <vector>
 #include <chrono>
+#include <exception>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -38,6 +42,7 @@ class DisplayReport;
 
 namespace mesa
 {
+class PropertyCache;
 
 class KMSPageFlipper;
 struct PageFlipEventData
@@ -47,28 +52,55 @@ struct PageFlipEventData
     KMSPageFlipper* flipper;
 };
 
+/**
+ * Schedules page flips and collects their completion events.
+ *
+ * Page flip events are handled by a dedicated thread as they arrive, so
+ * scheduling a flip never blocks and waiting for one only blocks until its
+ * own event has been handled.
+ */
 class KMSPageFlipper : public PageFlipper
 {
 public:
-    KMSPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
+    /**
+     * \param [in] atomic_properties  The device's property cache if atomic
+     *                                updates are enabled on it, otherwise null
+     */
+    KMSPageFlipper(
+        int drm_fd,
+        std::shared_ptr<DisplayReport> const& report,
+        std::shared_ptr<PropertyCache> const& atomic_properties);
+    ~KMSPageFlipper();
 
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
+    void when_flipped(uint32_t crtc_id, std::function<void(Frame const&)> const& flipped) override;
 
-    std::thread::id debug_get_worker_tid();
+    std::unique_ptr<AtomicUpdate> begin_atomic_update() override;
+    bool schedule_flip(AtomicUpdate const& update) override;
 
     void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
 private:
     bool page_flip_is_done(uint32_t crtc_id);
+    void handle_events();
 
     int const drm_fd;
     std::shared_ptr<DisplayReport> const report;
+    std::shared_ptr<PropertyCache> const atomic_properties;
+    /// The user data of every atomic commit; its events identify their own CRTCs
+    PageFlipEventData const atomic_flip_data;
     std::unordered_map<uint32_t,PageFlipEventData> pending_page_flips;
     std::unordered_map<uint32_t,Frame> completed_page_flips;
+    std::unordered_multimap<uint32_t,std::function<void(Frame const&)>> flip_handlers;
+    /// Handlers whose flips have completed, to be called once pf_mutex is released
+    std::vector<std::function<void()>> ready_handlers;
     std::mutex pf_mutex;
     std::condition_variable pf_cv;
-    std::thread::id worker_tid;
+    std::exception_ptr event_error;
+    bool stopping;
     clockid_t clock_id;
+    mir::Fd const wakeup_fd;
+    std::thread event_thread;
 };
 
 }
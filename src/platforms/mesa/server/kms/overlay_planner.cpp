@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "overlay_planner.h"
+#include "mir/graphics/buffer.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace mgm = mir::graphics::mesa;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+std::vector<mgk::Plane> overlay_planes(std::vector<mgk::Plane> const& planes)
+{
+    std::vector<mgk::Plane> result;
+    std::copy_if(planes.begin(), planes.end(), std::back_inserter(result),
+                 [](mgk::Plane const& plane) { return plane.type == mgk::Plane::Type::overlay; });
+    return result;
+}
+
+bool overlaps_any(geom::Rectangle const& rect, std::vector<geom::Rectangle> const& others)
+{
+    return std::any_of(others.begin(), others.end(),
+                       [&rect](geom::Rectangle const& other) { return rect.overlaps(other); });
+}
+}
+
+mgm::OverlayPlanner::OverlayPlanner(std::vector<kms::Plane> const& planes)
+    : planes{overlay_planes(planes)}
+{
+}
+
+bool mgm::OverlayPlanner::has_planes() const
+{
+    return !planes.empty();
+}
+
+auto mgm::OverlayPlanner::plan(
+    geometry::Rectangle const& area,
+    RenderableList const& renderables,
+    ScanoutFormat const& scanout_format) const -> Plan
+{
+    glm::mat4 static const identity(1);
+
+    Plan plan;
+    std::vector<bool> plane_used(planes.size(), false);
+    std::vector<geom::Rectangle> composited_above;
+    std::vector<geom::Rectangle> on_planes;
+
+    for (auto it = renderables.rbegin(); it != renderables.rend(); ++it)
+    {
+        auto const& renderable = *it;
+        auto const rect = renderable->screen_position();
+
+        // Offscreen renderables don't affect this output
+        if (!area.overlaps(rect))
+            continue;
+
+        auto const format = scanout_format(*renderable);
+        auto const buffer = renderable->buffer();
+        bool const can_scanout =
+            format != 0 &&
+            renderable->alpha() == 1.0f &&
+            renderable->transformation() == identity &&
+            buffer && buffer->size() == rect.size;
+
+        if (can_scanout && rect == area && !renderable->shaped())
+        {
+            // Nothing below an opaque fullscreen renderable can be seen
+            if (composited_above.empty())
+                plan.primary = renderable;
+            else
+                plan.composited.push_back(renderable);
+            break;
+        }
+
+        if (can_scanout && area.contains(rect) &&
+            !overlaps_any(rect, composited_above) && !overlaps_any(rect, on_planes))
+        {
+            auto chosen = planes.size();
+            for (auto i = 0u; i != planes.size(); ++i)
+            {
+                if (!plane_used[i] && planes[i].supports(format))
+                {
+                    chosen = i;
+                    break;
+                }
+            }
+
+            if (chosen != planes.size())
+            {
+                plane_used[chosen] = true;
+                on_planes.push_back(rect);
+                plan.overlays.push_back({planes[chosen].id, renderable});
+                continue;
+            }
+        }
+
+        plan.composited.push_back(renderable);
+        composited_above.push_back(rect);
+    }
+
+    std::reverse(plan.overlays.begin(), plan.overlays.end());
+    std::reverse(plan.composited.begin(), plan.composited.end());
+
+    return plan;
+}
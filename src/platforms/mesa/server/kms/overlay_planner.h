@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_OVERLAY_PLANNER_H_
+#define MIR_GRAPHICS_MESA_OVERLAY_PLANNER_H_
+
+#include "mir/graphics/renderable.h"
+#include "mir/geometry/rectangle.h"
+#include "kms-utils/kms_plane.h"
+
+#include <functional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+/**
+ * Decides which renderables of a frame can be scanned out directly by
+ * hardware planes, leaving the rest to be composited with GL.
+ *
+ * The bottom-most renderable may go on the primary plane if it covers the
+ * whole output (as with bypass). Renderables above it may go on overlay
+ * planes as long as they are unscaled, untransformed, fully on the output,
+ * don't overlap each other and aren't covered by anything left for GL.
+ *
+ * The cursor plane is left to mesa::Cursor, which shows and hides the
+ * hardware cursor independently of composition.
+ */
+class OverlayPlanner
+{
+public:
+    /**
+     * The DRM fourcc format a plane needs to support to scan out the
+     * renderable's buffer as-is, or 0 if the buffer can't be scanned out.
+     */
+    typedef std::function<uint32_t(Renderable const&)> ScanoutFormat;
+
+    struct Assignment
+    {
+        uint32_t plane_id;
+        std::shared_ptr<Renderable> renderable;
+    };
+
+    struct Plan
+    {
+        std::shared_ptr<Renderable> primary;  ///< Replaces the composited frame, if set
+        std::vector<Assignment> overlays;     ///< Bottom to top
+        RenderableList composited;            ///< Everything that still needs GL, bottom to top
+    };
+
+    /**
+     * \param [in] planes  The planes usable on the output; only overlay planes are used
+     */
+    explicit OverlayPlanner(std::vector<kms::Plane> const& planes);
+
+    Plan plan(geometry::Rectangle const& area,
+              RenderableList const& renderables,
+              ScanoutFormat const& scanout_format) const;
+
+    bool has_planes() const;
+
+private:
+    std::vector<kms::Plane> const planes;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_OVERLAY_PLANNER_H_ */
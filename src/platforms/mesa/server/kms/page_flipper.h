@@ -21,6 +21,8 @@
 
 #include "mir/graphics/frame.h"
 #include <cstdint>
+#include <functional>
+#include <memory>
 
 namespace mir
 {
@@ -28,6 +30,7 @@ namespace graphics
 {
 namespace mesa
 {
+class AtomicUpdate;
 
 class PageFlipper
 {
@@ -36,6 +39,24 @@ public:
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
+    /**
+     * Calls flipped with the frame on which crtc_id's pending flip lands,
+     * from the thread that handles flip events. If no flip is pending it
+     * is called at once, with the last flip.
+     */
+    virtual void when_flipped(uint32_t crtc_id, std::function<void(Frame const&)> const& flipped) = 0;
+
+    /**
+     * Starts an atomic update of the device.
+     *
+     * \return  The update, or null if the device only supports the legacy API
+     */
+    virtual std::unique_ptr<AtomicUpdate> begin_atomic_update() = 0;
+    /**
+     * Commits update without waiting for it. Each of its flips() completes
+     * as if it had been scheduled by schedule_flip().
+     */
+    virtual bool schedule_flip(AtomicUpdate const& update) = 0;
 
 protected:
     PageFlipper() = default;
@@ -32,6 +32,7 @@
 #include "one_shot_device_observer.h"
 #include "mir/raii.h"
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/extension_list.h"
 #include "mir/graphics/gl_config.h"
 
 #include <EGL/egl.h>
@@ -125,7 +126,7 @@ mg::PlatformPriority probe_graphics_platform(
         mir::log_info("Unsupported: EGL platform does not support client extensions.");
         return mg::PlatformPriority::unsupported;
     }
-    if (strstr(client_extensions, "EGL_MESA_platform_gbm") == nullptr)
+    if (!mg::has_extension(client_extensions, "EGL_MESA_platform_gbm"))
     {
         // No platform_gbm support, so we can't work.
         mir::log_info("Unsupported: EGL platform does not support EGL_MESA_platform_gbm extension");
@@ -199,23 +199,27 @@ bool mgm::compatible(mgm::RealKMSDisplayConfiguration const& conf1, mgm::RealKMS
 
         for (unsigned int i = 0; i < count; ++i)
         {
-            compatible &= (conf1.outputs[i].first.power_mode == conf2.outputs[i].first.power_mode);
-            if (compatible)
-            {
-                auto clone = conf2.outputs[i].first;
-
-                // ignore difference in orientation, scale factor, form factor, subpixel arrangement
-                clone.orientation = conf1.outputs[i].first.orientation;
-                clone.subpixel_arrangement = conf1.outputs[i].first.subpixel_arrangement;
-                clone.scale = conf1.outputs[i].first.scale;
-                clone.form_factor = conf1.outputs[i].first.form_factor;
-                clone.custom_logical_size = conf1.outputs[i].first.custom_logical_size;
-                compatible &= (conf1.outputs[i].first == clone);
-            }
-            else
+            compatible &= mgm::compatible(conf1.outputs[i].first, conf2.outputs[i].first);
+            if (!compatible)
             	break;
         }
     }
 
     return compatible;
 }
+
+bool mgm::compatible(mg::DisplayConfigurationOutput const& output1, mg::DisplayConfigurationOutput const& output2)
+{
+    if (output1.power_mode != output2.power_mode)
+        return false;
+
+    auto clone = output2;
+
+    // ignore difference in orientation, scale factor, form factor, subpixel arrangement
+    clone.orientation = output1.orientation;
+    clone.subpixel_arrangement = output1.subpixel_arrangement;
+    clone.scale = output1.scale;
+    clone.form_factor = output1.form_factor;
+    clone.custom_logical_size = output1.custom_logical_size;
+    return output1 == clone;
+}
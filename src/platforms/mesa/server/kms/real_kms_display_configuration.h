@@ -61,6 +61,8 @@ private:
 };
 
 bool compatible(RealKMSDisplayConfiguration const& conf1, RealKMSDisplayConfiguration const& conf2);
+/// Whether an output configured as output1 can be reconfigured as output2 without changing its mode
+bool compatible(DisplayConfigurationOutput const& output1, DisplayConfigurationOutput const& output2);
 
 }
 }
@@ -19,6 +19,7 @@
 #include "real_kms_output.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
+#include "atomic_kms.h"
 #include "kms-utils/kms_connector.h"
 #include "mir/fatal.h"
 #include "mir/log.h"
@@ -78,6 +79,8 @@ mgm::RealKMSOutput::RealKMSOutput(
       connector{std::move(connector)},
       mode_index{0},
       current_crtc(),
+      primary_plane_crtc_id{0},
+      primary_plane{0},
       saved_crtc(),
       using_saved_crtc{true},
       has_cursor_{false},
@@ -240,6 +243,22 @@ void mgm::RealKMSOutput::wait_for_page_flip()
     last_frame_.store(page_flipper->wait_for_flip(current_crtc->crtc_id));
 }
 
+void mgm::RealKMSOutput::when_page_flipped(std::function<void(Frame const&)> const& flipped)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    if (power_mode != mir_power_mode_on || !current_crtc)
+    {
+        lg.unlock();
+        flipped(last_frame());
+        return;
+    }
+
+    auto const crtc_id = current_crtc->crtc_id;
+    lg.unlock();
+
+    page_flipper->when_flipped(crtc_id, flipped);
+}
+
 mg::Frame mgm::RealKMSOutput::last_frame() const
 {
     return last_frame_.load();
@@ -302,6 +321,156 @@ bool mgm::RealKMSOutput::has_cursor() const
     return has_cursor_;
 }
 
+std::vector<mgk::Plane> mgm::RealKMSOutput::planes() const
+{
+    std::vector<kms::Plane> usable;
+    if (!current_crtc)
+        return usable;
+
+    auto const index = kms::crtc_index(drm_fd_, current_crtc->crtc_id);
+    for (auto const& plane : kms::enumerate_planes(drm_fd_))
+    {
+        if (plane.type != kms::Plane::Type::primary && plane.can_be_used_on(index))
+            usable.push_back(plane);
+    }
+
+    return usable;
+}
+
+void mgm::RealKMSOutput::clear_plane(uint32_t plane_id)
+{
+    if (!current_crtc)
+        return;
+
+    if (auto result = drmModeSetPlane(drm_fd_, plane_id, current_crtc->crtc_id, 0, 0,
+                                      0, 0, 0, 0, 0, 0, 0, 0))
+    {
+        mir::log_warning("clear_plane: drmModeSetPlane failed (%s)", strerror(-result));
+    }
+}
+
+std::unique_ptr<mgm::AtomicUpdate> mgm::RealKMSOutput::begin_atomic_update()
+{
+    std::lock_guard<std::mutex> lg(power_mutex);
+
+    // Leave powered down outputs to the legacy path, which knows not to flip them
+    if (power_mode != mir_power_mode_on)
+        return nullptr;
+
+    return page_flipper->begin_atomic_update();
+}
+
+bool mgm::RealKMSOutput::add_to_update(AtomicUpdate& update, FBHandle const& fb, bool modeset)
+{
+    if (modeset && !ensure_crtc())
+    {
+        mir::log_error("Output %s has no associated CRTC to set a framebuffer on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    if (!current_crtc)
+        return false;
+
+    auto const plane_id = primary_plane_id();
+    if (!plane_id)
+        return false;
+
+    auto const crtc_id = current_crtc->crtc_id;
+    auto const& mode = connector->modes[mode_index];
+
+    try
+    {
+        if (modeset)
+        {
+            update.set(crtc_id, DRM_MODE_OBJECT_CRTC, "MODE_ID", update.mode_blob(mode));
+            update.set(crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE", 1);
+            update.set(connector->connector_id, DRM_MODE_OBJECT_CONNECTOR, "CRTC_ID", crtc_id);
+        }
+
+        // Source coordinates are 16.16 fixed point
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "FB_ID", fb.get_drm_fb_id());
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_ID", crtc_id);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_X", uint64_t(fb_offset.dx.as_int()) << 16);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_Y", uint64_t(fb_offset.dy.as_int()) << 16);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_W", uint64_t(mode.hdisplay) << 16);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_H", uint64_t(mode.vdisplay) << 16);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_X", 0);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_Y", 0);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_W", mode.hdisplay);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_H", mode.vdisplay);
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Output %s can't be updated atomically: %s",
+                         mgk::connector_name(connector).c_str(), e.what());
+        return false;
+    }
+
+    if (modeset)
+        using_saved_crtc = false;
+    else
+        update.add_flip(crtc_id, connector->connector_id);
+
+    return true;
+}
+
+void mgm::RealKMSOutput::add_plane_to_update(
+    AtomicUpdate& update,
+    uint32_t plane_id,
+    FBHandle const* fb,
+    geometry::Rectangle const& destination)
+{
+    if (!current_crtc)
+        return;
+
+    auto const width = destination.size.width.as_uint32_t();
+    auto const height = destination.size.height.as_uint32_t();
+
+    update.set(plane_id, DRM_MODE_OBJECT_PLANE, "FB_ID", fb ? fb->get_drm_fb_id() : 0);
+    update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_ID", fb ? current_crtc->crtc_id : 0);
+    if (fb)
+    {
+        // Source coordinates are 16.16 fixed point
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_X", 0);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_Y", 0);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_W", uint64_t(width) << 16);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_H", uint64_t(height) << 16);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_X", uint64_t(destination.top_left.x.as_int()));
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_Y", uint64_t(destination.top_left.y.as_int()));
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_W", width);
+        update.set(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_H", height);
+    }
+}
+
+bool mgm::RealKMSOutput::schedule_page_flip(AtomicUpdate const& update)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    return page_flipper->schedule_flip(update);
+}
+
+uint32_t mgm::RealKMSOutput::primary_plane_id()
+{
+    if (primary_plane_crtc_id != current_crtc->crtc_id)
+    {
+        primary_plane_crtc_id = current_crtc->crtc_id;
+        primary_plane = 0;
+
+        auto const index = kms::crtc_index(drm_fd_, current_crtc->crtc_id);
+        for (auto const& plane : kms::enumerate_planes(drm_fd_))
+        {
+            // Drivers give each CRTC a primary plane of its own
+            if (plane.type == kms::Plane::Type::primary && plane.can_be_used_on(index))
+            {
+                primary_plane = plane.id;
+                break;
+            }
+        }
+    }
+
+    return primary_plane;
+}
+
 bool mgm::RealKMSOutput::ensure_crtc()
 {
     /* Nothing to do if we already have a crtc */
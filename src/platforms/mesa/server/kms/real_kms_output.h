@@ -23,6 +23,7 @@
 #include "kms_output.h"
 #include "kms-utils/drm_mode_resources.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -55,12 +56,25 @@ public:
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
+    void when_page_flipped(std::function<void(Frame const&)> const& flipped) override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
     bool clear_cursor() override;
     bool has_cursor() const override;
 
+    std::vector<kms::Plane> planes() const override;
+    void clear_plane(uint32_t plane_id) override;
+
+    std::unique_ptr<AtomicUpdate> begin_atomic_update() override;
+    bool add_to_update(AtomicUpdate& update, FBHandle const& fb, bool modeset) override;
+    void add_plane_to_update(
+        AtomicUpdate& update,
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination) override;
+    bool schedule_page_flip(AtomicUpdate const& update) override;
+
     void set_power_mode(MirPowerMode mode) override;
     void set_gamma(GammaCurves const& gamma) override;
 
@@ -76,6 +90,7 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    uint32_t primary_plane_id();
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -84,9 +99,11 @@ private:
     size_t mode_index;
     geometry::Displacement fb_offset;
     kms::DRMModeCrtcUPtr current_crtc;
+    uint32_t primary_plane_crtc_id;   ///< The CRTC primary_plane was found for
+    uint32_t primary_plane;
     drmModeCrtc saved_crtc;
     bool using_saved_crtc;
-    bool has_cursor_;
+    std::atomic<bool> has_cursor_;
 
     MirPowerMode power_mode;
     int dpms_enum_id;
@@ -23,7 +23,8 @@
 #include "display_configuration.h"
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
-#include <cstring>
+#include "mir/graphics/extension_list.h"
+#include <EGL/eglext.h>
 
 namespace mg=mir::graphics;
 namespace mgx=mg::X;
@@ -40,8 +41,9 @@ mgx::DisplayBuffer::DisplayBuffer(::Display* const x_dpy,
                                     area{{0,0},view_area_size},
                                     transform(1),
                                     egl{gl_config},
-                                    last_frame{f},
-                                    eglGetSyncValues{nullptr}
+                                    last_frame_{f},
+                                    eglGetSyncValues{nullptr},
+                                    supports_buffer_age{false}
 {
     egl.setup(x_dpy, win, shared_context);
     egl.report_egl_configuration(
@@ -69,16 +71,11 @@ mgx::DisplayBuffer::DisplayBuffer(::Display* const x_dpy,
      * However this remains the correct and only way of doing it in EGL on X11.
      * AFAIK the only existing implementation is Mesa.
      */
-    auto const extensions = eglQueryString(egl.display(), EGL_EXTENSIONS);
-    auto const extension = "EGL_CHROMIUM_sync_control";
-    auto const found = strstr(extensions, extension);
-    if (found)
-    {
-        char end = found[strlen(extension)];
-        if (end == '\0' || end == ' ')
-            eglGetSyncValues = reinterpret_cast<EglGetSyncValuesCHROMIUM*>(
-                                 eglGetProcAddress("eglGetSyncValuesCHROMIUM"));
-    }
+    if (mg::has_extension(eglQueryString(egl.display(), EGL_EXTENSIONS), "EGL_CHROMIUM_sync_control"))
+        eglGetSyncValues = reinterpret_cast<EglGetSyncValuesCHROMIUM*>(
+                             eglGetProcAddress("eglGetSyncValuesCHROMIUM"));
+
+    supports_buffer_age = mg::has_extension(eglQueryString(egl.display(), EGL_EXTENSIONS), "EGL_EXT_buffer_age");
 }
 
 geom::Rectangle mgx::DisplayBuffer::view_area() const
@@ -124,12 +121,12 @@ void mgx::DisplayBuffer::swap_buffers()
         mg::Frame frame;
         frame.msc = msc;
         frame.ust = {CLOCK_MONOTONIC, ust_ns};
-        last_frame->store(frame);
+        last_frame_->store(frame);
         (void)sbc; // unused
     }
     else  // Extension not available? Fall back to a reasonable estimate:
     {
-        last_frame->increment_now();
+        last_frame_->increment_now();
     }
 
     /*
@@ -138,13 +135,24 @@ void mgx::DisplayBuffer::swap_buffers()
      * real vsyncs because that would mean the compositor never sleeps.
      */
     report->report_vsync(mgx::DisplayConfiguration::the_output_id.as_value(),
-                         last_frame->load());
+                         last_frame_->load());
 }
 
 void mgx::DisplayBuffer::bind()
 {
 }
 
+int mgx::DisplayBuffer::buffer_age()
+{
+    EGLint age = 0;
+    if (!supports_buffer_age ||
+        !eglQuerySurface(egl.display(), egl.surface(), EGL_BUFFER_AGE_EXT, &age))
+    {
+        return 0;
+    }
+    return age;
+}
+
 glm::mat2 mgx::DisplayBuffer::transformation() const
 {
     return transform;
@@ -179,3 +187,14 @@ std::chrono::milliseconds mgx::DisplayBuffer::recommended_sleep() const
 {
     return std::chrono::milliseconds::zero();
 }
+
+mg::Frame mgx::DisplayBuffer::last_frame() const
+{
+    return last_frame_->load();
+}
+
+std::chrono::nanoseconds mgx::DisplayBuffer::frame_interval() const
+{
+    // The X server gives us no refresh rate, so we can't predict the next vsync
+    return std::chrono::nanoseconds::zero();
+}
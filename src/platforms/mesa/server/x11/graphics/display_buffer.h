@@ -60,6 +60,7 @@ public:
     void release_current() override;
     void swap_buffers() override;
     void bind() override;
+    int buffer_age() override;
     bool overlay(RenderableList const& renderlist) override;
     void set_view_area(geometry::Rectangle const& a);
     void set_transformation(glm::mat2 const& t);
@@ -68,6 +69,8 @@ public:
         std::function<void(graphics::DisplayBuffer&)> const& f) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    Frame last_frame() const override;
+    std::chrono::nanoseconds frame_interval() const override;
 
     glm::mat2 transformation() const override;
     NativeDisplayBuffer* native_display_buffer() override;
@@ -77,12 +80,13 @@ private:
     geometry::Rectangle area;
     glm::mat2 transform;
     helpers::EGLHelper egl;
-    std::shared_ptr<AtomicFrame> const last_frame;
+    std::shared_ptr<AtomicFrame> const last_frame_;
 
     typedef EGLBoolean (EGLAPIENTRY EglGetSyncValuesCHROMIUM)
         (EGLDisplay dpy, EGLSurface surface, int64_t *ust,
          int64_t *msc, int64_t *sbc);
     EglGetSyncValuesCHROMIUM* eglGetSyncValues;
+    bool supports_buffer_age;
 };
 
 }
@@ -0,0 +1,511 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "draw_batcher.h"
+#include "mir/graphics/buffer.h"
+#include "mir/gl/texture_cache.h"
+#include "mir/gl/texture.h"
+#include "mir/report_exception.h"
+
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace mg = mir::graphics;
+namespace mgl = mir::gl;
+namespace mrg = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Looking further down the stack for a batch to join costs more than it saves
+size_t const max_batch_lookback = 16;
+// Choosing between textures costs every fragment, so only renderables small
+// enough for the draw call to matter more than their fill share draw calls
+// with other textures.
+long long const max_multitexture_area = 256 * 256;
+
+GLuint generate_buffer()
+{
+    GLuint id = 0;
+    glGenBuffers(1, &id);
+    return id;
+}
+
+// The vertex indices of the triangles making up a primitive, if it can be drawn as GL_TRIANGLES
+std::vector<int> triangle_indices(GLenum type, int nvertices)
+{
+    std::vector<int> indices;
+    switch (type)
+    {
+    case GL_TRIANGLES:
+        for (int i = 0; i + 2 < nvertices; i += 3)
+            indices.insert(indices.end(), {i, i + 1, i + 2});
+        break;
+    case GL_TRIANGLE_STRIP:
+        for (int i = 0; i + 2 < nvertices; ++i)
+        {
+            if (i % 2 == 0)
+                indices.insert(indices.end(), {i, i + 1, i + 2});
+            else
+                indices.insert(indices.end(), {i + 1, i, i + 2});
+        }
+        break;
+    case GL_TRIANGLE_FAN:
+        for (int i = 1; i + 1 < nvertices; ++i)
+            indices.insert(indices.end(), {0, i, i + 1});
+        break;
+    default:
+        for (int i = 0; i != nvertices; ++i)
+            indices.push_back(i);
+        break;
+    }
+    return indices;
+}
+
+bool drawn_as_triangles(GLenum type)
+{
+    return type == GL_TRIANGLES || type == GL_TRIANGLE_STRIP || type == GL_TRIANGLE_FAN;
+}
+
+GLchar const* const vshader =
+{
+    "attribute vec4 position;\n"
+    "attribute vec2 texcoord;\n"
+    "attribute vec2 properties;\n"
+    "uniform mat4 screen_to_gl_coords;\n"
+    "uniform mat4 display_transform;\n"
+    "varying vec2 v_texcoord;\n"
+    "varying vec2 v_properties;\n"
+    "void main() {\n"
+    "   gl_Position = display_transform * screen_to_gl_coords * position;\n"
+    "   v_texcoord = texcoord;\n"
+    "   v_properties = properties;\n"
+    "}\n"
+};
+
+/*
+ * The properties are the alpha and the texture unit. Choosing between
+ * textures and applying alpha cost every fragment something, so there's a
+ * shader for each combination.
+ */
+std::string fshader_source(bool premultiplied, bool rgbx_alpha, bool multitexture, bool alpha)
+{
+    std::string source =
+        "#ifdef GL_ES\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "varying vec2 v_texcoord;\n"
+        "varying vec2 v_properties;\n";
+
+    if (multitexture)
+    {
+        source +=
+            "uniform sampler2D tex0, tex1, tex2, tex3, tex4, tex5, tex6, tex7;\n"
+            "void main() {\n"
+            "   vec4 frag;\n"
+            "   float unit = v_properties.y;\n"
+            "   if (unit < 0.5) frag = texture2D(tex0, v_texcoord);\n"
+            "   else if (unit < 1.5) frag = texture2D(tex1, v_texcoord);\n"
+            "   else if (unit < 2.5) frag = texture2D(tex2, v_texcoord);\n"
+            "   else if (unit < 3.5) frag = texture2D(tex3, v_texcoord);\n"
+            "   else if (unit < 4.5) frag = texture2D(tex4, v_texcoord);\n"
+            "   else if (unit < 5.5) frag = texture2D(tex5, v_texcoord);\n"
+            "   else if (unit < 6.5) frag = texture2D(tex6, v_texcoord);\n"
+            "   else frag = texture2D(tex7, v_texcoord);\n";
+    }
+    else
+    {
+        source +=
+            "uniform sampler2D tex0;\n"
+            "void main() {\n"
+            "   vec4 frag = texture2D(tex0, v_texcoord);\n";
+    }
+
+    if (rgbx_alpha)
+        source += "   gl_FragColor = vec4(v_properties.x * frag.rgb, v_properties.x);\n";  // LP: #1423462
+    else if (premultiplied && alpha)
+        source += "   gl_FragColor = v_properties.x * frag;\n";
+    else
+        source += "   gl_FragColor = frag;\n";
+
+    return source + "}\n";
+}
+
+// ProgramFamily keys shaders by their source pointers, so they have to stay put
+GLchar const* fshader(bool premultiplied, bool rgbx_alpha, bool multitexture, bool alpha)
+{
+    static std::vector<std::string> const sources = []
+        {
+            std::vector<std::string> sources;
+            for (int i = 0; i != 16; ++i)
+                sources.push_back(fshader_source(i & 8, i & 4, i & 2, i & 1));
+            return sources;
+        }();
+
+    return sources[premultiplied * 8 + rgbx_alpha * 4 + multitexture * 2 + alpha].c_str();
+}
+}
+
+mrg::DrawBatcher::DrawBatcher(ProgramFamily& family, Tessellator const& tessellate)
+    : family(family),
+      tessellate{tessellate},
+      vertex_buffer{generate_buffer()}
+{
+}
+
+mrg::DrawBatcher::~DrawBatcher()
+{
+    glDeleteBuffers(1, &vertex_buffer);
+}
+
+auto mrg::DrawBatcher::tessellation_of(mg::Renderable const& renderable) -> Tessellation const&
+{
+    auto const position = renderable.screen_position();
+    auto const transformation = renderable.transformation();
+    auto const alpha = renderable.alpha();
+    auto const shaped = renderable.shaped();
+    auto const buffer_size = renderable.buffer()->size();
+
+    auto cached = tessellations.find(renderable.id());
+    if (cached != tessellations.end() &&
+        cached->second.screen_position == position &&
+        cached->second.transformation == transformation &&
+        cached->second.alpha == alpha &&
+        cached->second.shaped == shaped &&
+        cached->second.buffer_size == buffer_size)
+    {
+        cached->second.used = true;
+        return cached->second;
+    }
+
+    primitives.clear();
+    tessellate(primitives, renderable);
+
+    Tessellation tessellation{position, transformation, alpha, shaped, buffer_size, {}, true};
+
+    // These renderable method names could be better (see LP: #1236224)
+    Blend const client_blend =
+        shaped ? Blend::premultiplied :
+        alpha == 1.0f ? Blend::none :
+        Blend::rgbx_alpha;
+
+    glm::vec4 const centre{
+        position.top_left.x.as_int() + position.size.width.as_int() / 2.0f,
+        position.top_left.y.as_int() + position.size.height.as_int() / 2.0f,
+        0.0f, 0.0f};
+
+    for (auto const& primitive : primitives)
+    {
+        bool const client_texture = primitive.tex_id == 0;
+        Piece piece{
+            drawn_as_triangles(primitive.type) ? static_cast<GLenum>(GL_TRIANGLES) : primitive.type,
+            primitive.tex_id,
+            client_texture ? client_blend : Blend::premultiplied,
+            alpha < 1.0f,
+            {}};
+
+        for (auto const i : triangle_indices(primitive.type, primitive.nvertices))
+        {
+            auto const& v = primitive.vertices[i];
+            auto const p = transformation *
+                (glm::vec4{v.position[0], v.position[1], v.position[2], 1.0f} - centre) + centre;
+            piece.vertices.push_back(
+                {{p[0], p[1], p[2], p[3]}, {v.texcoord[0], v.texcoord[1]}, alpha, 0.0f});
+        }
+
+        tessellation.pieces.push_back(std::move(piece));
+    }
+
+    auto& result = tessellations[renderable.id()];
+    result = std::move(tessellation);
+    return result;
+}
+
+void mrg::DrawBatcher::add_to_batches(
+    Piece const& piece,
+    mgl::Texture const* texture,
+    geom::Rectangle const& area,
+    bool transformed)
+{
+    TextureRef const texture_ref{texture, texture ? 0 : piece.tex_id};
+    bool const small = !transformed &&
+        static_cast<long long>(area.size.width.as_int()) * area.size.height.as_int() <= max_multitexture_area;
+
+    auto const overlaps = [&](Batch const& batch)
+        {
+            return transformed || batch.everywhere ||
+                std::any_of(batch.areas.begin(), batch.areas.end(),
+                            [&area](geom::Rectangle const& other) { return area.overlaps(other); });
+        };
+
+    auto const unit_in = [&](Batch const& batch)
+        {
+            if (piece.type != GL_TRIANGLES || batch.type != GL_TRIANGLES || batch.blend != piece.blend)
+                return -1;
+            auto const found = std::find(batch.textures.begin(), batch.textures.end(), texture_ref);
+            if (found != batch.textures.end())
+                return static_cast<int>(found - batch.textures.begin());
+            if (batch.textures.size() < max_textures && small && !batch.large)
+                return static_cast<int>(batch.textures.size());
+            return -1;
+        };
+
+    // Join the highest batch we can, as long as we'd not be moved below
+    // anything we overlap.
+    Batch* target = nullptr;
+    int unit = 0;
+    size_t looked = 0;
+    for (auto b = batches.rbegin(); b != batches.rend() && looked != max_batch_lookback; ++b, ++looked)
+    {
+        unit = unit_in(*b);
+        if (unit >= 0)
+        {
+            target = &*b;
+            break;
+        }
+        if (overlaps(*b))
+            break;
+    }
+
+    if (!target)
+    {
+        batches.push_back({piece.type, piece.blend, {}, {}, false, false, {}});
+        target = &batches.back();
+        unit = 0;
+    }
+
+    if (unit == static_cast<int>(target->textures.size()))
+        target->textures.push_back(texture_ref);
+    if (!small)
+        target->large = true;
+    if (transformed)
+        target->everywhere = true;
+    else
+        target->areas.push_back(area);
+    target->pieces.emplace_back(&piece, unit);
+}
+
+unsigned mrg::DrawBatcher::draw(
+    mg::RenderableList const& renderables,
+    mgl::TextureCache& texture_cache,
+    glm::mat4 const& screen_to_gl_coords,
+    glm::mat4 const& display_transform)
+{
+    static glm::mat4 const identity{1};
+
+    batches.clear();
+
+    // Texture loads bind to the active unit
+    glActiveTexture(GL_TEXTURE0);
+    for (auto const& renderable : renderables)
+    {
+        // if we fail to load the texture, we need to carry on (part of lp:1629275)
+        std::shared_ptr<mgl::Texture> texture;
+        try
+        {
+            texture = texture_cache.load(*renderable);
+        }
+        catch (std::exception const&)
+        {
+            report_exception();
+            continue;
+        }
+
+        auto const& tessellation = tessellation_of(*renderable);
+        bool const transformed = tessellation.transformation != identity;
+        for (auto const& piece : tessellation.pieces)
+        {
+            add_to_batches(piece, piece.tex_id == 0 ? texture.get() : nullptr,
+                           tessellation.screen_position, transformed);
+        }
+    }
+
+    vertices.clear();
+    for (auto const& batch : batches)
+    {
+        for (auto const& piece : batch.pieces)
+        {
+            for (auto vertex : piece.first->vertices)
+            {
+                vertex.texture = piece.second;
+                vertices.push_back(vertex);
+            }
+        }
+    }
+
+    if (vertices.empty())
+        return 0;
+
+    // Respecifying the whole buffer each frame lets the driver give us fresh
+    // storage rather than wait for the GPU to finish reading the last frame's.
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
+
+    std::vector<TextureRef> bound(max_textures, TextureRef{nullptr, 0});
+    Program* program = nullptr;
+    bool blend_set = false;
+    Blend blend = Blend::none;
+    GLint first = 0;
+    unsigned draw_calls = 0;
+
+    for (auto const& batch : batches)
+    {
+        auto& batch_program = program_for(batch);
+        if (&batch_program != program)
+        {
+            if (program)
+            {
+                if (program->properties_attr >= 0)
+                    glDisableVertexAttribArray(program->properties_attr);
+                glDisableVertexAttribArray(program->texcoord_attr);
+                glDisableVertexAttribArray(program->position_attr);
+            }
+            program = &batch_program;
+
+            glUseProgram(program->id);
+            if (!program->uniforms_set || screen_to_gl_coords != program->screen_to_gl_coords)
+            {
+                glUniformMatrix4fv(program->screen_to_gl_coords_uniform, 1, GL_FALSE,
+                                   glm::value_ptr(screen_to_gl_coords));
+                program->screen_to_gl_coords = screen_to_gl_coords;
+            }
+            if (!program->uniforms_set || display_transform != program->display_transform)
+            {
+                glUniformMatrix4fv(program->display_transform_uniform, 1, GL_FALSE,
+                                   glm::value_ptr(display_transform));
+                program->display_transform = display_transform;
+            }
+            program->uniforms_set = true;
+
+            glEnableVertexAttribArray(program->position_attr);
+            glEnableVertexAttribArray(program->texcoord_attr);
+            glVertexAttribPointer(program->position_attr, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  reinterpret_cast<void const*>(offsetof(Vertex, position)));
+            glVertexAttribPointer(program->texcoord_attr, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  reinterpret_cast<void const*>(offsetof(Vertex, texcoord)));
+            if (program->properties_attr >= 0)
+            {
+                glEnableVertexAttribArray(program->properties_attr);
+                glVertexAttribPointer(program->properties_attr, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                      reinterpret_cast<void const*>(offsetof(Vertex, alpha)));
+            }
+        }
+
+        for (size_t unit = 0; unit != batch.textures.size(); ++unit)
+        {
+            auto const& texture = batch.textures[unit];
+            if (bound[unit] == texture)
+                continue;
+
+            glActiveTexture(GL_TEXTURE0 + unit);
+            if (texture.first)
+                texture.first->bind();
+            else
+                glBindTexture(GL_TEXTURE_2D, texture.second);
+            bound[unit] = texture;
+        }
+
+        if (!blend_set || batch.blend != blend)
+        {
+            switch (batch.blend)
+            {
+            case Blend::premultiplied:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                    GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            case Blend::rgbx_alpha:
+                // The shader makes the source alpha the renderable's alpha,
+                // and the destination alpha is kept.
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                    GL_ZERO, GL_ONE);
+                break;
+            default:
+                glDisable(GL_BLEND);
+                break;
+            }
+            blend = batch.blend;
+            blend_set = true;
+        }
+
+        GLsizei count = 0;
+        for (auto const& piece : batch.pieces)
+            count += piece.first->vertices.size();
+
+        glDrawArrays(batch.type, first, count);
+        ++draw_calls;
+        first += count;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    if (program->properties_attr >= 0)
+        glDisableVertexAttribArray(program->properties_attr);
+    glDisableVertexAttribArray(program->texcoord_attr);
+    glDisableVertexAttribArray(program->position_attr);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return draw_calls;
+}
+
+auto mrg::DrawBatcher::program_for(Batch const& batch) -> Program&
+{
+    bool const multitexture = batch.textures.size() > 1;
+    bool const alpha = std::any_of(batch.pieces.begin(), batch.pieces.end(),
+        [](std::pair<Piece const*, int> const& piece) { return piece.first->translucent; });
+
+    auto& program = programs[(batch.blend * 2 + multitexture) * 2 + alpha];
+    if (!program.id)
+    {
+        program.id = family.add_program(
+            vshader,
+            fshader(batch.blend == Blend::premultiplied, batch.blend == Blend::rgbx_alpha, multitexture, alpha));
+        program.position_attr = glGetAttribLocation(program.id, "position");
+        program.texcoord_attr = glGetAttribLocation(program.id, "texcoord");
+        program.properties_attr = glGetAttribLocation(program.id, "properties");
+        program.screen_to_gl_coords_uniform = glGetUniformLocation(program.id, "screen_to_gl_coords");
+        program.display_transform_uniform = glGetUniformLocation(program.id, "display_transform");
+
+        glUseProgram(program.id);
+        for (int unit = 0; unit != (multitexture ? max_textures : 1); ++unit)
+        {
+            auto const name = "tex" + std::to_string(unit);
+            glUniform1i(glGetUniformLocation(program.id, name.c_str()), unit);
+        }
+    }
+    return program;
+}
+
+void mrg::DrawBatcher::drop_unused()
+{
+    auto t = tessellations.begin();
+    while (t != tessellations.end())
+    {
+        if (t->second.used)
+        {
+            t->second.used = false;
+            ++t;
+        }
+        else
+        {
+            t = tessellations.erase(t);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_DRAW_BATCHER_H_
+#define MIR_RENDERER_GL_DRAW_BATCHER_H_
+
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/renderable.h>
+#include <mir/gl/primitive.h>
+#include "program_family.h"
+
+#include MIR_SERVER_GL_H
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace gl { class Texture; class TextureCache; }
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * Draws a frame from a single vertex buffer, in as few draw calls as
+ * stacking allows.
+ *
+ * Renderables are transformed on the CPU, so that neighbours can share a
+ * draw call regardless of their transformation and alpha. Each draw call
+ * samples from up to max_textures textures (if they're all small) and uses
+ * one blend state, and a renderable is only drawn out of order when it
+ * doesn't overlap anything it would be moved below. Tessellation is kept until a renderable moves,
+ * is transformed, changes alpha or gets a buffer of a different size.
+ *
+ * Each draw call uses the simplest of a handful of programs that will do,
+ * which are compiled the first time they're needed.
+ */
+class DrawBatcher
+{
+public:
+    typedef std::function<void(std::vector<mir::gl::Primitive>&, graphics::Renderable const&)> Tessellator;
+
+    DrawBatcher(ProgramFamily& family, Tessellator const& tessellate);
+    ~DrawBatcher();
+
+    /**
+     * Draws the renderables, bottom to top.
+     *   \returns The number of draw calls made
+     */
+    unsigned draw(graphics::RenderableList const& renderables,
+                  mir::gl::TextureCache& texture_cache,
+                  glm::mat4 const& screen_to_gl_coords,
+                  glm::mat4 const& display_transform);
+
+    /// Forgets the tessellation of renderables not drawn since the last call
+    void drop_unused();
+
+    /// Every GLES2 implementation has at least this many texture units
+    static int const max_textures = 8;
+
+private:
+    DrawBatcher(DrawBatcher const&) = delete;
+    DrawBatcher& operator=(DrawBatcher const&) = delete;
+
+    enum Blend
+    {
+        none,           // Opaque RGBX
+        premultiplied,  // RGBA
+        rgbx_alpha,     // Translucent RGBX: must not use the texture's alpha
+        blends
+    };
+
+    struct Vertex
+    {
+        GLfloat position[4];
+        GLfloat texcoord[2];
+        GLfloat alpha;
+        GLfloat texture;
+    };
+
+    struct Program
+    {
+        GLuint id = 0;
+        GLint position_attr = -1;
+        GLint texcoord_attr = -1;
+        GLint properties_attr = -1;    ///< -1 if the shaders ignore it, as single textures without alpha do
+        GLint screen_to_gl_coords_uniform = -1;
+        GLint display_transform_uniform = -1;
+        bool uniforms_set = false;
+        glm::mat4 screen_to_gl_coords;
+        glm::mat4 display_transform;
+    };
+
+    // A primitive of a renderable, ready to draw as GL_TRIANGLES if possible
+    struct Piece
+    {
+        GLenum type;
+        GLuint tex_id;
+        Blend blend;
+        bool translucent;
+        std::vector<Vertex> vertices;
+    };
+
+    struct Tessellation
+    {
+        geometry::Rectangle screen_position;
+        glm::mat4 transformation;
+        float alpha;
+        bool shaped;
+        geometry::Size buffer_size;
+        std::vector<Piece> pieces;
+        bool used;
+    };
+
+    // A client texture, or a texture of the shell's if null
+    typedef std::pair<mir::gl::Texture const*, GLuint> TextureRef;
+
+    struct Batch
+    {
+        GLenum type;
+        Blend blend;
+        std::vector<TextureRef> textures;
+        std::vector<geometry::Rectangle> areas;
+        bool everywhere;
+        bool large;  // Holds a renderable too big to share a draw call with other textures
+        std::vector<std::pair<Piece const*, int>> pieces;  // With their texture unit
+    };
+
+    Tessellation const& tessellation_of(graphics::Renderable const& renderable);
+    Program& program_for(Batch const& batch);
+    void add_to_batches(Piece const& piece,
+                        mir::gl::Texture const* texture,
+                        geometry::Rectangle const& area,
+                        bool transformed);
+
+    ProgramFamily& family;
+    Tessellator const tessellate;
+    GLuint const vertex_buffer;
+    // By blend, whether more than one texture is sampled, and whether any alpha is applied
+    std::array<Program, blends * 2 * 2> programs;
+
+    std::unordered_map<graphics::Renderable::ID, Tessellation> tessellations;
+    std::vector<mir::gl::Primitive> primitives;
+    std::vector<Batch> batches;
+    std::vector<Vertex> vertices;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_DRAW_BATCHER_H_
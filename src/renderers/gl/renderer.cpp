@@ -37,6 +37,7 @@
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
 
 namespace mg = mir::graphics;
@@ -44,6 +45,45 @@ namespace mgl = mir::gl;
 namespace mrg = mir::renderer::gl;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Beyond this many scissored passes we're better off with one bounding pass
+size_t const max_scissor_rects = 4;
+// Enough for triple buffering with a frame to spare
+size_t const max_damage_history = 4;
+
+geom::Rectangle buffer_damage_to_screen(
+    geom::Rectangle const& damage,
+    geom::Size const& buffer_size,
+    geom::Rectangle const& screen_position)
+{
+    auto const& position = screen_position.top_left;
+    if (buffer_size == screen_position.size)
+        return {position + geom::Displacement{damage.top_left.x.as_int(), damage.top_left.y.as_int()},
+                damage.size};
+
+    if (buffer_size.width.as_int() <= 0 || buffer_size.height.as_int() <= 0)
+        return screen_position;
+
+    // Scaled: round outwards, and allow a pixel for texture filtering to bleed
+    double const scale_x = double(screen_position.size.width.as_int()) / buffer_size.width.as_int();
+    double const scale_y = double(screen_position.size.height.as_int()) / buffer_size.height.as_int();
+    int const left = std::floor(damage.left().as_int() * scale_x) - 1;
+    int const top = std::floor(damage.top().as_int() * scale_y) - 1;
+    int const right = std::ceil(damage.right().as_int() * scale_x) + 1;
+    int const bottom = std::ceil(damage.bottom().as_int() * scale_y) + 1;
+
+    return geom::Rectangle{
+        {position.x.as_int() + left, position.y.as_int() + top},
+        {right - left, bottom - top}}.intersection_with(screen_position);
+}
+
+long long area_of(geom::Rectangle const& rect)
+{
+    return static_cast<long long>(rect.size.width.as_int()) * rect.size.height.as_int();
+}
+}
+
 mrg::CurrentRenderTarget::CurrentRenderTarget(mg::DisplayBuffer* display_buffer)
     : render_target{
         dynamic_cast<renderer::gl::RenderTarget*>(display_buffer->native_display_buffer())}
@@ -75,6 +115,11 @@ void mrg::CurrentRenderTarget::swap_buffers()
     render_target->swap_buffers();
 }
 
+int mrg::CurrentRenderTarget::buffer_age()
+{
+    return render_target->buffer_age();
+}
+
 const GLchar* const mrg::Renderer::vshader =
 {
     "attribute vec3 position;\n"
@@ -132,11 +177,24 @@ mrg::Renderer::Program::Program(GLuint program_id)
 }
 
 mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
+    : Renderer(display_buffer, false)
+{
+}
+
+mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer, bool batch_draws)
     : render_target(&display_buffer),
       clear_color{0.0f, 0.0f, 0.0f, 0.0f},
       default_program(family.add_program(vshader, default_fshader)),
       alpha_program(family.add_program(vshader, alpha_fshader)),
       texture_cache(mgl::DefaultProgramFactory().create_texture_cache()),
+      batcher(batch_draws ?
+          std::make_unique<DrawBatcher>(
+              family,
+              [this](std::vector<mgl::Primitive>& primitives, mg::Renderable const& renderable)
+              {
+                  tessellate(primitives, renderable);
+              }) :
+          nullptr),
       display_transform(1)
 {
     eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
@@ -205,24 +263,228 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 {
     render_target.bind();
 
+    damage_history.push_front(frame_damage(renderables));
+    if (damage_history.size() > max_damage_history)
+        damage_history.pop_back();
+
+    auto const repaint = region_to_repaint(render_target.buffer_age());
+    bool const repaint_all = repaint.size() == 1 && *repaint.begin() == viewport;
+
+    // The glViewport maps our (letterboxed) viewport into the window
+    GLint gl_viewport[4] = {0, 0, 0, 0};
+    if (!repaint_all)
+        glGetIntegerv(GL_VIEWPORT, gl_viewport);
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
-        draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+    last_draw_calls = 0;
+    if (repaint_all || gl_viewport[2] <= 0 || gl_viewport[3] <= 0)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        draw_all(renderables);
+
+        last_repainted_fraction = 1.0f;
+    }
+    else
+    {
+        // Overlapping areas get redrawn in full by each pass, which is
+        // wasteful but still correct.
+        long long repainted_area = 0;
+
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& area : repaint)
+        {
+            scissor_to(area, gl_viewport);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            mg::RenderableList overlapping;
+            for (auto const& r : renderables)
+            {
+                if (r->screen_position().overlaps(area))
+                    overlapping.push_back(r);
+            }
+            draw_all(overlapping);
+
+            repainted_area += area_of(area);
+        }
+        glDisable(GL_SCISSOR_TEST);
+
+        // Renderables outside the repainted areas may still have new buffers.
+        // Keep their textures current so later uploads can be incremental.
+        for (auto const& r : renderables)
+        {
+            auto const position = r->screen_position();
+            if (std::none_of(repaint.begin(), repaint.end(),
+                    [&position](auto const& area) { return position.overlaps(area); }))
+            {
+                try
+                {
+                    texture_cache->load(*r);
+                }
+                catch (std::exception const&)
+                {
+                    report_exception();
+                }
+            }
+        }
+
+        auto const viewport_area = area_of(viewport);
+        last_repainted_fraction = viewport_area > 0 ?
+            std::min(1.0f, static_cast<float>(repainted_area) / viewport_area) : 1.0f;
+    }
 
     render_target.swap_buffers();
 
     // Deleting unused textures only requires the GL context. This clean-up
     // does not affect screen contents so can happen after swap_buffers...
     texture_cache->drop_unused();
+    if (batcher)
+        batcher->drop_unused();
 
     while (auto const gl_error = glGetError())
         mir::log_debug("GL error: %d", gl_error);
 }
 
+geom::Rectangles mrg::Renderer::frame_damage(mg::RenderableList const& renderables) const
+{
+    static glm::mat4 const identity{1};
+
+    // We can only reason about damage in terms of screen_position(), so
+    // anything transformed, either way, means redrawing everything.
+    bool everything_damaged = !last_frame_valid || display_transform != identity;
+    bool transformed = false;
+
+    std::vector<RenderedRenderable> this_frame;
+    this_frame.reserve(renderables.size());
+    std::vector<bool> still_present(last_frame.size(), false);
+    size_t highest_previous_index = 0;
+
+    geom::Rectangles damage;
+    for (auto const& r : renderables)
+    {
+        this_frame.push_back({r->id(), r->screen_position(), r->alpha()});
+        auto const& now = this_frame.back();
+
+        if (r->transformation() != identity)
+            transformed = everything_damaged = true;
+
+        if (everything_damaged)
+            continue;
+
+        auto const before = std::find_if(last_frame.begin(), last_frame.end(),
+            [&now](RenderedRenderable const& rr) { return rr.id == now.id; });
+
+        if (before == last_frame.end())
+        {
+            damage.add(now.screen_position);
+            continue;
+        }
+
+        size_t const index = before - last_frame.begin();
+        still_present[index] = true;
+
+        if (before->screen_position != now.screen_position || before->alpha != now.alpha)
+        {
+            damage.add(before->screen_position);
+            damage.add(now.screen_position);
+        }
+        else if (index < highest_previous_index)
+        {
+            // Restacked below something it was above: only the overlap
+            // changes, and that's within our own rectangle.
+            damage.add(now.screen_position);
+        }
+        else
+        {
+            auto const content_damage = r->damage();
+            if (content_damage.size() > 0)
+            {
+                auto const buffer_size = r->buffer()->size();
+                for (auto const& rect : content_damage)
+                    damage.add(buffer_damage_to_screen(rect, buffer_size, now.screen_position));
+            }
+        }
+
+        highest_previous_index = std::max(highest_previous_index, index);
+    }
+
+    for (size_t i = 0; i != last_frame.size(); ++i)
+    {
+        if (!still_present[i])
+            damage.add(last_frame[i].screen_position);
+    }
+
+    last_frame.swap(this_frame);
+    last_frame_valid = !transformed;
+
+    if (everything_damaged)
+        return {viewport};
+
+    geom::Rectangles clipped;
+    for (auto const& rect : damage)
+    {
+        auto const visible = rect.intersection_with(viewport);
+        if (visible.size.width.as_int() > 0 && visible.size.height.as_int() > 0)
+            clipped.add(visible);
+    }
+    return clipped;
+}
+
+geom::Rectangles mrg::Renderer::region_to_repaint(int buffer_age) const
+{
+    // The buffer holds what we drew buffer_age frames ago, so everything
+    // damaged since then (including this frame) needs to be redrawn.
+    if (buffer_age <= 0 || static_cast<size_t>(buffer_age) > damage_history.size())
+        return {viewport};
+
+    geom::Rectangles region;
+    for (auto frame = damage_history.begin(); frame != damage_history.begin() + buffer_age; ++frame)
+    {
+        for (auto const& rect : *frame)
+        {
+            if (rect.contains(viewport))
+                return {viewport};
+            region.add(rect);
+        }
+    }
+
+    if (region.size() > max_scissor_rects)
+        return {region.bounding_rectangle()};
+
+    return region;
+}
+
+void mrg::Renderer::scissor_to(geom::Rectangle const& area, GLint const gl_viewport[4]) const
+{
+    // GL window coordinates have y going up from the bottom
+    double const scale_x = double(gl_viewport[2]) / viewport.size.width.as_int();
+    double const scale_y = double(gl_viewport[3]) / viewport.size.height.as_int();
+    int const dx = area.left().as_int() - viewport.left().as_int();
+    int const dy = viewport.bottom().as_int() - area.bottom().as_int();
+
+    GLint const left = gl_viewport[0] + std::floor(dx * scale_x);
+    GLint const bottom = gl_viewport[1] + std::floor(dy * scale_y);
+    GLint const right = gl_viewport[0] + std::ceil((dx + area.size.width.as_int()) * scale_x);
+    GLint const top = gl_viewport[1] + std::ceil((dy + area.size.height.as_int()) * scale_y);
+
+    glScissor(left, bottom, right - left, top - bottom);
+}
+
+void mrg::Renderer::draw_all(mg::RenderableList const& renderables) const
+{
+    if (batcher)
+    {
+        last_draw_calls += batcher->draw(renderables, *texture_cache, screen_to_gl_coords, display_transform);
+        return;
+    }
+
+    for (auto const& r : renderables)
+        draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+}
+
 void mrg::Renderer::draw(mg::Renderable const& renderable,
                           Renderer::Program const& prog) const
 {
@@ -325,6 +587,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable,
             }
 
             glDrawArrays(p.type, 0, p.nvertices);
+            ++last_draw_calls;
         }
     }
     catch (std::exception const& ex)
@@ -377,6 +640,7 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
 
     viewport = rect;
     update_gl_viewport();
+    invalidate_damage_history();
 }
 
 void mrg::Renderer::update_gl_viewport()
@@ -422,11 +686,31 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
     {
         display_transform = new_display_transform;
         update_gl_viewport();
+        invalidate_damage_history();
     }
 }
 
 void mrg::Renderer::suspend()
 {
     texture_cache->invalidate();
+    // Whatever is on screen now wasn't drawn by us
+    invalidate_damage_history();
+}
+
+float mrg::Renderer::repainted_fraction() const
+{
+    return last_repainted_fraction;
+}
+
+unsigned mrg::Renderer::draw_calls() const
+{
+    return last_draw_calls;
+}
+
+void mrg::Renderer::invalidate_damage_history()
+{
+    last_frame.clear();
+    last_frame_valid = false;
+    damage_history.clear();
 }
 
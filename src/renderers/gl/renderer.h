@@ -20,15 +20,18 @@
 #define MIR_RENDERER_GL_RENDERER_H_
 
 #include "program_family.h"
+#include "draw_batcher.h"
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -51,6 +54,7 @@ public:
     void ensure_current();
     void bind();
     void swap_buffers();
+    int buffer_age();
 
 private:
     renderer::gl::RenderTarget* const render_target;
@@ -60,6 +64,12 @@ class Renderer : public renderer::Renderer
 {
 public:
     Renderer(graphics::DisplayBuffer& display_buffer);
+    /**
+     * \param [in] batch_draws  Draw each frame from one vertex buffer in as
+     *                          few draw calls as stacking allows, instead of
+     *                          calling draw() for each renderable
+     */
+    Renderer(graphics::DisplayBuffer& display_buffer, bool batch_draws);
     virtual ~Renderer();
 
     // These are called with a valid GL context:
@@ -70,6 +80,11 @@ public:
     // This is called _without_ a GL context:
     void suspend() override;
 
+    float repainted_fraction() const override;
+
+    /// The number of draw calls made by the last render()
+    unsigned draw_calls() const;
+
 private:
     mutable CurrentRenderTarget render_target;
 
@@ -84,6 +99,13 @@ protected:
      *                            grown and/or modified.
      * \param [in]     renderable The renderable surface being tessellated.
      *
+     * \note Only the renderable's screen_position() is repainted when it
+     *       changes, so primitives should not extend outside of it.
+     *
+     * \note When batching draws, the primitives are reused until the
+     *       renderable's position, transformation, alpha, shape or buffer
+     *       size change.
+     *
      * \note The cohesion of this function to gl::Renderer is quite loose and it
      *       does not strictly need to reside here.
      *       However it seems a good choice under gl::Renderer while this remains
@@ -123,13 +145,36 @@ protected:
                       Renderer::Program const& prog) const;
 
 private:
+    void draw_all(graphics::RenderableList const& renderables) const;
     void update_gl_viewport();
+    void invalidate_damage_history();
+
+    /// What has changed on screen since the last frame, clipped to the viewport
+    geometry::Rectangles frame_damage(graphics::RenderableList const& renderables) const;
+    /// What must be redrawn over a render target whose content is buffer_age frames old
+    geometry::Rectangles region_to_repaint(int buffer_age) const;
+    void scissor_to(geometry::Rectangle const& area, GLint const gl_viewport[4]) const;
 
     std::unique_ptr<mir::gl::TextureCache> const texture_cache;
+    std::unique_ptr<DrawBatcher> const batcher;  ///< Null unless batching draws
+    unsigned mutable last_draw_calls = 0;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    struct RenderedRenderable
+    {
+        graphics::Renderable::ID id;
+        geometry::Rectangle screen_position;
+        float alpha;
+    };
+    // What was drawn in the last frame, bottom to top
+    std::vector<RenderedRenderable> mutable last_frame;
+    bool mutable last_frame_valid = false;
+    // Screen damage of the most recent frames, newest first
+    std::deque<geometry::Rectangles> mutable damage_history;
+    float mutable last_repainted_fraction = 1.0f;
 };
 
 }
@@ -22,9 +22,14 @@
 
 namespace mrg = mir::renderer::gl;
 
+mrg::RendererFactory::RendererFactory(bool batch_draws)
+    : batch_draws{batch_draws}
+{
+}
+
 std::unique_ptr<mir::renderer::Renderer>
 mrg::RendererFactory::create_renderer_for(
     graphics::DisplayBuffer& display_buffer)
 {
-    return std::make_unique<Renderer>(display_buffer);
+    return std::make_unique<Renderer>(display_buffer, batch_draws);
 }
@@ -31,8 +31,14 @@ namespace gl
 class RendererFactory : public renderer::RendererFactory
 {
 public:
+    /// \param [in] batch_draws  Whether renderers batch their draw calls
+    explicit RendererFactory(bool batch_draws);
+
     std::unique_ptr<renderer::Renderer> create_renderer_for(
         graphics::DisplayBuffer& display_buffer) override;
+
+private:
+    bool const batch_draws;
 };
 
 }
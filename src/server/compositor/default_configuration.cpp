@@ -22,6 +22,7 @@
 #include "buffer_stream_factory.h"
 #include "default_display_buffer_compositor_factory.h"
 #include "multi_threaded_compositor.h"
+#include "presentation_observer_multiplexer.h"
 #include "gl/renderer_factory.h"
 #include "compositing_screencast.h"
 #include "mir/main_loop.h"
@@ -78,17 +79,39 @@ mir::DefaultServerConfiguration::the_compositor()
                 the_display_buffer_compositor_factory(),
                 the_shell(),
                 the_compositor_report(),
+                the_presentation_observer(),
                 composite_delay,
                 !the_options()->is_set(options::host_socket_opt));
         });
 }
 
+std::shared_ptr<mir::ObserverRegistrar<mc::PresentationObserver>>
+mir::DefaultServerConfiguration::the_presentation_observer_registrar()
+{
+    return presentation_observer_multiplexer(
+        [default_executor = the_main_loop()]
+        {
+            return std::make_shared<mc::PresentationObserverMultiplexer>(default_executor);
+        });
+}
+
+std::shared_ptr<mc::PresentationObserver>
+mir::DefaultServerConfiguration::the_presentation_observer()
+{
+    return presentation_observer_multiplexer(
+        [default_executor = the_main_loop()]
+        {
+            return std::make_shared<mc::PresentationObserverMultiplexer>(default_executor);
+        });
+}
+
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]()
         {
-            return std::make_shared<mir::renderer::gl::RendererFactory>();
+            return std::make_shared<mir::renderer::gl::RendererFactory>(
+                the_options()->get<bool>(options::batch_gl_draws_opt));
         });
 }
 
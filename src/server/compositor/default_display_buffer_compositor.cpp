@@ -72,7 +72,9 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
-    if (display_buffer.overlay(renderable_list))
+    // Whatever the hardware shows itself the display buffer holds on to until it's posted
+    auto to_render = renderable_list;
+    if (display_buffer.overlay_partially(to_render))
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
@@ -81,10 +83,11 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     {
         renderer->set_output_transform(display_buffer.transformation());
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->render(to_render);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
+        report->repainted_fraction(this, renderer->repainted_fraction());
 
         /*
          * This is used for the 'early release' optimization to release buffers
@@ -98,6 +101,7 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
          *        acquisition calls when we composite the next frame.
          */
         renderable_list.clear();
+        to_render.clear();
     }
 
     report->finished_frame(this);
@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mt = mir::time;
+
+mc::FrameScheduler::FrameScheduler(std::chrono::nanoseconds safety_margin)
+    : safety_margin{safety_margin}
+{
+}
+
+void mc::FrameScheduler::frame_rendered(std::chrono::nanoseconds render_time)
+{
+    samples[next_sample] = render_time;
+    next_sample = (next_sample + 1) % samples.size();
+    nsamples = std::min(nsamples + 1, samples.size());
+}
+
+std::chrono::nanoseconds mc::FrameScheduler::predicted_render_time() const
+{
+    // Render times are spiky (texture uploads, new windows) so the mean
+    // would miss too often; the recent worst case is a safer budget.
+    if (nsamples == 0)
+        return std::chrono::nanoseconds::zero();
+
+    return *std::max_element(samples.begin(), samples.begin() + nsamples);
+}
+
+mt::PosixTimestamp mc::FrameScheduler::start_time(
+    mt::PosixTimestamp const& last_vsync,
+    std::chrono::nanoseconds vsync_interval,
+    mt::PosixTimestamp const& now) const
+{
+    if (vsync_interval <= std::chrono::nanoseconds::zero() ||
+        last_vsync.nanoseconds == std::chrono::nanoseconds::zero() ||
+        nsamples == 0)
+    {
+        return now;
+    }
+
+    auto const lead = predicted_render_time() + safety_margin;
+
+    // The first vblank after last_vsync that we can still render in time for
+    auto const vsyncs_ahead = (now - last_vsync + lead + vsync_interval - std::chrono::nanoseconds{1}) / vsync_interval;
+    auto const deadline = last_vsync + std::max<decltype(vsyncs_ahead)>(vsyncs_ahead, 1) * vsync_interval;
+
+    return deadline - lead;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_SCHEDULER_H_
+#define MIR_COMPOSITOR_FRAME_SCHEDULER_H_
+
+#include "mir/time/posix_timestamp.h"
+
+#include <array>
+#include <chrono>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Decides when a compositing thread should start rendering so that the frame
+ * is ready just before the next vblank of its outputs.
+ *
+ * Starting as late as possible means the scene is snapshotted as late as
+ * possible, minimising the time from a client's buffer being committed to it
+ * appearing on screen. The render time is learnt from recent frames; the
+ * scheduler budgets for the slowest of them plus a fixed safety margin.
+ */
+class FrameScheduler
+{
+public:
+    explicit FrameScheduler(std::chrono::nanoseconds safety_margin);
+
+    void frame_rendered(std::chrono::nanoseconds render_time);
+
+    /// The render time budgeted for the next frame, or zero before any frame has been rendered
+    std::chrono::nanoseconds predicted_render_time() const;
+
+    /**
+     * When to start compositing to make the first vblank after now that
+     * there is still time for. If nothing is known about the vblank timing
+     * (a zero last_vsync or interval) or the render time, that is now.
+     */
+    time::PosixTimestamp start_time(
+        time::PosixTimestamp const& last_vsync,
+        std::chrono::nanoseconds vsync_interval,
+        time::PosixTimestamp const& now) const;
+
+private:
+    std::chrono::nanoseconds const safety_margin;
+    std::array<std::chrono::nanoseconds, 16> samples;
+    size_t nsamples{0};
+    size_t next_sample{0};
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_FRAME_SCHEDULER_H_ */
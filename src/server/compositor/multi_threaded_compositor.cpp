@@ -17,6 +17,7 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "frame_scheduler.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/compositor/display_buffer_compositor.h"
@@ -24,6 +25,7 @@
 #include "mir/compositor/display_listener.h"
 #include "mir/compositor/scene.h"
 #include "mir/compositor/compositor_report.h"
+#include "mir/compositor/presentation_observer.h"
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface_observer.h"
 #include "mir/scene/surface.h"
@@ -42,6 +44,22 @@ using namespace std::literals::chrono_literals;
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
+namespace mt = mir::time;
+
+namespace
+{
+// Headroom on top of the predicted render time, for scheduling jitter and
+// the post() itself
+auto const render_safety_margin = 2ms;
+
+// Each compositor thread composites a single group for as long as it runs
+thread_local mc::DisplayGroupId thread_group{nullptr};
+}
+
+mc::DisplayGroupId mc::compositing_group()
+{
+    return thread_group;
+}
 
 namespace mir
 {
@@ -57,7 +75,8 @@ public:
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
         std::chrono::milliseconds fixed_composite_delay,
-        std::shared_ptr<CompositorReport> const& report) :
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<PresentationObserver> const& presentation_observer) :
         compositor_factory{db_compositor_factory},
         group(group),
         scene(scene),
@@ -66,6 +85,8 @@ public:
         force_sleep{fixed_composite_delay},
         display_listener{display_listener},
         report{report},
+        presentation_observer{presentation_observer},
+        scheduler{render_safety_margin},
         started_future{started.get_future()}
     {
     }
@@ -74,6 +95,7 @@ public:
     try
     {
         mir::set_thread_name("Mir/Comp");
+        thread_group = &group;
 
         std::vector<std::tuple<mg::DisplayBuffer*, std::unique_ptr<mc::DisplayBufferCompositor>>> compositors;
         group.for_each_display_buffer(
@@ -118,6 +140,14 @@ public:
                 /* Wait until compositing has been scheduled or we are stopped */
                 run_cv.wait(lock, [&]{ return (frames_scheduled > 0) || !running; });
 
+                /*
+                 * If we know when the next vblank is, hold off until just
+                 * long enough before it to render the frame. The later we
+                 * snapshot the scene the fresher the client content we show.
+                 */
+                if (running && automatic_timing())
+                    wait_for_deadline(lock);
+
                 /*
                  * Check if we are running before compositing, since we may have
                  * been stopped while waiting for the run_cv above.
@@ -135,23 +165,38 @@ public:
                     not_posted_yet = false;
                     lock.unlock();
 
+                    auto const predicted = scheduler.predicted_render_time();
+                    auto const render_start = std::chrono::steady_clock::now();
+
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
                         compositor->composite(scene->scene_elements_for(compositor.get()));
                     }
+
+                    auto const render_time = std::chrono::steady_clock::now() - render_start;
                     group.post();
+                    frame_presented();
 
-                    /*
-                     * "Predictive bypass" optimization: If the last frame was
-                     * bypassed/overlayed or you simply have a fast GPU, it is
-                     * beneficial to sleep for most of the next frame. This reduces
-                     * the latency between snapshotting the scene and post()
-                     * completing by almost a whole frame.
-                     */
-                    auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
-                                 force_sleep : group.recommended_sleep();
-                    std::this_thread::sleep_for(delay);
+                    scheduler.frame_rendered(render_time);
+                    for (auto& tuple : compositors)
+                        report->render_time(std::get<1>(tuple).get(), predicted, render_time);
+
+                    if (force_sleep >= std::chrono::milliseconds::zero())
+                    {
+                        std::this_thread::sleep_for(force_sleep);
+                    }
+                    else if (!automatic_timing())
+                    {
+                        /*
+                         * "Predictive bypass" optimization: If the last frame was
+                         * bypassed/overlayed or you simply have a fast GPU, it is
+                         * beneficial to sleep for most of the next frame. This reduces
+                         * the latency between snapshotting the scene and post()
+                         * completing by almost a whole frame.
+                         */
+                        std::this_thread::sleep_for(group.recommended_sleep());
+                    }
 
                     lock.lock();
 
@@ -231,6 +276,42 @@ public:
     }
 
 private:
+    bool automatic_timing() const
+    {
+        return force_sleep < std::chrono::milliseconds::zero() &&
+               group.frame_interval() > std::chrono::nanoseconds::zero();
+    }
+
+    void frame_presented()
+    {
+        auto const refresh = group.frame_interval();
+
+        // This may outlive us, if the group's display goes while the frame is still on its way
+        group.when_presented(
+            [observer = presentation_observer, id = static_cast<DisplayGroupId>(&group), refresh]
+                (mg::Frame const& presented)
+            {
+                auto frame = presented;
+
+                // Without vsync timing, the best we know is that the group has finished with the frame
+                if (refresh == std::chrono::nanoseconds::zero())
+                    frame.ust = mt::PosixTimestamp::now(CLOCK_MONOTONIC);
+
+                observer->frame_presented(id, frame, refresh);
+            });
+    }
+
+    void wait_for_deadline(std::unique_lock<std::mutex>& lock)
+    {
+        auto const last_vsync = group.last_frame().ust;
+        auto const now = mt::PosixTimestamp::now(last_vsync.clock_id);
+        auto const start = scheduler.start_time(last_vsync, group.frame_interval(), now);
+
+        // Still wake promptly if we're stopped in the meantime
+        if (start > now)
+            run_cv.wait_for(lock, start - now, [this]{ return !running; });
+    }
+
     std::shared_ptr<mc::DisplayBufferCompositorFactory> const compositor_factory;
     mg::DisplaySyncGroup& group;
     std::shared_ptr<mc::Scene> const scene;
@@ -241,6 +322,8 @@ private:
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<PresentationObserver> const presentation_observer;
+    FrameScheduler scheduler;
     std::promise<void> started;
     std::future<void> started_future;
     bool not_posted_yet = true;
@@ -255,6 +338,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
     std::shared_ptr<DisplayListener> const& display_listener,
     std::shared_ptr<CompositorReport> const& compositor_report,
+    std::shared_ptr<PresentationObserver> const& presentation_observer,
     std::chrono::milliseconds fixed_composite_delay,
     bool compose_on_start)
     : display{display},
@@ -262,6 +346,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
       report{compositor_report},
+      presentation_observer{presentation_observer},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
       compose_on_start{compose_on_start},
@@ -368,7 +453,7 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            fixed_composite_delay, report, presentation_observer);
 
         futures.push_back(thread_pool.run(std::ref(*thread_functor), &group));
         thread_functors.push_back(std::move(thread_functor));
@@ -17,11 +17,12 @@
  */
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/region.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
 
-#include <vector>
+#include <algorithm>
 
 using namespace mir::geometry;
 using namespace mir::graphics;
@@ -32,7 +33,7 @@ namespace
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage)
 {
     static glm::mat4 const identity(1);
     static Rectangle const empty{};
@@ -46,20 +47,25 @@ bool renderable_is_occluded(
     if (clipped_window == empty)
         return true;  // Not in the area; definitely occluded.
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+    // Several windows above may hide this one between them
+    if (coverage.contains(clipped_window))
+        return true;
+
+    if (renderable.alpha() == 1.0f)
     {
-        if (r.contains(clipped_window))
+        if (!renderable.shaped())
+        {
+            coverage.unite(clipped_window);
+        }
+        else
         {
-            occluded = true;
-            break;
+            auto opaque = renderable.opaque_region();
+            opaque.intersect(clipped_window);
+            coverage.unite(opaque);
         }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
-
-    return occluded;
+    return false;
 }
 }
 
@@ -67,23 +73,23 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     SceneElementSequence& elements,
     Rectangle const& area)
 {
+    SceneElementSequence visible;
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
-    auto it = elements.rbegin();
-    while (it != elements.rend())
+    // Walk from the top down, partitioning in one pass rather than erasing from the middle
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it)
     {
         auto const renderable = (*it)->renderable();
         if (renderable_is_occluded(*renderable, area, coverage))
-        {
-            occluded.insert(occluded.begin(), *it);
-            it = SceneElementSequence::reverse_iterator(elements.erase(std::prev(it.base())));
-        }
+            occluded.push_back(*it);
         else
-        {
-            it++;
-        }
+            visible.push_back(*it);
     }
 
+    std::reverse(visible.begin(), visible.end());
+    std::reverse(occluded.begin(), occluded.end());
+    elements = std::move(visible);
+
     return occluded;
 }
@@ -176,6 +176,13 @@ void mc::ScreencastDisplayBuffer::swap_buffers()
     }
 }
 
+int mc::ScreencastDisplayBuffer::buffer_age()
+{
+    // We render into whichever client buffer comes next and know nothing
+    // of what it last held.
+    return 0;
+}
+
 void mc::ScreencastDisplayBuffer::commit()
 {
     if (current_buffer)
@@ -112,6 +112,8 @@ public:
 
     void swap_buffers() override;
 
+    int buffer_age() override;
+
     glm::mat2 transformation() const override;
 
     NativeDisplayBuffer* native_display_buffer() override;
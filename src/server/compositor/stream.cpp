@@ -22,6 +22,7 @@
 #include "dropping_schedule.h"
 #include "mir/graphics/buffer.h"
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -29,6 +30,13 @@ namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Enough to cover the deepest queue plus a compositor that skipped a few frames;
+// anyone further behind than this just sees the whole buffer as damaged.
+size_t const max_damage_history = 8;
+}
+
 enum class mc::Stream::ScheduleMode {
     Queueing,
     Dropping
@@ -42,6 +50,7 @@ mc::Stream::Stream(
     size(size),
     pf(pf),
     first_frame_posted(false),
+    frames_submitted(0),
     frame_callback{[](auto){}}
 {
 }
@@ -49,6 +58,11 @@ mc::Stream::Stream(
 mc::Stream::~Stream() = default;
 
 void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    submit_buffer(buffer, {});
+}
+
+void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer, geom::Rectangles const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
@@ -57,6 +71,27 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
         std::lock_guard<decltype(mutex)> lk(mutex); 
         first_frame_posted = true;
         pf = buffer->pixel_format();
+
+        // The history must be updated before the buffer becomes available to compositors
+        submitted_frames.push_back({
+            ++frames_submitted,
+            buffer->id(),
+            buffer->size(),
+            damage.size() ? damage : geom::Rectangles{{{}, buffer->size()}},
+            pending_opaque});
+        if (submitted_frames.size() > max_damage_history)
+            submitted_frames.pop_front();
+
+        // Forget compositors that have stopped compositing this stream (or no
+        // longer exist): they would see the whole buffer as damaged anyway
+        for (auto i = compositor_frames.begin(); i != compositor_frames.end();)
+        {
+            if (i->second.locked_after + max_damage_history < frames_submitted)
+                i = compositor_frames.erase(i);
+            else
+                ++i;
+        }
+
         schedule->schedule(buffer);
     }
     {
@@ -86,7 +121,86 @@ void mc::Stream::set_frame_posted_callback(
 
 std::shared_ptr<mg::Buffer> mc::Stream::lock_compositor_buffer(void const* id)
 {
-    return arbiter->compositor_acquire(id);
+    auto const buffer = arbiter->compositor_acquire(id);
+
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    // A buffer may be resubmitted, so the most recent submission is the one being composited
+    auto const submitted = std::find_if(
+        submitted_frames.rbegin(), submitted_frames.rend(),
+        [&buffer](auto const& submitted) { return submitted.buffer == buffer->id(); });
+
+    auto& composited = compositor_frames[id];
+    if (submitted == submitted_frames.rend())
+    {
+        // We don't know what was promised for it, so don't assume anything is opaque
+        composited = {0, frames_submitted, {{{}, buffer->size()}}, {}};
+    }
+    else
+    {
+        composited.damage = damage_between(composited.frame, submitted->frame, lk);
+        composited.opaque = submitted->opaque;
+        composited.frame = submitted->frame;
+        composited.locked_after = frames_submitted;
+    }
+
+    return buffer;
+}
+
+geom::Rectangles mc::Stream::damage_for_compositor(void const* id) const
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const composited = compositor_frames.find(id);
+    if (composited == compositor_frames.end())
+        return {};
+    return composited->second.damage;
+}
+
+geom::Rectangles mc::Stream::damage_between(
+    uint64_t previous_frame, uint64_t frame, std::lock_guard<std::mutex> const&) const
+{
+    if (previous_frame == frame)
+        return {};
+
+    auto const current = std::find_if(
+        submitted_frames.begin(), submitted_frames.end(),
+        [frame](auto const& submitted) { return submitted.frame == frame; });
+    geom::Rectangles const everything{{{}, current->size}};
+
+    // Without a complete record of the intervening frames we can't know what changed
+    if (previous_frame == 0 || previous_frame > frame ||
+        submitted_frames.front().frame > previous_frame + 1)
+    {
+        return everything;
+    }
+
+    geom::Rectangles damage;
+    for (auto i = submitted_frames.begin(); i != submitted_frames.end(); ++i)
+    {
+        if (i->frame <= previous_frame || i->frame > frame)
+            continue;
+
+        if (i->size != current->size)
+            return everything;
+
+        for (auto const& rect : i->damage)
+            damage.add(rect);
+    }
+    return damage;
+}
+
+geom::Region mc::Stream::opaque_region_for_compositor(void const* id) const
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const composited = compositor_frames.find(id);
+    if (composited == compositor_frames.end())
+        return {};
+    return composited->second.opaque;
+}
+
+void mc::Stream::set_opaque_region(geom::Region const& region)
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    pending_opaque = region;
 }
 
 geom::Size mc::Stream::stream_size()
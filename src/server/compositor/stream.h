@@ -25,10 +25,14 @@
 #include "mir/frontend/buffer_stream_id.h"
 #include "mir/lockable_callback.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
 #include "multi_monitor_arbiter.h"
 #include <mutex>
 #include <memory>
 #include <set>
+#include <deque>
+#include <unordered_map>
 
 namespace mir
 {
@@ -43,12 +47,18 @@ public:
     ~Stream();
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) override;
     std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) override;
+    geometry::Rectangles damage_for_compositor(void const* user_id) const override;
+    geometry::Region opaque_region_for_compositor(void const* user_id) const override;
+    void set_opaque_region(geometry::Region const& region) override;
     geometry::Size stream_size() override;
     void resize(geometry::Size const& size) override;
     void allow_framedropping(bool) override;
@@ -61,6 +71,24 @@ public:
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    geometry::Rectangles damage_between(
+        uint64_t previous_frame, uint64_t frame, std::lock_guard<std::mutex> const&) const;
+
+    struct SubmittedFrame
+    {
+        uint64_t frame;
+        graphics::BufferID buffer;
+        geometry::Size size;
+        geometry::Rectangles damage;
+        geometry::Region opaque;
+    };
+    struct CompositorFrame
+    {
+        uint64_t frame;
+        uint64_t locked_after;  // The value of frames_submitted when it was last locked
+        geometry::Rectangles damage;
+        geometry::Region opaque;
+    };
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -69,6 +97,10 @@ private:
     geometry::Size size; 
     MirPixelFormat pf;
     bool first_frame_posted;
+    uint64_t frames_submitted;
+    std::deque<SubmittedFrame> submitted_frames;
+    std::unordered_map<void const*, CompositorFrame> compositor_frames;
+    geometry::Region pending_opaque;
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
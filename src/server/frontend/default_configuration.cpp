@@ -58,7 +58,8 @@ mir::DefaultServerConfiguration::the_connector()
             {
                 return std::make_shared<mf::BasicConnector>(
                     the_connection_creator(),
-                    the_connector_report());
+                    the_connector_report(),
+                    the_options()->get<int>(options::frontend_threads_opt));
             }
             else
             {
@@ -66,7 +67,8 @@ mir::DefaultServerConfiguration::the_connector()
                     the_socket_file(),
                     the_connection_creator(),
                     *the_emergency_cleanup(),
-                    the_connector_report());
+                    the_connector_report(),
+                    the_options()->get<int>(options::frontend_threads_opt));
 
                 if (the_options()->is_set(options::arw_server_socket_opt))
                     chmod(the_socket_file().c_str(), S_IRUSR|S_IWUSR| S_IRGRP|S_IWGRP | S_IROTH|S_IWOTH);
@@ -39,6 +39,8 @@ public:
     virtual size_t available_bytes() = 0;
     virtual SessionCredentials client_creds() = 0;
     virtual void receive_fds(std::vector<Fd>& fds) = 0;
+    // The client has said it can receive messages too large to frame inline
+    virtual void client_accepts_large_results() = 0;
 
 protected:
     MessageReceiver() = default;
@@ -32,6 +32,7 @@
 
 #include <cstdio>
 #include <fstream>
+#include <stdexcept>
 
 namespace mf = mir::frontend;
 namespace mfd = mir::frontend::detail;
@@ -119,16 +120,39 @@ std::shared_ptr<boost::asio::local::stream_protocol::socket> make_socket_self_co
         holder,
         holder->socket.get());
 }
+
+auto make_io_services(int threads) -> std::vector<std::shared_ptr<boost::asio::io_service>>
+{
+    if (threads < 1)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("IPC needs at least one thread"));
+
+    std::vector<std::shared_ptr<boost::asio::io_service>> io_services;
+    for (auto i = 0; i != threads; ++i)
+        io_services.push_back(std::make_shared<boost::asio::io_service>(1));
+
+    return io_services;
+}
+
+auto make_work(std::vector<std::shared_ptr<boost::asio::io_service>> const& io_services)
+    -> std::vector<boost::asio::io_service::work>
+{
+    std::vector<boost::asio::io_service::work> work;
+    for (auto const& io_service : io_services)
+        work.emplace_back(*io_service);
+
+    return work;
+}
 }
 
 mf::PublishedSocketConnector::PublishedSocketConnector(
     const std::string& socket_file,
     std::shared_ptr<ConnectionCreator> const& connection_creator,
     EmergencyCleanupRegistry& emergency_cleanup_registry,
-    std::shared_ptr<ConnectorReport> const& report)
-:   BasicConnector(connection_creator, report),
+    std::shared_ptr<ConnectorReport> const& report,
+    int threads)
+:   BasicConnector(connection_creator, report, threads),
     socket_file(remove_if_stale(socket_file)),
-    acceptor(*io_service, socket_file)
+    acceptor(*io_services.front(), socket_file)
 {
     emergency_cleanup_registry.add(
         [socket_file] { std::remove(socket_file.c_str()); });
@@ -144,6 +168,7 @@ void mf::PublishedSocketConnector::start_accept()
 {
     report->listening_on(socket_file);
 
+    auto const& io_service = next_io_service();
     auto socket = std::make_shared<boost::asio::local::stream_protocol::socket>(*io_service);
 
     acceptor.async_accept(
@@ -189,17 +214,19 @@ auto mir::frontend::PublishedSocketConnector::socket_name() const -> optional_va
 
 mf::BasicConnector::BasicConnector(
     std::shared_ptr<ConnectionCreator> const& connection_creator,
-    std::shared_ptr<ConnectorReport> const& report)
-:   io_service(std::make_shared<boost::asio::io_service>()),
-    work(*io_service),
+    std::shared_ptr<ConnectorReport> const& report,
+    int threads)
+:   io_services(make_io_services(threads)),
+    work(make_work(io_services)),
     report(report),
-    connection_creator{connection_creator}
+    connection_creator{connection_creator},
+    next_service{0}
 {
 }
 
 void mf::BasicConnector::start()
 {
-    auto run_io_service = [this]
+    auto run_io_service = [this](std::shared_ptr<boost::asio::io_service> const& io_service)
     {
         mir::set_thread_name("Mir/IPC");
         while (true)
@@ -216,20 +243,32 @@ void mf::BasicConnector::start()
         }
     };
 
-    io_service_thread = std::thread(run_io_service);
+    for (auto const& io_service : io_services)
+        io_service_threads.emplace_back(run_io_service, io_service);
 }
 
 void mf::BasicConnector::stop()
 {
     /* Stop processing new requests */
-    io_service->stop();
+    for (auto const& io_service : io_services)
+        io_service->stop();
 
-    /* Wait for io processing thread to finish */
-    if (io_service_thread.joinable())
-        io_service_thread.join();
+    /* Wait for io processing threads to finish */
+    for (auto& thread : io_service_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    io_service_threads.clear();
 
     /* Prepare for a potential restart */
-    io_service->reset();
+    for (auto const& io_service : io_services)
+        io_service->reset();
+}
+
+auto mf::BasicConnector::next_io_service() const -> std::shared_ptr<boost::asio::io_service> const&
+{
+    return io_services[next_service++ % io_services.size()];
 }
 
 void mf::BasicConnector::create_session_for(
@@ -263,6 +302,7 @@ int mf::BasicConnector::client_socket_fd(std::function<void(std::shared_ptr<Sess
                 std::runtime_error("Could not create socket pair")) << boost::errinfo_errno(errno));
     }
 
+    auto const& io_service = next_io_service();
     auto const server_socket = std::make_shared<boost::asio::local::stream_protocol::socket>(
         *io_service,
         boost::asio::local::stream_protocol(),
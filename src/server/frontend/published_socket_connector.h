@@ -23,9 +23,11 @@
 
 #include <boost/asio.hpp>
 
+#include <atomic>
 #include <thread>
 #include <string>
 #include <functional>
+#include <vector>
 
 namespace google
 {
@@ -44,13 +46,20 @@ namespace frontend
 class ConnectionCreator;
 class ConnectorReport;
 
-/// provides a client-side socket fd for each connection
+/**
+ * Provides a client-side socket fd for each connection.
+ *
+ * IPC is handled on a pool of threads, each running its own io_service.
+ * Sessions are shared out between the threads in turn, and each session is
+ * only ever handled on the one thread it was given.
+ */
 class BasicConnector : public Connector
 {
 public:
     explicit BasicConnector(
         std::shared_ptr<ConnectionCreator> const& connection_creator,
-        std::shared_ptr<ConnectorReport> const& report);
+        std::shared_ptr<ConnectorReport> const& report,
+        int threads = 1);
     ~BasicConnector() noexcept;
     void start() override;
     void stop() override;
@@ -63,13 +72,18 @@ protected:
         std::shared_ptr<boost::asio::local::stream_protocol::socket> const& server_socket,
         std::function<void(std::shared_ptr<Session> const& session)> const& connect_handler) const;
 
-    std::shared_ptr<boost::asio::io_service> const io_service;
-    boost::asio::io_service::work work;
+    /// The io_service to handle the next session on
+    auto next_io_service() const -> std::shared_ptr<boost::asio::io_service> const&;
+
+    /// One per thread. The first also accepts connections.
+    std::vector<std::shared_ptr<boost::asio::io_service>> const io_services;
+    std::vector<boost::asio::io_service::work> const work;
     std::shared_ptr<ConnectorReport> const report;
 
 private:
-    std::thread io_service_thread;
+    std::vector<std::thread> io_service_threads;
     std::shared_ptr<ConnectionCreator> const connection_creator;
+    std::atomic<unsigned> mutable next_service;
 };
 
 /// Accept connections over a published socket
@@ -80,7 +94,8 @@ public:
         const std::string& socket_file,
         std::shared_ptr<ConnectionCreator> const& connection_creator,
         EmergencyCleanupRegistry& emergency_cleanup_registry,
-        std::shared_ptr<ConnectorReport> const& report);
+        std::shared_ptr<ConnectorReport> const& report,
+        int threads = 1);
     ~PublishedSocketConnector() noexcept;
 
     auto socket_name() const -> optional_value<std::string> override;
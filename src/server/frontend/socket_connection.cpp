@@ -107,6 +107,9 @@ try
         v >= mir::protobuf::next_incompatible_protocol_version())
         BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported protocol version"));
 
+    if (invocation.large_results())
+        message_receiver->client_accepts_large_results();
+
     std::vector<mir::Fd> fds;
     if (invocation.side_channel_fds() > 0)
     {
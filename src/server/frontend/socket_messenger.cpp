@@ -20,29 +20,89 @@
 #include "mir/frontend/client_constants.h"
 #include "mir/variable_length_array.h"
 #include "mir/fd_socket_transmission.h"
+#include "mir/anonymous_shm_file.h"
 #include "mir/raii.h"
+#include "mir/log.h"
+
+#include "mir_protobuf_wire.pb.h"
 
 #include <boost/throw_exception.hpp>
 
 #include <errno.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <stdexcept>
+#include <system_error>
 
 namespace mf = mir::frontend;
 namespace mfd = mf::detail;
 namespace bs = boost::system;
 namespace ba = boost::asio;
 
-mfd::SocketMessenger::SocketMessenger(std::shared_ptr<ba::local::stream_protocol::socket> const& socket)
+namespace
+{
+size_t const header_size{2};
+
+// The most we hand to the kernel in one go when catching up with a client
+size_t const max_iov{64};
+
+// Like mir::send_fds(), but gives up rather than block
+bool try_send_fds(mir::Fd const& socket, std::vector<mir::Fd> const& fds)
+{
+    if (fds.empty())
+        return true;
+
+    char dummy_iov_data = 'M';
+    iovec iov{&dummy_iov_data, 1};
+
+    static auto const builtin_n_fds = 5;
+    static auto const builtin_cmsg_space = CMSG_SPACE(builtin_n_fds * sizeof(int));
+    auto const fds_bytes = fds.size() * sizeof(int);
+    mir::VariableLengthArray<builtin_cmsg_space> control{CMSG_SPACE(fds_bytes)};
+    memset(control.data(), 0, control.size());
+
+    msghdr header{};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_controllen = control.size();
+    header.msg_control = control.data();
+
+    auto const message = CMSG_FIRSTHDR(&header);
+    message->cmsg_len = CMSG_LEN(fds_bytes);
+    message->cmsg_level = SOL_SOCKET;
+    message->cmsg_type = SCM_RIGHTS;
+
+    int* const data = reinterpret_cast<int*>(CMSG_DATA(message));
+    int i = 0;
+    for (auto& fd : fds)
+        data[i++] = fd;
+
+    while (sendmsg(socket, &header, MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return false;
+        if (errno != EINTR)
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to send fds"));
+    }
+    return true;
+}
+}
+
+mfd::SocketMessenger::SocketMessenger(
+    std::shared_ptr<ba::local::stream_protocol::socket> const& socket,
+    size_t max_queued_bytes)
     : socket(socket),
-      socket_fd{IntOwnedFd{socket->native_handle()}}
+      socket_fd{IntOwnedFd{socket->native_handle()}},
+      max_queued_bytes{max_queued_bytes}
 {
     // Make the socket non-blocking to avoid hanging the server when a client
     // is unresponsive. Also increase the send buffer size to 64KiB to allow
-    // more leeway for transient client freezes.
+    // more leeway for transient client freezes, before we start queuing.
     // See https://bugs.launchpad.net/mir/+bug/1350207
-    // TODO: Rework the messenger to support asynchronous sends
     socket->non_blocking(true);
     boost::asio::socket_base::send_buffer_size option(64*1024);
     socket->set_option(option);
@@ -73,24 +133,193 @@ mf::SessionCredentials mfd::SocketMessenger::client_creds()
 
 void mfd::SocketMessenger::send(char const* data, size_t length, FdSets const& fd_set)
 {
-    static size_t const header_size{2};
-    mir::VariableLengthArray<mf::serialization_buffer_size> whole_message{header_size + length};
+    if (length > max_inline_size)
+    {
+        send_out_of_line(data, length, fd_set);
+        return;
+    }
+
+    char const header[header_size] = {
+        static_cast<char>((length >> 8) & 0xff),
+        static_cast<char>((length >> 0) & 0xff)};
+
+    std::lock_guard<std::mutex> lg(message_lock);
+
+    // Messages must arrive in the order they're sent (SessionMediator relies
+    // on it), so we only write directly when nothing is queued ahead of us.
+    size_t sent{0};
+    auto unsent_fds = fd_set.begin();
+    if (outgoing.empty())
+    {
+        iovec const iov[] = {
+            {const_cast<char*>(header), header_size},
+            {const_cast<char*>(data), length}};
+        sent = write_some(iov, 2);
+
+        if (sent == header_size + length)
+        {
+            while (unsent_fds != fd_set.end() && try_send_fds(socket_fd, *unsent_fds))
+                ++unsent_fds;
+
+            if (unsent_fds == fd_set.end())
+                return;
+        }
+    }
+
+    Outgoing message{{}, 0, FdSets(unsent_fds, fd_set.end())};
+    message.bytes.reserve(header_size + length - sent);
+    if (sent < header_size)
+        message.bytes.insert(message.bytes.end(), header + sent, header + header_size);
+    auto const body_sent = sent > header_size ? sent - header_size : 0;
+    message.bytes.insert(message.bytes.end(), data + body_sent, data + length);
+
+    queued_bytes += message.bytes.size();
+    outgoing.push_back(std::move(message));
+
+    if (queued_bytes > max_queued_bytes)
+    {
+        log_warning(
+            "Disconnecting client (pid %d): it has stopped reading and %zu bytes are waiting for it",
+            client_creds().pid(), queued_bytes);
+
+        outgoing.clear();
+        queued_bytes = 0;
+        ::shutdown(socket_fd, SHUT_RDWR);
+        BOOST_THROW_EXCEPTION(std::runtime_error("Client is not reading its messages"));
+    }
+
+    wait_until_writable();
+}
+
+void mfd::SocketMessenger::send_out_of_line(char const* data, size_t length, FdSets const& fd_set)
+{
+    if (!large_results_accepted)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Message is too large for the client to receive"));
+
+    mir::AnonymousShmFile payload{length};
+    memcpy(payload.base_ptr(), data, length);
+
+    mir::protobuf::wire::Result placeholder;
+    placeholder.set_out_of_line_size(length);
+    auto const frame = placeholder.SerializeAsString();
+
+    auto const payload_fd = dup(payload.fd());
+    if (payload_fd < 0)
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to dup out-of-line message fd"));
+
+    FdSets fds{{mir::Fd{payload_fd}}};
+    fds.insert(fds.end(), fd_set.begin(), fd_set.end());
+
+    send(frame.data(), frame.size(), fds);
+}
+
+size_t mfd::SocketMessenger::write_some(iovec const* iov, size_t count)
+{
+    msghdr header{};
+    header.msg_iov = const_cast<iovec*>(iov);
+    header.msg_iovlen = count;
+
+    ssize_t written;
+    while ((written = sendmsg(socket_fd, &header, MSG_DONTWAIT | MSG_NOSIGNAL)) < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        if (errno != EINTR)
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to send message"));
+    }
+    return written;
+}
+
+bool mfd::SocketMessenger::send_queued_fds(Outgoing& message)
+{
+    auto fds = message.fds.begin();
+    while (fds != message.fds.end() && try_send_fds(socket_fd, *fds))
+        ++fds;
+
+    message.fds.erase(message.fds.begin(), fds);
+    return message.fds.empty();
+}
+
+bool mfd::SocketMessenger::flush_outgoing()
+{
+    while (!outgoing.empty())
+    {
+        // Coalesce everything queued up to the next message with fds, which
+        // must be read by the client before they're sent
+        iovec iov[max_iov];
+        size_t count{0};
+        size_t batch{0};
+        for (auto const& message : outgoing)
+        {
+            if (count == max_iov)
+                break;
+
+            ++batch;
+            if (message.sent < message.bytes.size())
+                iov[count++] = {const_cast<char*>(message.bytes.data()) + message.sent,
+                                message.bytes.size() - message.sent};
+
+            if (!message.fds.empty())
+                break;
+        }
+
+        auto written = count ? write_some(iov, count) : 0;
+        queued_bytes -= written;
+
+        for (; batch != 0; --batch)
+        {
+            auto& message = outgoing.front();
+            auto const step = std::min(written, message.bytes.size() - message.sent);
+            message.sent += step;
+            written -= step;
+
+            if (message.sent < message.bytes.size() || !send_queued_fds(message))
+                return false;
+
+            outgoing.pop_front();
+        }
+    }
+
+    return true;
+}
+
+void mfd::SocketMessenger::wait_until_writable()
+{
+    if (waiting_until_writable)
+        return;
 
-    whole_message.data()[0] = static_cast<unsigned char>((length >> 8) & 0xff);
-    whole_message.data()[1] = static_cast<unsigned char>((length >> 0) & 0xff);
-    std::copy(data, data + length, whole_message.data() + header_size);
+    waiting_until_writable = true;
+    std::weak_ptr<SocketMessenger> const weak_self = shared_from_this();
+    socket->async_send(
+        ba::null_buffers(),
+        [weak_self](bs::error_code const& error, size_t)
+        {
+            if (auto const self = weak_self.lock())
+                self->on_writable(error);
+        });
+}
 
-    std::unique_lock<std::mutex> lg(message_lock);
+void mfd::SocketMessenger::on_writable(bs::error_code const& error)
+{
+    std::lock_guard<std::mutex> lg(message_lock);
+    waiting_until_writable = false;
 
-    // TODO: This should be asynchronous, but we are not making sure
-    // that a potential call to send_fds is executed _after_ this
-    // function has completed (if it would be executed asynchronously.
-    // NOTE: we rely on this synchronous behavior as per the comment in
-    // mf::SessionMediator::create_surface
-    ba::write(*socket, ba::buffer(whole_message.data(), whole_message.size()));
+    if (!error)
+    {
+        try
+        {
+            if (!flush_outgoing())
+                wait_until_writable();
+            return;
+        }
+        catch (std::exception const&)
+        {
+            // The client has gone: its connection notices when reading fails
+        }
+    }
 
-    for (auto const& fds : fd_set)
-        mir::send_fds(socket_fd, fds);
+    outgoing.clear();
+    queued_bytes = 0;
 }
 
 void mfd::SocketMessenger::async_receive_msg(
@@ -130,6 +359,11 @@ void mfd::SocketMessenger::receive_fds(std::vector<Fd>& fds)
     mir::receive_data(socket_fd, &buffer, 1, fds);
 }
 
+void mfd::SocketMessenger::client_accepts_large_results()
+{
+    large_results_accepted = true;
+}
+
 size_t mfd::SocketMessenger::available_bytes()
 {
     // We call available_bytes() once the client is talking to us
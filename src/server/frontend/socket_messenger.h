@@ -21,7 +21,14 @@
 #include "message_sender.h"
 #include "message_receiver.h"
 #include "mir/frontend/session_credentials.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
+
+struct iovec;
 
 namespace mir
 {
@@ -29,11 +36,25 @@ namespace frontend
 {
 namespace detail
 {
+/**
+ * Sends messages without ever blocking the sending thread.
+ *
+ * Whatever the socket won't take immediately is queued, along with any fds
+ * that follow it, and written from the io_service as the client reads. A
+ * client that lets more than max_queued_bytes back up is disconnected.
+ */
 class SocketMessenger : public MessageSender,
-                        public MessageReceiver
+                        public MessageReceiver,
+                        public std::enable_shared_from_this<SocketMessenger>
 {
 public:
-    SocketMessenger(std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket);
+    static size_t const default_max_queued_bytes = 4*1024*1024;
+    /// Larger messages can only be sent out of line, by memfd
+    static size_t const max_inline_size = 0xffff;
+
+    SocketMessenger(
+        std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket,
+        size_t max_queued_bytes = default_max_queued_bytes);
 
     void send(char const* data, size_t length, FdSets const& fds) override;
 
@@ -42,16 +63,38 @@ public:
     size_t available_bytes() override;
     SessionCredentials client_creds() override;
     void receive_fds(std::vector<Fd>& fds) override;
+    void client_accepts_large_results() override;
 
 private:
     void set_passcred(int opt);
     void update_session_creds();
     SessionCredentials creator_creds() const;
+    void send_out_of_line(char const* data, size_t length, FdSets const& fds);
+
+    // A message, or what's left of it, and the fds to send after it
+    struct Outgoing
+    {
+        std::vector<char> bytes;
+        size_t sent;
+        FdSets fds;
+    };
+
+    // These require message_lock to be held
+    size_t write_some(iovec const* iov, size_t count);
+    bool send_queued_fds(Outgoing& message);
+    bool flush_outgoing();
+    void wait_until_writable();
+    void on_writable(boost::system::error_code const& error);
 
     std::shared_ptr<boost::asio::local::stream_protocol::socket> socket;
     mir::Fd socket_fd;
+    size_t const max_queued_bytes;
+    std::atomic<bool> large_results_accepted{false};
 
     std::mutex message_lock;
+    std::deque<Outgoing> outgoing;
+    size_t queued_bytes{0};
+    bool waiting_until_writable{false};
     SessionCredentials session_creds{0, 0, 0};
 };
 }
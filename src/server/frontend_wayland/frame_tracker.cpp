@@ -0,0 +1,174 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_tracker.h"
+
+#include "mir/executor.h"
+#include "mir/time/posix_timestamp.h"
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mt = mir::time;
+
+mf::FrameNotifier::FrameNotifier(std::shared_ptr<Executor> const& wayland_executor)
+    : wayland_executor{wayland_executor}
+{
+}
+
+void mf::FrameNotifier::on_next_frame(mc::DisplayGroupId group, Notification const& notification)
+{
+    waiting.emplace_back(group, notification);
+}
+
+void mf::FrameNotifier::frame_presented(
+    mc::DisplayGroupId group,
+    mg::Frame const& frame,
+    std::chrono::nanoseconds refresh)
+{
+    std::vector<Notification> notifications;
+    auto i = begin(waiting);
+    while (i != end(waiting))
+    {
+        // Other groups' frames don't show what was drawn for this one
+        if (!i->first || i->first == group)
+        {
+            notifications.push_back(std::move(i->second));
+            i = waiting.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (notifications.empty())
+        return;
+
+    auto monotonic_frame = frame;
+    if (frame.ust.clock_id != CLOCK_MONOTONIC)
+    {
+        // Clients are told all times are CLOCK_MONOTONIC, so carry the frame's age across
+        auto const age = mt::PosixTimestamp::now(frame.ust.clock_id) - frame.ust;
+        monotonic_frame.ust = mt::PosixTimestamp::now(CLOCK_MONOTONIC) - age;
+    }
+
+    for (auto const& notification : notifications)
+        notification(monotonic_frame, refresh);
+}
+
+mf::FrameTracker::FrameTracker(std::shared_ptr<FrameNotifier> const& frame_notifier, Replies const& replies)
+    : frame_notifier{frame_notifier},
+      replies{replies}
+{
+}
+
+mf::FrameTracker::~FrameTracker()
+{
+    discard_feedbacks(begin(feedbacks), end(feedbacks));
+}
+
+uint64_t mf::FrameTracker::commit(
+    std::vector<Callback> const& new_frame_callbacks,
+    std::vector<Callback> const& new_feedbacks)
+{
+    auto const commit = ++commits;
+
+    for (auto const& callback : new_frame_callbacks)
+        frame_callbacks.emplace(commit, callback);
+    for (auto const& feedback : new_feedbacks)
+        feedbacks.emplace(commit, feedback);
+
+    return commit;
+}
+
+void mf::FrameTracker::buffer_consumed(uint64_t commit, mc::DisplayGroupId group)
+{
+    // Feedback for earlier commits whose buffers were never consumed is for content that was never shown
+    discard_feedbacks(begin(feedbacks), feedbacks.lower_bound(commit));
+
+    std::vector<Callback> presented_feedbacks;
+    auto const consumed_feedbacks = feedbacks.upper_bound(commit);
+    for (auto i = begin(feedbacks); i != consumed_feedbacks; ++i)
+        presented_feedbacks.push_back(i->second);
+    feedbacks.erase(begin(feedbacks), consumed_feedbacks);
+
+    // Frame callbacks only ask for a good time to draw again, which the frame showing this is
+    std::vector<Callback> done_callbacks;
+    auto const consumed_callbacks = frame_callbacks.upper_bound(commit);
+    for (auto i = begin(frame_callbacks); i != consumed_callbacks; ++i)
+        done_callbacks.push_back(i->second);
+    frame_callbacks.erase(begin(frame_callbacks), consumed_callbacks);
+
+    if (done_callbacks.empty() && presented_feedbacks.empty())
+        return;
+
+    // The buffer has been drawn into a frame, so tell the client once that frame is on screen
+    frame_notifier->on_next_frame(
+        group,
+        [replies = replies, done_callbacks = std::move(done_callbacks), feedbacks = std::move(presented_feedbacks)]
+            (mg::Frame const& frame, std::chrono::nanoseconds refresh)
+        {
+            for (auto const& callback : done_callbacks)
+            {
+                if (!*callback.destroyed)
+                    replies.done(callback.resource, frame.ust.nanoseconds);
+            }
+
+            for (auto const& feedback : feedbacks)
+            {
+                if (!*feedback.destroyed)
+                    replies.presented(feedback.resource, frame, refresh);
+            }
+        });
+}
+
+void mf::FrameTracker::nothing_to_draw(uint64_t commit)
+{
+    discard_feedbacks(feedbacks.lower_bound(commit), feedbacks.upper_bound(commit));
+    send_frame_callbacks_now();
+}
+
+void mf::FrameTracker::unmapped()
+{
+    discard_feedbacks(begin(feedbacks), end(feedbacks));
+    send_frame_callbacks_now();
+}
+
+void mf::FrameTracker::send_frame_callbacks_now()
+{
+    auto const now = mt::PosixTimestamp::now(CLOCK_MONOTONIC).nanoseconds;
+
+    // Answering a callback destroys it, so take them all first
+    auto const callbacks = std::move(frame_callbacks);
+    frame_callbacks.clear();
+
+    for (auto const& callback : callbacks)
+    {
+        if (!*callback.second.destroyed)
+            replies.done(callback.second.resource, now);
+    }
+}
+
+void mf::FrameTracker::discard_feedbacks(Callbacks::iterator from, Callbacks::iterator to)
+{
+    for (auto i = from; i != to; ++i)
+    {
+        if (!*i->second.destroyed)
+            replies.discarded(i->second.resource);
+    }
+    feedbacks.erase(from, to);
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_FRAME_TRACKER_H
+#define MIR_FRONTEND_FRAME_TRACKER_H
+
+#include "mir/compositor/presentation_observer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct wl_resource;
+
+namespace mir
+{
+class Executor;
+
+namespace frontend
+{
+/**
+ * Runs notifications on the Wayland thread when the compositor next puts a
+ * frame on screen.
+ *
+ * Register with the compositor's presentation observers using executor(),
+ * and only call on_next_frame() on the Wayland thread.
+ */
+class FrameNotifier : public compositor::PresentationObserver
+{
+public:
+    /// The frame is always timed by CLOCK_MONOTONIC
+    typedef std::function<void(graphics::Frame const& frame, std::chrono::nanoseconds refresh)> Notification;
+
+    FrameNotifier(std::shared_ptr<Executor> const& wayland_executor);
+
+    Executor& executor() const { return *wayland_executor; }
+
+    /// Runs notification once, when group next presents a frame (or when any group does, if group is null)
+    void on_next_frame(compositor::DisplayGroupId group, Notification const& notification);
+
+    void frame_presented(
+        compositor::DisplayGroupId group,
+        graphics::Frame const& frame,
+        std::chrono::nanoseconds refresh) override;
+
+private:
+    std::shared_ptr<Executor> const wayland_executor;
+    std::vector<std::pair<compositor::DisplayGroupId, Notification>> waiting;
+};
+
+/**
+ * Follows a surface's commits to the screen, answering their frame callbacks
+ * and presentation feedback. Only use on the Wayland thread.
+ */
+class FrameTracker
+{
+public:
+    struct Callback
+    {
+        wl_resource* resource;
+        std::shared_ptr<bool> destroyed;
+    };
+
+    /// How callbacks are answered. These are never given destroyed callbacks.
+    struct Replies
+    {
+        std::function<void(wl_resource* callback, std::chrono::nanoseconds time)> done;
+        std::function<void(wl_resource* feedback, graphics::Frame const& frame, std::chrono::nanoseconds refresh)>
+            presented;
+        std::function<void(wl_resource* feedback)> discarded;
+    };
+
+    FrameTracker(std::shared_ptr<FrameNotifier> const& frame_notifier, Replies const& replies);
+    /// Discards any feedback still waiting
+    ~FrameTracker();
+
+    /**
+     * Starts tracking a commit's frame callbacks and presentation feedback.
+     *
+     * \return  The commit, as the other functions know it
+     */
+    uint64_t commit(std::vector<Callback> const& frame_callbacks, std::vector<Callback> const& feedbacks);
+
+    /**
+     * The commit's buffer has been drawn into a frame for group (null if
+     * unknown). Its callbacks, and those of earlier commits, are answered
+     * once that frame is on screen; except for feedback on the earlier
+     * commits, whose buffers were never shown and so is discarded.
+     */
+    void buffer_consumed(uint64_t commit, compositor::DisplayGroupId group);
+
+    /**
+     * The commit has no new buffer, so nothing will be drawn for it. Its
+     * feedback is discarded, and all waiting frame callbacks are answered
+     * now so that an idle compositor never stalls the client.
+     */
+    void nothing_to_draw(uint64_t commit);
+
+    /// Nothing committed so far will be shown: discards all feedback and answers all frame callbacks now
+    void unmapped();
+
+private:
+    std::shared_ptr<FrameNotifier> const frame_notifier;
+    Replies const replies;
+    // Keyed by the commit they were requested for, until that commit's buffer is consumed
+    typedef std::multimap<uint64_t, Callback> Callbacks;
+
+    uint64_t commits{0};
+    Callbacks frame_callbacks;
+    Callbacks feedbacks;
+
+    void send_frame_callbacks_now();
+    void discard_feedbacks(Callbacks::iterator from, Callbacks::iterator to);
+};
+}
+}
+
+#endif // MIR_FRONTEND_FRAME_TRACKER_H
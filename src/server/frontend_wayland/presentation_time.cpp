@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_time.h"
+
+#include "wl_surface.h"
+#include "deleted_for_resource.h"
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+
+mf::WpPresentation::WpPresentation(struct wl_display* display)
+    : Presentation(display, 1)
+{
+}
+
+void mf::WpPresentation::send_presented(
+    wl_resource* feedback,
+    mg::Frame const& frame,
+    std::chrono::nanoseconds refresh)
+{
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(frame.ust.nanoseconds);
+    auto const nanoseconds = frame.ust.nanoseconds - seconds;
+    uint64_t const sec = seconds.count();
+    uint64_t const msc = frame.msc;
+
+    /*
+     * Groups with a refresh interval time their frames by the page flip that
+     * showed them. Without one the time is only when the group reported the
+     * frame done.
+     */
+    uint32_t const flags = refresh.count() > 0 ?
+        WP_PRESENTATION_FEEDBACK_KIND_VSYNC |
+        WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK |
+        WP_PRESENTATION_FEEDBACK_KIND_HW_COMPLETION :
+        0;
+
+    wp_presentation_feedback_send_presented(
+        feedback,
+        sec >> 32, sec & 0xffffffff,
+        nanoseconds.count(),
+        refresh.count(),
+        msc >> 32, msc & 0xffffffff,
+        flags);
+    wl_resource_destroy(feedback);
+}
+
+void mf::WpPresentation::send_discarded(wl_resource* feedback)
+{
+    wp_presentation_feedback_send_discarded(feedback);
+    wl_resource_destroy(feedback);
+}
+
+void mf::WpPresentation::bind(struct wl_client* /*client*/, struct wl_resource* resource)
+{
+    wp_presentation_send_clock_id(resource, CLOCK_MONOTONIC);
+}
+
+void mf::WpPresentation::destroy(struct wl_client* /*client*/, struct wl_resource* resource)
+{
+    wl_resource_destroy(resource);
+}
+
+void mf::WpPresentation::feedback(
+    struct wl_client* client,
+    struct wl_resource* resource,
+    struct wl_resource* surface,
+    uint32_t callback)
+{
+    auto const feedback_resource = wl_resource_create(
+        client,
+        &wp_presentation_feedback_interface,
+        wl_resource_get_version(resource),
+        callback);
+    if (feedback_resource == nullptr)
+    {
+        wl_resource_post_no_memory(resource);
+        return;
+    }
+
+    WlSurface::from(surface)->add_presentation_feedback(
+        WlSurfaceState::Callback{feedback_resource, deleted_flag_for_resource(feedback_resource)});
+}
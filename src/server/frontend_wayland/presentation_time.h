@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PRESENTATION_TIME_H
+#define MIR_FRONTEND_PRESENTATION_TIME_H
+
+#include "generated/presentation-time_wrapper.h"
+
+#include "mir/graphics/frame.h"
+
+#include <chrono>
+
+namespace mir
+{
+namespace frontend
+{
+/// The wp_presentation global
+class WpPresentation : public wayland::Presentation
+{
+public:
+    WpPresentation(struct wl_display* display);
+
+    /// Sends the presented event to a wp_presentation_feedback, which destroys it
+    static void send_presented(wl_resource* feedback, graphics::Frame const& frame, std::chrono::nanoseconds refresh);
+    /// Sends the discarded event to a wp_presentation_feedback, which destroys it
+    static void send_discarded(wl_resource* feedback);
+
+private:
+    void bind(struct wl_client* client, struct wl_resource* resource) override;
+    void destroy(struct wl_client* client, struct wl_resource* resource) override;
+    void feedback(struct wl_client* client, struct wl_resource* resource,
+                  struct wl_resource* surface, uint32_t callback) override;
+};
+}
+}
+
+#endif // MIR_FRONTEND_PRESENTATION_TIME_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_access.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+struct Access
+{
+    char* start;
+    size_t length;
+    bool volatile faulted;
+    Access* enclosing;
+};
+
+// Only ever touched by its own thread, and by the signal handler interrupting that thread
+thread_local Access* current_access = nullptr;
+
+struct sigaction previous_action;
+std::once_flag handler_installed;
+
+void handle_sigbus(int signal, siginfo_t* info, void* context)
+{
+    auto const address = static_cast<char*>(info->si_addr);
+
+    for (auto access = current_access; access; access = access->enclosing)
+    {
+        if (access->start <= address && address < access->start + access->length)
+        {
+            // Swap in zeroed memory, so the faulting instruction succeeds when it is restarted
+            if (mmap(access->start, access->length,
+                     PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0) != MAP_FAILED)
+            {
+                access->faulted = true;
+                return;
+            }
+            break;
+        }
+    }
+
+    // Not ours: hand it on as though we weren't here (libwayland's handler does the same for its accesses)
+    if (previous_action.sa_flags & SA_SIGINFO)
+    {
+        previous_action.sa_sigaction(signal, info, context);
+    }
+    else if (previous_action.sa_handler == SIG_DFL)
+    {
+        ::signal(signal, SIG_DFL);
+        raise(signal);
+    }
+    else if (previous_action.sa_handler != SIG_IGN)
+    {
+        previous_action.sa_handler(signal);
+    }
+}
+
+void install_handler()
+{
+    struct sigaction action{};
+    action.sa_sigaction = &handle_sigbus;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGBUS, &action, &previous_action) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to install SIGBUS handler"}));
+    }
+}
+}
+
+bool mf::access_client_memory(void* data, size_t size, std::function<void()> const& access)
+{
+    std::call_once(handler_installed, &install_handler);
+
+    // A truncated file faults whole pages, and those are what we have to replace
+    auto const page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto const begin = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+    auto const end = (reinterpret_cast<uintptr_t>(data) + size + page_size - 1) & ~(page_size - 1);
+
+    Access this_access{reinterpret_cast<char*>(begin), end - begin, false, current_access};
+
+    current_access = &this_access;
+    try
+    {
+        access();
+    }
+    catch (...)
+    {
+        current_access = this_access.enclosing;
+        throw;
+    }
+    current_access = this_access.enclosing;
+
+    return !this_access.faulted;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_SHM_ACCESS_H_
+#define MIR_FRONTEND_SHM_ACCESS_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Runs access() on memory a client shares with us, surviving the client
+ * truncating the file behind it.
+ *
+ * Unlike wl_shm_buffer_begin_access()/end_access() this touches no libwayland
+ * state, so it is safe on any thread, and it leaves reporting the client's
+ * error to the caller (who should do so on the Wayland thread).
+ *
+ * \param [in] data, size  the client's memory
+ * \param [in] access      reads or writes [data, data + size)
+ * \return false if the memory went away under access(); it has then been
+ *         replaced by zeroed memory, so access() saw zeros rather than crashing
+ */
+bool access_client_memory(void* data, size_t size, std::function<void()> const& access);
+}
+}
+
+#endif /* MIR_FRONTEND_SHM_ACCESS_H_ */
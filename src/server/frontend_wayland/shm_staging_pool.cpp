@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_staging_pool.h"
+
+namespace mf = mir::frontend;
+
+mf::ShmStagingPool::ShmStagingPool(size_t max_free_blocks)
+    : max_free_blocks{max_free_blocks}
+{
+}
+
+std::shared_ptr<uint8_t> mf::ShmStagingPool::acquire(size_t size)
+{
+    Block block{0, nullptr};
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        // Don't tie up a much bigger block than we need
+        auto best = free.end();
+        for (auto i = free.begin(); i != free.end(); ++i)
+        {
+            if (i->size >= size && i->size / 2 <= size && (best == free.end() || i->size < best->size))
+                best = i;
+        }
+
+        if (best != free.end())
+        {
+            block = std::move(*best);
+            free.erase(best);
+        }
+    }
+
+    if (!block.memory)
+        block = {size, std::make_unique<uint8_t[]>(size)};
+
+    std::weak_ptr<ShmStagingPool> const pool = shared_from_this();
+    auto const block_size = block.size;
+
+    return {
+        block.memory.release(),
+        [pool, block_size](uint8_t* memory)
+        {
+            Block block{block_size, std::unique_ptr<uint8_t[]>{memory}};
+            if (auto const live_pool = pool.lock())
+                live_pool->release(std::move(block));
+        }};
+}
+
+size_t mf::ShmStagingPool::free_blocks() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return free.size();
+}
+
+void mf::ShmStagingPool::release(Block&& block)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // The oldest block is the least likely to match what clients use now
+    if (free.size() >= max_free_blocks && !free.empty())
+        free.erase(free.begin());
+
+    if (max_free_blocks > 0)
+        free.push_back(std::move(block));
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_SHM_STAGING_POOL_H_
+#define MIR_FRONTEND_SHM_STAGING_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Recycles the memory that wl_shm buffer content is copied into when it
+ * can't be read from the client's pool in place.
+ *
+ * Clients typically cycle through two or three buffers of one size, so
+ * keeping a few freed blocks around avoids allocating (and faulting in)
+ * a whole frame's worth of memory on every commit.
+ */
+class ShmStagingPool : public std::enable_shared_from_this<ShmStagingPool>
+{
+public:
+    explicit ShmStagingPool(size_t max_free_blocks);
+
+    /// At least size bytes, which go back to the pool when the last reference is dropped
+    std::shared_ptr<uint8_t> acquire(size_t size);
+
+    size_t free_blocks() const;
+
+private:
+    ShmStagingPool(ShmStagingPool const&) = delete;
+    ShmStagingPool& operator=(ShmStagingPool const&) = delete;
+
+    struct Block
+    {
+        size_t size;
+        std::unique_ptr<uint8_t[]> memory;
+    };
+
+    void release(Block&& block);
+
+    size_t const max_free_blocks;
+    std::mutex mutable mutex;
+    std::vector<Block> free;
+};
+}
+}
+
+#endif /* MIR_FRONTEND_SHM_STAGING_POOL_H_ */
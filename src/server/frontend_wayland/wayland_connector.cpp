@@ -29,8 +29,11 @@
 
 #include "null_event_sink.h"
 #include "output_manager.h"
+#include "presentation_time.h"
+#include "frame_tracker.h"
 #include "wayland_executor.h"
 #include "wlshmbuffer.h"
+#include "shm_staging_pool.h"
 
 #include "generated/wayland_wrapper.h"
 
@@ -40,6 +43,7 @@
 #include "mir/frontend/session_authorizer.h"
 
 #include "mir/compositor/buffer_stream.h"
+#include "mir/observer_registrar.h"
 
 #include "mir/frontend/session.h"
 #include "mir/scene/surface_creation_parameters.h"
@@ -98,6 +102,9 @@ namespace frontend
 
 namespace
 {
+// Enough for a few clients' double-buffered content
+size_t const shm_staging_blocks = 8;
+
 struct ClientPrivate
 {
     ClientPrivate(std::shared_ptr<mf::Session> const& session, mf::Shell* shell)
@@ -263,16 +270,24 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& executor,
-        std::shared_ptr<mg::WaylandAllocator> const& allocator)
+        std::shared_ptr<FrameNotifier> const& frame_notifier,
+        std::shared_ptr<mg::WaylandAllocator> const& allocator,
+        bool shm_direct_access)
         : Compositor(display, 3),
           allocator{allocator},
-          executor{executor}
+          shm_staging{std::make_shared<ShmStagingPool>(shm_staging_blocks)},
+          shm_direct_access{shm_direct_access},
+          executor{executor},
+          frame_notifier{frame_notifier}
     {
     }
 
 private:
     std::shared_ptr<mg::WaylandAllocator> const allocator;
+    std::shared_ptr<ShmStagingPool> const shm_staging;
+    bool const shm_direct_access;
     std::shared_ptr<mir::Executor> const executor;
+    std::shared_ptr<FrameNotifier> const frame_notifier;
 
     void create_surface(wl_client* client, wl_resource* resource, uint32_t id) override;
     void create_region(wl_client* client, wl_resource* resource, uint32_t id) override;
@@ -280,7 +295,7 @@ private:
 
 void WlCompositor::create_surface(wl_client* client, wl_resource* resource, uint32_t id)
 {
-    new WlSurface{client, resource, id, executor, allocator};
+    new WlSurface{client, resource, id, executor, frame_notifier, allocator, shm_staging, shm_direct_access};
 }
 
 void WlCompositor::create_region(wl_client* client, wl_resource* resource, uint32_t id)
@@ -593,7 +608,9 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<mi::Seat> const& seat,
     std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
     std::shared_ptr<mf::SessionAuthorizer> const& session_authorizer,
+    std::shared_ptr<ObserverRegistrar<compositor::PresentationObserver>> const& presentation_observers,
     bool arw_socket,
+    bool shm_direct_access,
     std::unique_ptr<WaylandExtensions> extensions_)
     : display{wl_display_create(), &cleanup_display},
       pause_signal{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)},
@@ -624,10 +641,15 @@ mf::WaylandConnector::WaylandConnector(
      */
     auto const executor = executor_for_event_loop(wl_display_get_event_loop(display.get()));
 
+    frame_notifier = std::make_shared<mf::FrameNotifier>(executor);
+    presentation_observers->register_interest(frame_notifier, frame_notifier->executor());
+
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        this->allocator);
+        frame_notifier,
+        this->allocator,
+        shm_direct_access);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
     seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, seat, executor);
     output_manager = std::make_unique<mf::OutputManager>(
@@ -635,6 +657,7 @@ mf::WaylandConnector::WaylandConnector(
         display_config);
 
     data_device_manager_global = mf::create_data_device_manager(display.get());
+    presentation_global = std::make_unique<mf::WpPresentation>(display.get());
 
     extensions->init(display.get(), shell, seat_global.get(), output_manager.get());
 
@@ -29,6 +29,12 @@
 
 namespace mir
 {
+template<class Observer>
+class ObserverRegistrar;
+namespace compositor
+{
+class PresentationObserver;
+}
 namespace input
 {
 class InputDeviceHub;
@@ -55,6 +61,8 @@ class Shell;
 class DisplayChanger;
 class SessionAuthorizer;
 class DataDeviceManager;
+class FrameNotifier;
+class WpPresentation;
 
 class WaylandExtensions
 {
@@ -88,7 +96,9 @@ public:
         std::shared_ptr<input::Seat> const& seat,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
+        std::shared_ptr<ObserverRegistrar<compositor::PresentationObserver>> const& presentation_observers,
         bool arw_socket,
+        bool shm_direct_access,
         std::unique_ptr<WaylandExtensions> extensions);
 
     ~WaylandConnector() override;
@@ -117,6 +127,8 @@ private:
     std::unique_ptr<OutputManager> output_manager;
     std::shared_ptr<graphics::WaylandAllocator> const allocator;
     std::unique_ptr<DataDeviceManager> data_device_manager_global;
+    std::shared_ptr<FrameNotifier> frame_notifier;
+    std::unique_ptr<WpPresentation> presentation_global;
     std::unique_ptr<WaylandExtensions> const extensions;
     std::thread dispatch_thread;
     wl_event_source* pause_source;
@@ -69,7 +69,9 @@ std::shared_ptr<mf::Connector>
                 the_seat(),
                 the_buffer_allocator(),
                 the_session_authorizer(),
+                the_presentation_observer_registrar(),
                 arw_socket,
+                options->get<bool>(mo::wayland_shm_direct_opt),
                 std::make_unique<WaylandExtensions>(options->is_set(mo::x11_display_opt)));
         });
 }
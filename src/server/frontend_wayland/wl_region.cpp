@@ -31,7 +31,12 @@ mf::WlRegion::~WlRegion()
 
 std::vector<geom::Rectangle> mf::WlRegion::rectangle_vector()
 {
-    return rects;
+    return region_.rectangles();
+}
+
+geom::Region mf::WlRegion::region() const
+{
+    return region_;
 }
 
 mf::WlRegion* mf::WlRegion::from(wl_resource* resource)
@@ -47,14 +52,10 @@ void mf::WlRegion::destroy()
 
 void mf::WlRegion::add(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    rects.push_back(geom::Rectangle{{x, y}, {width, height}});
+    region_.unite(geom::Rectangle{{x, y}, {width, height}});
 }
 
 void mf::WlRegion::subtract(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    log_warning("WlRegion::subtract not implemented. ignoring.");
+    region_.subtract(geom::Rectangle{{x, y}, {width, height}});
 }
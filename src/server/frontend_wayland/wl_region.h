@@ -23,6 +23,7 @@
 #include "generated/wayland_wrapper.h"
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/region.h"
 
 #include <vector>
 
@@ -38,6 +39,7 @@ public:
     ~WlRegion();
 
     std::vector<geometry::Rectangle> rectangle_vector();
+    geometry::Region region() const;
 
     static WlRegion* from(wl_resource* resource);
 
@@ -46,7 +48,7 @@ private:
     void add(int32_t x, int32_t y, int32_t width, int32_t height) override;
     void subtract(int32_t x, int32_t y, int32_t width, int32_t height) override;
 
-    std::vector<geometry::Rectangle> rects;
+    geometry::Region region_;
 };
 
 }
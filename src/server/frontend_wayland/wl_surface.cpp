@@ -24,6 +24,7 @@
 #include "wl_region.h"
 #include "wlshmbuffer.h"
 #include "deleted_for_resource.h"
+#include "presentation_time.h"
 
 #include "generated/wayland_wrapper.h"
 
@@ -34,9 +35,38 @@
 #include "mir/graphics/wayland_allocator.h"
 #include "mir/shell/surface_specification.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace mf = mir::frontend;
+namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Clients commonly damage (0, 0, INT32_MAX, INT32_MAX) to mean "everything", so avoid overflowing the far edge
+geom::Rectangle damage_rect(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    auto const max = std::numeric_limits<int32_t>::max();
+    int64_t const left = std::max(x, 0);
+    int64_t const top = std::max(y, 0);
+    int64_t const right = std::min(int64_t{x} + width, int64_t{max});
+    int64_t const bottom = std::min(int64_t{y} + height, int64_t{max});
+
+    return {{left, top}, {std::max(right - left, int64_t{0}), std::max(bottom - top, int64_t{0})}};
+}
+
+void send_done(wl_resource* callback, std::chrono::nanoseconds time)
+{
+    // wl_callback.done carries a timestamp in milliseconds
+    uint32_t const time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+
+    wl_callback_send_done(callback, time_ms);
+    wl_resource_destroy(callback);
+}
+}
+}
+
 void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
 {
     if (source.buffer)
@@ -52,6 +82,16 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedbacks.insert(end(presentation_feedbacks),
+                                  begin(source.presentation_feedbacks),
+                                  end(source.presentation_feedbacks));
+
+    for (auto const& rect : source.damage)
+        damage.add(rect);
+
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -68,15 +108,21 @@ mf::WlSurface::WlSurface(
     wl_resource* parent,
     uint32_t id,
     std::shared_ptr<Executor> const& executor,
-    std::shared_ptr<graphics::WaylandAllocator> const& allocator)
+    std::shared_ptr<FrameNotifier> const& frame_notifier,
+    std::shared_ptr<graphics::WaylandAllocator> const& allocator,
+    std::shared_ptr<ShmStagingPool> const& shm_staging,
+    bool shm_direct_access)
     : Surface(client, parent, id),
         session{mf::get_session(client)},
         stream_id{session->create_buffer_stream({{}, mir_pixel_format_invalid, graphics::BufferUsage::undefined})},
         stream{session->get_buffer_stream(stream_id)},
         allocator{allocator},
+        shm_staging{shm_staging},
+        shm_direct_access{shm_direct_access},
         executor{executor},
         null_role{this},
         role{&null_role},
+        frames{frame_notifier, {&send_done, &WpPresentation::send_presented, &WpPresentation::send_discarded}},
         destroyed{std::make_shared<bool>(false)}
 {
     // wl_surface is specified to act in mailbox mode
@@ -205,20 +251,6 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
     return static_cast<WlSurface*>(static_cast<wayland::Surface*>(raw_surface));
 }
 
-void mf::WlSurface::send_frame_callbacks()
-{
-    for (auto const& frame : frame_callbacks)
-    {
-        if (!*frame.destroyed)
-        {
-            // TODO: argument should be a timestamp
-            wl_callback_send_done(frame.resource, 0);
-            wl_resource_destroy(frame.resource);
-        }
-    }
-    frame_callbacks.clear();
-}
-
 void mf::WlSurface::destroy()
 {
     *destroyed = true;
@@ -239,20 +271,13 @@ void mf::WlSurface::attach(std::experimental::optional<wl_resource*> const& buff
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    // Surface and buffer coordinates coincide until buffer scale and transform are supported
+    pending.damage.add(damage_rect(x, y, width, height));
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.damage.add(damage_rect(x, y, width, height));
 }
 
 void mf::WlSurface::frame(uint32_t callback)
@@ -264,8 +289,11 @@ void mf::WlSurface::frame(uint32_t callback)
 
 void mf::WlSurface::set_opaque_region(std::experimental::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    // A null region means nothing is known to be opaque
+    if (region)
+        pending.opaque_region = WlRegion::from(region.value())->region();
+    else
+        pending.opaque_region = geom::Region{};
 }
 
 void mf::WlSurface::set_input_region(std::experimental::optional<wl_resource*> const& region)
@@ -285,10 +313,9 @@ void mf::WlSurface::set_input_region(std::experimental::optional<wl_resource*> c
 
 void mf::WlSurface::commit(WlSurfaceState const& state)
 {
-    // We're going to lose the value of state, so copy the frame_callbacks first. We have to maintain a list of
-    // callbacks in wl_surface because if a client commits multiple times before the first buffer is handled, all the
-    // callbacks should be sent at once.
-    frame_callbacks.insert(end(frame_callbacks), begin(state.frame_callbacks), end(state.frame_callbacks));
+    // We're going to lose the value of state, so hand over the callbacks first. If a client commits multiple times
+    // before the first buffer is handled, all the callbacks should be answered at once.
+    auto const commit = frames.commit(state.frame_callbacks, state.presentation_feedbacks);
 
     if (state.offset)
         offset_ = state.offset.value();
@@ -296,6 +323,9 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        stream->set_opaque_region(state.opaque_region.value());
+
     if (state.buffer)
     {
         wl_resource * buffer = *state.buffer;
@@ -304,17 +334,20 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::experimental::nullopt;
-            send_frame_callbacks();
+            frames.unmapped();
         }
         else
         {
-            auto const executor_send_frame_callbacks = [this, executor = executor, destroyed = destroyed]()
+            auto const executor_buffer_consumed = [this, commit, executor = executor, destroyed = destroyed]()
                 {
+                    // We're called on the thread compositing the buffer, so that's where to find its group
+                    auto const group = compositor::compositing_group();
+
                     executor->spawn(run_unless(
                         destroyed,
-                        [this]()
+                        [this, commit, group]()
                         {
-                            send_frame_callbacks();
+                            frames.buffer_consumed(commit, group);
                         }));
                 };
 
@@ -324,7 +357,10 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 mir_buffer = WlShmBuffer::mir_buffer_from_wl_buffer(
                     buffer,
-                    std::move(executor_send_frame_callbacks));
+                    shm_direct_access,
+                    shm_staging,
+                    executor,
+                    std::move(executor_buffer_consumed));
             }
             else
             {
@@ -339,7 +375,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
                 mir_buffer = allocator->buffer_from_resource(
                     buffer,
-                    std::move(executor_send_frame_callbacks),
+                    std::move(executor_buffer_consumed),
                     std::move(release_buffer));
             }
 
@@ -357,13 +393,24 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                 state.invalidate_surface_data(); // input shape needs to be recalculated for the new size
             }
             buffer_size_ = mir_buffer->size();
+
+            geom::Rectangle const buffer_rect{{}, buffer_size_.value()};
+            geom::Rectangles damage;
+            for (auto const& rect : state.damage)
+            {
+                auto const clipped = rect.intersection_with(buffer_rect);
+                if (clipped.size != geom::Size{})
+                    damage.add(clipped);
+            }
+
             stream->resize(buffer_size_.value());
-            stream->submit_buffer(mir_buffer);
+            stream->submit_buffer(mir_buffer, damage);
         }
     }
     else
     {
-        send_frame_callbacks();
+        // Nothing new will be drawn, so don't keep the client waiting for a frame that may never come
+        frames.nothing_to_draw(commit);
     }
 
     for (WlSubsurface* child: children)
@@ -22,6 +22,7 @@
 #include "generated/wayland_wrapper.h"
 
 #include "wl_surface_role.h"
+#include "frame_tracker.h"
 
 #include "mir/frontend/buffer_stream_id.h"
 #include "mir/frontend/surface_id.h"
@@ -29,7 +30,10 @@
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
 
+#include <map>
 #include <vector>
 
 namespace mir
@@ -53,16 +57,13 @@ namespace frontend
 {
 class BufferStream;
 class Session;
+class ShmStagingPool;
 class WlSurface;
 class WlSubsurface;
 
 struct WlSurfaceState
 {
-    struct Callback
-    {
-        wl_resource* resource;
-        std::shared_ptr<bool> destroyed;
-    };
+    typedef FrameTracker::Callback Callback;
 
     // if you add variables, don't forget to update this
     void update_from(WlSurfaceState const& source);
@@ -79,6 +80,11 @@ struct WlSurfaceState
     std::experimental::optional<geometry::Displacement> offset;
     std::experimental::optional<std::experimental::optional<std::vector<geometry::Rectangle>>> input_shape;
     std::vector<Callback> frame_callbacks;
+    std::vector<Callback> presentation_feedbacks;
+    // Accumulated from both wl_surface.damage and wl_surface.damage_buffer. As we don't (yet) support buffer scale,
+    // transform or attach offsets the two coordinate spaces are the same, so this is in buffer coordinates.
+    geometry::Rectangles damage;
+    std::experimental::optional<geometry::Region> opaque_region;
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -116,7 +122,10 @@ public:
               wl_resource* parent,
               uint32_t id,
               std::shared_ptr<mir::Executor> const& executor,
-              std::shared_ptr<mir::graphics::WaylandAllocator> const& allocator);
+              std::shared_ptr<FrameNotifier> const& frame_notifier,
+              std::shared_ptr<mir::graphics::WaylandAllocator> const& allocator,
+              std::shared_ptr<ShmStagingPool> const& shm_staging,
+              bool shm_direct_access);
 
     ~WlSurface();
 
@@ -132,6 +141,8 @@ public:
     void set_role(WlSurfaceRole* role_);
     void clear_role();
     void set_pending_offset(geometry::Displacement const& offset) { pending.offset = offset; }
+    void add_presentation_feedback(WlSurfaceState::Callback const& feedback)
+        { pending.presentation_feedbacks.push_back(feedback); }
     std::unique_ptr<WlSurface, std::function<void(WlSurface*)>> add_child(WlSubsurface* child);
     void refresh_surface_data_now();
     void pending_invalidate_surface_data() { pending.invalidate_surface_data(); }
@@ -150,6 +161,8 @@ public:
 
 private:
     std::shared_ptr<mir::graphics::WaylandAllocator> const allocator;
+    std::shared_ptr<ShmStagingPool> const shm_staging;
+    bool const shm_direct_access;
     std::shared_ptr<mir::Executor> const executor;
 
     NullWlSurfaceRole null_role;
@@ -159,13 +172,11 @@ private:
     WlSurfaceState pending;
     geometry::Displacement offset_;
     std::experimental::optional<geometry::Size> buffer_size_;
-    std::vector<WlSurfaceState::Callback> frame_callbacks;
+    FrameTracker frames;
     std::experimental::optional<std::vector<mir::geometry::Rectangle>> input_shape;
     std::map<void const*, std::function<void()>> destroy_listeners;
     std::shared_ptr<bool> const destroyed;
 
-    void send_frame_callbacks();
-
     void destroy() override;
     void attach(std::experimental::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
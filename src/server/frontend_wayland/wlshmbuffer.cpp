@@ -19,8 +19,12 @@
  */
 
 #include "wlshmbuffer.h"
+#include "shm_staging_pool.h"
+#include "shm_access.h"
+#include "deleted_for_resource.h"
 
-#include <mir/log.h>
+#include <mir/executor.h>
+#include <mir/graphics/pixel_upload.h>
 
 #include <wayland-server-protocol.h>
 
@@ -128,14 +132,24 @@ using namespace mir::geometry;
 
 mf::WlShmBuffer::~WlShmBuffer()
 {
-    std::lock_guard <std::mutex> lock{*buffer_mutex};
-    if (buffer) {
-        wl_resource_queue_event(resource, WL_BUFFER_RELEASE);
-    }
+    // Anything that has read our content has finished with it by now, so the client can
+    // have the buffer back. That, and letting go of the pool, must happen on the Wayland thread.
+    executor->spawn(
+        [resource = resource, destroyed = resource_destroyed, pool = pool]()
+        {
+            if (pool)
+                wl_shm_pool_unref(pool);
+
+            if (!*destroyed)
+                wl_resource_queue_event(resource, WL_BUFFER_RELEASE);
+        });
 }
 
 std::shared_ptr<mg::Buffer> mf::WlShmBuffer::mir_buffer_from_wl_buffer(
     wl_resource *buffer,
+    bool direct_access,
+    std::shared_ptr<ShmStagingPool> const& staging,
+    std::shared_ptr<Executor> const& executor,
     std::function<void()> &&on_consumed)
 {
     std::shared_ptr <WlShmBuffer> mir_buffer;
@@ -152,11 +166,11 @@ std::shared_ptr<mg::Buffer> mf::WlShmBuffer::mir_buffer_from_wl_buffer(
              *
              * Recreate a new WlShmBuffer to track the new compositor lifetime.
              */
-            mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, std::move(on_consumed)}};
+            mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, direct_access, staging, executor, std::move(on_consumed)}};
             shim->associated_buffer = mir_buffer;
         }
     } else {
-        mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, std::move(on_consumed)}};
+        mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, direct_access, staging, executor, std::move(on_consumed)}};
         shim = new DestructionShim;
         shim->destruction_listener.notify = &on_buffer_destroyed;
         shim->associated_buffer = mir_buffer;
@@ -225,29 +239,64 @@ void mf::WlShmBuffer::secure_for_render()
 {
 }
 
+void mf::WlShmBuffer::bind_damaged(Rectangles const& damage)
+{
+    GLenum format, type;
+
+    if (get_gl_pixel_format(
+        format_,
+        format,
+        type)) {
+        read(
+            [&](unsigned char const *pixels)
+            {
+                mg::upload_damaged_pixels(damage, size_, stride_, MIR_BYTES_PER_PIXEL(format_), format, type, pixels);
+            });
+    }
+}
+
 void mf::WlShmBuffer::write(unsigned char const *pixels, size_t size)
 {
     std::lock_guard <std::mutex> lock{*buffer_mutex};
-    wl_shm_buffer_begin_access(buffer);
-    auto data = wl_shm_buffer_get_data(buffer);
-    ::memcpy(data, pixels, size);
-    wl_shm_buffer_end_access(buffer);
+    if (pool_data) {
+        access_pool_data([&]{ ::memcpy(pool_data, pixels, size); });
+    } else if (buffer) {
+        wl_shm_buffer_begin_access(buffer);
+        auto data = wl_shm_buffer_get_data(buffer);
+        ::memcpy(data, pixels, size);
+        wl_shm_buffer_end_access(buffer);
+    }
 }
 
 void mf::WlShmBuffer::read(std::function<void(unsigned char const *)> const &do_with_pixels)
 {
     std::lock_guard <std::mutex> lock{*buffer_mutex};
-    if (!buffer) {
-        log_warning("Attempt to read from WlShmBuffer after the wl_buffer has been destroyed");
-        return;
-    }
 
     if (!consumed) {
         on_consumed();
         consumed = true;
     }
 
-    do_with_pixels(static_cast<unsigned char const *>(data.get()));
+    if (staged) {
+        do_with_pixels(staged.get());
+    } else {
+        access_pool_data([&]{ do_with_pixels(pool_data); });
+    }
+}
+
+void mf::WlShmBuffer::access_pool_data(std::function<void()> const& access)
+{
+    // This runs on compositor threads, so libwayland (which would report a truncated
+    // pool from wl_shm_buffer_end_access()) mustn't be involved until we're back on
+    // the Wayland thread
+    if (!access_client_memory(pool_data, size_.height.as_int() * stride_.as_int(), access)) {
+        executor->spawn(
+            [resource = resource, destroyed = resource_destroyed]()
+            {
+                if (!*destroyed)
+                    wl_resource_post_error(resource, WL_SHM_ERROR_INVALID_FD, "error accessing SHM buffer");
+            });
+    }
 }
 
 Stride mf::WlShmBuffer::stride() const
@@ -257,14 +306,21 @@ Stride mf::WlShmBuffer::stride() const
 
 mf::WlShmBuffer::WlShmBuffer(
     wl_resource *buffer,
+    bool direct_access,
+    std::shared_ptr<ShmStagingPool> const& staging,
+    std::shared_ptr<Executor> const& executor,
     std::function<void()> &&on_consumed)
     :
     buffer{shm_buffer_from_resource_checked(buffer)},
     resource{buffer},
+    resource_destroyed{deleted_flag_for_resource(buffer)},
     size_{wl_shm_buffer_get_width(this->buffer), wl_shm_buffer_get_height(this->buffer)},
     stride_{wl_shm_buffer_get_stride(this->buffer)},
     format_{wl_format_to_mir_format(wl_shm_buffer_get_format(this->buffer))},
-    data{std::make_unique<uint8_t[]>(size_.height.as_int() * stride_.as_int())},
+    staging{staging},
+    executor{executor},
+    pool{nullptr},
+    pool_data{nullptr},
     consumed{false},
     on_consumed{std::move(on_consumed)}
 {
@@ -280,9 +336,32 @@ mf::WlShmBuffer::WlShmBuffer(
                                   std::runtime_error{"Buffer has invalid stride"}));
     }
 
-    wl_shm_buffer_begin_access(this->buffer);
-    std::memcpy(data.get(), wl_shm_buffer_get_data(this->buffer), size_.height.as_int() * stride_.as_int());
-    wl_shm_buffer_end_access(this->buffer);
+    if (direct_access)
+    {
+        // While we hold a reference libwayland defers resizing (and so remapping) the pool
+        pool = wl_shm_buffer_ref_pool(this->buffer);
+        pool_data = static_cast<unsigned char*>(wl_shm_buffer_get_data(this->buffer));
+
+        // libwayland installs its SIGBUS handler on first access. Have it do so now, before
+        // access_client_memory() installs ours, so that ours sees the signal first and passes
+        // on any that aren't for it.
+        wl_shm_buffer_begin_access(this->buffer);
+        wl_shm_buffer_end_access(this->buffer);
+    }
+    else
+    {
+        stage_content();
+    }
+}
+
+void mf::WlShmBuffer::stage_content()
+{
+    auto const content_size = size_.height.as_int() * stride_.as_int();
+    staged = staging->acquire(content_size);
+
+    wl_shm_buffer_begin_access(buffer);
+    std::memcpy(staged.get(), wl_shm_buffer_get_data(buffer), content_size);
+    wl_shm_buffer_end_access(buffer);
 }
 
 void mf::WlShmBuffer::on_buffer_destroyed(wl_listener *listener, void *)
@@ -297,6 +376,9 @@ void mf::WlShmBuffer::on_buffer_destroyed(wl_listener *listener, void *)
     {
         if (auto mir_buffer = shim->associated_buffer.lock()) {
             std::lock_guard <std::mutex> lock{*shim->mutex};
+            // The client has gone back on its promise to leave the content alone until
+            // release. If we're reading in place our reference keeps the pool mapped, so
+            // there's nothing to rescue: at worst we show whatever the client puts there.
             mir_buffer->buffer = nullptr;
         }
     }
@@ -22,6 +22,7 @@
 
 #include <mir/graphics/buffer_basic.h>
 #include <mir/renderer/gl/texture_source.h>
+#include <mir/renderer/gl/incremental_texture_source.h>
 #include <mir/renderer/sw/pixel_source.h>
 
 #include <wayland-server-core.h>
@@ -30,22 +31,38 @@
 #include <mutex>
 #include <string>
 
+struct wl_shm_pool;
+
 namespace mir
 {
+class Executor;
+
 namespace frontend
 {
+class ShmStagingPool;
 
 class WlShmBuffer :
     public graphics::BufferBasic,
     public graphics::NativeBufferBase,
     public renderer::gl::TextureSource,
+    public renderer::gl::IncrementalTextureSource,
     public renderer::software::PixelSource
 {
 public:
     ~WlShmBuffer();
 
+    /**
+     * \param [in] direct_access   read the content from the client's pool when it is
+     *                              uploaded rather than copying it now
+     * \param [in] staging         memory for copies of the content, when one is needed
+     * \param [in] executor        runs work on the Wayland thread; the wl_buffer is
+     *                              released through it once we're done with it
+     */
     static std::shared_ptr <graphics::Buffer> mir_buffer_from_wl_buffer(
         wl_resource *buffer,
+        bool direct_access,
+        std::shared_ptr<ShmStagingPool> const& staging,
+        std::shared_ptr<Executor> const& executor,
         std::function<void()> &&on_consumed);
 
     std::shared_ptr <graphics::NativeBuffer> native_buffer_handle() const override;
@@ -62,6 +79,8 @@ public:
 
     void secure_for_render() override;
 
+    void bind_damaged(geometry::Rectangles const& damage) override;
+
     void write(unsigned char const *pixels, size_t size) override;
 
     void read(std::function<void(unsigned char const *)> const &do_with_pixels) override;
@@ -71,8 +90,14 @@ public:
 private:
     WlShmBuffer(
         wl_resource *buffer,
+        bool direct_access,
+        std::shared_ptr<ShmStagingPool> const& staging,
+        std::shared_ptr<Executor> const& executor,
         std::function<void()> &&on_consumed);
 
+    void stage_content();
+    void access_pool_data(std::function<void()> const& access);
+
     static void on_buffer_destroyed(wl_listener *listener, void *);
 
     struct DestructionShim
@@ -86,12 +111,21 @@ private:
 
     wl_shm_buffer *buffer;
     wl_resource *const resource;
+    std::shared_ptr<bool> const resource_destroyed;
 
     geometry::Size const size_;
     geometry::Stride const stride_;
     MirPixelFormat const format_;
 
-    std::unique_ptr<uint8_t[]> const data;
+    std::shared_ptr<ShmStagingPool> const staging;
+    std::shared_ptr<Executor> const executor;
+
+    // Held while reading in place so the client's pool can't be unmapped or resized under us,
+    // even once the wl_buffer itself has gone
+    wl_shm_pool* pool;
+    unsigned char* pool_data;
+    // A copy of the content, for when it can't be read in place
+    std::shared_ptr<uint8_t> staged;
 
     bool consumed;
     std::function<void()> on_consumed;
@@ -32,6 +32,12 @@ void mg::DisplayConfigurationObserverMultiplexer::configuration_applied(
     for_each_observer(&mg::DisplayConfigurationObserver::configuration_applied, config);
 }
 
+void mg::DisplayConfigurationObserverMultiplexer::configuration_timings(
+    DisplayConfigurationTimings const& timings)
+{
+    for_each_observer(&mg::DisplayConfigurationObserver::configuration_timings, timings);
+}
+
 void mg::DisplayConfigurationObserverMultiplexer::base_configuration_updated(
     std::shared_ptr<DisplayConfiguration const> const& base_config)
 {
@@ -17,12 +17,11 @@
  */
 
 #include "mir/graphics/gl_extensions_base.h"
+#include "mir/graphics/extension_list.h"
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
 
-#include <cstring>
-
 namespace mg = mir::graphics;
 
 mg::GLExtensionsBase::GLExtensionsBase(char const* extensions)
@@ -37,15 +36,5 @@ mg::GLExtensionsBase::GLExtensionsBase(char const* extensions)
 
 bool mg::GLExtensionsBase::support(char const* ext) const
 {
-    char const* ext_ptr = extensions;
-    size_t const len = strlen(ext);
-
-    while ((ext_ptr = strstr(ext_ptr, ext)) != nullptr)
-    {
-        if (ext_ptr[len] == ' ' || ext_ptr[len] == '\0')
-            break;
-        ext_ptr += len;
-    }
-
-    return ext_ptr != nullptr;
+    return has_extension(extensions, ext);
 }
@@ -171,6 +171,17 @@ mgn::detail::DisplaySyncGroup::recommended_sleep() const
     return std::chrono::milliseconds::zero();
 }
 
+mg::Frame mgn::detail::DisplaySyncGroup::last_frame() const
+{
+    return {};
+}
+
+std::chrono::nanoseconds mgn::detail::DisplaySyncGroup::frame_interval() const
+{
+    // The host server's vsync isn't visible to us
+    return std::chrono::nanoseconds::zero();
+}
+
 geom::Rectangle mgn::detail::DisplaySyncGroup::view_area() const
 {
     return output->view_area();
@@ -101,6 +101,8 @@ public:
     void for_each_display_buffer(std::function<void(graphics::DisplayBuffer&)> const&) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    Frame last_frame() const override;
+    std::chrono::nanoseconds frame_interval() const override;
 
     geometry::Rectangle view_area() const;
 private:
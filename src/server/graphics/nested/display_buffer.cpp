@@ -25,8 +25,11 @@
 #include "mir/graphics/pixel_format_utils.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/gl_extensions_base.h"
 #include "buffer.h"
 
+#include <EGL/eglext.h>
+
 #include <sstream>
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
@@ -57,6 +60,12 @@ std::shared_ptr<mgn::HostSurface> create_host_surface(
         host_stream, mir::geometry::Displacement{0, 0}, properties,
         surface_title.str().c_str(), static_cast<uint32_t>(output.id.as_value()));
 }
+
+bool supports_buffer_age(EGLDisplay egl_display)
+{
+    mg::GLExtensionsBase const extensions{eglQueryString(egl_display, EGL_EXTENSIONS)};
+    return extensions.support("EGL_EXT_buffer_age");
+}
 }
 
 mgn::detail::DisplayBuffer::DisplayBuffer(
@@ -75,7 +84,8 @@ mgn::detail::DisplayBuffer::DisplayBuffer(
     egl_surface{egl_display, host_stream->egl_native_window(), egl_config},
     passthrough_option(option),
     content{BackingContent::stream},
-    identity(1)
+    identity(1),
+    buffer_age_supported{supports_buffer_age(egl_display)}
 {
     host_surface->set_event_handler(event_thunk, this);
 }
@@ -115,6 +125,17 @@ void mgn::detail::DisplayBuffer::bind()
 {
 }
 
+int mgn::detail::DisplayBuffer::buffer_age()
+{
+    EGLint age = 0;
+    if (!buffer_age_supported ||
+        eglQuerySurface(egl_display, egl_surface, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+    {
+        return 0;
+    }
+    return age;
+}
+
 bool mgn::detail::DisplayBuffer::overlay(RenderableList const& list)
 {
     if ((passthrough_option == mgn::PassthroughOption::disabled) ||
@@ -60,6 +60,7 @@ public:
     void release_current() override;
     void swap_buffers() override;
     void bind() override;
+    int buffer_age() override;
     glm::mat2 transformation() const override;
 
     bool overlay(RenderableList const& renderlist) override;
@@ -89,6 +90,7 @@ private:
         chain
     } content;
     glm::mat4 const identity;
+    bool const buffer_age_supported;
 
     std::mutex mutex;
     typedef std::tuple<MirBuffer*, MirPresentationChain*> SubmissionInfo;
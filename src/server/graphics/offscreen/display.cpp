@@ -94,6 +94,16 @@ mgo::detail::DisplaySyncGroup::recommended_sleep() const
     return std::chrono::milliseconds::zero();
 }
 
+mg::Frame mgo::detail::DisplaySyncGroup::last_frame() const
+{
+    return {};
+}
+
+std::chrono::nanoseconds mgo::detail::DisplaySyncGroup::frame_interval() const
+{
+    return std::chrono::nanoseconds::zero();
+}
+
 mgo::Display::Display(
     EGLNativeDisplayType egl_native_display,
     std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
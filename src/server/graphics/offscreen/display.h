@@ -66,6 +66,8 @@ public:
     void for_each_display_buffer(std::function<void(DisplayBuffer&)> const&) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    Frame last_frame() const override;
+    std::chrono::nanoseconds frame_interval() const override;
 private:
     std::unique_ptr<DisplayBuffer> const output;
 };
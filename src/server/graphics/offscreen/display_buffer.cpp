@@ -43,6 +43,51 @@ public:
     }
 };
 
+/*
+ * Framebuffer objects aren't shared between contexts, so the FBO has to be
+ * created and destroyed in the context that draws to it. This makes that
+ * context current for a while, then puts back whatever was current before.
+ */
+class ScopedCurrentContext
+{
+public:
+    ScopedCurrentContext(mg::SurfacelessEGLContext const& context)
+        : context(context),
+          previous_display{eglGetCurrentDisplay()},
+          previous_draw{eglGetCurrentSurface(EGL_DRAW)},
+          previous_read{eglGetCurrentSurface(EGL_READ)},
+          previous_context{eglGetCurrentContext()}
+    {
+        context.make_current();
+    }
+
+    ~ScopedCurrentContext()
+    {
+        if (previous_context == static_cast<EGLContext>(context))
+            return;
+
+        if (previous_context != EGL_NO_CONTEXT)
+            eglMakeCurrent(previous_display, previous_draw, previous_read, previous_context);
+        else
+            context.release_current();
+    }
+
+private:
+    mg::SurfacelessEGLContext const& context;
+    EGLDisplay const previous_display;
+    EGLSurface const previous_draw;
+    EGLSurface const previous_read;
+    EGLContext const previous_context;
+};
+
+std::unique_ptr<mgo::detail::GLFramebufferObject> create_fbo_in(
+    mg::SurfacelessEGLContext const& context,
+    geom::Size const& size)
+{
+    ScopedCurrentContext const current{context};
+    return std::make_unique<mgo::detail::GLFramebufferObject>(size);
+}
+
 }
 
 mgo::detail::GLFramebufferObject::GLFramebufferObject(geom::Size const& size)
@@ -119,11 +164,18 @@ void mgo::detail::GLFramebufferObject::unbind() const
 mgo::DisplayBuffer::DisplayBuffer(SurfacelessEGLContext egl_context,
                                   geom::Rectangle const& area)
     : egl_context{std::move(egl_context)},
-      fbo{area.size},
-      area(area)
+      fbo{create_fbo_in(this->egl_context, area.size)},
+      area(area),
+      has_content{false}
 {
 }
 
+mgo::DisplayBuffer::~DisplayBuffer()
+{
+    ScopedCurrentContext const current{egl_context};
+    fbo.reset();
+}
+
 geom::Rectangle mgo::DisplayBuffer::view_area() const
 {
     return area;
@@ -136,18 +188,25 @@ void mgo::DisplayBuffer::make_current()
 
 void mgo::DisplayBuffer::bind()
 {
-    fbo.bind();
+    fbo->bind();
 }
 
 void mgo::DisplayBuffer::release_current()
 {
-    fbo.unbind();
+    fbo->unbind();
     egl_context.release_current();
 }
 
 void mgo::DisplayBuffer::swap_buffers()
 {
     glFinish();
+    has_content = true;
+}
+
+int mgo::DisplayBuffer::buffer_age()
+{
+    // There's only the one FBO, so it always holds the last frame drawn
+    return has_content ? 1 : 0;
 }
 
 bool mgo::DisplayBuffer::overlay(RenderableList const&)
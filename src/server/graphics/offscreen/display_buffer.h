@@ -28,6 +28,8 @@
 
 #include <EGL/egl.h>
 
+#include <memory>
+
 namespace mir
 {
 namespace graphics
@@ -64,6 +66,7 @@ class DisplayBuffer : public graphics::DisplayBuffer,
 public:
     DisplayBuffer(SurfacelessEGLContext egl_context,
                   geometry::Rectangle const& area);
+    ~DisplayBuffer();
 
     geometry::Rectangle view_area() const override;
     bool overlay(RenderableList const& renderlist) override;
@@ -73,10 +76,12 @@ public:
     void bind() override;
     void release_current() override;
     void swap_buffers() override;
+    int buffer_age() override;
 private:
     SurfacelessEGLContext const egl_context;
-    detail::GLFramebufferObject const fbo;
+    std::unique_ptr<detail::GLFramebufferObject> fbo;
     geometry::Rectangle const area;
+    bool has_content;
 };
 
 }
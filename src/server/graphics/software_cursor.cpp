@@ -26,6 +26,7 @@
 #include "mir/renderer/sw/pixel_source.h"
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <mutex>
 
@@ -36,6 +37,7 @@ namespace mrs = mir::renderer::software;
 
 namespace
 {
+size_t const cached_cursor_images = 8;
 
 MirPixelFormat get_8888_format(std::vector<MirPixelFormat> const& formats)
 {
@@ -86,6 +88,12 @@ public:
         return {position, buffer_->size()};
     }
 
+    geom::Rectangles damage() const override
+    {
+        // The image never changes: showing a new cursor creates a new renderable
+        return {};
+    }
+
     float alpha() const override
     {
         return 1.0;
@@ -101,6 +109,11 @@ public:
         return true;
     }
 
+    geom::Region opaque_region() const override
+    {
+        return {};
+    }
+
     void move_to(geom::Point new_position)
     {
         std::lock_guard<std::mutex> lock{position_mutex};
@@ -120,7 +133,8 @@ mg::SoftwareCursor::SoftwareCursor(
       scene{scene},
       format{get_8888_format(allocator->supported_pixel_formats())},
       visible(false),
-      hotspot{0,0}
+      hotspot{0,0},
+      images{cached_cursor_images}
 {
 }
 
@@ -177,27 +191,47 @@ void mg::SoftwareCursor::show(CursorImage const& cursor_image)
 std::shared_ptr<mg::detail::CursorRenderable>
 mg::SoftwareCursor::create_renderable_for(CursorImage const& cursor_image, geom::Point position)
 {
+    return std::make_shared<detail::CursorRenderable>(
+        buffer_for(images.pixels_of(cursor_image)),
+        position + hotspot - cursor_image.hotspot());
+}
+
+std::shared_ptr<mg::Buffer> mg::SoftwareCursor::buffer_for(std::shared_ptr<CursorPixels const> const& pixels)
+{
+    // Switching back to a recent cursor reuses its buffer: nothing is drawn to it after it is written
+    auto const cached = std::find_if(buffers.begin(), buffers.end(),
+        [&](decltype(buffers)::value_type const& entry) { return entry.first == pixels; });
+
+    if (cached != buffers.end())
+    {
+        std::rotate(cached, cached + 1, buffers.end());
+        return buffers.back().second;
+    }
+
     size_t const pixels_size =
-        cursor_image.size().width.as_uint32_t() *
-        cursor_image.size().height.as_uint32_t() *
+        pixels->size.width.as_uint32_t() *
+        pixels->size.height.as_uint32_t() *
         MIR_BYTES_PER_PIXEL(format);
 
     if (pixels_size == 0)
         BOOST_THROW_EXCEPTION(std::logic_error("zero sized software cursor image is invalid"));
 
-    auto new_renderable = std::make_shared<detail::CursorRenderable>(
-        allocator->alloc_buffer({cursor_image.size(), format, mg::BufferUsage::software}),
-        position + hotspot - cursor_image.hotspot());
+    auto const buffer = allocator->alloc_buffer({pixels->size, format, mg::BufferUsage::software});
 
     // TODO: The buffer pixel format may not be argb_8888, leading to
     // incorrect cursor colors. We need to transform the data to match
     // the buffer pixel format.
-    auto pixel_source = dynamic_cast<mrs::PixelSource*>(new_renderable->buffer()->native_buffer_base());
+    auto pixel_source = dynamic_cast<mrs::PixelSource*>(buffer->native_buffer_base());
     if (pixel_source)
-        pixel_source->write(static_cast<unsigned char const*>(cursor_image.as_argb_8888()), pixels_size);
+        pixel_source->write(pixels->argb8888.data(), pixels_size);
     else
         BOOST_THROW_EXCEPTION(std::logic_error("could not write to buffer for software cursor"));
-    return new_renderable;
+
+    if (buffers.size() == cached_cursor_images)
+        buffers.erase(buffers.begin());
+    buffers.emplace_back(pixels, buffer);
+
+    return buffer;
 }
 
 void mg::SoftwareCursor::hide()
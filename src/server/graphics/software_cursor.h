@@ -20,15 +20,19 @@
 #define MIR_GRAPHICS_SOFTWARE_CURSOR_H_
 
 #include "mir/graphics/cursor.h"
+#include "mir/graphics/cursor_image_cache.h"
 #include "mir_toolkit/client_types.h"
 #include "mir/geometry/displacement.h"
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
 namespace input { class Scene; }
 namespace graphics
 {
+class Buffer;
 class GraphicBufferAllocator;
 class Renderable;
 
@@ -53,6 +57,7 @@ public:
 private:
     std::shared_ptr<detail::CursorRenderable> create_renderable_for(
         CursorImage const& cursor_image, geometry::Point position);
+    std::shared_ptr<Buffer> buffer_for(std::shared_ptr<CursorPixels const> const& pixels);
 
     std::shared_ptr<GraphicBufferAllocator> const allocator;
     std::shared_ptr<input::Scene> const scene;
@@ -61,6 +66,9 @@ private:
     std::shared_ptr<detail::CursorRenderable> renderable;
     bool visible;
     geometry::Displacement hotspot;
+    CursorImageCache images;
+    // The buffers written with recently shown images, the most recent last
+    std::vector<std::pair<std::shared_ptr<CursorPixels const>, std::shared_ptr<Buffer>>> buffers;
 };
 
 }
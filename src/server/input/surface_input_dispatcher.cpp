@@ -516,12 +516,7 @@ bool is_gesture_terminator(MirPointerEvent const* pev)
 
 std::shared_ptr<mi::Surface> mi::SurfaceInputDispatcher::find_target_surface(geom::Point const& point)
 {
-    std::shared_ptr<mi::Surface> top_target = nullptr;
-    scene->for_each([&top_target, &point](std::shared_ptr<mi::Surface> const& target) {
-            if (target->input_area_contains(point))
-                top_target = target;
-    });
-    return top_target;
+    return scene->input_surface_at(point);
 }
 
 void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surface> const& surface,
@@ -73,6 +73,12 @@ public:
         return {position, buffer_->size()};
     }
     
+    geom::Rectangles damage() const override
+    {
+        // The touchspot image is written once, when the buffer is created
+        return {};
+    }
+    
     float alpha() const override
     {
         return 1.0;
@@ -88,6 +94,11 @@ public:
         return true;
     }
 
+    geom::Region opaque_region() const override
+    {
+        return {};
+    }
+
 // TouchspotRenderable    
     void move_center_to(geom::Point pos)
     {
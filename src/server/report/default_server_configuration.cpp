@@ -23,8 +23,12 @@
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
+#include "logging/compositor_statistics.h"
 
 #include "mir/abnormal_exit.h"
+#include "mir/main_loop.h"
+
+#include <csignal>
 
 namespace mg = mir::graphics;
 namespace mf = mir::frontend;
@@ -66,7 +70,21 @@ auto mir::DefaultServerConfiguration::the_compositor_report() -> std::shared_ptr
     return compositor_report(
         [this]()->std::shared_ptr<mc::CompositorReport>
         {
-            return report_factory(options::compositor_report_opt)->create_compositor_report();
+            auto const statistics = std::make_shared<report::logging::CompositorStatistics>(
+                the_clock(),
+                report_factory(options::compositor_report_opt)->create_compositor_report());
+
+            // Frame statistics are always collected; "kill -USR2" logs them
+            std::weak_ptr<report::logging::CompositorStatistics> const weak_statistics{statistics};
+            the_main_loop()->register_signal_handler(
+                {SIGUSR2},
+                [weak_statistics, logger = the_logger()](int)
+                {
+                    if (auto const statistics = weak_statistics.lock())
+                        statistics->log_to(*logger);
+                });
+
+            return statistics;
         });
 }
 
@@ -19,6 +19,8 @@
 #include "compositor_report.h"
 #include "mir/logging/logger.h"
 
+#include <cmath>
+
 using namespace mir::time;
 namespace ml = mir::logging;
 namespace mrl = mir::report::logging;
@@ -74,6 +76,25 @@ void mrl::CompositorReport::rendered_frame(SubCompositorId id)
     inst.bypassed = false;
 }
 
+void mrl::CompositorReport::repainted_fraction(SubCompositorId id, float fraction)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& inst = instance[id];
+    inst.repainted_sum += fraction;
+    inst.nrepainted++;
+}
+
+void mrl::CompositorReport::render_time(
+    SubCompositorId id, std::chrono::nanoseconds predicted, std::chrono::nanoseconds actual)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& inst = instance[id];
+    inst.predicted_sum += predicted;
+    inst.npredicted++;
+    if (actual > predicted)
+        inst.nover_budget++;
+}
+
 void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id)
 {
     // The first report is a valid sample, but don't log anything because
@@ -95,6 +116,17 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
             ).count();
 
         long bypass_percent = dn ? (nbypassed - last_reported_bypassed) * 100L / dn : 0;
+        auto const drepainted = nrepainted - last_reported_nrepainted;
+        long repainted_percent = drepainted ?
+            std::lround((repainted_sum - last_reported_repainted_sum) * 100.0 / drepainted) : 0;
+        auto const dpredicted = npredicted - last_reported_npredicted;
+        long long dp =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                predicted_sum - last_reported_predicted_sum
+            ).count();
+        long avg_predicted_usec = dpredicted ? dp / dpredicted : 0;
+        long over_budget_percent = dpredicted ?
+            (nover_budget - last_reported_nover_budget) * 100L / dpredicted : 0;
 
         // Keep everything premultiplied by 1000 to guarantee accuracy
         // and avoid floating point.
@@ -103,23 +135,29 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
         long avg_latency_usec = dn ? dl / dn : 0;
         long dt_msec = dt / 1000L;
 
-        char msg[128];
+        char msg[224];
         snprintf(msg, sizeof msg, "Display %p averaged %ld.%03ld FPS, "
                  "%ld.%03ld ms/frame, "
+                 "predicted %ld.%03ld ms/frame (%ld%% over), "
                  "latency %ld.%03ld ms, "
                  "%ld frames over %ld.%03ld sec, "
-                 "%ld%% bypassed",
+                 "%ld%% bypassed, "
+                 "%ld%% repainted",
                  id,
                  frames_per_1000sec / 1000,
                  frames_per_1000sec % 1000,
                  avg_render_time_usec / 1000,
                  avg_render_time_usec % 1000,
+                 avg_predicted_usec / 1000,
+                 avg_predicted_usec % 1000,
+                 over_budget_percent,
                  avg_latency_usec / 1000,
                  avg_latency_usec % 1000,
                  dn,
                  dt_msec / 1000,
                  dt_msec % 1000,
-                 bypass_percent
+                 bypass_percent,
+                 repainted_percent
                  );
 
         logger.log(ml::Severity::informational, msg, component);
@@ -130,6 +168,11 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_latency_sum = latency_sum;
     last_reported_nframes = nframes;
     last_reported_bypassed = nbypassed;
+    last_reported_nrepainted = nrepainted;
+    last_reported_repainted_sum = repainted_sum;
+    last_reported_predicted_sum = predicted_sum;
+    last_reported_npredicted = npredicted;
+    last_reported_nover_budget = nover_budget;
 }
 
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
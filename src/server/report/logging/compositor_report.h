@@ -46,7 +46,9 @@ public:
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
+    void repainted_fraction(SubCompositorId id, float fraction) override;
     void finished_frame(SubCompositorId id) override;
+    void render_time(SubCompositorId id, std::chrono::nanoseconds predicted, std::chrono::nanoseconds actual) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -67,6 +69,11 @@ private:
         TimePoint latency_sum;
         long nframes = 0;
         long nbypassed = 0;
+        long nrepainted = 0;
+        double repainted_sum = 0.0;
+        std::chrono::nanoseconds predicted_sum{0};
+        long npredicted = 0;
+        long nover_budget = 0;
         bool bypassed = true;
         bool prev_bypassed = false;
 
@@ -75,6 +82,11 @@ private:
         TimePoint last_reported_latency_sum;
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
+        long last_reported_nrepainted = 0;
+        double last_reported_repainted_sum = 0.0;
+        std::chrono::nanoseconds last_reported_predicted_sum{0};
+        long last_reported_npredicted = 0;
+        long last_reported_nover_budget = 0;
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
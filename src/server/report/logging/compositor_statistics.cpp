@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_statistics.h"
+#include "mir/logging/logger.h"
+
+#include <cstdio>
+
+namespace ml = mir::logging;
+namespace mrl = mir::report::logging;
+
+namespace
+{
+char const* const component = "compositor-statistics";
+
+uint64_t microseconds(mir::time::Timestamp::duration duration)
+{
+    auto const us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return us > 0 ? us : 0;
+}
+
+void log_histogram(ml::Logger& logger, char const* name, char const* unit, mrl::Histogram const& histogram)
+{
+    char msg[160];
+    snprintf(msg, sizeof msg, "  %s (%s): mean %llu, p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu",
+             name, unit,
+             static_cast<unsigned long long>(histogram.mean()),
+             static_cast<unsigned long long>(histogram.value_at_percentile(50.0)),
+             static_cast<unsigned long long>(histogram.value_at_percentile(90.0)),
+             static_cast<unsigned long long>(histogram.value_at_percentile(99.0)),
+             static_cast<unsigned long long>(histogram.value_at_percentile(99.9)),
+             static_cast<unsigned long long>(histogram.max()));
+    logger.log(ml::Severity::informational, msg, component);
+}
+}
+
+mrl::CompositorStatistics::CompositorStatistics(
+    std::shared_ptr<time::Clock> const& clock,
+    std::shared_ptr<mir::compositor::CompositorReport> const& next)
+    : clock{clock},
+      next{next}
+{
+}
+
+auto mrl::CompositorStatistics::output_for(SubCompositorId id) -> Output*
+{
+    for (auto& output : outputs)
+    {
+        if (output.id.load(std::memory_order_acquire) == id)
+            return &output;
+    }
+
+    return nullptr;
+}
+
+void mrl::CompositorStatistics::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const is_free = [](Output const& o) { return o.id.load(std::memory_order_relaxed) == nullptr; };
+
+        // Prefer the slot this output had before the compositor restarted,
+        // then an unused one, and only then recycle someone else's.
+        Output* slot = nullptr;
+        for (auto& o : outputs)
+        {
+            if (is_free(o) && o.used && o.width == width && o.height == height && o.x == x && o.y == y)
+            {
+                slot = &o;
+                break;
+            }
+        }
+        for (auto& o : outputs)
+        {
+            if (!slot && is_free(o) && !o.used)
+                slot = &o;
+        }
+        for (auto& o : outputs)
+        {
+            if (!slot && is_free(o))
+            {
+                slot = &o;
+                slot->composite_time_us.reset();
+                slot->post_time_us.reset();
+                slot->frame_interval_us.reset();
+                slot->renderables.reset();
+                slot->nbypassed = 0;
+            }
+        }
+
+        if (slot)
+        {
+            slot->used = true;
+            slot->width = width;
+            slot->height = height;
+            slot->x = x;
+            slot->y = y;
+            slot->last_posted = TimePoint{};
+            slot->id.store(id, std::memory_order_release);
+        }
+    }
+
+    next->added_display(width, height, x, y, id);
+}
+
+void mrl::CompositorStatistics::began_frame(SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+    {
+        output->start_of_frame = clock->now();
+        output->bypassed = true;
+    }
+
+    next->began_frame(id);
+}
+
+void mrl::CompositorStatistics::renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables)
+{
+    if (auto const output = output_for(id))
+        output->renderables.record(renderables.size());
+
+    next->renderables_in_frame(id, renderables);
+}
+
+void mrl::CompositorStatistics::rendered_frame(SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+        output->bypassed = false;
+
+    next->rendered_frame(id);
+}
+
+void mrl::CompositorStatistics::repainted_fraction(SubCompositorId id, float fraction)
+{
+    next->repainted_fraction(id, fraction);
+}
+
+void mrl::CompositorStatistics::finished_frame(SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+    {
+        output->end_of_frame = clock->now();
+        output->composite_time_us.record(microseconds(output->end_of_frame - output->start_of_frame));
+        if (output->bypassed)
+            output->nbypassed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    next->finished_frame(id);
+}
+
+void mrl::CompositorStatistics::render_time(
+    SubCompositorId id, std::chrono::nanoseconds predicted, std::chrono::nanoseconds actual)
+{
+    // The frame has been posted by the time its render time is reported
+    if (auto const output = output_for(id))
+    {
+        auto const posted = clock->now();
+        output->post_time_us.record(microseconds(posted - output->end_of_frame));
+        if (output->last_posted != TimePoint{})
+            output->frame_interval_us.record(microseconds(posted - output->last_posted));
+        output->last_posted = posted;
+    }
+
+    next->render_time(id, predicted, actual);
+}
+
+void mrl::CompositorStatistics::started()
+{
+    next->started();
+}
+
+void mrl::CompositorStatistics::stopped()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (auto& output : outputs)
+            output.id.store(nullptr, std::memory_order_release);
+    }
+
+    next->stopped();
+}
+
+void mrl::CompositorStatistics::scheduled()
+{
+    next->scheduled();
+}
+
+void mrl::CompositorStatistics::log_to(ml::Logger& logger) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto const& output : outputs)
+    {
+        if (!output.used)
+            continue;
+
+        auto const frames = output.composite_time_us.count();
+        auto const bypassed = output.nbypassed.load(std::memory_order_relaxed);
+
+        char msg[128];
+        snprintf(msg, sizeof msg, "Display %dx%d%+d%+d: %llu frames, %llu%% bypassed",
+                 output.width, output.height, output.x, output.y,
+                 static_cast<unsigned long long>(frames),
+                 static_cast<unsigned long long>(frames ? bypassed * 100 / frames : 0));
+        logger.log(ml::Severity::informational, msg, component);
+
+        log_histogram(logger, "composite time", "us", output.composite_time_us);
+        log_histogram(logger, "post time", "us", output.post_time_us);
+        log_histogram(logger, "frame interval", "us", output.frame_interval_us);
+        log_histogram(logger, "renderables per frame", "count", output.renderables);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_LOGGING_COMPOSITOR_STATISTICS_H_
+#define MIR_REPORT_LOGGING_COMPOSITOR_STATISTICS_H_
+
+#include "histogram.h"
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/time/clock.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace logging
+{
+class Logger;
+}
+namespace report
+{
+namespace logging
+{
+
+/**
+ * Keeps frame timing histograms for each output, at a cost low enough to
+ * leave on in production, and passes every report on to another
+ * CompositorReport (such as the one selected by --compositor-report).
+ *
+ * Recording a frame takes no locks. Statistics survive the compositor
+ * being restarted (e.g. on VT switch) as long as the output keeps its
+ * size and position.
+ */
+class CompositorStatistics : public mir::compositor::CompositorReport
+{
+public:
+    CompositorStatistics(std::shared_ptr<time::Clock> const& clock,
+                         std::shared_ptr<mir::compositor::CompositorReport> const& next);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void repainted_fraction(SubCompositorId id, float fraction) override;
+    void finished_frame(SubCompositorId id) override;
+    void render_time(SubCompositorId id, std::chrono::nanoseconds predicted, std::chrono::nanoseconds actual) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+    /// Writes a summary of every output's histograms, a line at a time
+    void log_to(mir::logging::Logger& logger) const;
+
+private:
+    typedef time::Timestamp TimePoint;
+
+    struct Output
+    {
+        std::atomic<SubCompositorId> id{nullptr};
+        bool used = false;
+        int width = 0, height = 0, x = 0, y = 0;
+
+        // Only touched by the compositing thread drawing this output
+        TimePoint start_of_frame;
+        TimePoint end_of_frame;
+        TimePoint last_posted;
+        bool bypassed = true;
+
+        Histogram composite_time_us;
+        Histogram post_time_us;
+        Histogram frame_interval_us;
+        Histogram renderables;
+        std::atomic<uint64_t> nbypassed{0};
+    };
+
+    Output* output_for(SubCompositorId id);
+
+    std::shared_ptr<time::Clock> const clock;
+    std::shared_ptr<mir::compositor::CompositorReport> const next;
+
+    std::mutex mutable mutex; // Serialises assigning outputs to slots and logging
+    std::array<Output, 8> outputs;
+};
+
+}
+}
+}
+
+#endif /* MIR_REPORT_LOGGING_COMPOSITOR_STATISTICS_H_ */
@@ -60,6 +60,34 @@ void mrl::DisplayConfigurationReport::configuration_applied(
     log_configuration(severity, *config);
 }
 
+void mrl::DisplayConfigurationReport::configuration_timings(mg::DisplayConfigurationTimings const& timings)
+{
+    auto const ms = [](std::chrono::nanoseconds duration)
+        {
+            return std::chrono::duration<double, std::milli>{duration}.count();
+        };
+
+    if (timings.compositor_stopped)
+    {
+        logger->log(component, severity,
+                    "Display configuration applied in %.1fms: "
+                    "%.1fms trying to preserve display buffers, %.1fms stopping the compositor, "
+                    "%.1fms configuring the display, %.1fms starting the compositor",
+                    ms(timings.preserving_display_buffers + timings.stopping_compositor +
+                       timings.configuring_display + timings.starting_compositor),
+                    ms(timings.preserving_display_buffers),
+                    ms(timings.stopping_compositor),
+                    ms(timings.configuring_display),
+                    ms(timings.starting_compositor));
+    }
+    else
+    {
+        logger->log(component, severity,
+                    "Display configuration applied in %.1fms, preserving display buffers",
+                    ms(timings.preserving_display_buffers));
+    }
+}
+
 void mrl::DisplayConfigurationReport::base_configuration_updated(
     std::shared_ptr<mg::DisplayConfiguration const> const& base_config)
 {
@@ -44,6 +44,8 @@ public:
     void configuration_applied(
         std::shared_ptr<graphics::DisplayConfiguration const> const& config) override;
 
+    void configuration_timings(graphics::DisplayConfigurationTimings const& timings) override;
+
     void base_configuration_updated(std::shared_ptr<graphics::DisplayConfiguration const> const& base_config) override;
 
     void session_configuration_applied(std::shared_ptr<frontend::Session> const& session,
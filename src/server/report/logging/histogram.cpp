@@ -0,0 +1,116 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mrl = mir::report::logging;
+
+mrl::Histogram::Histogram()
+{
+    reset();
+}
+
+unsigned mrl::Histogram::bucket_for(uint64_t value)
+{
+    if (value < linear_buckets)
+        return value;
+
+    // Values in [2^n, 2^(n+1)) share a magnitude; the top bits below the
+    // leading one pick the sub-bucket.
+    unsigned const msb = 63 - __builtin_clzll(value);
+    unsigned const magnitude = msb - 4;
+
+    if (magnitude > magnitudes)
+        return linear_buckets + magnitudes * sub_buckets - 1;
+
+    unsigned const sub_bucket = (value >> magnitude) - sub_buckets;
+    return linear_buckets + (magnitude - 1) * sub_buckets + sub_bucket;
+}
+
+uint64_t mrl::Histogram::highest_value_in(unsigned bucket)
+{
+    if (bucket < linear_buckets)
+        return bucket;
+
+    unsigned const magnitude = (bucket - linear_buckets) / sub_buckets + 1;
+    uint64_t const sub_bucket = (bucket - linear_buckets) % sub_buckets + sub_buckets;
+    return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+void mrl::Histogram::record(uint64_t value)
+{
+    buckets[bucket_for(value)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(value, std::memory_order_relaxed);
+
+    auto current_max = max_value.load(std::memory_order_relaxed);
+    while (value > current_max &&
+           !max_value.compare_exchange_weak(current_max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void mrl::Histogram::reset()
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    total_count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    max_value.store(0, std::memory_order_relaxed);
+}
+
+uint64_t mrl::Histogram::count() const
+{
+    return total_count.load(std::memory_order_relaxed);
+}
+
+uint64_t mrl::Histogram::max() const
+{
+    return max_value.load(std::memory_order_relaxed);
+}
+
+uint64_t mrl::Histogram::mean() const
+{
+    auto const n = count();
+    return n ? total.load(std::memory_order_relaxed) / n : 0;
+}
+
+uint64_t mrl::Histogram::value_at_percentile(double percentile) const
+{
+    // Sum the buckets rather than trusting count(), which a concurrent
+    // record() may already have bumped past what the buckets show.
+    uint64_t n = 0;
+    for (auto const& bucket : buckets)
+        n += bucket.load(std::memory_order_relaxed);
+
+    if (n == 0)
+        return 0;
+
+    auto const wanted = std::max<uint64_t>(1, std::ceil(std::min(percentile, 100.0) / 100.0 * n));
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i != buckets.size(); ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= wanted)
+            return std::min(highest_value_in(i), max());
+    }
+
+    return max();
+}
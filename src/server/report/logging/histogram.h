@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_LOGGING_HISTOGRAM_H_
+#define MIR_REPORT_LOGGING_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace mir
+{
+namespace report
+{
+namespace logging
+{
+
+/**
+ * A histogram of non-negative integer samples with bounded relative error,
+ * in the style of HdrHistogram.
+ *
+ * Small values get a bucket each; above that every power of two is split
+ * into 16 equal buckets, so any recorded value is known to within 1/16th
+ * (about 6%) while a few hundred buckets span microseconds to hours.
+ *
+ * record() is wait-free and may be called from any thread; readers see
+ * a snapshot that is at worst a few samples out of date.
+ */
+class Histogram
+{
+public:
+    Histogram();
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t max() const;
+    uint64_t mean() const;
+
+    /// The largest value that is equivalent, at the histogram's precision, to the percentile'th sample
+    uint64_t value_at_percentile(double percentile) const;
+
+private:
+    static unsigned constexpr linear_buckets = 32;
+    static unsigned constexpr sub_buckets = 16;
+    static unsigned constexpr magnitudes = 40;
+
+    static unsigned bucket_for(uint64_t value);
+    static uint64_t highest_value_in(unsigned bucket);
+
+    std::array<std::atomic<uint64_t>, linear_buckets + magnitudes * sub_buckets> buckets;
+    std::atomic<uint64_t> total_count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> max_value;
+};
+
+}
+}
+}
+
+#endif /* MIR_REPORT_LOGGING_HISTOGRAM_H_ */
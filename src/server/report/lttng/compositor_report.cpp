@@ -58,7 +58,18 @@ void mir::report::lttng::CompositorReport::rendered_frame(SubCompositorId id)
     mir_tracepoint(mir_server_compositor, rendered_frame, id);
 }
 
+void mir::report::lttng::CompositorReport::repainted_fraction(SubCompositorId id, float fraction)
+{
+    mir_tracepoint(mir_server_compositor, repainted_fraction, id, fraction);
+}
+
 void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::render_time(
+    SubCompositorId id, std::chrono::nanoseconds predicted, std::chrono::nanoseconds actual)
+{
+    mir_tracepoint(mir_server_compositor, render_time, id, predicted.count(), actual.count());
+}
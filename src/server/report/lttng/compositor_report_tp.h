@@ -68,6 +68,16 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    repainted_fraction,
+    TP_ARGS(void const*, id, float, fraction),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_float(float, fraction, fraction)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     finished_frame,
@@ -77,6 +87,17 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    render_time,
+    TP_ARGS(void const*, id, int64_t, predicted_ns, int64_t, actual_ns),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, predicted_ns, predicted_ns)
+        ctf_integer(int64_t, actual_ns, actual_ns)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
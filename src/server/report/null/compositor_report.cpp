@@ -36,10 +36,18 @@ void mrn::CompositorReport::rendered_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::repainted_fraction(SubCompositorId, float)
+{
+}
+
 void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::render_time(SubCompositorId, std::chrono::nanoseconds, std::chrono::nanoseconds)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
@@ -35,7 +35,9 @@ public:
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
+    void repainted_fraction(SubCompositorId id, float fraction) override;
     void finished_frame(SubCompositorId id) override;
+    void render_time(SubCompositorId id, std::chrono::nanoseconds predicted, std::chrono::nanoseconds actual) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
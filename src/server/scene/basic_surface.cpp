@@ -19,12 +19,12 @@
  */
 
 #include "basic_surface.h"
+#include "surface_snapshot.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/frontend/event_sink.h"
 #include "mir/shell/input_targeter.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/cursor_image.h"
-#include "mir/graphics/pixel_format_utils.h"
 #include "mir/geometry/displacement.h"
 #include "mir/renderer/sw/pixel_source.h"
 
@@ -247,11 +247,9 @@ ms::BasicSurface::BasicSurface(
     confine_pointer_state_(state),
     cursor_stream_adapter{std::make_unique<ms::CursorStreamImageAdapter>(*this)}
 {
-    auto callback = [this](auto const& size) { observers.frame_posted(this, 1, size); };
-
     for (auto& layer : layers)
     {
-        layer.stream->set_frame_posted_callback(callback);
+        layer.stream->set_frame_posted_callback(frame_posted_callback());
     }
     report->surface_created(this, surface_name);
 }
@@ -284,6 +282,7 @@ void ms::BasicSurface::move_to(geometry::Point const& top_left)
         std::unique_lock<std::mutex> lk(guard);
         surface_rect.top_left = top_left;
     }
+    ++generation;
     observers.moved_to(this, top_left);
 }
 
@@ -293,6 +292,7 @@ void ms::BasicSurface::set_hidden(bool hide)
         std::unique_lock<std::mutex> lk(guard);
         hidden = hide;
     }
+    ++generation;
     observers.hidden_set_to(this, hide);
 }
 
@@ -341,6 +341,7 @@ void ms::BasicSurface::resize(geom::Size const& desired_size)
         std::unique_lock<std::mutex> lock(guard);
         surface_rect.size = new_size;
     }
+    ++generation;
     observers.resized_to(this, new_size);
 }
 
@@ -362,13 +363,14 @@ bool ms::BasicSurface::input_area_contains(geom::Point const& point) const
 {
     std::unique_lock<std::mutex> lock(guard);
 
-    if (!visible(lock))
+    // Custom input regions are clipped to the surface, so the input bounds
+    // tell the scene where a surface might take input
+    if (!visible(lock) || !surface_rect.contains(point))
         return false;
 
     if (custom_input_rectangles.empty())
     {
-        // no custom input, restrict to bounding rectangle
-        return surface_rect.contains(point);
+        return true;
     }
     else
     {
@@ -388,6 +390,7 @@ void ms::BasicSurface::set_alpha(float alpha)
         std::unique_lock<std::mutex> lk(guard);
         surface_alpha = alpha;
     }
+    ++generation;
     observers.alpha_set_to(this, alpha);
 }
 
@@ -402,6 +405,7 @@ void ms::BasicSurface::set_transformation(glm::mat4 const& t)
         std::unique_lock<std::mutex> lk(guard);
         transformation_matrix = t;
     }
+    ++generation;
     observers.transformation_set_to(this, t);
 }
 
@@ -767,67 +771,24 @@ std::shared_ptr<ms::Surface> ms::BasicSurface::parent() const
     return parent_.lock();
 }
 
-namespace
+unsigned ms::BasicSurface::renderable_generation() const
 {
-//This class avoids locking for long periods of time by copying (or lazy-copying)
-class SurfaceSnapshot : public mg::Renderable
-{
-public:
-    SurfaceSnapshot(
-        std::shared_ptr<mc::BufferStream> const& stream,
-        void const* compositor_id,
-        geom::Rectangle const& position,
-        glm::mat4 const& transform,
-        float alpha,
-        mg::Renderable::ID id)
-    : underlying_buffer_stream{stream},
-      compositor_id{compositor_id},
-      alpha_{alpha},
-      screen_position_(position),
-      transformation_(transform),
-      id_(id)
-    {
-    }
-
-    ~SurfaceSnapshot()
-    {
-    }
-
-    unsigned int swap_interval() const override
-    {
-        return underlying_buffer_stream->framedropping() ? 0 : 1;
-    }
-
-    std::shared_ptr<mg::Buffer> buffer() const override
-    {
-        if (!compositor_buffer)
-            compositor_buffer = underlying_buffer_stream->lock_compositor_buffer(compositor_id);
-        return compositor_buffer;
-    }
-
-    geom::Rectangle screen_position() const override
-    { return screen_position_; }
-
-    float alpha() const override
-    { return alpha_; }
-
-    glm::mat4 transformation() const override
-    { return transformation_; }
-
-    bool shaped() const override
-    { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
+    return generation;
+}
 
-    mg::Renderable::ID id() const override
-    { return id_; }
-private:
-    std::shared_ptr<mc::BufferStream> const underlying_buffer_stream;
-    std::shared_ptr<mg::Buffer> mutable compositor_buffer;
-    void const*const compositor_id;
-    float const alpha_;
-    geom::Rectangle const screen_position_;
-    glm::mat4 const transformation_;
-    mg::Renderable::ID const id_;
-};
+auto ms::BasicSurface::frame_posted_callback() -> std::function<void(geom::Size const&)>
+{
+    // The stream's renderable changes when its first frame is posted, or it
+    // changes size. Callbacks for a stream are never run concurrently.
+    return [this, posted = optional_value<geom::Size>{}](geom::Size const& size) mutable
+        {
+            if (!posted.is_set() || posted.value() != size)
+            {
+                posted = size;
+                ++generation;
+            }
+            observers.frame_posted(this, 1, size);
+        };
 }
 
 int ms::BasicSurface::buffers_ready_for_compositor(void const* id) const
@@ -869,12 +830,9 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
         layers = s;
 
         for(auto& layer : layers)
-            layer.stream->set_frame_posted_callback(
-                [this](auto const& size)
-                {
-                    observers.frame_posted(this, 1, size);
-                });
+            layer.stream->set_frame_posted_callback(frame_posted_callback());
     }
+    ++generation;
     observers.moved_to(this, surface_rect.top_left);
 }
 
@@ -892,7 +850,7 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
             else
                 size = info.stream->stream_size();
 
-            list.emplace_back(std::make_shared<SurfaceSnapshot>(
+            list.emplace_back(std::make_shared<ms::SurfaceSnapshot>(
                 info.stream, id,
                 geom::Rectangle{surface_rect.top_left + info.displacement, std::move(size)},
                 transformation_matrix, surface_alpha, info.stream.get()));
@@ -28,6 +28,8 @@
 #include "mir_toolkit/common.h"
 
 #include <glm/glm.hpp>
+#include <atomic>
+#include <functional>
 #include <vector>
 #include <list>
 #include <memory>
@@ -105,6 +107,11 @@ public:
     bool visible() const override;
     
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    /**
+     * Changes whenever the renderables generate_renderables() would give
+     * change, other than by having new buffers to draw
+     */
+    unsigned renderable_generation() const;
     int buffers_ready_for_compositor(void const* compositor_id) const override;
 
     MirWindowType type() const override;
@@ -150,6 +157,7 @@ private:
     int set_swap_interval(int);
     MirWindowFocusState set_focus_state(MirWindowFocusState f);
     MirOrientationMode set_preferred_orientation(MirOrientationMode mode);
+    auto frame_posted_callback() -> std::function<void(geometry::Size const&)>;
 
     SurfaceObservers observers;
     std::mutex mutable guard;
@@ -166,6 +174,7 @@ private:
     std::weak_ptr<Surface> const parent_;
 
     std::list<StreamInfo> layers;
+    std::atomic<unsigned> generation{0};
     // Surface attributes:
     MirWindowType type_ = mir_window_type_normal;
     MirWindowState state_ = mir_window_state_restored;
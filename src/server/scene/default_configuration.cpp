@@ -57,13 +57,15 @@ std::shared_ptr<mc::Scene>
 mir::DefaultServerConfiguration::the_scene()
 {
     return scene_surface_stack([this]()
-                         { return std::make_shared<ms::SurfaceStack>(the_scene_report()); });
+                         { return std::make_shared<ms::SurfaceStack>(
+                               the_scene_report(), the_display_configuration_observer_registrar()); });
 }
 
 std::shared_ptr<mi::Scene> mir::DefaultServerConfiguration::the_input_scene()
 {
     return scene_surface_stack([this]()
-                             { return std::make_shared<ms::SurfaceStack>(the_scene_report()); });
+                             { return std::make_shared<ms::SurfaceStack>(
+                                   the_scene_report(), the_display_configuration_observer_registrar()); });
 }
 
 auto mir::DefaultServerConfiguration::the_surface_factory()
@@ -85,7 +87,8 @@ mir::DefaultServerConfiguration::the_surface_stack()
         -> std::shared_ptr<msh::SurfaceStack>
              {
                  auto const wrapped = scene_surface_stack([this]()
-                     { return std::make_shared<ms::SurfaceStack>(the_scene_report()); });
+                     { return std::make_shared<ms::SurfaceStack>(
+                           the_scene_report(), the_display_configuration_observer_registrar()); });
 
                  return wrap_surface_stack(wrapped);
              });
@@ -18,6 +18,7 @@
 
 #include "gl_pixel_buffer.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/pixel_kernels.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
 
@@ -39,14 +40,6 @@ bool is_big_endian()
     return (*reinterpret_cast<char*>(&n) != 1);
 }
 
-inline uint32_t abgr_to_argb(uint32_t p)
-{
-    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
-           ((p) & 0x0000ff00) |       /* G remains at same position */
-           ((p >> 16) & 0x000000ff) | /* Move B to new position */
-           ((p) & 0xff000000);        /* A remains at same position */
-}
-
 }
 
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
@@ -133,31 +126,11 @@ void const* ms::GLPixelBuffer::as_argb_8888()
 {
     if (pixels_need_y_flip)
     {
-        auto const stride_val = stride().as_uint32_t();
-        auto const height = size_.height.as_uint32_t();
-
-        std::vector<char> tmp(stride_val);
+        /* GL_RGBA pixels are abgr_8888, which need converting to argb_8888 */
+        auto const gl_format =
+            gl_pixel_format == GL_RGBA ? mir_pixel_format_abgr_8888 : mir_pixel_format_argb_8888;
 
-        for (unsigned int i = 0; i < height / 2; i++)
-        {
-            /* Store line i */
-            tmp.assign(&pixels[i * stride_val], &pixels[(i + 1) * stride_val]);
-
-            /* Copy line height - i - 1 to line i */
-            copy_and_convert_pixel_line(&pixels[(height - i - 1) * stride_val],
-                                        &pixels[i * stride_val]);
-
-            /* Copy stored line (i) to height - i - 1 */
-            copy_and_convert_pixel_line(tmp.data(),
-                                        &pixels[(height - i - 1) * stride_val]);
-        }
-
-        /* Process middle line if there is one */
-        if (height % 2 == 1)
-        {
-            copy_and_convert_pixel_line(&pixels[(height / 2) * stride_val],
-                                        &pixels[(height / 2) * stride_val]);
-        }
+        mg::pixel::flip_vertically(pixels.data(), size_, stride(), gl_format, mir_pixel_format_argb_8888);
 
         pixels_need_y_flip = false;
     }
@@ -174,21 +147,3 @@ geom::Stride ms::GLPixelBuffer::stride() const
 {
     return geom::Stride{size_.width.as_uint32_t() * sizeof(uint32_t)};
 }
-
-void ms::GLPixelBuffer::copy_and_convert_pixel_line(char* src, char* dst)
-{
-    if (gl_pixel_format == GL_RGBA)
-    {
-        /* Convert from abgr_8888 to argb_8888 while copying */
-        auto pixels_src = reinterpret_cast<uint32_t*>(src);
-        auto pixels_dst = reinterpret_cast<uint32_t*>(dst);
-        auto const width = size_.width.as_uint32_t();
-
-        for (uint32_t n = 0; n < width; n++)
-            pixels_dst[n] = abgr_to_argb(pixels_src[n]);
-    }
-    else if (src != dst)
-    {
-        std::copy(src, src + stride().as_uint32_t(), dst);
-    }
-}
@@ -56,7 +56,6 @@ public:
 
 private:
     void prepare();
-    void copy_and_convert_pixel_line(char* src, char* dst);
 
     std::unique_ptr<renderer::gl::Context> const gl_context;
     GLuint tex;
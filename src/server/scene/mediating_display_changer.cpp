@@ -16,6 +16,7 @@
  * Authored by: Kevin DuBois <kevin.dubois@canonical.com>
  */
 
+#include <chrono>
 #include <condition_variable>
 #include <boost/throw_exception.hpp>
 #include <unordered_set>
@@ -102,6 +103,14 @@ public:
     }
 };
 
+template<typename Step>
+std::chrono::nanoseconds time_of(Step const& step)
+{
+    auto const start = std::chrono::steady_clock::now();
+    step();
+    return std::chrono::steady_clock::now() - start;
+}
+
 class ApplyNowAndRevertOnScopeExit
 {
 public:
@@ -471,16 +480,27 @@ void ms::MediatingDisplayChanger::apply_config(
     auto existing_configuration = display->configuration();
     try
     {
-        if (configuration_has_new_outputs_enabled(*display->configuration(), *conf) ||
-            !display->apply_if_configuration_preserves_display_buffers(*conf))
+        mg::DisplayConfigurationTimings timings;
+        bool preserved{false};
+
+        timings.preserving_display_buffers = time_of(
+            [&]
+            {
+                preserved = !configuration_has_new_outputs_enabled(*display->configuration(), *conf) &&
+                    display->apply_if_configuration_preserves_display_buffers(*conf);
+            });
+
+        if (!preserved)
         {
+            timings.compositor_stopped = true;
             ApplyNowAndRevertOnScopeExit comp{
-                [this] { compositor->stop(); },
-                [this] { compositor->start(); }};
-            display->configure(*conf);
+                [&] { timings.stopping_compositor = time_of([this] { compositor->stop(); }); },
+                [&] { timings.starting_compositor = time_of([this] { compositor->start(); }); }};
+            timings.configuring_display = time_of([&] { display->configure(*conf); });
         }
 
         observer->configuration_applied(conf);
+        observer->configuration_timings(timings);
         base_configuration_applied = false;
     }
     catch (std::exception const& e)
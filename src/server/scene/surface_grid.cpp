@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_grid.h"
+#include "mir/scene/surface.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Rounds towards negative infinity, so that cells don't straddle the origin
+int cell_of(int coordinate)
+{
+    auto const size = ms::SurfaceGrid::cell_size;
+    return coordinate >= 0 ? coordinate / size : -((size - 1 - coordinate) / size);
+}
+
+std::uint64_t key_of(int column, int row)
+{
+    return (std::uint64_t(std::uint32_t(column)) << 32) | std::uint32_t(row);
+}
+}
+
+ms::SurfaceGrid::SurfaceGrid() = default;
+ms::SurfaceGrid::~SurfaceGrid() = default;
+
+template<typename Action>
+void ms::SurfaceGrid::for_each_cell_of(geom::Rectangle const& unclipped, Action const& action)
+{
+    auto const bounds = bounded ? unclipped.intersection_with(extents) : unclipped;
+    if (bounds.size.width.as_int() <= 0 || bounds.size.height.as_int() <= 0)
+        return;
+
+    auto const bottom_right = bounds.bottom_right() - geom::Displacement{1, 1};
+    auto const left = cell_of(bounds.top_left.x.as_int());
+    auto const right = cell_of(bottom_right.x.as_int());
+    auto const top = cell_of(bounds.top_left.y.as_int());
+    auto const bottom = cell_of(bottom_right.y.as_int());
+
+    for (auto row = top; row <= bottom; ++row)
+        for (auto column = left; column <= right; ++column)
+            action(key_of(column, row));
+}
+
+void ms::SurfaceGrid::file(Entry const& entry)
+{
+    for_each_cell_of(entry.bounds, [&](CellKey key)
+        {
+            cells[key].push_back(&entry);
+        });
+}
+
+void ms::SurfaceGrid::unfile(Entry const& entry)
+{
+    for_each_cell_of(entry.bounds, [&](CellKey key)
+        {
+            auto const cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+
+            auto& filed = cell->second;
+            auto const i = std::find(filed.begin(), filed.end(), &entry);
+            if (i != filed.end())
+            {
+                *i = filed.back();
+                filed.pop_back();
+            }
+            if (filed.empty())
+                cells.erase(cell);
+        });
+}
+
+void ms::SurfaceGrid::insert(std::shared_ptr<Surface> const& surface, geom::Rectangle const& bounds)
+{
+    auto const inserted = entries.emplace(surface.get(), Entry{surface, bounds, 0});
+    if (inserted.second)
+        file(inserted.first->second);
+}
+
+void ms::SurfaceGrid::update(Surface const* surface, geom::Rectangle const& bounds)
+{
+    auto const entry = entries.find(surface);
+    if (entry == entries.end() || entry->second.bounds == bounds)
+        return;
+
+    unfile(entry->second);
+    entry->second.bounds = bounds;
+    file(entry->second);
+}
+
+void ms::SurfaceGrid::erase(Surface const* surface)
+{
+    auto const entry = entries.find(surface);
+    if (entry == entries.end())
+        return;
+
+    unfile(entry->second);
+    entries.erase(entry);
+}
+
+void ms::SurfaceGrid::restack(std::vector<std::shared_ptr<Surface>> const& stack)
+{
+    unsigned rank = 0;
+    for (auto const& surface : stack)
+    {
+        auto const entry = entries.find(surface.get());
+        if (entry != entries.end())
+            entry->second.rank = ++rank;
+    }
+}
+
+void ms::SurfaceGrid::set_extents(geom::Rectangle const& new_extents)
+{
+    if (bounded && extents == new_extents)
+        return;
+
+    bounded = true;
+    extents = new_extents;
+
+    cells.clear();
+    for (auto const& entry : entries)
+        file(entry.second);
+}
+
+auto ms::SurfaceGrid::top_surface_at(
+    geom::Point point,
+    std::function<bool(Surface const&)> const& accepts) const -> std::shared_ptr<Surface>
+{
+    if (bounded && !extents.contains(point))
+    {
+        // Nothing is filed out here
+        Cell everything;
+        everything.reserve(entries.size());
+        for (auto const& entry : entries)
+            everything.push_back(&entry.second);
+
+        return top_surface_of(everything, point, accepts);
+    }
+
+    auto const cell = cells.find(key_of(cell_of(point.x.as_int()), cell_of(point.y.as_int())));
+    if (cell == cells.end())
+        return {};
+
+    return top_surface_of(cell->second, point, accepts);
+}
+
+auto ms::SurfaceGrid::top_surface_of(
+    Cell const& candidates,
+    geom::Point point,
+    std::function<bool(Surface const&)> const& accepts) -> std::shared_ptr<Surface>
+{
+    // Cells hold few surfaces, so rather than sorting them by rank we take
+    // the topmost candidate we haven't tried yet until one accepts the point
+    unsigned below = ~0u;
+    for (;;)
+    {
+        Entry const* top = nullptr;
+        for (auto const entry : candidates)
+        {
+            if (entry->rank < below &&
+                (!top || entry->rank > top->rank) &&
+                entry->bounds.contains(point))
+            {
+                top = entry;
+            }
+        }
+
+        if (!top)
+            return {};
+
+        if (accepts(*top->surface))
+            return top->surface;
+
+        below = top->rank;
+    }
+}
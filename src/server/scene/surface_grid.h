@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_GRID_H_
+#define MIR_SCENE_SURFACE_GRID_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * A spatial index of the surfaces of a stack, by their input bounds.
+ *
+ * The screen is divided into square cells, each of which lists the surfaces
+ * overlapping it, so that finding the surfaces under a point only looks at
+ * the few that share its cell. Surfaces are ranked by their place in the
+ * stack, and candidates are tried topmost first.
+ *
+ * Once given the extents of the outputs, only the cells within them are
+ * filled, so a huge surface costs no more than a fullscreen one. Points
+ * outside the extents fall back to trying every surface.
+ *
+ * SurfaceGrid does no locking of its own.
+ */
+class SurfaceGrid
+{
+public:
+    SurfaceGrid();
+    ~SurfaceGrid();
+
+    /// Starts tracking a surface; it has the lowest rank until restack()ed
+    void insert(std::shared_ptr<Surface> const& surface, geometry::Rectangle const& bounds);
+
+    /// Notes that the bounds of a tracked surface have changed
+    void update(Surface const* surface, geometry::Rectangle const& bounds);
+
+    void erase(Surface const* surface);
+
+    /// Ranks the surfaces by their order in the stack, bottom to top
+    void restack(std::vector<std::shared_ptr<Surface>> const& stack);
+
+    /// Limits the cells to those covering extents
+    void set_extents(geometry::Rectangle const& extents);
+
+    /**
+     * The topmost surface whose bounds contain the point and that accepts it
+     *   \returns An empty pointer if no surface accepts the point
+     */
+    auto top_surface_at(
+        geometry::Point point,
+        std::function<bool(Surface const&)> const& accepts) const -> std::shared_ptr<Surface>;
+
+    /// The side of a cell, in pixels
+    static int const cell_size = 256;
+
+private:
+    SurfaceGrid(SurfaceGrid const&) = delete;
+    SurfaceGrid& operator=(SurfaceGrid const&) = delete;
+
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        geometry::Rectangle bounds;
+        unsigned rank;
+    };
+
+    typedef std::uint64_t CellKey;
+    typedef std::vector<Entry const*> Cell;
+
+    template<typename Action>
+    void for_each_cell_of(geometry::Rectangle const& bounds, Action const& action);
+    void file(Entry const& entry);
+    void unfile(Entry const& entry);
+    static auto top_surface_of(
+        Cell const& candidates,
+        geometry::Point point,
+        std::function<bool(Surface const&)> const& accepts) -> std::shared_ptr<Surface>;
+
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<CellKey, Cell> cells;
+    bool bounded{false};
+    geometry::Rectangle extents;
+};
+
+}
+}
+
+#endif /* MIR_SCENE_SURFACE_GRID_H_ */
@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_snapshot.h"
+#include "mir/compositor/buffer_stream.h"
+#include "mir/graphics/pixel_format_utils.h"
+#include "mir/graphics/buffer.h"
+
+#include <cmath>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Rounds inwards, as claiming a pixel is opaque when it isn't would hide what's behind it
+geom::Region scaled(geom::Region const& region, geom::Size const& from, geom::Size const& to)
+{
+    if (from == to)
+        return region;
+
+    if (from.width == geom::Width{} || from.height == geom::Height{})
+        return {};
+
+    auto const x_scale = double(to.width.as_int()) / from.width.as_int();
+    auto const y_scale = double(to.height.as_int()) / from.height.as_int();
+
+    geom::Region result;
+    for (auto const& rect : region.rectangles())
+    {
+        int const left = std::ceil(rect.left().as_int() * x_scale);
+        int const top = std::ceil(rect.top().as_int() * y_scale);
+        int const right = std::floor(rect.right().as_int() * x_scale);
+        int const bottom = std::floor(rect.bottom().as_int() * y_scale);
+
+        if (left < right && top < bottom)
+            result.unite(geom::Rectangle{{left, top}, {right - left, bottom - top}});
+    }
+    return result;
+}
+}
+
+ms::SurfaceSnapshot::SurfaceSnapshot(
+    std::shared_ptr<mc::BufferStream> const& stream,
+    void const* compositor_id,
+    geom::Rectangle const& position,
+    glm::mat4 const& transform,
+    float alpha,
+    mg::Renderable::ID id)
+    : underlying_buffer_stream{stream},
+      compositor_id{compositor_id},
+      alpha_{alpha},
+      screen_position_(position),
+      transformation_(transform),
+      id_(id)
+{
+}
+
+unsigned int ms::SurfaceSnapshot::swap_interval() const
+{
+    return underlying_buffer_stream->framedropping() ? 0 : 1;
+}
+
+std::shared_ptr<mg::Buffer> ms::SurfaceSnapshot::buffer() const
+{
+    if (!compositor_buffer)
+    {
+        compositor_buffer = underlying_buffer_stream->lock_compositor_buffer(compositor_id);
+        damage_ = underlying_buffer_stream->damage_for_compositor(compositor_id);
+        opaque_ = underlying_buffer_stream->opaque_region_for_compositor(compositor_id);
+    }
+    return compositor_buffer;
+}
+
+geom::Rectangle ms::SurfaceSnapshot::screen_position() const
+{
+    return screen_position_;
+}
+
+geom::Rectangles ms::SurfaceSnapshot::damage() const
+{
+    buffer();
+    return damage_;
+}
+
+float ms::SurfaceSnapshot::alpha() const
+{
+    return alpha_;
+}
+
+glm::mat4 ms::SurfaceSnapshot::transformation() const
+{
+    return transformation_;
+}
+
+bool ms::SurfaceSnapshot::shaped() const
+{
+    return mg::contains_alpha(underlying_buffer_stream->pixel_format());
+}
+
+geom::Region ms::SurfaceSnapshot::opaque_region() const
+{
+    // The region goes with the buffer it was promised for, which is scaled to fill screen_position_
+    auto const buffer = this->buffer();
+    if (!buffer)
+        return {};
+
+    auto opaque = scaled(opaque_, buffer->size(), screen_position_.size);
+    opaque.translate(screen_position_.top_left - geom::Point{});
+    opaque.intersect(screen_position_);
+    return opaque;
+}
+
+mg::Renderable::ID ms::SurfaceSnapshot::id() const
+{
+    return id_;
+}
+
+void ms::SurfaceSnapshot::release_buffer()
+{
+    compositor_buffer.reset();
+    damage_.clear();
+    opaque_ = {};
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_SNAPSHOT_H_
+#define MIR_SCENE_SURFACE_SNAPSHOT_H_
+
+#include "mir/graphics/renderable.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace compositor { class BufferStream; }
+namespace scene
+{
+
+/**
+ * A stream of a BasicSurface as it was positioned when the snapshot was
+ * taken. The buffer to draw is only acquired from the stream when first
+ * asked for, and is held until release_buffer() so that the same snapshot
+ * can be drawn again in a later frame.
+ *
+ * A snapshot is only used by the one compositor it was taken for.
+ */
+class SurfaceSnapshot : public graphics::Renderable
+{
+public:
+    SurfaceSnapshot(
+        std::shared_ptr<compositor::BufferStream> const& stream,
+        void const* compositor_id,
+        geometry::Rectangle const& position,
+        glm::mat4 const& transform,
+        float alpha,
+        graphics::Renderable::ID id);
+
+    unsigned int swap_interval() const override;
+    std::shared_ptr<graphics::Buffer> buffer() const override;
+    geometry::Rectangle screen_position() const override;
+    geometry::Rectangles damage() const override;
+    float alpha() const override;
+    glm::mat4 transformation() const override;
+    bool shaped() const override;
+    geometry::Region opaque_region() const override;
+    graphics::Renderable::ID id() const override;
+
+    /// Gives the buffer back, so that the next frame acquires a new one
+    void release_buffer();
+
+private:
+    std::shared_ptr<compositor::BufferStream> const underlying_buffer_stream;
+    std::shared_ptr<graphics::Buffer> mutable compositor_buffer;
+    geometry::Rectangles mutable damage_;
+    geometry::Region mutable opaque_;
+    void const*const compositor_id;
+    float const alpha_;
+    geometry::Rectangle const screen_position_;
+    glm::mat4 const transformation_;
+    graphics::Renderable::ID const id_;
+};
+
+}
+}
+
+#endif /* MIR_SCENE_SURFACE_SNAPSHOT_H_ */
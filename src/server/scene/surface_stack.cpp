@@ -20,14 +20,21 @@
 
 #include "surface_stack.h"
 #include "rendering_tracker.h"
+#include "basic_surface.h"
+#include "surface_snapshot.h"
 #include "mir/scene/surface.h"
 #include "mir/scene/scene_report.h"
+#include "mir/scene/null_surface_observer.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
+#include "mir/graphics/display_configuration.h"
+#include "mir/graphics/display_configuration_observer.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <memory>
@@ -42,24 +49,129 @@ namespace geom = mir::geometry;
 namespace
 {
 
-class SurfaceSceneElement : public mc::SceneElement
+// Tells the stack when the input bounds of one of its surfaces change
+class InputBoundsObserver : public ms::NullSurfaceObserver
+{
+public:
+    InputBoundsObserver(std::function<void(ms::Surface const*)> const& bounds_changed)
+        : bounds_changed{bounds_changed}
+    {
+    }
+
+    void moved_to(ms::Surface const* surface, geom::Point const&) override
+    {
+        bounds_changed(surface);
+    }
+
+    void resized_to(ms::Surface const* surface, geom::Size const&) override
+    {
+        bounds_changed(surface);
+    }
+
+private:
+    std::function<void(ms::Surface const*)> const bounds_changed;
+};
+
+// Tells the stack where the outputs are, which is where input can arrive
+class OutputExtentsObserver : public mg::DisplayConfigurationObserver
+{
+public:
+    OutputExtentsObserver(std::function<void(geom::Rectangle const&)> const& extents_changed)
+        : extents_changed{extents_changed}
+    {
+    }
+
+    void initial_configuration(std::shared_ptr<mg::DisplayConfiguration const> const& config) override
+    {
+        update(*config);
+    }
+
+    void configuration_applied(std::shared_ptr<mg::DisplayConfiguration const> const& config) override
+    {
+        update(*config);
+    }
+
+    void configuration_timings(mg::DisplayConfigurationTimings const&) override
+    {}
+
+    void base_configuration_updated(std::shared_ptr<mg::DisplayConfiguration const> const&) override
+    {}
+
+    void session_configuration_applied(std::shared_ptr<mir::frontend::Session> const&,
+        std::shared_ptr<mg::DisplayConfiguration> const&) override
+    {}
+
+    void session_configuration_removed(std::shared_ptr<mir::frontend::Session> const&) override
+    {}
+
+    void configuration_failed(
+        std::shared_ptr<mg::DisplayConfiguration const> const&,
+        std::exception const&) override
+    {}
+
+    void catastrophic_configuration_error(
+        std::shared_ptr<mg::DisplayConfiguration const> const&,
+        std::exception const&) override
+    {}
+
+private:
+    void update(mg::DisplayConfiguration const& config)
+    {
+        geom::Rectangles outputs;
+        config.for_each_output(
+            [&outputs](mg::DisplayConfigurationOutput const& output)
+            {
+                if (output.used && output.connected && output.valid() &&
+                    output.current_mode_index < output.modes.size())
+                {
+                    outputs.add(output.extents());
+                }
+            });
+
+        extents_changed(outputs.bounding_rectangle());
+    }
+
+    std::function<void(geom::Rectangle const&)> const extents_changed;
+};
+
+/*
+ * The elements of a snapshot are kept from frame to frame, and handed out
+ * sharing ownership of the frame they're drawn in.
+ */
+class SnapshotElement : public mc::SceneElement
+{
+public:
+    SnapshotElement(std::shared_ptr<mg::Renderable> const& renderable)
+        : renderable_{renderable}
+    {
+    }
+
+    void drawn_in(std::weak_ptr<void> const& frame)
+    {
+        this->frame = frame;
+    }
+
+    std::shared_ptr<mg::Renderable> renderable() const override
+    {
+        return {frame.lock(), renderable_.get()};
+    }
+
+private:
+    std::shared_ptr<mg::Renderable> const renderable_;
+    std::weak_ptr<void> frame;
+};
+
+class SurfaceSceneElement : public SnapshotElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
         std::shared_ptr<mg::Renderable> const& renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
-        : renderable_{renderable},
+        : SnapshotElement{renderable},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
-    {
-    }
-
-    std::shared_ptr<mg::Renderable> renderable() const override
+          cid{id}
     {
-        return renderable_;
     }
 
     void rendered() override
@@ -73,46 +185,112 @@ public:
     }
 
 private:
-    std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
-class OverlaySceneElement : public mc::SceneElement
+class OverlaySceneElement : public SnapshotElement
 {
 public:
     OverlaySceneElement(
         std::shared_ptr<mg::Renderable> renderable)
-        : renderable_{renderable}
+        : SnapshotElement{renderable}
     {
     }
 
-    std::shared_ptr<mg::Renderable> renderable() const override
+    void rendered() override
     {
-        return renderable_;
     }
 
-    void rendered() override
+    void occluded() override
     {
     }
+};
 
-    void occluded() override
+}
+
+/*
+ * The scene as one compositor saw it. Surfaces' buffers are acquired when
+ * first drawn and given back once the compositor has dropped every element
+ * and renderable of the frame, as they would be if the snapshot were thrown
+ * away, so that the snapshot can be drawn again as long as nothing changes.
+ */
+struct ms::SurfaceStack::Snapshot
+{
+    // Whether the stack, or any surface in it, has changed since
+    bool is_out_of_date(unsigned stack_version) const
     {
+        if (!reusable || version != stack_version || in_use)
+            return true;
+
+        for (auto const& surface : surfaces)
+        {
+            if (surface.first->renderable_generation() != surface.second)
+                return true;
+        }
+        return false;
     }
 
-private:
-    std::shared_ptr<mg::Renderable> const renderable_;
+    mc::SceneElementSequence elements_for_frame(std::shared_ptr<Snapshot> const& self)
+    {
+        in_use = true;
+        // The deleter outlives the frame for as long as elements refer to it
+        auto end_frame = [snapshot = self](Snapshot*) mutable { snapshot->end_frame(); snapshot.reset(); };
+        std::shared_ptr<Snapshot> const frame{self.get(), end_frame};
+
+        mc::SceneElementSequence frame_elements;
+        frame_elements.reserve(elements.size());
+        for (auto const& element : elements)
+        {
+            element->drawn_in(frame);
+            frame_elements.emplace_back(frame, element.get());
+        }
+        return frame_elements;
+    }
+
+    void end_frame()
+    {
+        for (auto const snapshot : surface_snapshots)
+            snapshot->release_buffer();
+        in_use = false;
+    }
+
+    unsigned version;
+    bool reusable;
+    // With the renderable generation of each when the snapshot was taken
+    std::vector<std::pair<BasicSurface const*, unsigned>> surfaces;
+    std::vector<std::shared_ptr<SnapshotElement>> elements;
+    std::vector<SurfaceSnapshot*> surface_snapshots;
+    std::atomic<bool> in_use{false};
 };
 
+ms::SurfaceStack::SurfaceStack(
+    std::shared_ptr<SceneReport> const& report) :
+    report{report},
+    input_bounds_observer{std::make_shared<InputBoundsObserver>(
+        [this](Surface const* surface) { update_input_bounds(surface); })},
+    scene_changed{false}
+{
 }
 
 ms::SurfaceStack::SurfaceStack(
-    std::shared_ptr<SceneReport> const& report) :
+    std::shared_ptr<SceneReport> const& report,
+    std::shared_ptr<ObserverRegistrar<mg::DisplayConfigurationObserver>> const& registrar) :
     report{report},
+    input_bounds_observer{std::make_shared<InputBoundsObserver>(
+        [this](Surface const* surface) { update_input_bounds(surface); })},
+    output_extents_observer{std::make_shared<OutputExtentsObserver>(
+        [this](geom::Rectangle const& extents) { update_output_extents(extents); })},
     scene_changed{false}
 {
+    registrar->register_interest(output_extents_observer);
+}
+
+ms::SurfaceStack::~SurfaceStack() noexcept(true)
+{
+    for (auto const& surface : surfaces)
+        surface->remove_observer(input_bounds_observer);
 }
 
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
@@ -120,16 +298,47 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
     RecursiveReadLock lg(guard);
 
     scene_changed = false;
-    mc::SceneElementSequence elements;
+
+    auto const cached = snapshots.find(id);
+    if (cached == snapshots.end())
+    {
+        auto const snapshot = snapshot_for(id);
+        return snapshot->elements_for_frame(snapshot);
+    }
+
+    // Only this compositor uses its entry, and only writers add or remove entries
+    auto& snapshot = cached->second;
+    if (!snapshot || snapshot->is_out_of_date(version))
+        snapshot = snapshot_for(id);
+
+    return snapshot->elements_for_frame(snapshot);
+}
+
+auto ms::SurfaceStack::snapshot_for(mc::CompositorID id) -> std::shared_ptr<Snapshot>
+{
+    auto const snapshot = std::make_shared<Snapshot>();
+    snapshot->version = version;
+    snapshot->reusable = true;
+
     for (auto const& surface : surfaces)
     {
+        // The generation must be read first, in case the surface changes as we look
+        if (auto const basic_surface = dynamic_cast<BasicSurface const*>(surface.get()))
+            snapshot->surfaces.emplace_back(basic_surface, basic_surface->renderable_generation());
+        else
+            snapshot->reusable = false;
+
         if (surface->visible())
         {
             for (auto& renderable : surface->generate_renderables(id))
             {
-                elements.emplace_back(
+                if (auto const surface_snapshot = dynamic_cast<SurfaceSnapshot*>(renderable.get()))
+                    snapshot->surface_snapshots.push_back(surface_snapshot);
+                else
+                    snapshot->reusable = false;
+
+                snapshot->elements.emplace_back(
                     std::make_shared<SurfaceSceneElement>(
-                        surface->name(),
                         renderable,
                         rendering_trackers[surface.get()],
                         id));
@@ -138,9 +347,9 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
     }
     for (auto const& renderable : overlays)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        snapshot->elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
     }
-    return elements;
+    return snapshot;
 }
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
@@ -172,6 +381,7 @@ void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.insert(cid);
+    snapshots[cid];
 
     update_rendering_tracker_compositors();
 }
@@ -181,6 +391,7 @@ void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.erase(cid);
+    snapshots.erase(cid);
 
     update_rendering_tracker_compositors();
 }
@@ -191,6 +402,7 @@ void ms::SurfaceStack::add_input_visualization(
     {
         RecursiveWriteLock lg(guard);
         overlays.push_back(overlay);
+        ++version;
     }
     emit_scene_changed();
 }
@@ -207,6 +419,7 @@ void ms::SurfaceStack::remove_input_visualization(
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        ++version;
     }
     
     emit_scene_changed();
@@ -229,6 +442,13 @@ void ms::SurfaceStack::add_surface(
         RecursiveWriteLock lg(guard);
         surfaces.push_back(surface);
         create_rendering_tracker_for(surface);
+        ++version;
+
+        // Observe first, so that a move while the surface is added isn't missed
+        surface->add_observer(input_bounds_observer);
+        std::lock_guard<std::mutex> index_lock{input_index_guard};
+        input_index.insert(surface, surface->input_bounds());
+        input_index.restack(surfaces);
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface.get());
@@ -250,7 +470,15 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
         {
             surfaces.erase(surface);
             rendering_trackers.erase(keep_alive.get());
+            ++version;
             found_surface = true;
+
+            {
+                std::lock_guard<std::mutex> index_lock{input_index_guard};
+                input_index.erase(keep_alive.get());
+                input_index.restack(surfaces);
+            }
+            keep_alive->remove_observer(input_bounds_observer);
         }
     }
 
@@ -263,34 +491,38 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
 
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
 
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& surface : in_reverse(surfaces))
-    {
-        // TODO There's a lack of clarity about how the input area will
-        // TODO be maintained and whether this test will detect clicks on
-        // TODO decorations (it should) as these may be outside the area
-        // TODO known to the client.  But it works for now.
-        if (surface->input_area_contains(cursor))
-                return surface;
-    }
+    // TODO There's a lack of clarity about how the input area will
+    // TODO be maintained and whether this test will detect clicks on
+    // TODO decorations (it should) as these may be outside the area
+    // TODO known to the client.  But it works for now.
+    std::lock_guard<std::mutex> index_lock{input_index_guard};
+    return input_index.top_surface_at(
+        cursor,
+        [&cursor](Surface const& surface) { return surface.input_area_contains(cursor); });
+}
+
+auto ms::SurfaceStack::input_surface_at(geometry::Point const& point) -> std::shared_ptr<mi::Surface>
+{
+    return surface_at(point);
+}
 
-    return {};
+void ms::SurfaceStack::update_input_bounds(Surface const* surface)
+{
+    // The bounds are read under the lock so that racing updates can't
+    // leave the index with the older of them
+    std::lock_guard<std::mutex> index_lock{input_index_guard};
+    input_index.update(surface, surface->input_bounds());
+}
+
+void ms::SurfaceStack::update_output_extents(geom::Rectangle const& extents)
+{
+    std::lock_guard<std::mutex> index_lock{input_index_guard};
+    input_index.set_extents(extents);
 }
 
 void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback)
@@ -317,6 +549,10 @@ void ms::SurfaceStack::raise(std::weak_ptr<Surface> const& s)
             surfaces.erase(p);
             surfaces.push_back(surface);
             surfaces_reordered = true;
+            ++version;
+
+            std::lock_guard<std::mutex> index_lock{input_index_guard};
+            input_index.restack(surfaces);
         }
     }
 
@@ -339,7 +575,13 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             [&](std::weak_ptr<Surface> const& s) { return !ss.count(s); });
 
         if (old_surfaces != surfaces)
+        {
             surfaces_reordered = true;
+            ++version;
+
+            std::lock_guard<std::mutex> index_lock{input_index_guard};
+            input_index.restack(surfaces);
+        }
     }
 
     if (surfaces_reordered)
@@ -19,6 +19,7 @@
 #ifndef MIR_SCENE_SURFACE_STACK_H_
 #define MIR_SCENE_SURFACE_STACK_H_
 
+#include "surface_grid.h"
 #include "mir/shell/surface_stack.h"
 
 #include "mir/compositor/scene.h"
@@ -27,6 +28,7 @@
 #include "mir/recursive_read_write_mutex.h"
 
 #include "mir/basic_observers.h"
+#include "mir/observer_registrar.h"
 
 #include <atomic>
 #include <map>
@@ -40,6 +42,7 @@ namespace mir
 namespace graphics
 {
 class Renderable;
+class DisplayConfigurationObserver;
 }
 /// Management of Surface objects. Includes the model (SurfaceStack and Surface
 /// classes) and controller (SurfaceController) elements of an MVC design.
@@ -47,6 +50,7 @@ namespace scene
 {
 class BasicSurface;
 class SceneReport;
+class SurfaceObserver;
 class RenderingTracker;
 
 class Observers : public Observer, BasicObservers<Observer>
@@ -69,7 +73,11 @@ class SurfaceStack : public compositor::Scene, public input::Scene, public shell
 public:
     explicit SurfaceStack(
         std::shared_ptr<SceneReport> const& report);
-    virtual ~SurfaceStack() noexcept(true) {}
+    /// As above, but only indexes input within the outputs the registrar reports
+    SurfaceStack(
+        std::shared_ptr<SceneReport> const& report,
+        std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> const& registrar);
+    virtual ~SurfaceStack() noexcept(true);
 
     // From Scene
     compositor::SceneElementSequence scene_elements_for(compositor::CompositorID id) override;
@@ -79,6 +87,7 @@ public:
 
     // From Scene
     void for_each(std::function<void(std::shared_ptr<input::Surface> const&)> const& callback) override;
+    auto input_surface_at(geometry::Point const& point) -> std::shared_ptr<input::Surface> override;
 
     virtual void remove_surface(std::weak_ptr<Surface> const& surface) override;
 
@@ -106,6 +115,11 @@ private:
     SurfaceStack& operator=(const SurfaceStack&) = delete;
     void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
     void update_rendering_tracker_compositors();
+    void update_input_bounds(Surface const* surface);
+    void update_output_extents(geometry::Rectangle const& extents);
+
+    struct Snapshot;
+    auto snapshot_for(compositor::CompositorID id) -> std::shared_ptr<Snapshot>;
 
     RecursiveReadWriteMutex mutable guard;
 
@@ -114,6 +128,16 @@ private:
     std::vector<std::shared_ptr<Surface>> surfaces;
     std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
     std::set<compositor::CompositorID> registered_compositors;
+    // The scene each registered compositor last drew, kept until it changes
+    std::map<compositor::CompositorID, std::shared_ptr<Snapshot>> snapshots;
+    unsigned version{0};
+
+    // Where each surface takes input; guarded separately so that input
+    // can be dispatched while the stack is being changed
+    std::mutex mutable input_index_guard;
+    SurfaceGrid input_index;
+    std::shared_ptr<SurfaceObserver> const input_bounds_observer;
+    std::shared_ptr<graphics::DisplayConfigurationObserver> const output_extents_observer;
     
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
@@ -85,6 +85,16 @@ public:
         buf = b;
     }
 
+    void set_opaque_region(geometry::Region const& region)
+    {
+        opaque = region;
+    }
+
+    geometry::Region opaque_region() const override
+    {
+        return opaque;
+    }
+
     std::shared_ptr<graphics::Buffer> buffer() const override
     {
         return buf;
@@ -95,6 +105,11 @@ public:
         return rect;
     }
 
+    geometry::Rectangles damage() const override
+    {
+        return {{{}, buf->size()}};
+    }
+
     unsigned int swap_interval() const override
     {
         return 1u;
@@ -105,6 +120,7 @@ private:
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    geometry::Region opaque;
 };
 
 } // namespace doubles
@@ -41,8 +41,13 @@ public:
                  void(compositor::CompositorReport::SubCompositorId, graphics::RenderableList const&));
     MOCK_METHOD1(rendered_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD2(repainted_fraction,
+                 void(compositor::CompositorReport::SubCompositorId, float));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD3(render_time,
+                 void(compositor::CompositorReport::SubCompositorId,
+                      std::chrono::nanoseconds, std::chrono::nanoseconds));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
@@ -19,6 +19,8 @@
 #ifndef MIR_TEST_DOUBLES_MOCK_DRM_H_
 #define MIR_TEST_DOUBLES_MOCK_DRM_H_
 
+#include "mir/geometry/rectangle.h"
+
 #include <gmock/gmock.h>
 
 #include <xf86drm.h>
@@ -27,11 +29,6 @@
 
 namespace mir
 {
-namespace geometry
-{
-struct Size;
-}
-
 namespace test
 {
 namespace doubles
@@ -46,6 +43,7 @@ public:
     int fd() const;
     int write_fd() const;
     drmModeRes* resources_ptr();
+    drmModePlaneRes* plane_resources_ptr();
 
     void add_crtc(uint32_t id, drmModeModeInfo mode);
     void add_encoder(uint32_t encoder_id, uint32_t crtc_id, uint32_t possible_crtcs_mask);
@@ -54,6 +52,11 @@ public:
                        std::vector<uint32_t>& possible_encoder_ids,
                        geometry::Size const& physical_size,
                        drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
+    /**
+     * Adds a plane with a "type" property of type (eg: DRM_PLANE_TYPE_OVERLAY)
+     */
+    void add_plane(uint32_t plane_id, uint64_t type, uint32_t possible_crtcs_mask,
+                   std::vector<uint32_t> const& formats);
 
     void prepare();
     void reset();
@@ -61,6 +64,9 @@ public:
     drmModeCrtc* find_crtc(uint32_t id);
     drmModeEncoder* find_encoder(uint32_t id);
     drmModeConnector* find_connector(uint32_t id);
+    drmModePlane* find_plane(uint32_t id);
+    drmModeObjectProperties* find_plane_properties(uint32_t id);
+    drmModePropertyRes* find_property(uint32_t id);
 
     enum ModePreference {NormalMode, PreferredMode};
     static drmModeModeInfo create_mode(uint16_t hdisplay, uint16_t vdisplay,
@@ -82,6 +88,14 @@ private:
     std::vector<drmModeModeInfo> modes;
     std::vector<drmModeModeInfo> modes_empty;
     std::vector<uint32_t> connector_encoder_ids;
+
+    drmModePlaneRes plane_resources;
+    std::vector<drmModePlane> planes;
+    std::vector<uint32_t> plane_ids;
+    std::vector<std::vector<uint32_t>> plane_formats;
+    std::vector<uint64_t> plane_types;
+    std::vector<drmModeObjectProperties> plane_properties;
+    drmModePropertyRes type_property;
 };
 
 class MockDRM
@@ -104,6 +118,10 @@ public:
     MOCK_METHOD8(drmModeSetCrtc, int(int fd, uint32_t crtcId, uint32_t bufferId,
                                      uint32_t x, uint32_t y, uint32_t *connectors,
                                      int count, drmModeModeInfoPtr mode));
+    // drmModeSetPlane() has too many arguments to mock directly; src_area is in whole pixels
+    MOCK_METHOD7(drmModeSetPlane, int(int fd, uint32_t plane_id, uint32_t crtc_id, uint32_t fb_id,
+                                      uint32_t flags, geometry::Rectangle const& crtc_area,
+                                      geometry::Rectangle const& src_area));
 
     MOCK_METHOD1(drmModeFreeResources, void(drmModeResPtr ptr));
     MOCK_METHOD1(drmModeFreeConnector, void(drmModeConnectorPtr ptr));
@@ -132,6 +150,13 @@ public:
     MOCK_METHOD1(drmModeFreeProperty, void(drmModePropertyPtr));
     MOCK_METHOD4(drmModeConnectorSetProperty, int(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
 
+    // drmModeAtomicAlloc() and drmModeAtomicFree() are faked rather than mocked
+    MOCK_METHOD4(drmModeAtomicAddProperty, int(drmModeAtomicReqPtr req, uint32_t object_id,
+                                               uint32_t property_id, uint64_t value));
+    MOCK_METHOD4(drmModeAtomicCommit, int(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
+    MOCK_METHOD4(drmModeCreatePropertyBlob, int(int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD2(drmModeDestroyPropertyBlob, int(int fd, uint32_t id));
+
     MOCK_METHOD2(drmGetMagic, int(int fd, drm_magic_t *magic));
     MOCK_METHOD2(drmAuthMagic, int(int fd, drm_magic_t magic));
 
@@ -177,6 +202,12 @@ public:
         std::vector<uint32_t>& possible_encoder_ids,
         geometry::Size const& physical_size,
         drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
+    void add_plane(
+        char const* device,
+        uint32_t plane_id,
+        uint64_t type,
+        uint32_t possible_crtcs_mask,
+        std::vector<uint32_t> const& formats);
 
     void prepare(char const* device);
     void reset(char const* device);
@@ -187,6 +218,8 @@ public:
     friend class IsFdOfDeviceMatcher;
 
 private:
+    FakeDRMResources* fake_drm_for(int fd);
+
     std::unordered_map<std::string, FakeDRMResources> fake_drms;
     std::unordered_map<int, FakeDRMResources&> fd_to_drm;
     drmModeObjectProperties empty_object_props;
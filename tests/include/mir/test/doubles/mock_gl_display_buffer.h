@@ -37,6 +37,7 @@ public:
     MOCK_METHOD0(release_current, void());
     MOCK_METHOD0(swap_buffers, void());
     MOCK_METHOD0(bind, void());
+    MOCK_METHOD0(buffer_age, int());
 };
 
 }
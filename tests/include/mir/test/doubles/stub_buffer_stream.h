@@ -47,6 +47,20 @@ public:
         return stub_compositor_buffer;
     }
 
+    geometry::Rectangles damage_for_compositor(void const*) const override
+    {
+        return {{{}, stub_compositor_buffer->size()}};
+    }
+
+    geometry::Region opaque_region_for_compositor(void const*) const override
+    {
+        return {};
+    }
+
+    void set_opaque_region(geometry::Region const&) override
+    {
+    }
+
     geometry::Size stream_size() override
     {
         return geometry::Size();
@@ -70,6 +84,10 @@ public:
     {
         if (b) ++nready;
     }
+    void submit_buffer(std::shared_ptr<graphics::Buffer> const& b, geometry::Rectangles const&) override
+    {
+        submit_buffer(b);
+    }
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& fn) override
     {
         thread_name = current_thread_name();
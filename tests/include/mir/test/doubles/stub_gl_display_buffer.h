@@ -39,6 +39,7 @@ public:
     void release_current() override {}
     void swap_buffers() override {}
     void bind() override {}
+    int buffer_age() override { return 0; }
 };
 
 }
@@ -20,6 +20,7 @@
 #define MIR_TEST_DOUBLES_STUB_INPUT_SCENE_H_
 
 #include "mir/input/scene.h"
+#include "mir/input/surface.h"
 
 namespace mir
 {
@@ -33,6 +34,17 @@ class StubInputScene : public input::Scene
     void for_each(std::function<void(std::shared_ptr<input::Surface> const&)> const& ) override
     {
     }
+    auto input_surface_at(geometry::Point const& point) -> std::shared_ptr<input::Surface> override
+    {
+        std::shared_ptr<input::Surface> top_surface_at_point;
+        for_each(
+            [&](std::shared_ptr<input::Surface> const& surface)
+            {
+                if (surface->input_area_contains(point))
+                    top_surface_at_point = surface;
+            });
+        return top_surface_at_point;
+    }
     void add_observer(std::shared_ptr<scene::Observer> const& /* observer */) override
     {
     }
@@ -74,6 +74,10 @@ public:
     {
         return rect;
     }
+    geometry::Rectangles damage() const override
+    {
+        return {{{}, stub_buffer->size()}};
+    }
     float alpha() const override
     {
         return 1.0f;
@@ -86,6 +90,10 @@ public:
     {
         return false;
     }
+    geometry::Region opaque_region() const override
+    {
+        return {};
+    }
     unsigned int swap_interval() const override
     {
         return 1;
@@ -36,6 +36,7 @@ public:
     void set_viewport(geometry::Rectangle const&) override {}
     void set_output_transform(glm::mat2 const&) override {}
     void suspend() override {}
+    float repainted_fraction() const override { return 1.0f; }
 
     void render(graphics::RenderableList const& renderables) const override
     {
@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 
 #include <stdexcept>
+#include <cstring>
 #include <unistd.h>
 #include <dlfcn.h>
 #include <system_error>
@@ -33,11 +34,18 @@ namespace geom = mir::geometry;
 namespace
 {
 mtd::MockDRM* global_mock = nullptr;
+
+uint32_t const plane_type_property_id{100};
 }
 
 mtd::FakeDRMResources::FakeDRMResources()
-    : pipe_fds{-1, -1}
+    : pipe_fds{-1, -1},
+      plane_resources(),
+      type_property()
 {
+    type_property.prop_id = plane_type_property_id;
+    strncpy(type_property.name, "type", sizeof(type_property.name) - 1);
+
     /* Use the read end of a pipe as the fake DRM fd */
     if (pipe(pipe_fds) < 0 || pipe_fds[0] < 0)
         throw std::runtime_error("Failed to create fake DRM fd");
@@ -98,6 +106,11 @@ drmModeRes* mtd::FakeDRMResources::resources_ptr()
     return &resources;
 }
 
+drmModePlaneRes* mtd::FakeDRMResources::plane_resources_ptr()
+{
+    return &plane_resources;
+}
+
 void mtd::FakeDRMResources::prepare()
 {
     resources.count_crtcs = crtcs.size();
@@ -114,6 +127,23 @@ void mtd::FakeDRMResources::prepare()
     for (auto const& connector: connectors)
         connector_ids.push_back(connector.connector_id);
     resources.connectors = connector_ids.data();
+
+    plane_ids.clear();
+    plane_properties.clear();
+    for (auto i = 0u; i != planes.size(); ++i)
+    {
+        planes[i].formats = plane_formats[i].data();
+        planes[i].count_formats = plane_formats[i].size();
+        plane_ids.push_back(planes[i].plane_id);
+
+        drmModeObjectProperties props = drmModeObjectProperties();
+        props.count_props = 1;
+        props.props = &type_property.prop_id;
+        props.prop_values = &plane_types[i];
+        plane_properties.push_back(props);
+    }
+    plane_resources.count_planes = plane_ids.size();
+    plane_resources.planes = plane_ids.data();
 }
 
 void mtd::FakeDRMResources::reset()
@@ -127,6 +157,13 @@ void mtd::FakeDRMResources::reset()
     crtc_ids.clear();
     encoder_ids.clear();
     connector_ids.clear();
+
+    plane_resources = drmModePlaneRes();
+    planes.clear();
+    plane_ids.clear();
+    plane_formats.clear();
+    plane_types.clear();
+    plane_properties.clear();
 }
 
 void mtd::FakeDRMResources::add_crtc(uint32_t id, drmModeModeInfo mode)
@@ -177,6 +214,22 @@ void mtd::FakeDRMResources::add_connector(uint32_t connector_id,
     connectors.push_back(connector);
 }
 
+void mtd::FakeDRMResources::add_plane(
+    uint32_t plane_id,
+    uint64_t type,
+    uint32_t possible_crtcs_mask,
+    std::vector<uint32_t> const& formats)
+{
+    drmModePlane plane = drmModePlane();
+
+    plane.plane_id = plane_id;
+    plane.possible_crtcs = possible_crtcs_mask;
+
+    planes.push_back(plane);
+    plane_formats.push_back(formats);
+    plane_types.push_back(type);
+}
+
 drmModeCrtc* mtd::FakeDRMResources::find_crtc(uint32_t id)
 {
     for (auto& crtc : crtcs)
@@ -207,6 +260,33 @@ drmModeConnector* mtd::FakeDRMResources::find_connector(uint32_t id)
     return nullptr;
 }
 
+drmModePlane* mtd::FakeDRMResources::find_plane(uint32_t id)
+{
+    for (auto& plane : planes)
+    {
+        if (plane.plane_id == id)
+            return &plane;
+    }
+    return nullptr;
+}
+
+drmModeObjectProperties* mtd::FakeDRMResources::find_plane_properties(uint32_t id)
+{
+    for (auto i = 0u; i != plane_properties.size(); ++i)
+    {
+        if (planes[i].plane_id == id)
+            return &plane_properties[i];
+    }
+    return nullptr;
+}
+
+drmModePropertyRes* mtd::FakeDRMResources::find_property(uint32_t id)
+{
+    if (id == type_property.prop_id)
+        return &type_property;
+    return nullptr;
+}
+
 
 drmModeModeInfo mtd::FakeDRMResources::create_mode(uint16_t hdisplay, uint16_t vdisplay,
                                                    uint32_t clock, uint16_t htotal,
@@ -293,8 +373,46 @@ mtd::MockDRM::MockDRM()
                     return fd_to_drm.at(fd).find_connector(connector_id);
                 }));
 
+    ON_CALL(*this, drmModeGetPlaneResources(_))
+        .WillByDefault(
+            Invoke(
+                [this](int fd) -> drmModePlaneResPtr
+                {
+                    auto const drm = fake_drm_for(fd);
+                    return drm ? drm->plane_resources_ptr() : nullptr;
+                }));
+
+    ON_CALL(*this, drmModeGetPlane(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t plane_id) -> drmModePlanePtr
+                {
+                    auto const drm = fake_drm_for(fd);
+                    return drm ? drm->find_plane(plane_id) : nullptr;
+                }));
+
     ON_CALL(*this, drmModeObjectGetProperties(_, _, _))
-        .WillByDefault(Return(&empty_object_props));
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t id, uint32_t type) -> drmModeObjectPropertiesPtr
+                {
+                    auto const drm = fake_drm_for(fd);
+                    if (drm && type == DRM_MODE_OBJECT_PLANE)
+                    {
+                        if (auto const props = drm->find_plane_properties(id))
+                            return props;
+                    }
+                    return &empty_object_props;
+                }));
+
+    ON_CALL(*this, drmModeGetProperty(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t property_id) -> drmModePropertyPtr
+                {
+                    auto const drm = fake_drm_for(fd);
+                    return drm ? drm->find_property(property_id) : nullptr;
+                }));
 
     ON_CALL(*this, drmSetInterfaceVersion(_, _))
     .WillByDefault(Return(0));
@@ -339,6 +457,22 @@ void mtd::MockDRM::add_encoder(
     fake_drms[device].add_encoder(encoder_id, crtc_id, possible_crtcs_mask);
 }
 
+void mtd::MockDRM::add_plane(
+    char const* device,
+    uint32_t plane_id,
+    uint64_t type,
+    uint32_t possible_crtcs_mask,
+    std::vector<uint32_t> const& formats)
+{
+    fake_drms[device].add_plane(plane_id, type, possible_crtcs_mask, formats);
+}
+
+mtd::FakeDRMResources* mtd::MockDRM::fake_drm_for(int fd)
+{
+    auto const drm = fd_to_drm.find(fd);
+    return drm != fd_to_drm.end() ? &drm->second : nullptr;
+}
+
 void mtd::MockDRM::prepare(char const *device)
 {
     fake_drms[device].prepare();
@@ -490,6 +624,19 @@ int drmModeSetCrtc(int fd, uint32_t crtcId, uint32_t bufferId,
                                        connectors, count, mode);
 }
 
+int drmModeSetPlane(int fd, uint32_t plane_id, uint32_t crtc_id,
+                    uint32_t fb_id, uint32_t flags,
+                    int32_t crtc_x, int32_t crtc_y,
+                    uint32_t crtc_w, uint32_t crtc_h,
+                    uint32_t src_x, uint32_t src_y,
+                    uint32_t src_w, uint32_t src_h)
+{
+    return global_mock->drmModeSetPlane(
+        fd, plane_id, crtc_id, fb_id, flags,
+        geom::Rectangle{{crtc_x, crtc_y}, {crtc_w, crtc_h}},
+        geom::Rectangle{{src_x >> 16, src_y >> 16}, {src_w >> 16, src_h >> 16}});
+}
+
 int drmModeCrtcGetGamma(int fd, uint32_t crtc_id, uint32_t size,
                         uint16_t* red, uint16_t* green, uint16_t* blue)
 {
@@ -542,6 +689,41 @@ int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
 }
 
+// Opaque in libdrm; the fake only needs something to point at
+struct _drmModeAtomicReq
+{
+};
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return new _drmModeAtomicReq;
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    delete req;
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
 void drmModeFreeConnector(drmModeConnectorPtr ptr)
 {
     global_mock->drmModeFreeConnector(ptr);
@@ -22,7 +22,12 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace mtf = mir_test_framework;
 
@@ -42,18 +47,25 @@ struct ClientStartupPerformance : testing::Test, mtf::AsyncServerRunner
         stop_server();
     }
 
-    MirConnection* create_connection()
+    MirConnection* create_connection();
+};
+
+MirConnection* connect_to(std::string const& connect_string)
+{
+    auto conn = mir_connect_sync(connect_string.c_str(), "Perf test");
+    if (!mir_connection_is_valid(conn))
     {
-        auto conn = mir_connect_sync(new_connection().c_str(), "Perf test");
-        if (!mir_connection_is_valid(conn))
-        {
-            std::string error_msg{"Could not create connection: "};
-            error_msg.append(mir_connection_get_error_message(conn));
-            throw std::runtime_error(error_msg);
-        }
-        return conn;
+        std::string error_msg{"Could not create connection: "};
+        error_msg.append(mir_connection_get_error_message(conn));
+        throw std::runtime_error(error_msg);
     }
-};
+    return conn;
+}
+
+MirConnection* ClientStartupPerformance::create_connection()
+{
+    return connect_to(new_connection());
+}
 
 MirPixelFormat find_pixel_format(MirConnection* connection)
 {
@@ -86,15 +98,9 @@ MirWindow* make_surface(MirConnection* connection)
     }
     return window;
 }
-}
 
-TEST_F(ClientStartupPerformance, create_surface_and_swap)
+void swap_buffers_of(MirWindow* window)
 {
-    using namespace std::chrono_literals;
-    auto start = std::chrono::steady_clock::now();
-
-    auto conn = create_connection();
-    auto window = make_surface(conn);
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
     auto stream  = mir_window_get_buffer_stream(window);
@@ -107,6 +113,34 @@ TEST_F(ClientStartupPerformance, create_surface_and_swap)
     }
 
     mir_buffer_stream_swap_buffers_sync(stream);
+}
+
+// Many clients starting at once, as at login, with the given number of IPC threads
+struct ConnectionStormPerformance : testing::TestWithParam<int>, mtf::AsyncServerRunner
+{
+    void SetUp() override
+    {
+        add_to_environment("MIR_SERVER_IPC_THREAD_POOL", std::to_string(GetParam()).c_str());
+        start_server();
+    }
+
+    void TearDown() override
+    {
+        stop_server();
+    }
+};
+
+int const storm_clients = 100;
+}
+
+TEST_F(ClientStartupPerformance, create_surface_and_swap)
+{
+    using namespace std::chrono_literals;
+    auto start = std::chrono::steady_clock::now();
+
+    auto conn = create_connection();
+    auto window = make_surface(conn);
+    swap_buffers_of(window);
 
     auto end = std::chrono::steady_clock::now();
     auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
@@ -119,3 +153,46 @@ TEST_F(ClientStartupPerformance, create_surface_and_swap)
     mir_connection_release(conn);
 }
 
+
+TEST_P(ConnectionStormPerformance, clients_connect_create_surface_and_swap)
+{
+    std::vector<std::string> connect_strings;
+    for (int i = 0; i != storm_clients; ++i)
+        connect_strings.push_back(new_connection());
+
+    std::atomic<int> failures{0};
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    for (auto const& connect_string : connect_strings)
+    {
+        clients.emplace_back([&failures, connect_string]
+            {
+                try
+                {
+                    auto conn = connect_to(connect_string);
+                    auto window = make_surface(conn);
+                    swap_buffers_of(window);
+                    mir_window_release_sync(window);
+                    mir_connection_release(conn);
+                }
+                catch (std::exception const&)
+                {
+                    ++failures;
+                }
+            });
+    }
+
+    for (auto& client : clients)
+        client.join();
+
+    auto end = std::chrono::steady_clock::now();
+    auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+
+    printf("%d clients with %d IPC threads: %lld ms\n",
+           storm_clients, GetParam(), static_cast<long long>(diff.count()));
+
+    EXPECT_THAT(failures, Eq(0));
+}
+
+INSTANTIATE_TEST_CASE_P(IpcThreads, ConnectionStormPerformance, testing::Values(1, 2, 4, 8));
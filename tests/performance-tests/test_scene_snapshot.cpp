@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/scene/basic_surface.h"
+#include "src/server/report/null_report_factory.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/graphics/renderable.h"
+#include "mir/input/input_reception_mode.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+int const outputs = 3;
+int const frames = 1000;
+
+struct SceneSnapshotPerformance : testing::TestWithParam<int>
+{
+    SceneSnapshotPerformance()
+    {
+        for (int i = 0; i != GetParam(); ++i)
+        {
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                "window",
+                geom::Rectangle{{(i * 37) % 1600, (i * 23) % 900}, {320, 200}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{std::make_shared<mtd::StubBufferStream>(), {}, {}}},
+                std::shared_ptr<mg::CursorImage>{},
+                report);
+            stack.add_surface(surface, mir::input::InputReceptionMode::normal);
+            surfaces.push_back(surface);
+        }
+
+        for (auto const& output : output_ids)
+            stack.register_compositor(&output);
+    }
+
+    // Composites frames on every output, calling change() before each
+    template<typename Change>
+    double microseconds_per_frame(Change const& change)
+    {
+        auto const start = std::chrono::steady_clock::now();
+
+        for (int frame = 0; frame != frames; ++frame)
+        {
+            change(frame);
+            for (auto const& output : output_ids)
+            {
+                mg::RenderableList renderables;
+                {
+                    auto const elements = stack.scene_elements_for(&output);
+                    renderables.reserve(elements.size());
+                    for (auto const& element : elements)
+                        renderables.push_back(element->renderable());
+                }
+                for (auto const& renderable : renderables)
+                    renderable->screen_position();
+            }
+        }
+
+        auto const duration = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(duration).count() / (frames * outputs);
+    }
+
+    std::shared_ptr<ms::SceneReport> const report = mir::report::null_scene_report();
+    ms::SurfaceStack stack{report};
+    std::vector<std::shared_ptr<ms::BasicSurface>> surfaces;
+    int const output_ids[outputs] = {0, 1, 2};
+};
+}
+
+TEST_P(SceneSnapshotPerformance, unchanged_scene_is_not_rebuilt)
+{
+    microseconds_per_frame([](int){});  // Take the first snapshots
+    auto const unchanged = microseconds_per_frame([](int){});
+    auto const moving = microseconds_per_frame([this](int frame)
+        {
+            surfaces.back()->move_to({frame % 100, 0});
+        });
+
+    printf("%d surfaces on %d outputs, per output per frame:\n"
+           "  unchanged scene:  %8.2f us\n"
+           "  moving a surface: %8.2f us\n",
+           GetParam(), outputs, unchanged, moving);
+
+    EXPECT_LT(unchanged, moving);
+}
+
+INSTANTIATE_TEST_CASE_P(SceneSizes, SceneSnapshotPerformance, testing::Values(10, 50, 200));
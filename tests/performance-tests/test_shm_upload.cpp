@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_upload.h"
+
+#include <EGL/egl.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+// An 80x24 terminal with a 9x18 pixel font
+int const columns = 80;
+int const rows = 24;
+geom::Size const cell{9, 18};
+geom::Size const size{columns * cell.width.as_int(), rows * cell.height.as_int()};
+int const bytes_per_pixel = 4;
+geom::Stride const stride{size.width.as_int() * bytes_per_pixel};
+
+geom::Rectangle cells(int column, int row, int count)
+{
+    return {{column * cell.width.as_int(), row * cell.height.as_int()},
+            {count * cell.width.as_int(), cell.height}};
+}
+
+/*
+ * The damage a terminal submits over a few minutes of typing: each key press
+ * draws a character and moves the cursor, the idle cursor blinks, and each
+ * new line at the bottom of the screen scrolls (and so redraws) everything.
+ */
+std::vector<geom::Rectangles> terminal_frames()
+{
+    std::vector<geom::Rectangles> frames;
+    int column = 0;
+
+    for (int line = 0; line != 100; ++line)
+    {
+        int const line_length = 20 + (line * 37) % 60;
+        for (column = 0; column < line_length; ++column)
+        {
+            frames.push_back({cells(column, rows - 1, 2)});
+            if (column % 10 == 9)
+            {
+                frames.push_back({cells(column + 1, rows - 1, 1)});
+                frames.push_back({cells(column + 1, rows - 1, 1)});
+            }
+        }
+        frames.push_back({{{}, size}});
+    }
+
+    return frames;
+}
+
+size_t bytes_per_frame(std::vector<geom::Rectangles> const& frames, bool row_length_supported)
+{
+    size_t total = 0;
+    for (auto const& damage : frames)
+    {
+        for (auto const& upload : mg::pixel_uploads_for(damage, size, stride, bytes_per_pixel, row_length_supported))
+            total += upload.area.size.width.as_int() * upload.area.size.height.as_int() * bytes_per_pixel;
+    }
+    return total / frames.size();
+}
+
+// A GL context with nothing to draw to, for timing the uploads themselves
+struct GLContext
+{
+    GLContext()
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+            return;
+
+        EGLint const config_attribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, MIR_SERVER_EGL_OPENGL_BIT,
+            EGL_NONE};
+        EGLint const surface_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        EGLint const context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+        EGLConfig config;
+        EGLint num_configs{0};
+
+        if (!eglBindAPI(MIR_SERVER_EGL_OPENGL_API) ||
+            !eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs < 1)
+            return;
+
+        surface = eglCreatePbufferSurface(display, config, surface_attribs);
+        context = eglCreateContext(
+            display, config, EGL_NO_CONTEXT,
+            MIR_SERVER_EGL_OPENGL_API == EGL_OPENGL_ES_API ? context_attribs : nullptr);
+        current = surface != EGL_NO_SURFACE && context != EGL_NO_CONTEXT &&
+                  eglMakeCurrent(display, surface, surface, context);
+    }
+
+    ~GLContext()
+    {
+        if (display == EGL_NO_DISPLAY)
+            return;
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        eglTerminate(display);
+    }
+
+    EGLDisplay display{EGL_NO_DISPLAY};
+    EGLSurface surface{EGL_NO_SURFACE};
+    EGLContext context{EGL_NO_CONTEXT};
+    bool current{false};
+};
+
+template<typename Upload>
+std::chrono::microseconds time_per_frame(std::vector<geom::Rectangles> const& frames, Upload const& upload)
+{
+    glFinish();
+    auto const start = std::chrono::steady_clock::now();
+
+    for (auto const& damage : frames)
+        upload(damage);
+    glFinish();
+
+    auto const duration = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration) / frames.size();
+}
+}
+
+TEST(ShmUploadPerformance, terminal_uploads_a_fraction_of_each_frame)
+{
+    auto const frames = terminal_frames();
+
+    size_t const full = size.height.as_int() * stride.as_int();
+    auto const rectangles = bytes_per_frame(frames, true);
+    auto const whole_rows = bytes_per_frame(frames, false);
+
+    printf("%zu frames of a %dx%d terminal, average upload per frame:\n"
+           "  whole buffer:     %8zu bytes\n"
+           "  damaged rows:     %8zu bytes\n"
+           "  damaged rects:    %8zu bytes\n",
+           frames.size(), size.width.as_int(), size.height.as_int(),
+           full, whole_rows, rectangles);
+
+    EXPECT_LT(whole_rows, full / 4);
+    EXPECT_LT(rectangles, full / 10);
+}
+
+TEST(ShmUploadPerformance, terminal_texture_updates_take_a_fraction_of_the_time)
+{
+    GLContext const gl;
+    if (!gl.current)
+    {
+        printf("No GL context available, not timing texture uploads\n");
+        return;
+    }
+
+    auto const frames = terminal_frames();
+    std::vector<unsigned char> const pixels(size.height.as_int() * stride.as_int(), 0x7f);
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    auto const whole_buffer = time_per_frame(frames,
+        [&](geom::Rectangles const&)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        });
+    auto const damaged = time_per_frame(frames,
+        [&](geom::Rectangles const& damage)
+        {
+            mg::upload_damaged_pixels(
+                damage, size, stride, bytes_per_pixel, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        });
+
+    glDeleteTextures(1, &texture);
+    ASSERT_EQ(GLenum{GL_NO_ERROR}, glGetError());
+
+    printf("%zu frames of a %dx%d terminal, average texture update per frame (%s):\n"
+           "  whole buffer:     %8lld us\n"
+           "  damaged pixels:   %8lld us\n",
+           frames.size(), width, height,
+           mg::unpack_row_length_supported() ? "damaged rects" : "damaged rows",
+           static_cast<long long>(whole_buffer.count()), static_cast<long long>(damaged.count()));
+
+    EXPECT_LT(damaged, whole_buffer);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/scene/basic_surface.h"
+#include "src/server/report/null_report_factory.h"
+#include "mir/input/input_reception_mode.h"
+#include "mir/input/surface.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+unsigned const probes = 100000;
+
+struct SurfaceHitTestingPerformance : testing::TestWithParam<int>
+{
+    SurfaceHitTestingPerformance()
+    {
+        for (int i = 0; i != GetParam(); ++i)
+        {
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                "window",
+                geom::Rectangle{{(i * 37) % 3500, (i * 23) % 2000}, {320, 200}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{std::make_shared<mtd::StubBufferStream>(), {}, {}}},
+                std::shared_ptr<mg::CursorImage>{},
+                report);
+            stack.add_surface(surface, mi::InputReceptionMode::normal);
+        }
+    }
+
+    // Probes points spread over the screen, returning how many hit a surface
+    template<typename HitTest>
+    int microseconds_for_probes(HitTest const& hit_test, double& microseconds)
+    {
+        int hits = 0;
+        auto const start = std::chrono::steady_clock::now();
+
+        for (unsigned probe = 0; probe != probes; ++probe)
+        {
+            if (hit_test(geom::Point{int(probe * 7919 % 3840), int(probe * 104729 % 2160)}))
+                ++hits;
+        }
+
+        auto const duration = std::chrono::steady_clock::now() - start;
+        microseconds = std::chrono::duration<double, std::micro>(duration).count() / probes;
+        return hits;
+    }
+
+    std::shared_ptr<ms::SceneReport> const report = mir::report::null_scene_report();
+    ms::SurfaceStack stack{report};
+};
+}
+
+TEST_P(SurfaceHitTestingPerformance, indexed_hit_testing_beats_a_scan_of_the_stack)
+{
+    double scanning;
+    auto const scanned_hits = microseconds_for_probes([this](geom::Point point)
+        {
+            // How input targets were found before the scene was indexed
+            std::shared_ptr<mi::Surface> top;
+            stack.for_each([&](std::shared_ptr<mi::Surface> const& surface)
+                {
+                    if (surface->input_area_contains(point))
+                        top = surface;
+                });
+            return top;
+        },
+        scanning);
+
+    double indexed;
+    auto const indexed_hits = microseconds_for_probes([this](geom::Point point)
+        {
+            return stack.input_surface_at(point);
+        },
+        indexed);
+
+    printf("%d surfaces, per hit test:\n"
+           "  scanning the stack: %8.3f us\n"
+           "  indexed:            %8.3f us\n",
+           GetParam(), scanning, indexed);
+
+    EXPECT_EQ(scanned_hits, indexed_hits);
+    EXPECT_LT(indexed, scanning);
+}
+
+INSTANTIATE_TEST_CASE_P(SceneSizes, SurfaceHitTestingPerformance, testing::Values(10, 100, 1000));
@@ -26,6 +26,7 @@
 #include "src/client/buffer_factory.h"
 
 #include "mir/variable_length_array.h"
+#include "mir/anonymous_shm_file.h"
 #include "mir_protobuf.pb.h"
 #include "mir_protobuf_wire.pb.h"
 #include "mir/client/surface_map.h"
@@ -43,6 +44,8 @@
 
 #include <sys/eventfd.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
 
 #include <boost/throw_exception.hpp>
 
@@ -391,6 +394,79 @@ TEST_F(MirProtobufRpcChannelTest, reads_fds)
     }
 }
 
+TEST_F(MirProtobufRpcChannelTest, tells_server_it_accepts_large_results)
+{
+    mclr::DisplayServer channel_user{channel};
+    mir::protobuf::PlatformOperationMessage reply;
+    mir::protobuf::PlatformOperationMessage request;
+
+    channel_user.platform_operation(&request, &reply, google::protobuf::NewCallback([](){}));
+
+    ASSERT_EQ(transport->sent_messages.size(), 1u);
+
+    mir::protobuf::wire::Invocation invocation;
+    invocation.ParseFromArray(transport->sent_messages.front().data() + sizeof(uint16_t),
+                              transport->sent_messages.front().size() - sizeof(uint16_t));
+
+    EXPECT_TRUE(invocation.large_results());
+}
+
+TEST_F(MirProtobufRpcChannelTest, reads_results_sent_out_of_line)
+{
+    mclr::DisplayServer channel_user{channel};
+    mir::protobuf::PlatformOperationMessage reply;
+    mir::protobuf::PlatformOperationMessage request;
+
+    channel_user.platform_operation(&request, &reply, google::protobuf::NewCallback([](){}));
+
+    std::initializer_list<mir::Fd> fds = {mir::Fd{open("/dev/null", O_RDONLY)}};
+    std::string const large_data(100000, 'x');
+
+    ASSERT_EQ(transport->sent_messages.size(), 1u);
+    {
+        mir::protobuf::PlatformOperationMessage reply_message;
+        reply_message.set_data(large_data);
+        for (auto fd : fds)
+            reply_message.add_fd(fd);
+        reply_message.set_fds_on_side_channel(fds.size());
+
+        mir::protobuf::wire::Invocation request;
+        request.ParseFromArray(transport->sent_messages.front().data() + sizeof(uint16_t),
+                               transport->sent_messages.front().size() - sizeof(uint16_t));
+
+        mir::protobuf::wire::Result reply;
+        reply.set_id(request.id());
+        reply.set_response(reply_message.SerializeAsString());
+        auto const serialized_reply = reply.SerializeAsString();
+
+        mir::AnonymousShmFile payload{serialized_reply.size()};
+        memcpy(payload.base_ptr(), serialized_reply.data(), serialized_reply.size());
+
+        mir::protobuf::wire::Result placeholder;
+        placeholder.set_out_of_line_size(serialized_reply.size());
+
+        std::vector<uint8_t> buffer(placeholder.ByteSize() + sizeof(uint16_t));
+        *reinterpret_cast<uint16_t*>(buffer.data()) = htobe16(placeholder.ByteSize());
+        ASSERT_TRUE(placeholder.SerializeToArray(buffer.data() + sizeof(uint16_t), buffer.size() - sizeof(uint16_t)));
+
+        transport->add_server_message(buffer);
+
+        std::vector<uint8_t> dummy = {1};
+        transport->add_server_message(dummy, {mir::Fd{dup(payload.fd())}});
+        transport->add_server_message(dummy, fds);
+
+        while(mt::fd_is_readable(channel->watch_fd()))
+        {
+            channel->dispatch(md::FdEvent::readable);
+        }
+    }
+
+    EXPECT_EQ(large_data, reply.data());
+    ASSERT_EQ(static_cast<size_t>(reply.fd_size()), fds.size());
+    EXPECT_EQ(reply.fd(0), *fds.begin());
+    EXPECT_TRUE(transport->all_data_consumed());
+}
+
 TEST_F(MirProtobufRpcChannelTest, notifies_streams_of_disconnect)
 {
     using namespace testing;
@@ -1318,3 +1318,50 @@ TYPED_TEST(StreamTransportTest, receiving_data_without_asking_for_fds_is_an_erro
 
     EXPECT_TRUE(receive_done->wait_for(std::chrono::seconds{1}));
 }
+
+TYPED_TEST(StreamTransportTest, fds_read_ahead_of_their_data_are_received_with_it)
+{
+    std::array<TestFd, 1> test_files;
+    std::array<int, 1> test_fds{{test_files[0].fd}};
+
+    uint32_t message{0xdeadbeef};
+    EXPECT_EQ(ssizeof(message), write(this->test_fd, &message, sizeof(message)));
+    char side_channel{'M'};
+    EXPECT_EQ(ssizeof(side_channel), send_with_fds(this->test_fd, test_fds, &side_channel, sizeof(side_channel), MSG_DONTWAIT));
+
+    uint32_t received_message;
+    EXPECT_NO_THROW(this->transport->receive_data(&received_message, sizeof(received_message)));
+    EXPECT_EQ(message, received_message);
+
+    char received_side_channel;
+    std::vector<mir::Fd> received_fds(1);
+    this->transport->receive_data(&received_side_channel, sizeof(received_side_channel), received_fds);
+    EXPECT_PRED_FORMAT2(fds_are_equivalent, test_files[0].fd, received_fds[0]);
+}
+
+TYPED_TEST(StreamTransportTest, notifies_until_data_read_ahead_is_taken)
+{
+    using namespace testing;
+
+    auto observer = std::make_shared<NiceMock<MockObserver>>();
+    int notifications{0};
+
+    ON_CALL(*observer, on_data_available())
+        .WillByDefault(Invoke([&notifications, this]()
+                              {
+                                  uint32_t dummy;
+                                  this->transport->receive_data(&dummy, sizeof(dummy));
+                                  ++notifications;
+                              }));
+
+    this->transport->register_observer(observer);
+
+    std::array<uint32_t, 3> messages{{1, 2, 3}};
+    EXPECT_EQ(ssizeof(messages), write(this->test_fd, messages.data(), sizeof(messages)));
+
+    EXPECT_TRUE(mt::fd_becomes_readable(this->transport->watch_fd(), std::chrono::seconds{1}));
+    this->transport->dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(notifications, Eq(3));
+    EXPECT_FALSE(mt::fd_is_readable(this->transport->watch_fd()));
+}
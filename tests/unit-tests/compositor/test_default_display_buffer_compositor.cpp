@@ -143,6 +143,8 @@ TEST_F(DefaultDisplayBufferCompositor, optimization_skips_composition)
         .InSequence(seq);
     EXPECT_CALL(*report, rendered_frame(_))
         .Times(0);
+    EXPECT_CALL(*report, repainted_fraction(_,_))
+        .Times(0);
     EXPECT_CALL(*report, finished_frame(_))
         .InSequence(seq);
 
@@ -171,6 +173,8 @@ TEST_F(DefaultDisplayBufferCompositor, rendering_reports_everything)
         .InSequence(seq);
     EXPECT_CALL(*report, rendered_frame(_))
         .InSequence(seq);
+    EXPECT_CALL(*report, repainted_fraction(_,_))
+        .InSequence(seq);
     EXPECT_CALL(*report, finished_frame(_))
         .InSequence(seq);
 
@@ -184,6 +188,23 @@ TEST_F(DefaultDisplayBufferCompositor, rendering_reports_everything)
     compositor.composite(make_scene_elements({}));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, reports_fraction_repainted_by_renderer)
+{
+    using namespace testing;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    ON_CALL(mock_renderer, repainted_fraction())
+        .WillByDefault(Return(0.25f));
+    EXPECT_CALL(*report, repainted_fraction(_, FloatEq(0.25f)))
+        .Times(1);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        report);
+    compositor.composite(make_scene_elements({}));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, calls_renderer_in_sequence)
 {
     using namespace testing;
@@ -210,6 +231,44 @@ TEST_F(DefaultDisplayBufferCompositor, calls_renderer_in_sequence)
     }));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, renders_only_what_the_hardware_does_not_overlay)
+{
+    using namespace testing;
+
+    struct PartiallyOverlayingDisplayBuffer : NiceMock<mtd::MockDisplayBuffer>
+    {
+        explicit PartiallyOverlayingDisplayBuffer(std::shared_ptr<mg::Renderable> const& composited)
+            : composited{composited}
+        {
+        }
+
+        bool overlay_partially(mg::RenderableList& renderlist) override
+        {
+            renderlist = {composited};
+            return false;
+        }
+
+        std::shared_ptr<mg::Renderable> const composited;
+    } partially_overlaying{big};
+
+    ON_CALL(partially_overlaying, transformation())
+        .WillByDefault(Return(no_transformation));
+    ON_CALL(partially_overlaying, view_area())
+        .WillByDefault(Return(screen));
+
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{big})));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        partially_overlaying,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({
+        big,
+        small
+    }));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, rotates_viewport)
 {   // Regression test for LP: #1643488
     using namespace testing;
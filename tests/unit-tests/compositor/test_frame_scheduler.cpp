@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/frame_scheduler.h"
+
+#include <gtest/gtest.h>
+
+namespace mc = mir::compositor;
+namespace mt = mir::time;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+struct FrameScheduler : testing::Test
+{
+    std::chrono::nanoseconds const margin = 2ms;
+    std::chrono::nanoseconds const interval = 16ms;
+    mt::PosixTimestamp const last_vsync{CLOCK_MONOTONIC, 1000ms};
+    mc::FrameScheduler scheduler{margin};
+};
+}
+
+TEST_F(FrameScheduler, predicts_nothing_before_the_first_frame)
+{
+    EXPECT_EQ(0ns, scheduler.predicted_render_time());
+}
+
+TEST_F(FrameScheduler, predicts_the_slowest_recent_frame)
+{
+    scheduler.frame_rendered(3ms);
+    scheduler.frame_rendered(7ms);
+    scheduler.frame_rendered(4ms);
+
+    EXPECT_EQ(7ms, scheduler.predicted_render_time());
+}
+
+TEST_F(FrameScheduler, forgets_old_frames)
+{
+    scheduler.frame_rendered(10ms);
+    for (int i = 0; i != 16; ++i)
+        scheduler.frame_rendered(3ms);
+
+    EXPECT_EQ(3ms, scheduler.predicted_render_time());
+}
+
+TEST_F(FrameScheduler, starts_immediately_without_timing_information)
+{
+    auto const now = last_vsync + 1ms;
+
+    EXPECT_EQ(now, scheduler.start_time(last_vsync, interval, now));
+
+    scheduler.frame_rendered(3ms);
+
+    EXPECT_EQ(now, scheduler.start_time(last_vsync, 0ns, now));
+    EXPECT_EQ(now, scheduler.start_time(mt::PosixTimestamp{}, interval, now));
+}
+
+TEST_F(FrameScheduler, starts_just_in_time_for_the_next_vsync)
+{
+    scheduler.frame_rendered(3ms);
+
+    auto const now = last_vsync + 1ms;
+
+    EXPECT_EQ(last_vsync + interval - 3ms - margin, scheduler.start_time(last_vsync, interval, now));
+}
+
+TEST_F(FrameScheduler, aims_for_a_later_vsync_if_the_next_is_too_close)
+{
+    scheduler.frame_rendered(3ms);
+
+    auto const now = last_vsync + 12ms;
+
+    EXPECT_EQ(last_vsync + 2*interval - 3ms - margin, scheduler.start_time(last_vsync, interval, now));
+}
+
+TEST_F(FrameScheduler, catches_up_after_idling)
+{
+    scheduler.frame_rendered(3ms);
+
+    auto const now = last_vsync + 100*interval + 1ms;
+    auto const start = scheduler.start_time(last_vsync, interval, now);
+
+    EXPECT_EQ(last_vsync + 101*interval - 3ms - margin, start);
+}
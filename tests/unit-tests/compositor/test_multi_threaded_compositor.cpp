@@ -23,10 +23,12 @@
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/scene.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
+#include "mir/compositor/presentation_observer.h"
 #include "mir/scene/observer.h"
 #include "mir/raii.h"
 
 #include "mir/test/current_thread_name.h"
+#include "mir/test/signal.h"
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_buffer.h"
 #include "mir/test/doubles/mock_display_buffer.h"
@@ -35,9 +37,11 @@
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_display.h"
 #include "mir/test/doubles/null_display_buffer_compositor_factory.h"
+#include "mir/test/doubles/null_display_sync_group.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <thread>
@@ -87,12 +91,107 @@ private:
         {
             return std::chrono::milliseconds::zero();
         }
+        mg::Frame last_frame() const override
+        {
+            return {};
+        }
+        std::chrono::nanoseconds frame_interval() const override
+        {
+            return std::chrono::nanoseconds::zero();
+        }
         testing::NiceMock<mtd::MockDisplayBuffer> buffer; 
     };
 
     std::vector<StubDisplaySyncGroup> buffers;
 };
 
+// A single output whose vsync timing is known
+class StubDisplayWithTiming : public mtd::NullDisplay
+{
+public:
+    StubDisplayWithTiming(mg::Frame const& frame, std::chrono::nanoseconds interval)
+    {
+        group.frame = frame;
+        group.interval = interval;
+    }
+
+    void for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f) override
+    {
+        f(group);
+    }
+
+private:
+    struct StubDisplaySyncGroup : mtd::NullDisplaySyncGroup
+    {
+        mg::Frame last_frame() const override
+        {
+            return frame;
+        }
+        std::chrono::nanoseconds frame_interval() const override
+        {
+            return interval;
+        }
+        mg::Frame frame;
+        std::chrono::nanoseconds interval;
+    };
+
+    StubDisplaySyncGroup group;
+};
+
+// A single output whose frames reach the screen only when the test says so
+class StubDisplayWithLateFrames : public mtd::NullDisplay
+{
+public:
+    StubDisplayWithLateFrames(std::chrono::nanoseconds interval)
+    {
+        group.interval = interval;
+    }
+
+    void for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f) override
+    {
+        f(group);
+    }
+
+    bool present(mg::Frame const& frame)
+    {
+        std::function<void(mg::Frame const&)> presented;
+        {
+            std::lock_guard<std::mutex> lock{group.mutex};
+            presented = std::move(group.presented);
+            group.presented = nullptr;
+        }
+
+        if (!presented)
+            return false;
+
+        presented(frame);
+        return true;
+    }
+
+private:
+    struct StubDisplaySyncGroup : mtd::NullDisplaySyncGroup
+    {
+        mg::Frame last_frame() const override
+        {
+            return {};
+        }
+        std::chrono::nanoseconds frame_interval() const override
+        {
+            return interval;
+        }
+        void when_presented(std::function<void(mg::Frame const&)> const& handler) override
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            presented = handler;
+        }
+        std::chrono::nanoseconds interval;
+        std::mutex mutex;
+        std::function<void(mg::Frame const&)> presented;
+    };
+
+    StubDisplaySyncGroup group;
+};
+
 class StubScene : public mtd::StubScene
 {
 public:
@@ -345,6 +444,31 @@ public:
     std::vector<std::string> thread_names;
 };
 
+class GroupRecordingDisplayBufferCompositorFactory : public mc::DisplayBufferCompositorFactory
+{
+public:
+    std::unique_ptr<mc::DisplayBufferCompositor> create_compositor_for(mg::DisplayBuffer&)
+    {
+        auto raw = new RecordingDisplayBufferCompositor{
+            [this]()
+            {
+                std::lock_guard<std::mutex> lock{groups_mutex};
+                groups.insert(mc::compositing_group());
+            }};
+        return std::unique_ptr<RecordingDisplayBufferCompositor>(raw);
+    }
+
+    std::set<mc::DisplayGroupId> compositing_groups()
+    {
+        std::lock_guard<std::mutex> lock{groups_mutex};
+        return groups;
+    }
+
+private:
+    std::mutex groups_mutex;
+    std::set<mc::DisplayGroupId> groups;
+};
+
 namespace
 {
 struct StubDisplayListener : mc::DisplayListener
@@ -359,7 +483,18 @@ struct MockDisplayListener : mc::DisplayListener
     MOCK_METHOD1(remove_display, void(geom::Rectangle const& /*area*/));
 };
 
+struct NullPresentationObserver : mc::PresentationObserver
+{
+    void frame_presented(mc::DisplayGroupId, mg::Frame const&, std::chrono::nanoseconds) override {}
+};
+
+struct MockPresentationObserver : mc::PresentationObserver
+{
+    MOCK_METHOD3(frame_presented, void(mc::DisplayGroupId, mg::Frame const&, std::chrono::nanoseconds));
+};
+
 auto const null_report = mr::null_compositor_report();
+auto const null_presentation_observer = std::make_shared<NullPresentationObserver>();
 unsigned int const composites_per_update{1};
 auto const null_display_listener = std::make_shared<StubDisplayListener>();
 std::chrono::milliseconds const default_delay{-1};
@@ -375,7 +510,7 @@ TEST(MultiThreadedCompositor, compositing_happens_in_different_threads)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -416,6 +551,7 @@ TEST(MultiThreadedCompositor, does_not_deadlock_itself)
         std::make_shared<mtd::NullDisplayBufferCompositorFactory>(),
         std::make_shared<ReentrantDisplayListener>(scene),
         null_report,
+        null_presentation_observer,
         default_delay,
         true
     };
@@ -441,6 +577,7 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
                                            db_compositor_factory,
                                            null_display_listener,
                                            mock_report,
+                                           null_presentation_observer,
                                            default_delay,
                                            true};
 
@@ -457,6 +594,8 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
         .Times(1);
     EXPECT_CALL(*mock_report, scheduled())
         .Times(2);
+    EXPECT_CALL(*mock_report, render_time(_,_,_))
+        .Times(AtLeast(1));
 
     EXPECT_CALL(*mock_report, stopped())
         .Times(AtLeast(1));
@@ -468,6 +607,133 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, tells_presentation_observer_the_vsync_each_frame_was_shown_at)
+{
+    using namespace testing;
+
+    mg::Frame shown;
+    shown.msc = 42;
+    shown.ust = {CLOCK_MONOTONIC, std::chrono::nanoseconds{123456789}};
+    auto const interval = std::chrono::nanoseconds{16666667};
+
+    auto display = std::make_shared<StubDisplayWithTiming>(shown, interval);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto observer = std::make_shared<NiceMock<MockPresentationObserver>>();
+    mt::Signal presented;
+
+    EXPECT_CALL(*observer, frame_presented(
+            _,
+            AllOf(Field(&mg::Frame::msc, Eq(42)),
+                  Field(&mg::Frame::ust, Field(&mir::time::PosixTimestamp::nanoseconds, Eq(shown.ust.nanoseconds)))),
+            Eq(interval)))
+        .WillRepeatedly(InvokeWithoutArgs([&presented] { presented.raise(); }));
+
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, observer, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(presented.wait_for(10s));
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, tells_presentation_observer_only_once_the_group_has_presented_the_frame)
+{
+    using namespace testing;
+
+    mg::Frame shown;
+    shown.msc = 42;
+    shown.ust = {CLOCK_MONOTONIC, std::chrono::nanoseconds{123456789}};
+    auto const interval = std::chrono::nanoseconds{16666667};
+
+    auto display = std::make_shared<StubDisplayWithLateFrames>(interval);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto observer = std::make_shared<NiceMock<MockPresentationObserver>>();
+
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, observer, default_delay, true};
+
+    EXPECT_CALL(*observer, frame_presented(_, _, _))
+        .Times(0);
+
+    compositor.start();
+    while (!db_compositor_factory->check_record_count_for_each_buffer(1, 1))
+        std::this_thread::yield();
+
+    Mock::VerifyAndClearExpectations(observer.get());
+
+    EXPECT_CALL(*observer, frame_presented(
+            _,
+            AllOf(Field(&mg::Frame::msc, Eq(42)),
+                  Field(&mg::Frame::ust, Field(&mir::time::PosixTimestamp::nanoseconds, Eq(shown.ust.nanoseconds)))),
+            Eq(interval)));
+
+    // The frame is composited before the group is told to post it
+    while (!display->present(shown))
+        std::this_thread::yield();
+
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, without_vsync_timing_tells_presentation_observer_when_post_completed)
+{
+    using namespace testing;
+
+    auto display = std::make_shared<mtd::StubDisplay>(1);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto observer = std::make_shared<NiceMock<MockPresentationObserver>>();
+    mt::Signal presented;
+
+    auto const before = mir::time::PosixTimestamp::now(CLOCK_MONOTONIC);
+
+    EXPECT_CALL(*observer, frame_presented(
+            _,
+            Field(&mg::Frame::ust, Field(&mir::time::PosixTimestamp::nanoseconds, Ge(before.nanoseconds))),
+            Eq(std::chrono::nanoseconds::zero())))
+        .WillRepeatedly(InvokeWithoutArgs([&presented] { presented.raise(); }));
+
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, observer, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(presented.wait_for(10s));
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, tells_presentation_observer_which_group_composited_each_frame)
+{
+    using namespace testing;
+
+    unsigned int const nbuffers{2};
+    auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<GroupRecordingDisplayBufferCompositorFactory>();
+    auto observer = std::make_shared<NiceMock<MockPresentationObserver>>();
+    std::mutex presented_mutex;
+    std::set<mc::DisplayGroupId> presented_groups;
+    mt::Signal all_presented;
+
+    ON_CALL(*observer, frame_presented(_, _, _))
+        .WillByDefault(Invoke(
+            [&](mc::DisplayGroupId group, mg::Frame const&, std::chrono::nanoseconds)
+            {
+                std::lock_guard<std::mutex> lock{presented_mutex};
+                presented_groups.insert(group);
+                if (presented_groups.size() == nbuffers)
+                    all_presented.raise();
+            }));
+
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, observer, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(all_presented.wait_for(10s));
+    compositor.stop();
+
+    std::lock_guard<std::mutex> lock{presented_mutex};
+    EXPECT_THAT(db_compositor_factory->compositing_groups(), Eq(presented_groups));
+    EXPECT_THAT(presented_groups, Not(Contains(nullptr)));
+    EXPECT_THAT(mc::compositing_group(), IsNull());
+}
+
 /*
  * It's difficult to test that a render won't happen, without some further
  * introspective capabilities that would complicate the code. This test will
@@ -486,7 +752,7 @@ TEST(MultiThreadedCompositor, composites_only_on_demand)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     // Verify we're actually starting at zero frames
     EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -547,7 +813,7 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report, default_delay, true};
+                                           null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
 
@@ -623,6 +889,7 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
                                            null_display_listener, null_report,
+                                           null_presentation_observer,
                                            recommendation, false};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -671,7 +938,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, false};
 
     // Verify we're actually starting at zero frames
     ASSERT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -694,7 +961,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_we_still_compo
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, false};
 
     compositor.start();
 
@@ -729,7 +996,7 @@ TEST(MultiThreadedCompositor, surface_update_from_render_doesnt_deadlock)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<SurfaceUpdatingDisplayBufferCompositorFactory>(scene);
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -761,7 +1028,7 @@ TEST(MultiThreadedCompositor, double_start_or_stop_ignored)
         .Times(AtLeast(0))
         .WillRepeatedly(Return(mc::SceneElementSequence{}));
 
-    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
     compositor.start();
@@ -776,7 +1043,7 @@ TEST(MultiThreadedCompositor, cleans_up_after_throw_in_start)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     scene->throw_on_add_observer(true);
 
@@ -826,7 +1093,7 @@ TEST(MultiThreadedCompositor, names_compositor_threads)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<ThreadNameDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -855,7 +1122,7 @@ TEST(MultiThreadedCompositor, registers_and_unregisters_with_scene)
     EXPECT_CALL(*mock_scene, register_compositor(_))
         .Times(nbuffers);
     mc::MultiThreadedCompositor compositor{
-        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -878,7 +1145,7 @@ TEST(MultiThreadedCompositor, notifies_about_display_additions_and_removals)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_)).Times(nbuffers);
 
@@ -900,7 +1167,7 @@ TEST(MultiThreadedCompositor, when_compositor_thread_fails_start_reports_error)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_))
         .WillRepeatedly(Throw(std::runtime_error("Failed to add display")));
@@ -923,7 +1190,7 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_adding_dis
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
     compositor.start();
 }
 
@@ -941,6 +1208,6 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
     compositor.start();
 }
@@ -202,3 +202,57 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_together_is_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 960, 1200);
+    auto const top_right = std::make_shared<mtd::FakeRenderable>(960, 0, 960, 600);
+    auto const bottom_right = std::make_shared<mtd::FakeRenderable>(960, 600, 960, 600);
+    auto const beneath = std::make_shared<mtd::FakeRenderable>(500, 300, 800, 600);
+    auto elements = scene_elements_from({beneath, left, top_right, bottom_right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(beneath));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, top_right, bottom_right));
+}
+
+TEST_F(OcclusionFilterTest, window_showing_through_a_gap_is_not_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 950, 1200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(960, 0, 960, 1200);
+    auto const beneath = std::make_shared<mtd::FakeRenderable>(500, 300, 800, 600);
+    auto elements = scene_elements_from({beneath, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(beneath, left, right));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_shaped_window_occludes)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {100, 100}}, 1.0f, false);
+    top->set_opaque_region(Rectangle{{20, 20}, {80, 80}});
+    auto const under_opaque_part = std::make_shared<mtd::FakeRenderable>(30, 30, 10, 10);
+    auto const under_shadow = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto elements = scene_elements_from({under_shadow, under_opaque_part, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(under_opaque_part));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(under_shadow, top));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_translucent_window_occludes_nothing)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {100, 100}}, 0.5f, false);
+    top->set_opaque_region(Rectangle{{10, 10}, {100, 100}});
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(30, 30, 10, 10);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
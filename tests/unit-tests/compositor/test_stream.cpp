@@ -226,3 +226,131 @@ TEST_F(Stream, returns_buffers_to_client_when_told_to_bring_queue_up_to_date)
     EXPECT_THAT(buffers[1].use_count(), Eq(1));
     EXPECT_THAT(buffers[2].use_count(), Eq(2));
 }
+
+TEST_F(Stream, first_buffer_for_a_compositor_is_entirely_damaged)
+{
+    geom::Rectangles const damage{{{1, 0}, {2, 1}}};
+    stream.submit_buffer(buffers[0], damage);
+
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, reports_submitted_damage_to_compositor)
+{
+    geom::Rectangles const damage{{{1, 0}, {2, 1}}};
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1], damage);
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(damage));
+}
+
+TEST_F(Stream, submission_without_damage_damages_entire_buffer)
+{
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1]);
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, accumulates_damage_of_dropped_frames)
+{
+    geom::Rectangle const first{{0, 0}, {1, 1}};
+    geom::Rectangle const second{{3, 1}, {1, 1}};
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1], {first});
+    stream.submit_buffer(buffers[2], {second});
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(geom::Rectangles{first, second}));
+}
+
+TEST_F(Stream, tracks_damage_separately_for_each_compositor)
+{
+    int that{0};
+    geom::Rectangle const first{{0, 0}, {1, 1}};
+    geom::Rectangle const second{{3, 1}, {1, 1}};
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&that);
+
+    stream.submit_buffer(buffers[1], {first});
+    stream.lock_compositor_buffer(this);
+    stream.submit_buffer(buffers[2], {second});
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&that);
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(geom::Rectangles{second}));
+    EXPECT_THAT(stream.damage_for_compositor(&that), Eq(geom::Rectangles{first, second}));
+}
+
+TEST_F(Stream, relocking_the_same_buffer_has_no_damage)
+{
+    int that{0};
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&that);
+
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(geom::Rectangles{}));
+}
+
+TEST_F(Stream, forgets_compositors_that_stop_compositing_it)
+{
+    int that{0};
+    geom::Rectangles const damage{{{1, 0}, {2, 1}}};
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&that);
+
+    for (int i = 0; i != 20; ++i)
+    {
+        stream.submit_buffer(buffers[(i + 1) % buffers.size()], damage);
+        stream.lock_compositor_buffer(this);
+    }
+
+    EXPECT_THAT(stream.damage_for_compositor(this), Eq(damage));
+    EXPECT_THAT(stream.damage_for_compositor(&that), Eq(geom::Rectangles{}));
+
+    stream.lock_compositor_buffer(&that);
+    EXPECT_THAT(stream.damage_for_compositor(&that), Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, reports_the_opaque_region_set_for_the_buffer_a_compositor_has)
+{
+    geom::Region const opaque{geom::Rectangle{{1, 1}, {2, 2}}};
+    geom::Region const other_opaque{geom::Rectangle{{2, 2}, {3, 3}}};
+    int that{0};
+
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    EXPECT_TRUE(stream.opaque_region_for_compositor(this).empty());
+
+    stream.set_opaque_region(opaque);
+    stream.submit_buffer(buffers[1]);
+    stream.lock_compositor_buffer(this);
+    EXPECT_THAT(stream.opaque_region_for_compositor(this), Eq(opaque));
+
+    // Until the next buffer is composited the region of the one on screen still applies
+    stream.set_opaque_region(other_opaque);
+    EXPECT_THAT(stream.opaque_region_for_compositor(this), Eq(opaque));
+    EXPECT_TRUE(stream.opaque_region_for_compositor(&that).empty());
+
+    stream.submit_buffer(buffers[2]);
+    stream.lock_compositor_buffer(this);
+    EXPECT_THAT(stream.opaque_region_for_compositor(this), Eq(other_opaque));
+}
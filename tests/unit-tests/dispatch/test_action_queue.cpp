@@ -23,6 +23,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <thread>
+#include <vector>
+
 namespace mt = mir::test;
 namespace md = mir::dispatch;
 using namespace ::testing;
@@ -79,3 +82,140 @@ TEST(ActionQueue, executes_action_only_once)
 }
 
 
+
+TEST(ActionQueue, executes_every_pending_action_in_order_in_one_dispatch)
+{
+    md::ActionQueue queue;
+
+    std::vector<int> executed;
+
+    for (int i = 0; i != 3; ++i)
+        queue.enqueue([&executed, i](){executed.push_back(i);});
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(executed, ElementsAre(0, 1, 2));
+    EXPECT_FALSE(mt::fd_is_readable(queue.watch_fd()));
+}
+
+TEST(ActionQueue, leaves_actions_enqueued_by_actions_for_the_next_dispatch)
+{
+    md::ActionQueue queue;
+
+    auto count_executed = 0;
+
+    queue.enqueue([&]()
+        {
+            ++count_executed;
+            queue.enqueue([&](){++count_executed;});
+        });
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(count_executed, Eq(1));
+    ASSERT_TRUE(mt::fd_is_readable(queue.watch_fd()));
+
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(count_executed, Eq(2));
+    EXPECT_FALSE(mt::fd_is_readable(queue.watch_fd()));
+}
+
+TEST(ActionQueue, keeps_the_actions_after_one_that_throws)
+{
+    md::ActionQueue queue;
+
+    auto action_executed = false;
+
+    queue.enqueue([](){ throw std::runtime_error{"Oops"}; });
+    queue.enqueue([&](){action_executed = true;});
+
+    EXPECT_THROW(queue.dispatch(md::FdEvent::readable), std::runtime_error);
+    ASSERT_TRUE(mt::fd_is_readable(queue.watch_fd()));
+
+    queue.dispatch(md::FdEvent::readable);
+    EXPECT_TRUE(action_executed);
+}
+
+TEST(ActionQueue, can_be_dispatched_from_within_an_action)
+{
+    md::ActionQueue queue;
+
+    auto inner_executed = false;
+
+    queue.enqueue([&]()
+        {
+            queue.enqueue([&](){inner_executed = true;});
+            queue.dispatch(md::FdEvent::readable);
+        });
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_TRUE(inner_executed);
+    EXPECT_FALSE(mt::fd_is_readable(queue.watch_fd()));
+}
+
+TEST(ActionQueue, dispatch_from_within_an_action_finishes_the_outer_batch_first)
+{
+    md::ActionQueue queue;
+
+    std::vector<char> executed;
+
+    queue.enqueue([&]()
+        {
+            executed.push_back('A');
+            queue.enqueue([&](){executed.push_back('D');});
+            queue.dispatch(md::FdEvent::readable);
+        });
+    queue.enqueue([&](){executed.push_back('B');});
+    queue.enqueue([&](){executed.push_back('C');});
+    queue.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(executed, ElementsAre('A', 'B', 'C', 'D'));
+    EXPECT_FALSE(mt::fd_is_readable(queue.watch_fd()));
+}
+
+TEST(ActionQueue, executes_actions_enqueued_concurrently)
+{
+    md::ActionQueue queue;
+
+    int const producers = 4;
+    int const actions_per_producer = 10000;
+    std::vector<int> executed(producers, 0);
+    bool in_order = true;
+
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer != producers; ++producer)
+    {
+        threads.emplace_back([&, producer]
+            {
+                for (int i = 0; i != actions_per_producer; ++i)
+                {
+                    queue.enqueue([&, producer, i]
+                        {
+                            in_order = in_order && executed[producer] == i;
+                            ++executed[producer];
+                        });
+                }
+            });
+    }
+
+    auto const all_executed = [&]
+        {
+            for (auto const count : executed)
+            {
+                if (count != actions_per_producer)
+                    return false;
+            }
+            return true;
+        };
+
+    while (!all_executed())
+    {
+        if (mt::fd_is_readable(queue.watch_fd()))
+            queue.dispatch(md::FdEvent::readable);
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_FALSE(mt::fd_is_readable(queue.watch_fd()));
+}
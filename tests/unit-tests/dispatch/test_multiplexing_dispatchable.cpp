@@ -490,3 +490,84 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_handles_every_ready_dispatchee_in_one_call)
+{
+    int dispatch_count{0};
+    auto const dispatchee_a = std::make_shared<mt::TestDispatchable>([&dispatch_count]() { ++dispatch_count; });
+    auto const dispatchee_b = std::make_shared<mt::TestDispatchable>([&dispatch_count]() { ++dispatch_count; });
+    auto const dispatchee_c = std::make_shared<mt::TestDispatchable>([&dispatch_count]() { ++dispatch_count; });
+
+    md::MultiplexingDispatchable dispatcher(8);
+    dispatcher.add_watch(dispatchee_a);
+    dispatcher.add_watch(dispatchee_b);
+    dispatcher.add_watch(dispatchee_c);
+
+    dispatchee_a->trigger();
+    dispatchee_b->trigger();
+    dispatchee_c->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(3));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_rearms_sequential_dispatchees)
+{
+    int dispatch_count{0};
+    auto const dispatchee = std::make_shared<mt::TestDispatchable>([&dispatch_count]() { ++dispatch_count; });
+
+    md::MultiplexingDispatchable dispatcher(8);
+    dispatcher.add_watch(dispatchee);
+
+    for (int i = 0; i != 3; ++i)
+    {
+        dispatchee->trigger();
+
+        ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+        dispatcher.dispatch(md::FdEvent::readable);
+    }
+
+    EXPECT_THAT(dispatch_count, testing::Eq(3));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_skips_dispatchees_removed_earlier_in_the_batch)
+{
+    md::MultiplexingDispatchable dispatcher(8);
+
+    std::shared_ptr<mt::TestDispatchable> dispatchees[2];
+    int dispatch_count{0};
+    for (auto& dispatchee : dispatchees)
+    {
+        // Whichever is dispatched first removes the other
+        dispatchee = std::make_shared<mt::TestDispatchable>(
+            [&]()
+            {
+                ++dispatch_count;
+                for (auto const& other : dispatchees)
+                {
+                    if (other != dispatchee)
+                        dispatcher.remove_watch(other);
+                }
+            });
+        dispatcher.add_watch(dispatchee);
+    }
+
+    for (auto const& dispatchee : dispatchees)
+        dispatchee->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(1));
+}
+
+TEST(MultiplexingDispatchableTest, rejects_invalid_batch_sizes)
+{
+    EXPECT_THROW(md::MultiplexingDispatchable(0u), std::invalid_argument);
+    EXPECT_THROW(
+        md::MultiplexingDispatchable(md::MultiplexingDispatchable::max_events_per_dispatch_limit + 1),
+        std::invalid_argument);
+}
@@ -18,12 +18,20 @@
 
 #include "src/server/frontend/published_socket_connector.h"
 #include "src/server/report/null/connector_report.h"
+#include "mir/frontend/connection_creator.h"
 #include "mir/test/current_thread_name.h"
 #include "mir/test/fake_shared.h"
+#include "mir/test/signal.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <map>
+#include <mutex>
+#include <set>
+
+#include <unistd.h>
+
 namespace mt = mir::test;
 
 namespace
@@ -39,6 +47,39 @@ struct StubConnectorReport : mir::report::null::ConnectorReport
     std::string thread_name;
 };
 
+// Notes the thread each session's first read completes on
+struct ThreadRecordingConnectionCreator : mir::frontend::ConnectionCreator
+{
+    explicit ThreadRecordingConnectionCreator(int sessions)
+        : sessions{sessions}
+    {
+    }
+
+    void create_connection_for(
+        std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket,
+        mir::frontend::ConnectionContext const&) override
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const session = created++;
+        boost::asio::async_read(
+            *socket,
+            boost::asio::buffer(&bytes[session], 1),
+            [this, socket, session](boost::system::error_code const&, size_t)
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                threads[session] = std::this_thread::get_id();
+                if (static_cast<int>(threads.size()) == sessions)
+                    all_read.raise();
+            });
+    }
+
+    int const sessions;
+    std::mutex mutex;
+    int created = 0;
+    char bytes[16];
+    std::map<int, std::thread::id> threads;
+    mt::Signal all_read;
+};
 }
 
 TEST(BasicConnector, names_ipc_threads)
@@ -54,3 +95,37 @@ TEST(BasicConnector, names_ipc_threads)
 
     EXPECT_THAT(report.thread_name, Eq("Mir/IPC"));
 }
+
+TEST(BasicConnector, shares_sessions_out_between_ipc_threads)
+{
+    using namespace testing;
+
+    int const threads = 3;
+    int const sessions = 2 * threads;
+    mir::report::null::ConnectorReport report;
+    ThreadRecordingConnectionCreator creator{sessions};
+
+    mir::frontend::BasicConnector connector{mt::fake_shared(creator), mt::fake_shared(report), threads};
+    connector.start();
+
+    std::vector<int> client_fds;
+    for (int i = 0; i != sessions; ++i)
+        client_fds.push_back(connector.client_socket_fd());
+
+    for (auto const fd : client_fds)
+        ASSERT_THAT(write(fd, "x", 1), Eq(1));
+
+    ASSERT_TRUE(creator.all_read.wait_for(std::chrono::seconds{5}));
+    connector.stop();
+
+    std::set<std::thread::id> distinct_threads;
+    for (int i = 0; i != sessions; ++i)
+        distinct_threads.insert(creator.threads[i]);
+
+    EXPECT_THAT(distinct_threads.size(), Eq(threads));
+    for (int i = threads; i != sessions; ++i)
+        EXPECT_THAT(creator.threads[i], Eq(creator.threads[i - threads]));
+
+    for (auto const fd : client_fds)
+        close(fd);
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/frame_tracker.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct FrameTracker : Test
+{
+    // Only ever compared, so they needn't be real resources
+    mf::FrameTracker::Callback callback()
+    {
+        return {reinterpret_cast<wl_resource*>(++next_resource), std::make_shared<bool>(false)};
+    }
+
+    static mg::Frame frame(int64_t msc, std::chrono::nanoseconds ust)
+    {
+        mg::Frame frame;
+        frame.msc = msc;
+        frame.ust = {CLOCK_MONOTONIC, ust};
+        return frame;
+    }
+
+    uintptr_t next_resource{0};
+
+    std::vector<wl_resource*> done;
+    std::vector<std::chrono::nanoseconds> done_times;
+    std::vector<wl_resource*> presented;
+    std::vector<int64_t> presented_mscs;
+    std::vector<wl_resource*> discarded;
+
+    std::shared_ptr<mf::FrameNotifier> const notifier{std::make_shared<mf::FrameNotifier>(nullptr)};
+    mf::FrameTracker tracker{
+        notifier,
+        {
+            [this](wl_resource* callback, std::chrono::nanoseconds time)
+                { done.push_back(callback); done_times.push_back(time); },
+            [this](wl_resource* feedback, mg::Frame const& frame, std::chrono::nanoseconds)
+                { presented.push_back(feedback); presented_mscs.push_back(frame.msc); },
+            [this](wl_resource* feedback) { discarded.push_back(feedback); }
+        }};
+
+    int const output{0};
+    int const other_output{0};
+    mc::DisplayGroupId const group{&output};
+    mc::DisplayGroupId const other_group{&other_output};
+};
+}
+
+TEST_F(FrameTracker, answers_callbacks_when_the_frame_showing_the_buffer_is_presented)
+{
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+
+    auto const commit = tracker.commit({frame_callback}, {feedback});
+    tracker.buffer_consumed(commit, group);
+
+    EXPECT_THAT(done, IsEmpty());
+    EXPECT_THAT(presented, IsEmpty());
+
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    EXPECT_THAT(done, ElementsAre(frame_callback.resource));
+    EXPECT_THAT(done_times, ElementsAre(7s));
+    EXPECT_THAT(presented, ElementsAre(feedback.resource));
+    EXPECT_THAT(presented_mscs, ElementsAre(42));
+    EXPECT_THAT(discarded, IsEmpty());
+}
+
+TEST_F(FrameTracker, only_the_group_that_consumed_the_buffer_presents_it)
+{
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+
+    auto const commit = tracker.commit({frame_callback}, {feedback});
+    tracker.buffer_consumed(commit, group);
+
+    notifier->frame_presented(other_group, frame(100, 5s), 8ms);
+
+    EXPECT_THAT(done, IsEmpty());
+    EXPECT_THAT(presented, IsEmpty());
+
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    EXPECT_THAT(done, ElementsAre(frame_callback.resource));
+    EXPECT_THAT(presented_mscs, ElementsAre(42));
+}
+
+TEST_F(FrameTracker, buffers_consumed_for_an_unknown_group_are_presented_by_any)
+{
+    auto const feedback = callback();
+
+    auto const commit = tracker.commit({}, {feedback});
+    tracker.buffer_consumed(commit, nullptr);
+
+    notifier->frame_presented(other_group, frame(100, 5s), 8ms);
+
+    EXPECT_THAT(presented, ElementsAre(feedback.resource));
+    EXPECT_THAT(presented_mscs, ElementsAre(100));
+}
+
+TEST_F(FrameTracker, feedback_for_a_superseded_commit_is_discarded)
+{
+    auto const superseded_callback = callback();
+    auto const superseded_feedback = callback();
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+
+    tracker.commit({superseded_callback}, {superseded_feedback});
+    auto const commit = tracker.commit({frame_callback}, {feedback});
+    tracker.buffer_consumed(commit, group);
+
+    EXPECT_THAT(discarded, ElementsAre(superseded_feedback.resource));
+
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    // It's still a good time for the superseded commit's client to draw again
+    EXPECT_THAT(done, UnorderedElementsAre(superseded_callback.resource, frame_callback.resource));
+    EXPECT_THAT(presented, ElementsAre(feedback.resource));
+}
+
+TEST_F(FrameTracker, later_commits_wait_for_their_own_buffers)
+{
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+    auto const later_callback = callback();
+    auto const later_feedback = callback();
+
+    auto const commit = tracker.commit({frame_callback}, {feedback});
+    auto const later_commit = tracker.commit({later_callback}, {later_feedback});
+    tracker.buffer_consumed(commit, group);
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    EXPECT_THAT(done, ElementsAre(frame_callback.resource));
+    EXPECT_THAT(presented, ElementsAre(feedback.resource));
+
+    tracker.buffer_consumed(later_commit, group);
+    notifier->frame_presented(group, frame(43, 8s), 16ms);
+
+    EXPECT_THAT(done, ElementsAre(frame_callback.resource, later_callback.resource));
+    EXPECT_THAT(presented, ElementsAre(feedback.resource, later_feedback.resource));
+    EXPECT_THAT(discarded, IsEmpty());
+}
+
+TEST_F(FrameTracker, unmapping_discards_feedback_and_answers_frame_callbacks_now)
+{
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+    auto const unmap_callback = callback();
+    auto const unmap_feedback = callback();
+
+    tracker.commit({frame_callback}, {feedback});
+    tracker.commit({unmap_callback}, {unmap_feedback});
+    tracker.unmapped();
+
+    EXPECT_THAT(done, ElementsAre(frame_callback.resource, unmap_callback.resource));
+    EXPECT_THAT(discarded, ElementsAre(feedback.resource, unmap_feedback.resource));
+
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    EXPECT_THAT(presented, IsEmpty());
+}
+
+TEST_F(FrameTracker, a_commit_without_a_buffer_discards_its_feedback_and_answers_frame_callbacks_now)
+{
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+    auto const empty_callback = callback();
+    auto const empty_feedback = callback();
+
+    auto const commit = tracker.commit({frame_callback}, {feedback});
+    auto const empty_commit = tracker.commit({empty_callback}, {empty_feedback});
+    tracker.nothing_to_draw(empty_commit);
+
+    EXPECT_THAT(done, ElementsAre(frame_callback.resource, empty_callback.resource));
+    EXPECT_THAT(discarded, ElementsAre(empty_feedback.resource));
+
+    // The earlier commit's buffer may still be shown
+    tracker.buffer_consumed(commit, group);
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    EXPECT_THAT(presented, ElementsAre(feedback.resource));
+}
+
+TEST_F(FrameTracker, destroyed_callbacks_are_not_answered)
+{
+    auto const frame_callback = callback();
+    auto const feedback = callback();
+    auto const superseded_feedback = callback();
+
+    tracker.commit({}, {superseded_feedback});
+    auto const commit = tracker.commit({frame_callback}, {feedback});
+    *frame_callback.destroyed = true;
+    *feedback.destroyed = true;
+    *superseded_feedback.destroyed = true;
+
+    tracker.buffer_consumed(commit, group);
+    notifier->frame_presented(group, frame(42, 7s), 16ms);
+
+    EXPECT_THAT(done, IsEmpty());
+    EXPECT_THAT(presented, IsEmpty());
+    EXPECT_THAT(discarded, IsEmpty());
+}
+
+TEST_F(FrameTracker, feedback_still_waiting_for_a_buffer_is_discarded_with_the_tracker)
+{
+    auto const feedback = callback();
+
+    {
+        mf::FrameTracker surface_tracker{
+            notifier,
+            {
+                [](wl_resource*, std::chrono::nanoseconds) {},
+                [](wl_resource*, mg::Frame const&, std::chrono::nanoseconds) {},
+                [this](wl_resource* feedback) { discarded.push_back(feedback); }
+            }};
+
+        surface_tracker.commit({}, {feedback});
+    }
+
+    EXPECT_THAT(discarded, ElementsAre(feedback.resource));
+}
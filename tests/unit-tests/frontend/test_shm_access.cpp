@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/shm_access.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+using namespace testing;
+
+namespace
+{
+// Stands in for a client's wl_shm pool: a file it shares with us and can truncate at will
+struct ClientMemory
+{
+    explicit ClientMemory(size_t size)
+        : size{size}
+    {
+        char name[] = "/tmp/mir-test-shm-XXXXXX";
+        fd = mkstemp(name);
+        unlink(name);
+        if (fd < 0 || ftruncate(fd, size) != 0)
+            throw std::runtime_error{"Failed to create client memory"};
+
+        data = static_cast<unsigned char*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        if (data == MAP_FAILED)
+            throw std::runtime_error{"Failed to map client memory"};
+        memset(data, 0xff, size);
+    }
+
+    ~ClientMemory()
+    {
+        munmap(data, size);
+        close(fd);
+    }
+
+    void truncate()
+    {
+        if (ftruncate(fd, 0) != 0)
+            throw std::runtime_error{"Failed to truncate client memory"};
+    }
+
+    size_t const size;
+    int fd;
+    unsigned char* data;
+};
+
+size_t sum_of(unsigned char const* data, size_t size)
+{
+    // volatile, so that reads whose result we ignore still happen
+    auto const pixels = static_cast<unsigned char const volatile*>(data);
+    return std::accumulate(pixels, pixels + size, size_t{0});
+}
+
+size_t const size = 4 * 4096;
+}
+
+TEST(ShmAccess, reads_the_client_memory)
+{
+    ClientMemory memory{size};
+    size_t sum = 0;
+
+    EXPECT_TRUE(mf::access_client_memory(memory.data, size, [&]{ sum = sum_of(memory.data, size); }));
+    EXPECT_THAT(sum, Eq(0xff * size));
+}
+
+TEST(ShmAccess, reads_zeros_instead_of_crashing_if_the_client_truncates_its_memory)
+{
+    ClientMemory memory{size};
+    memory.truncate();
+    size_t sum = 1;
+
+    EXPECT_FALSE(mf::access_client_memory(memory.data, size, [&]{ sum = sum_of(memory.data, size); }));
+    EXPECT_THAT(sum, Eq(0u));
+}
+
+TEST(ShmAccess, writes_survive_the_client_truncating_its_memory)
+{
+    ClientMemory memory{size};
+    memory.truncate();
+    std::vector<unsigned char> const pixels(size, 0x7f);
+
+    EXPECT_FALSE(mf::access_client_memory(memory.data, size, [&]{ memcpy(memory.data, pixels.data(), size); }));
+}
+
+TEST(ShmAccess, handles_part_of_a_page)
+{
+    ClientMemory memory{size};
+    memory.truncate();
+    auto const offset = 100;
+    auto const length = 2 * 4096;
+    size_t sum = 1;
+
+    EXPECT_FALSE(mf::access_client_memory(
+        memory.data + offset, length, [&]{ sum = sum_of(memory.data + offset, length); }));
+    EXPECT_THAT(sum, Eq(0u));
+}
+
+TEST(ShmAccess, threads_see_only_their_own_faults)
+{
+    ClientMemory good{size};
+    ClientMemory truncated{size};
+    truncated.truncate();
+
+    bool good_read{false};
+    bool truncated_read{true};
+
+    std::thread reader{
+        [&]
+        {
+            good_read = mf::access_client_memory(good.data, size, [&]{ sum_of(good.data, size); });
+        }};
+    truncated_read = mf::access_client_memory(truncated.data, size, [&]{ sum_of(truncated.data, size); });
+    reader.join();
+
+    EXPECT_TRUE(good_read);
+    EXPECT_FALSE(truncated_read);
+}
+
+TEST(ShmAccess, leaves_other_bus_errors_fatal)
+{
+    EXPECT_DEATH(
+        {
+            ClientMemory memory{size};
+            memory.truncate();
+
+            mf::access_client_memory(memory.data, 4096, []{});
+            sum_of(memory.data, size);
+        },
+        "");
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/shm_staging_pool.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+using namespace testing;
+
+TEST(ShmStagingPool, reuses_released_memory_of_the_same_size)
+{
+    auto const pool = std::make_shared<mf::ShmStagingPool>(4);
+
+    auto first = pool->acquire(1024);
+    auto const first_memory = first.get();
+    first.reset();
+
+    EXPECT_THAT(pool->free_blocks(), Eq(1u));
+    EXPECT_THAT(pool->acquire(1024).get(), Eq(first_memory));
+}
+
+TEST(ShmStagingPool, does_not_hand_out_memory_that_is_too_small_or_much_too_big)
+{
+    auto const pool = std::make_shared<mf::ShmStagingPool>(4);
+
+    pool->acquire(1024);
+
+    auto const bigger = pool->acquire(2048);
+    auto const smaller = pool->acquire(100);
+
+    EXPECT_THAT(pool->free_blocks(), Eq(1u));
+}
+
+TEST(ShmStagingPool, keeps_at_most_the_configured_number_of_free_blocks)
+{
+    auto const pool = std::make_shared<mf::ShmStagingPool>(2);
+
+    {
+        auto const a = pool->acquire(16);
+        auto const b = pool->acquire(16);
+        auto const c = pool->acquire(16);
+    }
+
+    EXPECT_THAT(pool->free_blocks(), Eq(2u));
+}
+
+TEST(ShmStagingPool, memory_can_outlive_the_pool)
+{
+    auto pool = std::make_shared<mf::ShmStagingPool>(2);
+    auto const memory = pool->acquire(16);
+
+    pool.reset();
+    memory.get()[15] = 0xff;
+
+    EXPECT_THAT(memory.get()[15], Eq(0xff));
+}
@@ -113,6 +113,7 @@ struct StubReceiver : mfd::MessageReceiver
     std::vector<mir::Fd> some_fds;
 
     MOCK_METHOD0(client_creds, mf::SessionCredentials());
+    MOCK_METHOD0(client_accepts_large_results, void());
 };
 
 struct MockProcessor : public mfd::MessageProcessor
@@ -138,7 +139,7 @@ struct SocketConnection : public Test
         connection.read_next_message();
     }
 
-    void fake_receiving_message()
+    void fake_receiving_message(bool large_results = false)
     {
         int const header_size = 2;
         char buffer[512];
@@ -148,6 +149,8 @@ struct SocketConnection : public Test
         invocation.set_parameters(buffer, 0);
         invocation.set_protocol_version(mir::protobuf::current_protocol_version());
         invocation.set_side_channel_fds(2);
+        if (large_results)
+            invocation.set_large_results(true);
         auto const body_size = invocation.ByteSize();
         buffer[0] = body_size / 0x100;
         buffer[1] = body_size % 0x100;
@@ -206,3 +209,11 @@ TEST_F(SocketConnection, receives_and_dispatches_fds)
     EXPECT_CALL(mock_processor, dispatch(_, ContainerEq(fds)));
     fake_receiving_message();
 }
+
+TEST_F(SocketConnection, tells_receiver_when_client_accepts_large_results)
+{
+    EXPECT_CALL(stub_receiver, client_accepts_large_results()).Times(1);
+
+    fake_receiving_message();
+    fake_receiving_message(true);
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/socket_messenger.h"
+#include "mir/fd_socket_transmission.h"
+#include "mir/fd.h"
+
+#include "mir_protobuf_wire.pb.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace mf = mir::frontend;
+namespace mfd = mir::frontend::detail;
+namespace ba = boost::asio;
+
+using namespace testing;
+
+namespace
+{
+struct SocketMessenger : Test
+{
+    void create_messenger(size_t max_queued_bytes = mfd::SocketMessenger::default_max_queued_bytes)
+    {
+        int socket_fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds) < 0)
+            throw std::system_error(errno, std::system_category());
+
+        client_fd = mir::Fd{socket_fds[0]};
+        auto const socket = std::make_shared<ba::local::stream_protocol::socket>(
+            io_service, ba::local::stream_protocol(), socket_fds[1]);
+        messenger = std::make_shared<mfd::SocketMessenger>(socket, max_queued_bytes);
+    }
+
+    void SetUp() override
+    {
+        create_messenger();
+    }
+
+    void TearDown() override
+    {
+        io_service.stop();
+        if (io_thread.joinable())
+            io_thread.join();
+    }
+
+    void start_io_service()
+    {
+        io_thread = std::thread{[this] { io_service.run(); }};
+    }
+
+    void send(std::string const& message, mf::FdSets const& fds = {})
+    {
+        messenger->send(message.data(), message.size(), fds);
+    }
+
+    bool read_exactly(void* buffer, size_t size)
+    {
+        return recv(client_fd, buffer, size, MSG_WAITALL) == static_cast<ssize_t>(size);
+    }
+
+    std::string read_message()
+    {
+        unsigned char header[2];
+        if (!read_exactly(header, sizeof header))
+            throw std::runtime_error("Failed to read message header");
+
+        std::string message((header[0] << 8) + header[1], '\0');
+        if (!read_exactly(&message[0], message.size()))
+            throw std::runtime_error("Failed to read message body");
+        return message;
+    }
+
+    std::vector<mir::Fd> read_fds(size_t count)
+    {
+        std::vector<mir::Fd> fds(count);
+        char dummy;
+        mir::receive_data(client_fd, &dummy, 1, fds);
+        return fds;
+    }
+
+    mir::Fd a_fd()
+    {
+        return mir::Fd{dup(STDERR_FILENO)};
+    }
+
+    ba::io_service io_service;
+    ba::io_service::work work{io_service};
+    std::thread io_thread;
+    mir::Fd client_fd;
+    std::shared_ptr<mfd::SocketMessenger> messenger;
+};
+}
+
+TEST_F(SocketMessenger, sends_messages_followed_by_their_fds)
+{
+    send("hello", {{a_fd()}, {a_fd(), a_fd()}});
+    send("world");
+
+    EXPECT_THAT(read_message(), Eq("hello"));
+    EXPECT_THAT(read_fds(1).size(), Eq(1u));
+    EXPECT_THAT(read_fds(2).size(), Eq(2u));
+    EXPECT_THAT(read_message(), Eq("world"));
+}
+
+TEST_F(SocketMessenger, does_not_block_when_client_is_not_reading)
+{
+    std::string const payload(1000, 'x');
+    int const messages = 1000;   // Much more than fits in the socket buffer
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i != messages; ++i)
+        send(std::to_string(i) + payload);
+
+    EXPECT_THAT(std::chrono::steady_clock::now() - start, Lt(std::chrono::seconds{1}));
+}
+
+TEST_F(SocketMessenger, queued_messages_and_fds_arrive_in_order)
+{
+    std::string const payload(1000, 'x');
+    int const messages = 1000;
+
+    for (int i = 0; i != messages; ++i)
+    {
+        mf::FdSets fds;
+        if (i % 100 == 0)
+            fds.push_back({a_fd()});
+        send(std::to_string(i) + payload, fds);
+    }
+
+    start_io_service();
+
+    for (int i = 0; i != messages; ++i)
+    {
+        ASSERT_THAT(read_message(), Eq(std::to_string(i) + payload));
+        if (i % 100 == 0)
+        {
+            ASSERT_THAT(read_fds(1)[0], Ge(0));
+        }
+    }
+}
+
+TEST_F(SocketMessenger, disconnects_client_that_lets_too_much_back_up)
+{
+    create_messenger(16*1024);
+    std::string const payload(1000, 'x');
+
+    EXPECT_THROW(
+        for (int i = 0; i != 1000; ++i)
+            send(payload);,
+        std::runtime_error);
+
+    // The client can read what was sent before it was disconnected
+    char buffer[1024];
+    ssize_t result;
+    while ((result = recv(client_fd, buffer, sizeof buffer, 0)) > 0)
+        ;
+    EXPECT_THAT(result, Eq(0));
+}
+
+TEST_F(SocketMessenger, refuses_messages_too_large_to_frame_unless_client_accepts_them)
+{
+    std::string const message(mfd::SocketMessenger::max_inline_size + 1, 'x');
+
+    EXPECT_THROW(send(message), std::runtime_error);
+}
+
+TEST_F(SocketMessenger, sends_messages_too_large_to_frame_out_of_line)
+{
+    std::string const message(mfd::SocketMessenger::max_inline_size * 3, 'x');
+
+    messenger->client_accepts_large_results();
+    send(message, {{a_fd()}});
+
+    mir::protobuf::wire::Result placeholder;
+    ASSERT_TRUE(placeholder.ParseFromString(read_message()));
+    ASSERT_THAT(placeholder.out_of_line_size(), Eq(message.size()));
+
+    auto const payload = read_fds(1)[0];
+    auto const mapping = mmap(nullptr, message.size(), PROT_READ, MAP_PRIVATE, payload, 0);
+    ASSERT_THAT(mapping, Ne(MAP_FAILED));
+    EXPECT_THAT(std::string(static_cast<char const*>(mapping), message.size()), Eq(message));
+    munmap(mapping, message.size());
+
+    EXPECT_THAT(read_fds(1).size(), Eq(1u));
+}
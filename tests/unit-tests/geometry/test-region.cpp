@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace mir::geometry;
+using namespace testing;
+
+TEST(Region, default_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.rectangles(), IsEmpty());
+    EXPECT_EQ(Rectangle{}, region.bounding_rectangle());
+}
+
+TEST(Region, empty_rectangle_makes_empty_region)
+{
+    EXPECT_TRUE(Region{Rectangle({5, 5}, {0, 10})}.empty());
+    EXPECT_TRUE(Region{Rectangle({5, 5}, {10, 0})}.empty());
+}
+
+TEST(Region, overlapping_rectangles_are_stored_disjoint)
+{
+    Region const region{{{0, 0}, {10, 10}}, {{5, 5}, {10, 10}}};
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {10, 5}},
+        Rectangle{{0, 5}, {15, 5}},
+        Rectangle{{5, 10}, {10, 5}}));
+}
+
+TEST(Region, adjacent_rectangles_coalesce)
+{
+    Region side_by_side{Rectangle{{0, 0}, {10, 10}}};
+    side_by_side.unite(Rectangle{{10, 0}, {10, 10}});
+
+    Region stacked{Rectangle{{0, 0}, {10, 10}}};
+    stacked.unite(Rectangle{{0, 10}, {10, 10}});
+
+    EXPECT_THAT(side_by_side.rectangles(), ElementsAre(Rectangle{{0, 0}, {20, 10}}));
+    EXPECT_THAT(stacked.rectangles(), ElementsAre(Rectangle{{0, 0}, {10, 20}}));
+}
+
+TEST(Region, equality_does_not_depend_on_construction_order)
+{
+    Region a;
+    a.unite(Rectangle{{0, 0}, {10, 20}});
+    a.unite(Rectangle{{10, 0}, {10, 20}});
+
+    Region b;
+    b.unite(Rectangle{{0, 10}, {20, 10}});
+    b.unite(Rectangle{{0, 0}, {20, 10}});
+
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(Region{Rectangle({0, 0}, {20, 20})}, a);
+}
+
+TEST(Region, contains_a_rectangle_covered_only_by_several_pieces)
+{
+    Region const tiled{{{0, 0}, {100, 200}}, {{100, 0}, {100, 100}}, {{100, 100}, {100, 100}}};
+
+    EXPECT_TRUE(tiled.contains(Rectangle{{50, 50}, {100, 100}}));
+    EXPECT_TRUE(tiled.contains(Rectangle{{0, 0}, {200, 200}}));
+    EXPECT_FALSE(tiled.contains(Rectangle{{150, 150}, {100, 10}}));
+    EXPECT_FALSE(tiled.contains(Rectangle{{0, 190}, {10, 20}}));
+}
+
+TEST(Region, does_not_contain_a_rectangle_across_a_gap)
+{
+    Region const region{{{0, 0}, {100, 50}}, {{0, 51}, {100, 50}}};
+
+    EXPECT_FALSE(region.contains(Rectangle{{10, 40}, {10, 20}}));
+    EXPECT_TRUE(region.contains(Rectangle{{10, 40}, {10, 10}}));
+    EXPECT_FALSE(region.contains(Point{10, 50}));
+    EXPECT_TRUE(region.contains(Point{10, 51}));
+}
+
+TEST(Region, subtract_punches_a_hole)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_FALSE(region.contains(Point{15, 15}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{10, 10}, {10, 10}}));
+    EXPECT_TRUE(region.overlaps(Rectangle{{10, 10}, {11, 10}}));
+}
+
+TEST(Region, nothing_overlaps_an_empty_rectangle)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+
+    EXPECT_FALSE(region.overlaps(Rectangle{{10, 10}, {0, 10}}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{10, 10}, {10, 0}}));
+}
+
+TEST(Region, subtracting_everything_leaves_nothing)
+{
+    Region region{{{0, 0}, {10, 10}}, {{20, 20}, {10, 10}}};
+    region.subtract(Rectangle{{-5, -5}, {50, 50}});
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, intersect)
+{
+    Region region{{{0, 0}, {10, 10}}, {{20, 0}, {10, 10}}};
+    region.intersect(Rectangle{{5, 5}, {20, 20}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{5, 5}, {5, 5}},
+        Rectangle{{20, 5}, {5, 5}}));
+
+    region.intersect(Region{});
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, translate_and_bounding_rectangle)
+{
+    Region region{{{0, 0}, {10, 10}}, {{20, 30}, {10, 10}}};
+    region.translate({-5, 5});
+
+    EXPECT_EQ((Rectangle{{-5, 5}, {30, 40}}), region.bounding_rectangle());
+    EXPECT_TRUE(region.contains(Rectangle{{-5, 5}, {10, 10}}));
+}
@@ -21,14 +21,23 @@
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_renderable.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/renderer/gl/incremental_texture_source.h"
 #include <gtest/gtest.h>
 
 namespace mtd=mir::test::doubles;
 namespace mgl=mir::gl;
 namespace mg=mir::graphics;
+namespace geom=mir::geometry;
 
 namespace
 {
+struct MockIncrementalGLBuffer : mtd::MockGLBuffer,
+                                 mir::renderer::gl::IncrementalTextureSource
+{
+    using MockGLBuffer::MockGLBuffer;
+
+    MOCK_METHOD1(bind_damaged, void(geom::Rectangles const&));
+};
 
 class RecentlyUsedCache : public testing::Test
 {
@@ -140,3 +149,80 @@ TEST_F(RecentlyUsedCache, invalidated_buffers_are_reloaded)
     cache.invalidate();
     cache.load(*renderable);
 }
+
+TEST_F(RecentlyUsedCache, uploads_only_damage_of_a_new_buffer_of_the_same_size)
+{
+    using namespace testing;
+    geom::Size const size{640, 480};
+    geom::Rectangles const damage{{{10, 20}, {30, 40}}};
+    auto const buffer = std::make_shared<NiceMock<MockIncrementalGLBuffer>>(
+        size, geom::Stride{640 * 4}, mir_pixel_format_argb_8888);
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(buffer));
+    ON_CALL(*renderable, damage())
+        .WillByDefault(Return(damage));
+
+    EXPECT_CALL(*buffer, id())
+        .WillOnce(Return(mg::BufferID(1)))
+        .WillOnce(Return(mg::BufferID(2)));
+    EXPECT_CALL(*buffer, bind())
+        .Times(1);
+    EXPECT_CALL(*buffer, bind_damaged(damage))
+        .Times(1);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.load(*renderable);
+    cache.drop_unused();
+}
+
+TEST_F(RecentlyUsedCache, uploads_whole_buffer_when_the_size_changes)
+{
+    using namespace testing;
+    auto const buffer = std::make_shared<NiceMock<MockIncrementalGLBuffer>>(
+        geom::Size{640, 480}, geom::Stride{640 * 4}, mir_pixel_format_argb_8888);
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(buffer));
+
+    EXPECT_CALL(*buffer, id())
+        .WillOnce(Return(mg::BufferID(1)))
+        .WillOnce(Return(mg::BufferID(2)));
+    EXPECT_CALL(*buffer, size())
+        .WillOnce(Return(geom::Size{640, 480}))
+        .WillOnce(Return(geom::Size{800, 600}));
+    EXPECT_CALL(*buffer, bind())
+        .Times(2);
+    EXPECT_CALL(*buffer, bind_damaged(_))
+        .Times(0);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.load(*renderable);
+    cache.drop_unused();
+}
+
+TEST_F(RecentlyUsedCache, uploads_whole_buffer_after_invalidation)
+{
+    using namespace testing;
+    auto const buffer = std::make_shared<NiceMock<MockIncrementalGLBuffer>>(
+        geom::Size{640, 480}, geom::Stride{640 * 4}, mir_pixel_format_argb_8888);
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(buffer));
+
+    EXPECT_CALL(*buffer, id())
+        .WillOnce(Return(mg::BufferID(1)))
+        .WillOnce(Return(mg::BufferID(2)));
+    EXPECT_CALL(*buffer, bind())
+        .Times(2);
+    EXPECT_CALL(*buffer, bind_damaged(_))
+        .Times(0);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.invalidate();
+    cache.load(*renderable);
+    cache.drop_unused();
+}
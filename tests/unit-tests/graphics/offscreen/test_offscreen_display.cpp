@@ -147,6 +147,32 @@ TEST_F(OffscreenDisplayTest, makes_fbo_current_rendering_target)
     });
 }
 
+TEST_F(OffscreenDisplayTest, creates_fbos_in_the_display_buffer_contexts)
+{   // Framebuffer objects aren't shared between contexts
+    using namespace ::testing;
+
+    intptr_t contexts{0};
+    ON_CALL(mock_egl, eglCreateContext(_,_,_,_))
+        .WillByDefault(WithoutArgs(Invoke(
+            [&] { return reinterpret_cast<EGLContext>(++contexts); })));
+
+    std::vector<EGLContext> fbo_contexts;
+    ON_CALL(mock_gl, glGenFramebuffers(1,_))
+        .WillByDefault(WithoutArgs(Invoke(
+            [&] { fbo_contexts.push_back(eglGetCurrentContext()); })));
+
+    mgo::Display display{
+        native_display,
+        std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
+        mr::null_display_report()};
+
+    // The first context made is the shared one, which stays current
+    auto const shared_context = reinterpret_cast<EGLContext>(intptr_t{1});
+    EXPECT_THAT(fbo_contexts, Not(IsEmpty()));
+    EXPECT_THAT(fbo_contexts, Each(AllOf(Ne(shared_context), Ne(EGL_NO_CONTEXT))));
+    EXPECT_THAT(eglGetCurrentContext(), Eq(shared_context));
+}
+
 TEST_F(OffscreenDisplayTest, restores_previous_state_on_fbo_setup_failure)
 {
     using namespace ::testing;
@@ -0,0 +1,117 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/cursor_image_cache.h"
+#include "mir/graphics/cursor_image.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct StubCursorImage : mg::CursorImage
+{
+    StubCursorImage(geom::Size size, uint32_t fill)
+        : size_{size},
+          pixels(size.width.as_uint32_t() * size.height.as_uint32_t(), fill)
+    {
+    }
+
+    void const* as_argb_8888() const override { return pixels.data(); }
+    geom::Size size() const override { return size_; }
+    geom::Displacement hotspot() const override { return {}; }
+
+    geom::Size const size_;
+    std::vector<uint32_t> pixels;
+};
+
+struct CursorImageCache : Test
+{
+    size_t const capacity{3};
+    mg::CursorImageCache cache{capacity};
+
+    geom::Size const size{24, 24};
+};
+}
+
+TEST_F(CursorImageCache, copies_the_image)
+{
+    StubCursorImage const image{size, 0xff00ff00};
+
+    auto const pixels = cache.pixels_of(image);
+
+    EXPECT_THAT(pixels->size, Eq(size));
+    ASSERT_THAT(pixels->argb8888.size(), Eq(image.pixels.size() * 4));
+    EXPECT_THAT(memcmp(pixels->argb8888.data(), image.pixels.data(), pixels->argb8888.size()), Eq(0));
+}
+
+TEST_F(CursorImageCache, gives_the_same_pixels_for_images_with_the_same_pixels)
+{
+    StubCursorImage const image{size, 0xff00ff00};
+    StubCursorImage const same_image{size, 0xff00ff00};
+
+    EXPECT_THAT(cache.pixels_of(same_image), Eq(cache.pixels_of(image)));
+}
+
+TEST_F(CursorImageCache, gives_different_pixels_for_different_images)
+{
+    StubCursorImage const image{size, 0xff00ff00};
+    StubCursorImage const other_colour{size, 0xffff0000};
+    StubCursorImage const other_size{{12, 48}, 0xff00ff00};
+
+    auto const pixels = cache.pixels_of(image);
+
+    EXPECT_THAT(cache.pixels_of(other_colour), Ne(pixels));
+    EXPECT_THAT(cache.pixels_of(other_size), Ne(pixels));
+}
+
+TEST_F(CursorImageCache, notices_when_an_image_changes)
+{
+    StubCursorImage image{size, 0xff00ff00};
+
+    auto const pixels = cache.pixels_of(image);
+    image.pixels.back() = 0xffffffff;
+
+    EXPECT_THAT(cache.pixels_of(image), Ne(pixels));
+}
+
+TEST_F(CursorImageCache, forgets_the_least_recently_shown_image)
+{
+    std::vector<std::unique_ptr<StubCursorImage>> images;
+    for (uint32_t i = 0; i != capacity + 1; ++i)
+        images.push_back(std::make_unique<StubCursorImage>(size, i));
+
+    auto const first = cache.pixels_of(*images[0]);
+    auto const second = cache.pixels_of(*images[1]);
+    for (size_t i = 2; i != capacity; ++i)
+        cache.pixels_of(*images[i]);
+
+    // Showing the first again makes the second the least recently shown
+    cache.pixels_of(*images[0]);
+    cache.pixels_of(*images[capacity]);
+
+    EXPECT_THAT(cache.pixels_of(*images[0]), Eq(first));
+    EXPECT_THAT(cache.pixels_of(*images[1]), Ne(second));
+}
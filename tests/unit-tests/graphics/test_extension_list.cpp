@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/extension_list.h"
+
+#include <gtest/gtest.h>
+
+namespace mg = mir::graphics;
+
+TEST(ExtensionList, finds_extensions_anywhere_in_the_list)
+{
+    char const* const extensions = "EGL_KHR_image EGL_EXT_buffer_age EGL_KHR_fence_sync";
+
+    EXPECT_TRUE(mg::has_extension(extensions, "EGL_KHR_image"));
+    EXPECT_TRUE(mg::has_extension(extensions, "EGL_EXT_buffer_age"));
+    EXPECT_TRUE(mg::has_extension(extensions, "EGL_KHR_fence_sync"));
+    EXPECT_FALSE(mg::has_extension(extensions, "EGL_KHR_wait_sync"));
+}
+
+TEST(ExtensionList, matches_only_whole_names)
+{
+    EXPECT_FALSE(mg::has_extension("EGL_EXT_buffer_age_foo", "EGL_EXT_buffer_age"));
+    EXPECT_FALSE(mg::has_extension("FOO_EGL_EXT_buffer_age", "EGL_EXT_buffer_age"));
+    EXPECT_FALSE(mg::has_extension("EGL_EXT_buffer", "EGL_EXT_buffer_age"));
+    EXPECT_FALSE(mg::has_extension("EGL_KHR_image", ""));
+}
+
+TEST(ExtensionList, finds_a_name_after_a_longer_one_it_prefixes)
+{
+    EXPECT_TRUE(mg::has_extension("EGL_EXT_buffer_age_foo EGL_EXT_buffer_age", "EGL_EXT_buffer_age"));
+    EXPECT_TRUE(mg::has_extension("GL_EXT_unpack_subimage2 GL_EXT_unpack_subimage", "GL_EXT_unpack_subimage"));
+}
+
+TEST(ExtensionList, a_null_list_has_no_extensions)
+{
+    EXPECT_FALSE(mg::has_extension(nullptr, "EGL_EXT_buffer_age"));
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_kernels.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace mgp = mir::graphics::pixel;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+// Sizes that leave a few pixels over from every vector width
+size_t const count = 37;
+geom::Size const size{13, 7};
+int const padding = 3;
+
+std::vector<uint32_t> numbered(size_t n)
+{
+    std::vector<uint32_t> pixels(n);
+    for (size_t i = 0; i != n; ++i)
+        pixels[i] = 0x01020304 * (i + 1);
+    return pixels;
+}
+
+uint32_t swapped(uint32_t p)
+{
+    return (p & 0xff00ff00) | ((p & 0xff) << 16) | ((p >> 16) & 0xff);
+}
+
+struct PixelKernels : TestWithParam<mgp::InstructionSet>
+{
+    void SetUp() override
+    {
+        if (!mgp::supports(GetParam()))
+            return;
+
+        mgp::use_instruction_set(GetParam());
+        supported = true;
+    }
+
+    void TearDown() override
+    {
+        mgp::use_instruction_set(original);
+    }
+
+    mgp::InstructionSet const original{mgp::instruction_set()};
+    bool supported{false};
+};
+}
+
+TEST_P(PixelKernels, swaps_red_and_blue)
+{
+    if (!supported) return;
+
+    auto const src = numbered(count);
+    std::vector<uint32_t> dst(count);
+
+    EXPECT_TRUE(mgp::convert_row(mir_pixel_format_abgr_8888, src.data(), mir_pixel_format_argb_8888, dst.data(), count));
+
+    for (size_t i = 0; i != count; ++i)
+        EXPECT_THAT(dst[i], Eq(swapped(src[i]))) << "pixel " << i;
+}
+
+TEST_P(PixelKernels, converts_in_place)
+{
+    if (!supported) return;
+
+    auto const src = numbered(count);
+    auto pixels = src;
+
+    EXPECT_TRUE(mgp::convert_row(mir_pixel_format_argb_8888, pixels.data(), mir_pixel_format_abgr_8888, pixels.data(), count));
+
+    for (size_t i = 0; i != count; ++i)
+        EXPECT_THAT(pixels[i], Eq(swapped(src[i]))) << "pixel " << i;
+}
+
+TEST_P(PixelKernels, pixels_without_alpha_become_opaque)
+{
+    if (!supported) return;
+
+    auto const src = numbered(count);
+    std::vector<uint32_t> same_order(count);
+    std::vector<uint32_t> other_order(count);
+
+    mgp::convert_row(mir_pixel_format_xrgb_8888, src.data(), mir_pixel_format_argb_8888, same_order.data(), count);
+    mgp::convert_row(mir_pixel_format_xrgb_8888, src.data(), mir_pixel_format_abgr_8888, other_order.data(), count);
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        EXPECT_THAT(same_order[i], Eq(src[i] | 0xff000000)) << "pixel " << i;
+        EXPECT_THAT(other_order[i], Eq(swapped(src[i]) | 0xff000000)) << "pixel " << i;
+    }
+}
+
+TEST_P(PixelKernels, expands_rgb565)
+{
+    if (!supported) return;
+
+    std::vector<uint16_t> src(count, 0x0000);
+    src[0] = 0xffff;
+    src[1] = 0xf800;
+    src[2] = 0x07e0;
+    src[3] = 0x001f;
+    src[count - 1] = 0x8410;    // Just over half of each
+    std::vector<uint32_t> argb(count);
+    std::vector<uint32_t> abgr(count);
+
+    EXPECT_TRUE(mgp::convert_row(mir_pixel_format_rgb_565, src.data(), mir_pixel_format_argb_8888, argb.data(), count));
+    EXPECT_TRUE(mgp::convert_row(mir_pixel_format_rgb_565, src.data(), mir_pixel_format_abgr_8888, abgr.data(), count));
+
+    EXPECT_THAT(argb[0], Eq(0xffffffffu));
+    EXPECT_THAT(argb[1], Eq(0xffff0000u));
+    EXPECT_THAT(argb[2], Eq(0xff00ff00u));
+    EXPECT_THAT(argb[3], Eq(0xff0000ffu));
+    EXPECT_THAT(argb[4], Eq(0xff000000u));
+    EXPECT_THAT(argb[count - 1], Eq(0xff848284u));
+    EXPECT_THAT(abgr[1], Eq(0xff0000ffu));
+    EXPECT_THAT(abgr[3], Eq(0xffff0000u));
+}
+
+TEST_P(PixelKernels, refuses_conversions_it_cannot_do)
+{
+    if (!supported) return;
+
+    std::vector<uint32_t> src(count, 0x12345678);
+    std::vector<uint32_t> dst(count, 0);
+
+    EXPECT_FALSE(mgp::convert_row(mir_pixel_format_bgr_888, src.data(), mir_pixel_format_argb_8888, dst.data(), 4));
+    EXPECT_FALSE(mgp::convert_row(mir_pixel_format_argb_8888, src.data(), mir_pixel_format_rgb_565, dst.data(), 4));
+    EXPECT_THAT(dst, Each(Eq(0u)));
+}
+
+TEST_P(PixelKernels, flips_vertically_while_converting)
+{
+    if (!supported) return;
+
+    geom::Stride const stride{(size.width.as_int() + padding) * 4};
+    size_t const row_pixels = stride.as_int() / 4;
+    auto const src = numbered(row_pixels * size.height.as_int());
+    auto pixels = src;
+
+    mgp::flip_vertically(pixels.data(), size, stride, mir_pixel_format_abgr_8888, mir_pixel_format_argb_8888);
+
+    for (int y = 0; y != size.height.as_int(); ++y)
+    {
+        auto const flipped_y = size.height.as_int() - 1 - y;
+        for (size_t x = 0; x != row_pixels; ++x)
+        {
+            // The padding is left alone
+            auto const expected = x < size.width.as_uint32_t() ?
+                swapped(src[flipped_y * row_pixels + x]) :
+                src[y * row_pixels + x];
+            EXPECT_THAT(pixels[y * row_pixels + x], Eq(expected)) << "at " << x << ", " << y;
+        }
+    }
+}
+
+TEST_P(PixelKernels, rotates_as_for_output_orientation)
+{
+    if (!supported) return;
+
+    for (geom::Size const image : {size, geom::Size{64, 64}, geom::Size{21, 40}})
+    {
+        int const width = image.width.as_int();
+        int const height = image.height.as_int();
+        int const src_row = width + padding;
+        int const dst_row = std::max(width, height) + padding;
+        auto const src = numbered(src_row * height);
+
+        for (auto const orientation :
+             {mir_orientation_normal, mir_orientation_left, mir_orientation_inverted, mir_orientation_right})
+        {
+            bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
+            int const rows = sideways ? width : height;
+            int const cols = sideways ? height : width;
+            std::vector<uint32_t> dst(dst_row * rows, 0);
+
+            mgp::rotate(src.data(), geom::Stride{src_row * 4}, image, dst.data(), geom::Stride{dst_row * 4}, orientation);
+
+            for (int row = 0; row != rows; ++row)
+            {
+                for (int col = 0; col != cols; ++col)
+                {
+                    int x = col, y = row;
+                    switch (orientation)
+                    {
+                    case mir_orientation_left:     x = width - 1 - row; y = col; break;
+                    case mir_orientation_inverted: x = width - 1 - col; y = height - 1 - row; break;
+                    case mir_orientation_right:    x = row; y = height - 1 - col; break;
+                    default: break;
+                    }
+
+                    ASSERT_THAT(dst[row * dst_row + col], Eq(src[y * src_row + x]))
+                        << width << "x" << height << " rotated " << orientation
+                        << " at " << col << ", " << row;
+                }
+
+                for (int col = cols; col != dst_row; ++col)
+                    ASSERT_THAT(dst[row * dst_row + col], Eq(0u));
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    InstructionSets,
+    PixelKernels,
+    Values(mgp::InstructionSet::scalar, mgp::InstructionSet::sse2, mgp::InstructionSet::avx2, mgp::InstructionSet::neon));
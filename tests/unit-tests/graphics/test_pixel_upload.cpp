@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_upload.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Size const size{100, 50};
+int const bpp = 4;
+geom::Stride const packed{100 * bpp};
+geom::Stride const padded{128 * bpp};
+}
+
+TEST(PixelUpload, uploads_nothing_without_damage)
+{
+    EXPECT_TRUE(mg::pixel_uploads_for({}, size, packed, bpp, true).empty());
+    EXPECT_TRUE(mg::pixel_uploads_for({{{200, 200}, {10, 10}}}, size, packed, bpp, true).empty());
+}
+
+TEST(PixelUpload, uploads_damaged_rectangles_clipped_to_the_buffer_with_row_length)
+{
+    auto const uploads = mg::pixel_uploads_for(
+        {{{10, 5}, {20, 4}}, {{90, 45}, {20, 20}}}, size, padded, bpp, true);
+
+    ASSERT_EQ(2u, uploads.size());
+    EXPECT_EQ(geom::Rectangle({10, 5}, {20, 4}), uploads[0].area);
+    EXPECT_EQ(5u * padded.as_int() + 10 * bpp, uploads[0].offset);
+    EXPECT_EQ(geom::Rectangle({90, 45}, {10, 5}), uploads[1].area);
+    EXPECT_EQ(45u * padded.as_int() + 90 * bpp, uploads[1].offset);
+}
+
+TEST(PixelUpload, merges_damage_into_whole_rows_without_row_length)
+{
+    auto const uploads = mg::pixel_uploads_for(
+        {{{10, 5}, {20, 4}}, {{50, 8}, {1, 4}}, {{0, 30}, {1, 1}}}, size, packed, bpp, false);
+
+    ASSERT_EQ(2u, uploads.size());
+    EXPECT_EQ(geom::Rectangle({0, 5}, {100, 7}), uploads[0].area);
+    EXPECT_EQ(5u * packed.as_int(), uploads[0].offset);
+    EXPECT_EQ(geom::Rectangle({0, 30}, {100, 1}), uploads[1].area);
+    EXPECT_EQ(30u * packed.as_int(), uploads[1].offset);
+}
+
+TEST(PixelUpload, uploads_whole_buffer_when_rows_are_padded_and_there_is_no_row_length)
+{
+    auto const uploads = mg::pixel_uploads_for({{{10, 5}, {20, 4}}}, size, padded, bpp, false);
+
+    ASSERT_EQ(1u, uploads.size());
+    EXPECT_EQ(geom::Rectangle({0, 0}, size), uploads[0].area);
+    EXPECT_EQ(0u, uploads[0].offset);
+}
+
+TEST(PixelUpload, uploads_bounding_rectangle_of_fragmented_damage)
+{
+    geom::Rectangles damage;
+    for (int i = 0; i != 20; ++i)
+        damage.add({{i * 2, i}, {1, 1}});
+
+    auto const uploads = mg::pixel_uploads_for(damage, size, packed, bpp, true);
+
+    ASSERT_EQ(1u, uploads.size());
+    EXPECT_EQ(geom::Rectangle({0, 0}, {39, 20}), uploads[0].area);
+}
@@ -26,6 +26,8 @@
 #include <GLES2/gl2ext.h>
 #include <endian.h>
 
+#include <vector>
+
 namespace mg = mir::graphics;
 namespace mgc = mir::graphics::common;
 namespace mtd = mir::test::doubles;
@@ -44,6 +46,15 @@ struct StubShmFile : public mir::ShmFile
     int const fake_fd = 17;
 };
 
+struct MemoryShmFile : public mir::ShmFile
+{
+    MemoryShmFile(void* memory) : memory{memory} {}
+    void* base_ptr() const { return memory; }
+    int fd() const { return 18; }
+
+    void* const memory;
+};
+
 struct PlatformlessShmBuffer : mgc::ShmBuffer
 {
     PlatformlessShmBuffer(
@@ -199,3 +210,84 @@ TEST_F(ShmBufferTest, uploads_abgr_8888_correctly)
     PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_abgr_8888);
     buf.gl_bind_to_texture();
 }
+
+TEST_F(ShmBufferTest, converts_argb_8888_for_gles_without_bgra_textures)
+{
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 2.0 Mesa")));
+    ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image")));
+
+    auto const pixel_count = size.width.as_int() * size.height.as_int();
+    std::vector<uint32_t> argb(pixel_count, 0x80102030);
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                                      size.width.as_int(), size.height.as_int(),
+                                      0, GL_RGBA, GL_UNSIGNED_BYTE, _))
+        .WillOnce(Invoke(
+            [&](GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, GLvoid const* pixels)
+            {
+                auto const abgr = static_cast<uint32_t const*>(pixels);
+                EXPECT_THAT(abgr, Ne(argb.data()));
+                EXPECT_THAT(abgr[0], Eq(0x80302010u));
+                EXPECT_THAT(abgr[pixel_count - 1], Eq(0x80302010u));
+            }));
+#endif
+    PlatformlessShmBuffer buf(std::make_unique<MemoryShmFile>(argb.data()), size, mir_pixel_format_argb_8888);
+    buf.gl_bind_to_texture();
+}
+
+TEST_F(ShmBufferTest, uploads_only_damaged_rectangles_with_row_length)
+{
+    auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(mir_pixel_format_rgb_888);
+    auto const stride = size.width.as_int() * bytes_per_pixel;
+    auto const base = static_cast<char*>(stub_shm_file->fake_mapping);
+
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0 Mesa")));
+
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, size.width.as_int()));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 20, 30, 40,
+                                         GL_RGB, GL_UNSIGNED_BYTE,
+                                         base + 20 * stride + 10 * bytes_per_pixel));
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+
+    PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_rgb_888);
+    buf.bind_damaged({{{10, 20}, {30, 40}}});
+}
+
+TEST_F(ShmBufferTest, uploads_whole_damaged_rows_without_row_length)
+{
+    auto const stride = size.width.as_int() * MIR_BYTES_PER_PIXEL(mir_pixel_format_rgb_888);
+    auto const base = static_cast<char*>(stub_shm_file->fake_mapping);
+
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 2.0 Mesa")));
+    ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image")));
+
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, _))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 20, size.width.as_int(), 50,
+                                         GL_RGB, GL_UNSIGNED_BYTE,
+                                         base + 20 * stride));
+
+    PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_rgb_888);
+    buf.bind_damaged({{{10, 20}, {30, 40}}, {{50, 40}, {5, 30}}});
+}
+
+TEST_F(ShmBufferTest, uploads_nothing_without_damage)
+{
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+
+    PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_rgb_888);
+    buf.bind_damaged({});
+}
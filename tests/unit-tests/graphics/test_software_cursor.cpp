@@ -49,11 +49,11 @@ struct MockInputScene : mtd::StubInputScene
 
 struct StubCursorImage : mg::CursorImage
 {
-    StubCursorImage(geom::Displacement const& hotspot)
+    StubCursorImage(geom::Displacement const& hotspot, unsigned char fill = 0x55)
         : hotspot_{hotspot},
           pixels(
             size().width.as_uint32_t() * size().height.as_uint32_t() * bytes_per_pixel,
-            0x55)
+            fill)
     {
     }
 
@@ -294,26 +294,59 @@ TEST_F(SoftwareCursor, places_new_cursor_renderable_at_correct_position)
     cursor.show(another_stub_cursor_image);
 }
 
+namespace
+{
+struct MockBufferAllocator : public mg::GraphicBufferAllocator
+{
+    MOCK_METHOD1(alloc_buffer, std::shared_ptr<mg::Buffer>(mg::BufferProperties const&));
+    MOCK_METHOD2(alloc_software_buffer, std::shared_ptr<mg::Buffer>(geom::Size, MirPixelFormat));
+    MOCK_METHOD3(alloc_buffer, std::shared_ptr<mg::Buffer>(geom::Size, uint32_t, uint32_t));
+    std::vector<MirPixelFormat> supported_pixel_formats() { return {mir_pixel_format_abgr_8888}; } 
+};
+}
+
 //lp: #1413211
-TEST_F(SoftwareCursor, new_buffer_on_each_show)
+TEST_F(SoftwareCursor, new_buffer_for_each_new_image)
 {
-    struct MockBufferAllocator : public mg::GraphicBufferAllocator
-    {
-        MOCK_METHOD1(alloc_buffer, std::shared_ptr<mg::Buffer>(mg::BufferProperties const&));
-        MOCK_METHOD2(alloc_software_buffer, std::shared_ptr<mg::Buffer>(geom::Size, MirPixelFormat));
-        MOCK_METHOD3(alloc_buffer, std::shared_ptr<mg::Buffer>(geom::Size, uint32_t, uint32_t));
-        std::vector<MirPixelFormat> supported_pixel_formats() { return {mir_pixel_format_abgr_8888}; } 
-    } mock_allocator;
+    MockBufferAllocator mock_allocator;
+    StubCursorImage const different_cursor_image{{3,4}, 0xaa};
 
     EXPECT_CALL(mock_allocator, alloc_buffer(testing::_))
-        .Times(3)
+        .Times(2)
         .WillRepeatedly(testing::Return(std::make_shared<mtd::StubBuffer>()));;
     mg::SoftwareCursor cursor{
         mt::fake_shared(mock_allocator),
         mt::fake_shared(mock_input_scene)};
     cursor.show(another_stub_cursor_image);
-    cursor.show(another_stub_cursor_image);
+    cursor.show(different_cursor_image);
+}
+
+TEST_F(SoftwareCursor, reuses_the_buffer_of_a_recently_shown_image)
+{
+    using namespace testing;
+
+    MockBufferAllocator mock_allocator;
+    StubCursorImage const different_cursor_image{{3,4}, 0xaa};
+    auto const buffer = std::make_shared<mtd::StubBuffer>();
+
+    EXPECT_CALL(mock_allocator, alloc_buffer(_))
+        .WillOnce(Return(buffer))
+        .WillOnce(Return(std::make_shared<mtd::StubBuffer>()));
+    mg::SoftwareCursor cursor{
+        mt::fake_shared(mock_allocator),
+        mt::fake_shared(mock_input_scene)};
     cursor.show(stub_cursor_image);
+    cursor.show(different_cursor_image);
+
+    std::shared_ptr<mg::Renderable> renderable;
+    EXPECT_CALL(mock_input_scene, add_input_visualization(_))
+        .WillOnce(SaveArg<0>(&renderable));
+
+    // Only the pixels identify an image, not the hotspot
+    cursor.show(another_stub_cursor_image);
+
+    ASSERT_THAT(renderable, NotNull());
+    EXPECT_THAT(renderable->buffer(), Eq(buffer));
 }
 
 //lp: 1483779
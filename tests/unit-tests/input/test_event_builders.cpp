@@ -283,3 +283,37 @@ TEST_F(InputEventBuilder, when_deserialized_input_device_state_event_has_supplie
         EXPECT_THAT(mir_input_device_state_event_device_pressed_keys_for_index(ids_event, 2, i), Eq(pressed_keys[i]));
     }
 }
+
+TEST_F(InputEventBuilder, reuses_the_storage_of_dropped_events)
+{
+    auto ev = mev::make_event(device_id, timestamp, cookie, modifiers, mir_pointer_action_motion,
+                              0, 1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    MirEvent const* const dropped = ev.get();
+    ev.reset();
+
+    auto const next = mev::make_event(device_id, timestamp,
+                                      cookie, mir_keyboard_action_down, 34, 17, modifiers);
+
+    EXPECT_THAT(next.get(), Eq(dropped));
+}
+
+TEST_F(InputEventBuilder, events_too_big_to_build_in_place_are_intact_when_cloned_and_deserialized)
+{
+    std::vector<uint32_t> pressed_keys;
+    for (uint32_t key = 0; key != 1000; ++key)
+        pressed_keys.push_back(key);
+
+    auto ev = mev::make_event(timestamp, 0, mir_input_event_modifier_none, 0.0f, 0.0f,
+                              {mev::InputDeviceState{MirInputDeviceId{3}, pressed_keys, 0}});
+    auto const clone = mev::clone_event(*ev);
+    ev.reset();
+    auto const deserialized_event = MirEvent::deserialize(MirEvent::serialize(clone.get()));
+
+    for (auto const event : {clone.get(), deserialized_event.get()})
+    {
+        auto const ids_event = mir_event_get_input_device_state_event(event);
+        ASSERT_THAT(mir_input_device_state_event_device_pressed_keys_count(ids_event, 0), Eq(pressed_keys.size()));
+        for (uint32_t i = 0; i != pressed_keys.size(); ++i)
+            EXPECT_THAT(mir_input_device_state_event_device_pressed_keys_for_index(ids_event, 0, i), Eq(pressed_keys[i]));
+    }
+}
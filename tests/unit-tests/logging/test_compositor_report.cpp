@@ -189,3 +189,24 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, reports_predicted_render_time_and_misses)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 8; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::milliseconds(3));
+        report.rendered_frame(id);
+        report.render_time(id, chrono::milliseconds(4), chrono::milliseconds(f % 2 ? 5 : 3));
+        report.finished_frame(id);
+        clock->advance_by(chrono::milliseconds(600));
+    }
+    EXPECT_TRUE(recorder->last_message_contains("predicted 4.000 ms/frame (50% over)"))
+        << recorder->last_message();
+
+    report.stopped();
+}
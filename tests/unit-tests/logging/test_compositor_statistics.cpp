@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/compositor_statistics.h"
+#include "mir/logging/logger.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_compositor_report.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+namespace mtd = mir::test::doubles;
+namespace mrl = mir::report::logging;
+namespace ml = mir::logging;
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+class Recorder : public ml::Logger
+{
+public:
+    void log(ml::Severity, std::string const& message, std::string const&) override
+    {
+        messages.push_back(message);
+    }
+
+    std::vector<std::string> messages;
+};
+
+struct CompositorStatistics : Test
+{
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    std::shared_ptr<NiceMock<mtd::MockCompositorReport>> const next =
+        std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    mrl::CompositorStatistics statistics{clock, next};
+    Recorder recorder;
+
+    void frame(void const* id, std::chrono::microseconds composite, std::chrono::microseconds post, bool bypass)
+    {
+        statistics.began_frame(id);
+        clock->advance_by(composite);
+        if (!bypass)
+            statistics.rendered_frame(id);
+        statistics.finished_frame(id);
+        clock->advance_by(post);
+        statistics.render_time(id, 0ns, composite);
+    }
+};
+}
+
+TEST_F(CompositorStatistics, forwards_reports)
+{
+    void const* const id = "Screen";
+
+    InSequence seq;
+    EXPECT_CALL(*next, started());
+    EXPECT_CALL(*next, added_display(1920, 1080, 0, 0, id));
+    EXPECT_CALL(*next, began_frame(id));
+    EXPECT_CALL(*next, rendered_frame(id));
+    EXPECT_CALL(*next, finished_frame(id));
+    EXPECT_CALL(*next, render_time(id, 0ns, std::chrono::nanoseconds{2ms}));
+    EXPECT_CALL(*next, stopped());
+
+    statistics.started();
+    statistics.added_display(1920, 1080, 0, 0, id);
+    frame(id, 2ms, 10ms, false);
+    statistics.stopped();
+}
+
+TEST_F(CompositorStatistics, logs_histograms_per_output)
+{
+    void const* const left = "Left";
+    void const* const right = "Right";
+
+    statistics.added_display(1920, 1080, 0, 0, left);
+    statistics.added_display(1280, 1024, 1920, 0, right);
+
+    for (int i = 0; i != 4; ++i)
+    {
+        frame(left, 3ms, 13ms, i % 2);
+        frame(right, 1ms, 15ms, false);
+    }
+
+    statistics.log_to(recorder);
+
+    ASSERT_THAT(recorder.messages, SizeIs(10));
+    EXPECT_THAT(recorder.messages[0], StrEq("Display 1920x1080+0+0: 4 frames, 50% bypassed"));
+    EXPECT_THAT(recorder.messages[1], StartsWith("  composite time (us): mean 3000"));
+    EXPECT_THAT(recorder.messages[2], StartsWith("  post time (us): mean 13000"));
+    EXPECT_THAT(recorder.messages[3], StartsWith("  frame interval (us): mean 32000"));
+    EXPECT_THAT(recorder.messages[5], StrEq("Display 1280x1024+1920+0: 4 frames, 0% bypassed"));
+    EXPECT_THAT(recorder.messages[6], StartsWith("  composite time (us): mean 1000"));
+}
+
+TEST_F(CompositorStatistics, keeps_an_outputs_statistics_across_restarts)
+{
+    statistics.added_display(1920, 1080, 0, 0, "Before");
+    frame("Before", 3ms, 13ms, false);
+    statistics.stopped();
+
+    statistics.added_display(1920, 1080, 0, 0, "After");
+    frame("After", 3ms, 13ms, false);
+
+    statistics.log_to(recorder);
+
+    ASSERT_THAT(recorder.messages, Not(IsEmpty()));
+    EXPECT_THAT(recorder.messages[0], StrEq("Display 1920x1080+0+0: 2 frames, 0% bypassed"));
+    EXPECT_THAT(recorder.messages, SizeIs(5));
+}
+
+TEST_F(CompositorStatistics, ignores_unknown_compositors)
+{
+    frame("Unknown", 3ms, 13ms, false);
+
+    statistics.log_to(recorder);
+
+    EXPECT_THAT(recorder.messages, IsEmpty());
+}
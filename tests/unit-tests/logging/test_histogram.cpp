@@ -0,0 +1,108 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/histogram.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+namespace mrl = mir::report::logging;
+using namespace testing;
+
+TEST(Histogram, empty_histogram_reports_zeroes)
+{
+    mrl::Histogram const histogram;
+
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.mean());
+    EXPECT_EQ(0u, histogram.max());
+    EXPECT_EQ(0u, histogram.value_at_percentile(50.0));
+}
+
+TEST(Histogram, small_values_are_exact)
+{
+    mrl::Histogram histogram;
+
+    for (uint64_t v = 1; v <= 10; ++v)
+        histogram.record(v);
+
+    EXPECT_EQ(10u, histogram.count());
+    EXPECT_EQ(5u, histogram.mean());
+    EXPECT_EQ(5u, histogram.value_at_percentile(50.0));
+    EXPECT_EQ(9u, histogram.value_at_percentile(90.0));
+    EXPECT_EQ(10u, histogram.value_at_percentile(100.0));
+}
+
+TEST(Histogram, large_values_are_within_a_sixteenth)
+{
+    for (uint64_t const value : {33ull, 1000ull, 16667ull, 123456789ull, 1ull << 40})
+    {
+        mrl::Histogram histogram;
+        histogram.record(value);
+        histogram.record(value * 4);
+
+        auto const p50 = histogram.value_at_percentile(50.0);
+        EXPECT_THAT(p50, Ge(value)) << value;
+        EXPECT_THAT(p50, Le(value + value / 16)) << value;
+        EXPECT_EQ(value * 4, histogram.max());
+    }
+}
+
+TEST(Histogram, percentiles_reflect_the_tail)
+{
+    mrl::Histogram histogram;
+
+    for (int i = 0; i != 990; ++i)
+        histogram.record(16000);
+    for (int i = 0; i != 10; ++i)
+        histogram.record(50000);
+
+    EXPECT_THAT(histogram.value_at_percentile(99.0), AllOf(Ge(16000u), Le(17000u)));
+    EXPECT_THAT(histogram.value_at_percentile(99.9), AllOf(Ge(50000u), Le(53125u)));
+}
+
+TEST(Histogram, reset_forgets_everything)
+{
+    mrl::Histogram histogram;
+    histogram.record(100);
+    histogram.reset();
+
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.max());
+}
+
+TEST(Histogram, records_from_many_threads_without_loss)
+{
+    mrl::Histogram histogram;
+    int const threads = 4;
+    int const per_thread = 10000;
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t != threads; ++t)
+        writers.emplace_back([&histogram, t]
+            {
+                for (int i = 0; i != per_thread; ++i)
+                    histogram.record(t * 1000 + i % 100);
+            });
+    for (auto& writer : writers)
+        writer.join();
+
+    EXPECT_EQ(uint64_t{threads * per_thread}, histogram.count());
+    EXPECT_EQ(uint64_t{(threads - 1) * 1000 + 99}, histogram.max());
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms-utils/kms_plane.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mtd = mir::test::doubles;
+namespace mgk = mir::graphics::kms;
+using namespace testing;
+
+namespace
+{
+char const* const drm_device = "/dev/dri/card0";
+
+uint32_t const xrgb{0x34325258};
+uint32_t const argb{0x34325241};
+
+struct KMSPlane : Test
+{
+    KMSPlane()
+    {
+        mock_drm.add_plane(drm_device, 40, DRM_PLANE_TYPE_PRIMARY, 0x1, {xrgb});
+        mock_drm.add_plane(drm_device, 41, DRM_PLANE_TYPE_CURSOR, 0x1, {argb});
+        mock_drm.add_plane(drm_device, 42, DRM_PLANE_TYPE_OVERLAY, 0x3, {xrgb, argb});
+        mock_drm.add_plane(drm_device, 43, DRM_PLANE_TYPE_OVERLAY, 0x2, {xrgb});
+        mock_drm.prepare(drm_device);
+
+        drm_fd = mock_drm.open(drm_device, 0, 0);
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    int drm_fd;
+};
+
+MATCHER_P3(IsPlane, id, type, possible_crtcs, "")
+{
+    return arg.id == static_cast<uint32_t>(id) && arg.type == type &&
+        arg.possible_crtcs == static_cast<uint32_t>(possible_crtcs);
+}
+}
+
+TEST_F(KMSPlane, enables_universal_planes)
+{
+    EXPECT_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1));
+
+    mgk::enumerate_planes(drm_fd);
+}
+
+TEST_F(KMSPlane, enumerates_planes_of_every_type)
+{
+    auto const planes = mgk::enumerate_planes(drm_fd);
+
+    EXPECT_THAT(planes, ElementsAre(
+        IsPlane(40, mgk::Plane::Type::primary, 0x1),
+        IsPlane(41, mgk::Plane::Type::cursor, 0x1),
+        IsPlane(42, mgk::Plane::Type::overlay, 0x3),
+        IsPlane(43, mgk::Plane::Type::overlay, 0x2)));
+    ASSERT_THAT(planes.size(), Eq(4u));
+    EXPECT_THAT(planes[2].formats, ElementsAre(xrgb, argb));
+}
+
+TEST_F(KMSPlane, reports_which_crtcs_and_formats_a_plane_supports)
+{
+    auto const planes = mgk::enumerate_planes(drm_fd);
+    ASSERT_THAT(planes.size(), Eq(4u));
+
+    auto const& overlay = planes[3];
+    EXPECT_FALSE(overlay.can_be_used_on(0));
+    EXPECT_TRUE(overlay.can_be_used_on(1));
+    EXPECT_FALSE(overlay.can_be_used_on(-1));
+    EXPECT_TRUE(overlay.supports(xrgb));
+    EXPECT_FALSE(overlay.supports(argb));
+}
+
+TEST_F(KMSPlane, enumerates_nothing_when_the_driver_has_no_plane_resources)
+{
+    ON_CALL(mock_drm, drmModeGetPlaneResources(_))
+        .WillByDefault(Return(nullptr));
+
+    EXPECT_THAT(mgk::enumerate_planes(drm_fd), IsEmpty());
+}
+
+TEST_F(KMSPlane, treats_planes_without_a_type_as_overlays)
+{
+    drmModeObjectProperties no_properties{0, nullptr, nullptr};
+    ON_CALL(mock_drm, drmModeObjectGetProperties(_, _, _))
+        .WillByDefault(Return(&no_properties));
+
+    auto const planes = mgk::enumerate_planes(drm_fd);
+
+    EXPECT_THAT(planes, Each(Field(&mgk::Plane::type, mgk::Plane::Type::overlay)));
+    EXPECT_THAT(planes.size(), Eq(4u));
+}
+
+TEST_F(KMSPlane, finds_the_index_of_a_crtc)
+{
+    // The default fake DRM device has CRTCs 10 and 11
+    EXPECT_THAT(mgk::crtc_index(drm_fd, 10), Eq(0));
+    EXPECT_THAT(mgk::crtc_index(drm_fd, 11), Eq(1));
+    EXPECT_THAT(mgk::crtc_index(drm_fd, 12), Eq(-1));
+}
@@ -20,6 +20,7 @@
 #define MOCK_KMS_OUTPUT_H_
 
 #include "src/platforms/mesa/server/kms/kms_output.h"
+#include "src/platforms/mesa/server/kms/atomic_kms.h"
 #include <gmock/gmock.h>
 
 namespace mir
@@ -58,6 +59,7 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::mesa::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
+    MOCK_METHOD1(when_page_flipped, void(std::function<void(graphics::Frame const&)> const&));
 
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
@@ -66,6 +68,27 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     MOCK_METHOD0(clear_cursor, bool());
     MOCK_CONST_METHOD0(has_cursor, bool());
 
+    MOCK_CONST_METHOD0(planes, std::vector<graphics::kms::Plane>());
+    MOCK_METHOD1(clear_plane, void(uint32_t));
+
+    std::unique_ptr<graphics::mesa::AtomicUpdate> begin_atomic_update() override
+    {
+        return std::unique_ptr<graphics::mesa::AtomicUpdate>{begin_atomic_update_thunk()};
+    }
+    MOCK_METHOD0(begin_atomic_update_thunk, graphics::mesa::AtomicUpdate*());
+    bool add_to_update(graphics::mesa::AtomicUpdate& update, graphics::mesa::FBHandle const& fb, bool modeset) override
+    {
+        return add_to_update_thunk(&update, &fb, modeset);
+    }
+    MOCK_METHOD3(add_to_update_thunk, bool(graphics::mesa::AtomicUpdate*, graphics::mesa::FBHandle const*, bool));
+    MOCK_METHOD4(add_plane_to_update, void(graphics::mesa::AtomicUpdate&, uint32_t,
+                                           graphics::mesa::FBHandle const*, geometry::Rectangle const&));
+    bool schedule_page_flip(graphics::mesa::AtomicUpdate const& update) override
+    {
+        return schedule_atomic_page_flip_thunk(&update);
+    }
+    MOCK_METHOD1(schedule_atomic_page_flip_thunk, bool(graphics::mesa::AtomicUpdate const*));
+
     MOCK_METHOD1(set_power_mode, void(MirPowerMode));
     MOCK_METHOD1(set_gamma, void(mir::graphics::GammaCurves const&));
 
@@ -0,0 +1,185 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/mesa/server/kms/atomic_kms.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace mgm = mir::graphics::mesa;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+
+class AtomicKMSTest : public ::testing::Test
+{
+public:
+    AtomicKMSTest()
+        : properties{std::make_shared<mgm::PropertyCache>(drm_fd)}
+    {
+        // A CRTC with an ACTIVE and a MODE_ID property
+        add_property(active_property_id, "ACTIVE", 1);
+        add_property(mode_id_property_id, "MODE_ID", 0);
+        crtc_properties.count_props = property_ids.size();
+        crtc_properties.props = property_ids.data();
+        crtc_properties.prop_values = property_values.data();
+
+        ON_CALL(mock_drm, drmModeObjectGetProperties(drm_fd, crtc_id, DRM_MODE_OBJECT_CRTC))
+            .WillByDefault(Return(&crtc_properties));
+        ON_CALL(mock_drm, drmModeGetProperty(drm_fd, _))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id) -> drmModePropertyPtr
+                {
+                    for (auto& property : property_table)
+                    {
+                        if (property.prop_id == id)
+                            return &property;
+                    }
+                    return nullptr;
+                }));
+    }
+
+    void add_property(uint32_t id, char const* name, uint64_t value)
+    {
+        drmModePropertyRes property;
+        memset(&property, 0, sizeof property);
+        property.prop_id = id;
+        strncpy(property.name, name, sizeof(property.name) - 1);
+
+        property_table.push_back(property);
+        property_ids.push_back(id);
+        property_values.push_back(value);
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    int const drm_fd{17};
+    uint32_t const crtc_id{31};
+    uint32_t const active_property_id{41};
+    uint32_t const mode_id_property_id{42};
+
+    std::vector<drmModePropertyRes> property_table;
+    std::vector<uint32_t> property_ids;
+    std::vector<uint64_t> property_values;
+    drmModeObjectProperties crtc_properties;
+
+    std::shared_ptr<mgm::PropertyCache> const properties;
+};
+
+}
+
+TEST_F(AtomicKMSTest, not_enabled_unless_events_identify_crtc)
+{
+    EXPECT_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillOnce(DoAll(SetArgPointee<2>(0), Return(0)));
+    EXPECT_CALL(mock_drm, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+        .Times(0);
+
+    EXPECT_FALSE(mgm::enable_atomic_kms(drm_fd));
+}
+
+TEST_F(AtomicKMSTest, enabled_if_driver_accepts_atomic_client)
+{
+    EXPECT_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillOnce(DoAll(SetArgPointee<2>(1), Return(0)));
+    EXPECT_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+        .WillOnce(Return(0));
+
+    EXPECT_TRUE(mgm::enable_atomic_kms(drm_fd));
+}
+
+TEST_F(AtomicKMSTest, not_enabled_if_driver_refuses_atomic_client)
+{
+    ON_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+    ON_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+        .WillByDefault(Return(-EOPNOTSUPP));
+
+    EXPECT_FALSE(mgm::enable_atomic_kms(drm_fd));
+}
+
+TEST_F(AtomicKMSTest, object_properties_are_looked_up_once)
+{
+    EXPECT_CALL(mock_drm, drmModeObjectGetProperties(drm_fd, crtc_id, DRM_MODE_OBJECT_CRTC))
+        .Times(1);
+
+    EXPECT_THAT(properties->id_for(crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE"), Eq(active_property_id));
+    EXPECT_THAT(properties->id_for(crtc_id, DRM_MODE_OBJECT_CRTC, "MODE_ID"), Eq(mode_id_property_id));
+    EXPECT_THAT(properties->id_for(crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE"), Eq(active_property_id));
+}
+
+TEST_F(AtomicKMSTest, set_adds_property_by_id)
+{
+    mgm::AtomicUpdate update{drm_fd, properties};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, crtc_id, active_property_id, 1))
+        .WillOnce(Return(1));
+
+    update.set(crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE", 1);
+}
+
+TEST_F(AtomicKMSTest, set_of_unknown_property_throws)
+{
+    mgm::AtomicUpdate update{drm_fd, properties};
+
+    EXPECT_THROW(
+        { update.set(crtc_id, DRM_MODE_OBJECT_CRTC, "GAMMA_LUT", 1); },
+        std::out_of_range);
+}
+
+TEST_F(AtomicKMSTest, mode_blobs_are_destroyed_with_update)
+{
+    uint32_t const blob_id{77};
+    drmModeModeInfo mode;
+    memset(&mode, 0, sizeof mode);
+
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(drm_fd, _, sizeof mode, _))
+        .WillOnce(DoAll(SetArgPointee<3>(blob_id), Return(0)));
+    EXPECT_CALL(mock_drm, drmModeDestroyPropertyBlob(drm_fd, blob_id))
+        .Times(1);
+
+    mgm::AtomicUpdate update{drm_fd, properties};
+    EXPECT_THAT(update.mode_blob(mode), Eq(blob_id));
+}
+
+TEST_F(AtomicKMSTest, test_commits_without_applying)
+{
+    mgm::AtomicUpdate update{drm_fd, properties};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY, nullptr))
+        .WillOnce(Return(0))
+        .WillOnce(Return(-1));
+
+    EXPECT_TRUE(update.test(0));
+    EXPECT_FALSE(update.test(0));
+}
+
+TEST_F(AtomicKMSTest, failed_commit_returns_negative_errno)
+{
+    mgm::AtomicUpdate update{drm_fd, properties};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_NONBLOCK, _))
+        .WillOnce(InvokeWithoutArgs([] { errno = EBUSY; return -1; }));
+
+    EXPECT_THAT(update.commit(DRM_MODE_ATOMIC_NONBLOCK, nullptr), Eq(-EBUSY));
+}
@@ -465,6 +465,22 @@ TEST_F(MesaCursorTest, pads_missing_data_when_buffer_size_differs)
     cursor_tmp.show(SinglePixelCursorImage());
 }
 
+TEST_F(MesaCursorTest, does_not_rewrite_a_recently_shown_image)
+{
+    using namespace testing;
+
+    cursor.show(stub_image);
+    cursor.show(SinglePixelCursorImage());
+    Mock::VerifyAndClearExpectations(&mock_gbm);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(0);
+    EXPECT_CALL(*output_container.outputs[0], set_cursor(_));
+
+    cursor.show(stub_image);
+
+    output_container.verify_and_clear_expectations();
+}
+
 TEST_F(MesaCursorTest, does_not_throw_when_images_are_too_large)
 {
     using namespace testing;
@@ -396,12 +396,42 @@ TEST_F(MesaDisplayBufferTest, clone_mode_first_flip_flips_but_no_wait)
     db.post();
 }
 
-TEST_F(MesaDisplayBufferTest, single_mode_first_post_flips_with_wait)
+TEST_F(MesaDisplayBufferTest, single_mode_first_post_flips_but_no_wait)
 {
+    // The flip completes while the next frame is rendered
     EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
         .Times(1);
     EXPECT_CALL(*mock_kms_output, wait_for_page_flip())
+        .Times(0);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, atomic_update_replaces_legacy_modeset_and_flip)
+{
+    auto const properties = std::make_shared<PropertyCache>(0);
+    ON_CALL(*mock_kms_output, begin_atomic_update_thunk())
+        .WillByDefault(Invoke([properties] { return new AtomicUpdate{0, properties}; }));
+    ON_CALL(*mock_kms_output, add_to_update_thunk(_, _, _))
+        .WillByDefault(Return(true));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
         .Times(1);
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_))
+        .Times(0);
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+    EXPECT_CALL(*mock_kms_output, schedule_atomic_page_flip_thunk(_))
+        .WillOnce(Return(true));
 
     graphics::mesa::DisplayBuffer db(
         graphics::mesa::BypassOption::allowed,
@@ -415,6 +445,128 @@ TEST_F(MesaDisplayBufferTest, single_mode_first_post_flips_with_wait)
     db.post();
 }
 
+TEST_F(MesaDisplayBufferTest, failed_atomic_flip_falls_back_to_legacy_api)
+{
+    auto const properties = std::make_shared<PropertyCache>(0);
+    ON_CALL(*mock_kms_output, begin_atomic_update_thunk())
+        .WillByDefault(Invoke([properties] { return new AtomicUpdate{0, properties}; }));
+    ON_CALL(*mock_kms_output, add_to_update_thunk(_, _, _))
+        .WillByDefault(Return(true));
+
+    // Once the driver has refused an atomic update we stop trying them
+    EXPECT_CALL(*mock_kms_output, schedule_atomic_page_flip_thunk(_))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(2);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, last_frame_predicts_vsync_of_pending_flip)
+{
+    std::chrono::nanoseconds const interval{std::chrono::seconds{1}};
+    graphics::Frame flipped;
+    flipped.msc = 7;
+    flipped.ust = {CLOCK_MONOTONIC, std::chrono::steady_clock::now().time_since_epoch() - interval / 2};
+    ON_CALL(*mock_kms_output, last_frame())
+        .WillByDefault(Return(flipped));
+    ON_CALL(*mock_kms_output, max_refresh_rate())
+        .WillByDefault(Return(1));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_THAT(db.last_frame().msc, Eq(flipped.msc));
+
+    db.swap_buffers();
+    db.post();
+
+    auto const predicted = db.last_frame();
+    EXPECT_THAT(predicted.msc, Eq(flipped.msc + 1));
+    EXPECT_THAT(predicted.ust, Eq(flipped.ust + interval));
+}
+
+TEST_F(MesaDisplayBufferTest, reports_a_frame_presented_only_once_its_flip_lands)
+{
+    std::function<void(graphics::Frame const&)> flip_handler;
+    EXPECT_CALL(*mock_kms_output, when_page_flipped(_))
+        .WillOnce(SaveArg<0>(&flip_handler));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+
+    bool presented{false};
+    graphics::Frame presented_frame;
+    db.when_presented(
+        [&](graphics::Frame const& frame)
+        {
+            presented = true;
+            presented_frame = frame;
+        });
+
+    EXPECT_FALSE(presented);
+    ASSERT_TRUE(flip_handler);
+
+    graphics::Frame flipped;
+    flipped.msc = 42;
+    flip_handler(flipped);
+
+    EXPECT_TRUE(presented);
+    EXPECT_THAT(presented_frame.msc, Eq(flipped.msc));
+}
+
+TEST_F(MesaDisplayBufferTest, reports_the_last_frame_presented_at_once_without_a_pending_flip)
+{
+    graphics::Frame flipped;
+    flipped.msc = 7;
+    ON_CALL(*mock_kms_output, last_frame())
+        .WillByDefault(Return(flipped));
+    EXPECT_CALL(*mock_kms_output, when_page_flipped(_))
+        .Times(0);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    bool presented{false};
+    db.when_presented(
+        [&](graphics::Frame const& frame)
+        {
+            presented = true;
+            EXPECT_THAT(frame.msc, Eq(flipped.msc));
+        });
+
+    EXPECT_TRUE(presented);
+}
+
 TEST_F(MesaDisplayBufferTest, clone_mode_waits_for_page_flip_on_second_flip)
 {
     InSequence seq;
@@ -503,3 +655,222 @@ TEST_F(MesaDisplayBufferTest, buffer_requiring_migration_is_ineligable_for_bypas
 
     EXPECT_FALSE(db.overlay(bypassable_list));
 }
+
+TEST_F(MesaDisplayBufferTest, surfaces_above_a_bypassed_one_are_shown_on_overlay_planes)
+{
+    uint32_t const plane_id{40};
+    geometry::Rectangle const notification{display_area.top_left + geometry::Displacement{10, 10}, {20, 20}};
+
+    auto notification_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*notification_buffer, size())
+        .WillByDefault(Return(notification.size));
+    ON_CALL(*notification_buffer, native_buffer_handle())
+        .WillByDefault(Return(std::make_shared<StubGBMNativeBuffer>(notification.size)));
+    auto notification_renderable = std::make_shared<FakeRenderable>(notification);
+    notification_renderable->set_buffer(notification_buffer);
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(_))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(Return(std::vector<kms::Plane>{
+            {plane_id, kms::Plane::Type::overlay, 0x1, {GBM_FORMAT_XRGB8888}}}));
+    auto const properties = std::make_shared<PropertyCache>(0);
+    ON_CALL(*mock_kms_output, begin_atomic_update_thunk())
+        .WillByDefault(Invoke([properties] { return new AtomicUpdate{0, properties}; }));
+    ON_CALL(*mock_kms_output, add_to_update_thunk(_, _, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, schedule_atomic_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    // The plane changes in the same atomic update as the primary plane
+    EXPECT_CALL(*mock_kms_output, add_plane_to_update(_, plane_id, NotNull(), geometry::Rectangle{{10, 10}, {20, 20}}))
+        .Times(AtLeast(1));
+
+    EXPECT_TRUE(db.overlay({fake_bypassable_renderable, notification_renderable}));
+    db.post();
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
+
+    // Back to compositing; the plane mustn't cover the composited frame
+    EXPECT_CALL(*mock_kms_output, add_plane_to_update(_, plane_id, IsNull(), _))
+        .Times(AtLeast(1));
+
+    EXPECT_FALSE(db.overlay({fake_software_renderable, notification_renderable}));
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, surfaces_above_a_composited_one_can_still_be_shown_on_overlay_planes)
+{
+    uint32_t const plane_id{40};
+    geometry::Rectangle const notification{display_area.top_left + geometry::Displacement{10, 10}, {20, 20}};
+
+    auto notification_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*notification_buffer, size())
+        .WillByDefault(Return(notification.size));
+    ON_CALL(*notification_buffer, native_buffer_handle())
+        .WillByDefault(Return(std::make_shared<StubGBMNativeBuffer>(notification.size)));
+    auto notification_renderable = std::make_shared<FakeRenderable>(notification);
+    notification_renderable->set_buffer(notification_buffer);
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(_))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(Return(std::vector<kms::Plane>{
+            {plane_id, kms::Plane::Type::overlay, 0x1, {GBM_FORMAT_XRGB8888}}}));
+    auto const properties = std::make_shared<PropertyCache>(0);
+    ON_CALL(*mock_kms_output, begin_atomic_update_thunk())
+        .WillByDefault(Invoke([properties] { return new AtomicUpdate{0, properties}; }));
+    ON_CALL(*mock_kms_output, add_to_update_thunk(_, _, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, schedule_atomic_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList list{fake_software_renderable, notification_renderable};
+
+    EXPECT_FALSE(db.overlay_partially(list));
+    EXPECT_THAT(list, ElementsAre(fake_software_renderable));
+
+    EXPECT_CALL(*mock_kms_output, add_plane_to_update(_, plane_id, NotNull(), geometry::Rectangle{{10, 10}, {20, 20}}))
+        .Times(AtLeast(1));
+
+    db.make_current();
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, overlay_planes_are_not_used_without_atomic_updates)
+{
+    geometry::Rectangle const notification{display_area.top_left + geometry::Displacement{10, 10}, {20, 20}};
+
+    auto notification_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*notification_buffer, size())
+        .WillByDefault(Return(notification.size));
+    ON_CALL(*notification_buffer, native_buffer_handle())
+        .WillByDefault(Return(std::make_shared<StubGBMNativeBuffer>(notification.size)));
+    auto notification_renderable = std::make_shared<FakeRenderable>(notification);
+    notification_renderable->set_buffer(notification_buffer);
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(_))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(Return(std::vector<kms::Plane>{
+            {40, kms::Plane::Type::overlay, 0x1, {GBM_FORMAT_XRGB8888}}}));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList list{fake_software_renderable, notification_renderable};
+
+    EXPECT_FALSE(db.overlay_partially(list));
+    EXPECT_THAT(list, ElementsAre(fake_software_renderable, notification_renderable));
+}
+
+TEST_F(MesaDisplayBufferTest, surfaces_that_need_gl_prevent_use_of_overlay_planes)
+{
+    auto translucent = std::make_shared<FakeRenderable>(
+        geometry::Rectangle{display_area.top_left, {20, 20}}, 0.5f);
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(_))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(Return(std::vector<kms::Plane>{
+            {40, kms::Plane::Type::overlay, 0x1, {GBM_FORMAT_XRGB8888}}}));
+    auto const properties = std::make_shared<PropertyCache>(0);
+    ON_CALL(*mock_kms_output, begin_atomic_update_thunk())
+        .WillByDefault(Invoke([properties] { return new AtomicUpdate{0, properties}; }));
+    ON_CALL(*mock_kms_output, add_to_update_thunk(_, _, _))
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, add_plane_to_update(_, _, NotNull(), _))
+        .Times(0);
+
+    EXPECT_FALSE(db.overlay({fake_bypassable_renderable, translucent}));
+}
+
+TEST_F(MesaDisplayBufferTest, overlay_planes_are_only_tested_again_when_their_layout_changes)
+{
+    uint32_t const plane_id{40};
+    geometry::Rectangle const notification{display_area.top_left + geometry::Displacement{10, 10}, {20, 20}};
+
+    auto notification_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*notification_buffer, size())
+        .WillByDefault(Return(notification.size));
+    ON_CALL(*notification_buffer, native_buffer_handle())
+        .WillByDefault(Return(std::make_shared<StubGBMNativeBuffer>(notification.size)));
+    auto notification_renderable = std::make_shared<FakeRenderable>(notification);
+    notification_renderable->set_buffer(notification_buffer);
+    auto moved_renderable = std::make_shared<FakeRenderable>(
+        geometry::Rectangle{notification.top_left + geometry::Displacement{5, 5}, notification.size});
+    moved_renderable->set_buffer(notification_buffer);
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(_))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(Return(std::vector<kms::Plane>{
+            {plane_id, kms::Plane::Type::overlay, 0x1, {GBM_FORMAT_XRGB8888}}}));
+    auto const properties = std::make_shared<PropertyCache>(0);
+    ON_CALL(*mock_kms_output, begin_atomic_update_thunk())
+        .WillByDefault(Invoke([properties] { return new AtomicUpdate{0, properties}; }));
+    ON_CALL(*mock_kms_output, add_to_update_thunk(_, _, _))
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    // Rejected layouts aren't retried either
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(-EINVAL));
+
+    for (int frame = 0; frame != 3; ++frame)
+    {
+        graphics::RenderableList list{fake_software_renderable, notification_renderable};
+        EXPECT_FALSE(db.overlay_partially(list));
+        EXPECT_THAT(list, ElementsAre(fake_software_renderable, notification_renderable));
+    }
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(0));
+
+    for (int frame = 0; frame != 3; ++frame)
+    {
+        graphics::RenderableList list{fake_software_renderable, moved_renderable};
+        EXPECT_FALSE(db.overlay_partially(list));
+        EXPECT_THAT(list, ElementsAre(fake_software_renderable));
+    }
+}
@@ -376,14 +376,14 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
                                               _, _))
             .Times(2)
             .WillRepeatedly(DoAll(SaveArg<4>(&user_data[i]), Return(0)));
-
-        /* Emit fake DRM page-flip events */
-        mock_drm.generate_event_on(drm_device);
     }
 
     /* Handle the events properly */
     EXPECT_CALL(mock_drm, drmHandleEvent(mtd::IsFdOfDevice(drm_device), _))
-        .Times(num_connected_outputs)
+        .Times(2 * num_connected_outputs)
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[2]), Return(0)))
         .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)))
         .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1]), Return(0)))
         .WillOnce(DoAll(InvokePageFlipHandler(&user_data[2]), Return(0)));
@@ -396,12 +396,20 @@ TEST_F(MesaDisplayMultiMonitorTest, flip_flips_all_connected_crtcs)
         group.post();
     });
 
+    /* Emit fake DRM page-flip events */
+    for (int i = 0; i < num_connected_outputs; i++)
+        mock_drm.generate_event_on(drm_device);
+
     /* Second frame: Previous page flips finish (drmHandleEvent) and new ones
        are scheduled */
     display->for_each_display_sync_group([](mg::DisplaySyncGroup& group)
     {
         group.post();
     });
+
+    /* The display waits for the second frame's flips before it's destroyed */
+    for (int i = 0; i < num_connected_outputs; i++)
+        mock_drm.generate_event_on(drm_device);
 }
 
 namespace
@@ -541,6 +549,50 @@ TEST_F(MesaDisplayMultiMonitorTest, configure_clears_unused_connected_outputs)
     }
 }
 
+TEST_F(MesaDisplayMultiMonitorTest, configure_keeps_display_buffers_of_unchanged_outputs)
+{
+    using namespace testing;
+
+    int const num_connected_outputs{2};
+    int const num_disconnected_outputs{0};
+
+    setup_outputs(num_connected_outputs, num_disconnected_outputs);
+
+    auto display = create_display_side_by_side(create_platform());
+
+    Mock::VerifyAndClearExpectations(&mock_drm);
+    Mock::VerifyAndClearExpectations(&mock_gbm);
+
+    /* The output left alone is neither given a new surface nor a new mode */
+    EXPECT_CALL(mock_gbm, gbm_surface_create(_, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_drm,
+                drmModeSetCrtc(mtd::IsFdOfDevice(drm_device), crtc_ids[0], Ne(0u), _, _, _, _, _))
+        .Times(0);
+
+    /* Disable the second output */
+    auto conf = display->configuration();
+    int seen{0};
+    conf->for_each_output(
+        [&](mg::UserDisplayConfigurationOutput& output)
+        {
+            if (seen++ == 1)
+                output.used = false;
+        });
+
+    display->configure(*conf);
+
+    int db_count{0};
+    display->for_each_display_sync_group(
+        [&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_buffer([&](mg::DisplayBuffer&) { ++db_count; });
+        });
+    EXPECT_THAT(db_count, Eq(1));
+
+    Mock::VerifyAndClearExpectations(&mock_drm);
+}
+
 TEST_F(MesaDisplayMultiMonitorTest, resume_clears_unused_connected_outputs)
 {
     using namespace testing;
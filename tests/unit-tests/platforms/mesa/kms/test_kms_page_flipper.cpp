@@ -17,6 +17,7 @@
  */
 
 #include "src/platforms/mesa/server/kms/kms_page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_kms.h"
 
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_display_report.h"
@@ -47,7 +48,7 @@ class KMSPageFlipperTest : public ::testing::Test
 public:
     KMSPageFlipperTest()
     : drm_fd{open(drm_device, 0, 0)},
-      page_flipper{drm_fd, mt::fake_shared(report)}
+      page_flipper{drm_fd, mt::fake_shared(report), nullptr}
     {
     }
 
@@ -69,6 +70,23 @@ ACTION_P(InvokePageFlipHandler, param)
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
+ACTION_P2(InvokePageFlipHandlerForCrtcs, param, crtc_ids)
+{
+    int const dont_care{0};
+    char dummy;
+
+    for (auto crtc_id : crtc_ids)
+        arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, crtc_id, *param);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
+ACTION(ConsumeEvent)
+{
+    char dummy;
+
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
 }
 
 TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
@@ -171,25 +189,130 @@ TEST_F(KMSPageFlipperTest, failure_in_wait_for_flip_throws)
     uint32_t const crtc_id{10};
     uint32_t const fb_id{101};
     uint32_t const connector_id{345};
-    void* user_data{nullptr};
 
     EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
         .Times(1)
-        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+        .WillOnce(Return(0));
 
-    EXPECT_CALL(mock_drm, drmHandleEvent(_, _))
-        .Times(0);
+    /* Cause a failure in handling the DRM event */
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .Times(1)
+        .WillOnce(DoAll(ConsumeEvent(), SetErrnoAndReturn(EIO, -1)));
 
     page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
 
-    /* Cause a failure in wait_for_flip */
-    close(drm_fd);
+    mock_drm.generate_event_on(drm_device);
 
     EXPECT_THROW({
         page_flipper.wait_for_flip(crtc_id);
     }, std::runtime_error);
 }
 
+TEST_F(KMSPageFlipperTest, interrupted_event_handling_is_retried)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+
+    /* The interrupted read leaves the event to be read again */
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(SetErrnoAndReturn(EINTR, -1))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+
+    mock_drm.generate_event_on(drm_device);
+
+    EXPECT_NO_THROW(page_flipper.wait_for_flip(crtc_id));
+}
+
+TEST_F(KMSPageFlipperTest, tells_flip_handlers_the_frame_their_flip_landed_on)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    unsigned int const seq{1234};
+    unsigned int const sec{56};
+    unsigned int const usec{789};
+    void* user_data{nullptr};
+    std::atomic<bool> handled{false};
+    mg::Frame flipped;
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(
+            Invoke([&](int fd, drmEventContextPtr context)
+                {
+                    char dummy;
+                    context->page_flip_handler(fd, seq, sec, usec, user_data);
+                    EXPECT_EQ(1, read(fd, &dummy, 1));
+                }),
+            Return(0)));
+
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    page_flipper.when_flipped(crtc_id, [&](mg::Frame const& frame) { flipped = frame; handled = true; });
+
+    EXPECT_FALSE(handled);
+
+    /* Nobody waits: the handler is called from the event thread */
+    mock_drm.generate_event_on(drm_device);
+
+    while (!handled)
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+    EXPECT_THAT(flipped.msc, Eq(seq));
+    EXPECT_THAT(flipped.ust.nanoseconds, Eq(std::chrono::seconds{sec} + std::chrono::microseconds{usec}));
+}
+
+TEST_F(KMSPageFlipperTest, flip_handler_is_called_at_once_without_a_pending_flip)
+{
+    uint32_t const crtc_id{10};
+    bool handled{false};
+
+    page_flipper.when_flipped(crtc_id, [&](mg::Frame const&) { handled = true; });
+
+    EXPECT_TRUE(handled);
+}
+
+TEST_F(KMSPageFlipperTest, atomic_flip_completes_with_an_event_per_crtc)
+{
+    using namespace testing;
+
+    std::vector<uint32_t> const crtc_ids{10, 11};
+    std::vector<uint32_t> const connector_ids{23, 45};
+    void* user_data{nullptr};
+
+    mgm::KMSPageFlipper atomic_flipper{
+        drm_fd, mt::fake_shared(report), std::make_shared<mgm::PropertyCache>(drm_fd)};
+
+    auto const update = atomic_flipper.begin_atomic_update();
+    ASSERT_THAT(update, NotNull());
+    for (auto i = 0u; i != crtc_ids.size(); ++i)
+        update->add_flip(crtc_ids[i], connector_ids[i]);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK, _))
+        .WillOnce(DoAll(SaveArg<3>(&user_data), Return(0)));
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandlerForCrtcs(&user_data, crtc_ids), Return(0)));
+
+    EXPECT_TRUE(atomic_flipper.schedule_flip(*update));
+
+    mock_drm.generate_event_on(drm_device);
+
+    for (auto crtc_id : crtc_ids)
+        atomic_flipper.wait_for_flip(crtc_id);
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_flips_interleaved)
 {
     using namespace testing;
@@ -274,97 +397,64 @@ private:
 
 }
 
-TEST_F(KMSPageFlipperTest, threads_switch_worker)
+TEST_F(KMSPageFlipperTest, flip_is_handled_without_waiting)
 {
     using namespace testing;
 
-    size_t const worker_index{0};
-    size_t const other_index{1};
-    std::vector<uint32_t> const crtc_ids{10, 11};
-    std::vector<void*> user_data{nullptr, nullptr};
-    std::vector<std::unique_ptr<PageFlippingFunctor>> page_flipping_functors;
-    std::vector<std::thread> page_flipping_threads;
-    std::thread::id tid;
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    std::atomic<bool> handled{false};
 
-    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, _, _, _))
-        .Times(2)
-        .WillOnce(DoAll(SaveArg<4>(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(SaveArg<4>(&user_data[other_index]), Return(0)));
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
 
-    /*
-     * The first event releases the original worker, hence we expect that
-     * then the other thread will become the worker.
-     */
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
-        .Times(2)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[worker_index]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]), Return(0)));
-
-    /* Start the page-flipping threads */
-    for (auto crtc_id : crtc_ids)
-    {
-        auto pf = std::unique_ptr<PageFlippingFunctor>(new PageFlippingFunctor{page_flipper, crtc_id});
-        page_flipping_functors.push_back(std::move(pf));
-        page_flipping_threads.push_back(std::thread{std::ref(*page_flipping_functors.back())});
-
-        /* Wait for page-flip request and tell flipper to stop after this iteration */
-        while (page_flipping_functors.back()->page_flip_count() == 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        page_flipping_functors.back()->stop();
-
-        /* Wait until the (first) thread has become the worker */
-        while (tid == std::thread::id())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-            tid = page_flipper.debug_get_worker_tid();
-        }
-    }
+        .Times(1)
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data),
+                        InvokeWithoutArgs([&] { handled = true; }),
+                        Return(0)));
 
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(), tid);
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
 
-    /* Fake a DRM event */
+    /* Fake a DRM event, which is handled even though no one is waiting */
     mock_drm.generate_event_on(drm_device);
 
-    page_flipping_threads[worker_index].join();
-
-    /* Wait for the worker to switch */
-    while (tid != page_flipping_threads[other_index].get_id())
-    {
+    while (!handled)
         std::this_thread::sleep_for(std::chrono::milliseconds{1});
-        tid = page_flipper.debug_get_worker_tid();
-    }
 
-    /* Fake another DRM event to unblock the remaining thread */
-    mock_drm.generate_event_on(drm_device);
-
-    page_flipping_threads[other_index].join();
+    page_flipper.wait_for_flip(crtc_id);
 }
 
-TEST_F(KMSPageFlipperTest, threads_worker_notifies_non_worker)
+TEST_F(KMSPageFlipperTest, events_are_handled_on_a_single_thread)
 {
     using namespace testing;
 
-    size_t const worker_index{0};
+    size_t const first_index{0};
     size_t const other_index{1};
     std::vector<uint32_t> const crtc_ids{10, 11};
     std::vector<void*> user_data{nullptr, nullptr};
     std::vector<std::unique_ptr<PageFlippingFunctor>> page_flipping_functors;
     std::vector<std::thread> page_flipping_threads;
-    std::thread::id tid;
+    std::vector<std::thread::id> handler_tids;
 
     EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, _, _, _))
         .Times(2)
-        .WillOnce(DoAll(SaveArg<4>(&user_data[worker_index]), Return(0)))
+        .WillOnce(DoAll(SaveArg<4>(&user_data[first_index]), Return(0)))
         .WillOnce(DoAll(SaveArg<4>(&user_data[other_index]), Return(0)));
 
-    /*
-     * The first event releases the non-worker thread, hence we expect that
-     * original worker not change.
-     */
+    auto const record_tid = [&] { handler_tids.push_back(std::this_thread::get_id()); };
+
     EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
         .Times(2)
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]), Return(0)))
-        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[worker_index]), Return(0)));
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[other_index]),
+                        InvokeWithoutArgs(record_tid),
+                        Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[first_index]),
+                        InvokeWithoutArgs(record_tid),
+                        Return(0)));
 
     /* Start the page-flipping threads */
     for (auto crtc_id : crtc_ids)
@@ -377,31 +467,23 @@ TEST_F(KMSPageFlipperTest, threads_worker_notifies_non_worker)
         while (page_flipping_functors.back()->page_flip_count() == 0)
             std::this_thread::sleep_for(std::chrono::milliseconds{1});
         page_flipping_functors.back()->stop();
-
-        /* Wait until the (first) thread has become the worker */
-        while (tid == std::thread::id())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds{1});
-            tid = page_flipper.debug_get_worker_tid();
-        }
     }
 
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(), tid);
-
-    /* Fake a DRM event */
+    /* Fake a DRM event, releasing the thread that flipped last */
     mock_drm.generate_event_on(drm_device);
 
-    /* Wait for the non-worker thread to exit */
     page_flipping_threads[other_index].join();
 
-    /* Check that the worker hasn't changed */
-    EXPECT_EQ(page_flipping_threads[worker_index].get_id(),
-              page_flipper.debug_get_worker_tid());
-
     /* Fake another DRM event to unblock the remaining thread */
     mock_drm.generate_event_on(drm_device);
 
-    page_flipping_threads[worker_index].join();
+    page_flipping_threads[first_index].join();
+
+    ASSERT_THAT(handler_tids.size(), Eq(2u));
+    EXPECT_THAT(handler_tids[0], Eq(handler_tids[1]));
+    for (auto const& pf_thread : page_flipping_threads)
+        EXPECT_THAT(handler_tids[0], Ne(pf_thread.get_id()));
+    EXPECT_THAT(handler_tids[0], Ne(std::this_thread::get_id()));
 }
 
 namespace
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/mesa/server/kms/overlay_planner.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <unordered_map>
+
+namespace mg = mir::graphics;
+namespace mgm = mir::graphics::mesa;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+
+namespace
+{
+uint32_t const xrgb{0x34325258};
+uint32_t const argb{0x34325241};
+
+uint32_t const overlay_plane_id{31};
+uint32_t const second_overlay_plane_id{32};
+uint32_t const cursor_plane_id{33};
+
+struct OverlayPlanner : Test
+{
+    std::shared_ptr<mtd::FakeRenderable> scanout_renderable(geom::Rectangle const& rect, bool opaque = true)
+    {
+        auto renderable = std::make_shared<mtd::FakeRenderable>(rect, 1.0f, opaque);
+        renderable->set_buffer(std::make_shared<mtd::StubBuffer>(rect.size));
+        scanout_formats[renderable.get()] = opaque ? xrgb : argb;
+        return renderable;
+    }
+
+    std::shared_ptr<mtd::FakeRenderable> gl_renderable(geom::Rectangle const& rect)
+    {
+        auto renderable = std::make_shared<mtd::FakeRenderable>(rect);
+        renderable->set_buffer(std::make_shared<mtd::StubBuffer>(rect.size));
+        return renderable;
+    }
+
+    mgm::OverlayPlanner::Plan plan(mg::RenderableList const& renderables)
+    {
+        return planner.plan(
+            area,
+            renderables,
+            [this](mg::Renderable const& renderable)
+            {
+                auto const format = scanout_formats.find(&renderable);
+                return format != scanout_formats.end() ? format->second : 0u;
+            });
+    }
+
+    geom::Rectangle const area{{0, 0}, {1920, 1080}};
+    geom::Rectangle const small_window{{100, 100}, {640, 480}};
+    geom::Rectangle const cursor{{700, 700}, {24, 24}};
+
+    std::vector<mgk::Plane> const planes{
+        {1, mgk::Plane::Type::primary, 0x1, {xrgb, argb}},
+        {overlay_plane_id, mgk::Plane::Type::overlay, 0x1, {xrgb, argb}},
+        {cursor_plane_id, mgk::Plane::Type::cursor, 0x1, {argb}}};
+    mgm::OverlayPlanner planner{planes};
+
+    std::unordered_map<mg::Renderable const*, uint32_t> scanout_formats;
+};
+
+MATCHER_P2(IsAssignment, plane_id, renderable, "")
+{
+    return arg.plane_id == plane_id && arg.renderable == renderable;
+}
+}
+
+TEST_F(OverlayPlanner, uses_only_overlay_planes)
+{
+    EXPECT_FALSE((mgm::OverlayPlanner{{planes[0], planes[2]}}.has_planes()));
+    EXPECT_TRUE(planner.has_planes());
+}
+
+TEST_F(OverlayPlanner, plans_nothing_for_nothing)
+{
+    auto const result = plan({});
+
+    EXPECT_THAT(result.primary, IsNull());
+    EXPECT_THAT(result.overlays, IsEmpty());
+    EXPECT_THAT(result.composited, IsEmpty());
+}
+
+TEST_F(OverlayPlanner, scans_out_a_fullscreen_renderable_on_the_primary_plane)
+{
+    auto const fullscreen = scanout_renderable(area);
+
+    auto const result = plan({fullscreen});
+
+    EXPECT_THAT(result.primary, Eq(fullscreen));
+    EXPECT_THAT(result.overlays, IsEmpty());
+    EXPECT_THAT(result.composited, IsEmpty());
+}
+
+TEST_F(OverlayPlanner, puts_a_window_above_a_fullscreen_renderable_on_an_overlay_plane)
+{
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+
+    auto const result = plan({fullscreen, window});
+
+    EXPECT_THAT(result.primary, Eq(fullscreen));
+    EXPECT_THAT(result.overlays, ElementsAre(IsAssignment(overlay_plane_id, window)));
+    EXPECT_THAT(result.composited, IsEmpty());
+}
+
+TEST_F(OverlayPlanner, never_uses_the_cursor_plane)
+{
+    // That's mesa::Cursor's, which may show the hardware cursor at any time
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+    auto const pointer = scanout_renderable(cursor, false);
+
+    auto const result = plan({fullscreen, window, pointer});
+
+    EXPECT_THAT(result.overlays, ElementsAre(IsAssignment(overlay_plane_id, pointer)));
+    EXPECT_THAT(result.composited, ElementsAre(fullscreen, window));
+}
+
+TEST_F(OverlayPlanner, composites_what_does_not_fit_on_planes)
+{
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+    auto const other_window = scanout_renderable({{1000, 100}, {640, 480}});
+
+    auto const result = plan({fullscreen, window, other_window});
+
+    EXPECT_THAT(result.overlays, ElementsAre(IsAssignment(overlay_plane_id, other_window)));
+    EXPECT_THAT(result.composited, ElementsAre(fullscreen, window));
+    EXPECT_THAT(result.primary, IsNull());
+}
+
+TEST_F(OverlayPlanner, uses_every_overlay_plane_available)
+{
+    mgm::OverlayPlanner const two_overlays{
+        {{overlay_plane_id, mgk::Plane::Type::overlay, 0x1, {xrgb}},
+         {second_overlay_plane_id, mgk::Plane::Type::overlay, 0x1, {xrgb}}}};
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+    auto const other_window = scanout_renderable({{1000, 100}, {640, 480}});
+
+    auto const result = two_overlays.plan(
+        area,
+        {fullscreen, window, other_window},
+        [](mg::Renderable const&) { return xrgb; });
+
+    EXPECT_THAT(result.primary, Eq(fullscreen));
+    EXPECT_THAT(result.overlays, ElementsAre(
+        IsAssignment(second_overlay_plane_id, window),
+        IsAssignment(overlay_plane_id, other_window)));
+}
+
+TEST_F(OverlayPlanner, does_not_put_a_renderable_under_composited_content_on_a_plane)
+{
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+    auto const dialog = gl_renderable({{200, 200}, {100, 100}});
+
+    auto const result = plan({fullscreen, window, dialog});
+
+    EXPECT_THAT(result.overlays, IsEmpty());
+    EXPECT_THAT(result.composited, ElementsAre(fullscreen, window, dialog));
+    EXPECT_THAT(result.primary, IsNull());
+}
+
+TEST_F(OverlayPlanner, does_not_let_plane_renderables_overlap)
+{
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+    auto const overlapping = scanout_renderable({{200, 200}, {640, 480}});
+
+    auto const result = plan({fullscreen, window, overlapping});
+
+    EXPECT_THAT(result.overlays, ElementsAre(IsAssignment(overlay_plane_id, overlapping)));
+    EXPECT_THAT(result.composited, ElementsAre(fullscreen, window));
+}
+
+TEST_F(OverlayPlanner, composites_translucent_scaled_and_partly_offscreen_renderables)
+{
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(small_window, 0.5f);
+    translucent->set_buffer(std::make_shared<mtd::StubBuffer>(small_window.size));
+    scanout_formats[translucent.get()] = xrgb;
+
+    auto const scaled = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{1000, 100}, {640, 480}});
+    scaled->set_buffer(std::make_shared<mtd::StubBuffer>(geom::Size{320, 240}));
+    scanout_formats[scaled.get()] = xrgb;
+
+    auto const straddling = scanout_renderable({{1800, 900}, {640, 480}});
+
+    auto const result = plan({translucent, scaled, straddling});
+
+    EXPECT_THAT(result.overlays, IsEmpty());
+    EXPECT_THAT(result.composited, ElementsAre(translucent, scaled, straddling));
+}
+
+TEST_F(OverlayPlanner, only_uses_planes_supporting_the_buffer_format)
+{
+    auto const fullscreen = scanout_renderable(area);
+    auto const window = scanout_renderable(small_window);
+    scanout_formats[window.get()] = 0x3231564e; // NV12
+
+    auto const result = plan({fullscreen, window});
+
+    EXPECT_THAT(result.overlays, IsEmpty());
+    EXPECT_THAT(result.composited, ElementsAre(fullscreen, window));
+}
+
+TEST_F(OverlayPlanner, ignores_offscreen_and_hidden_renderables)
+{
+    auto const hidden = gl_renderable(small_window);
+    auto const fullscreen = scanout_renderable(area);
+    auto const offscreen = gl_renderable({{1920, 0}, {640, 480}});
+
+    auto const result = plan({hidden, fullscreen, offscreen});
+
+    EXPECT_THAT(result.primary, Eq(fullscreen));
+    EXPECT_THAT(result.overlays, IsEmpty());
+    EXPECT_THAT(result.composited, IsEmpty());
+}
@@ -18,6 +18,7 @@
 
 #include "src/platforms/mesa/server/kms/real_kms_output.h"
 #include "src/platforms/mesa/server/kms/page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_kms.h"
 #include "mir/fatal.h"
 
 #include "mir/test/fake_shared.h"
@@ -47,6 +48,9 @@ class NullPageFlipper : public mgm::PageFlipper
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
+    void when_flipped(uint32_t, std::function<void(mg::Frame const&)> const& flipped) override { flipped({}); }
+    std::unique_ptr<mgm::AtomicUpdate> begin_atomic_update() override { return nullptr; }
+    bool schedule_flip(mgm::AtomicUpdate const&) override { return true; }
 };
 
 class MockPageFlipper : public mgm::PageFlipper
@@ -54,6 +58,13 @@ class MockPageFlipper : public mgm::PageFlipper
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
+    MOCK_METHOD2(when_flipped, void(uint32_t, std::function<void(mg::Frame const&)> const&));
+    std::unique_ptr<mgm::AtomicUpdate> begin_atomic_update() override
+    {
+        return std::unique_ptr<mgm::AtomicUpdate>{begin_atomic_update_thunk()};
+    }
+    MOCK_METHOD0(begin_atomic_update_thunk, mgm::AtomicUpdate*());
+    MOCK_METHOD1(schedule_flip, bool(mgm::AtomicUpdate const&));
 };
 
 class RealKMSOutputTest : public ::testing::Test
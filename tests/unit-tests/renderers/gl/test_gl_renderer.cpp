@@ -24,6 +24,7 @@
 #include <mir/test/fake_shared.h>
 #include <mir/test/doubles/mock_gl_buffer.h>
 #include <mir/test/doubles/mock_renderable.h>
+#include <mir/test/doubles/fake_renderable.h>
 #include <mir/test/doubles/mock_buffer_stream.h>
 #include <mir/compositor/buffer_stream.h>
 #include <mir/test/doubles/mock_gl.h>
@@ -40,6 +41,8 @@ using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
 using testing::DoAll;
+using testing::Eq;
+using testing::StrEq;
 using testing::_;
 
 namespace mt=mir::test;
@@ -466,3 +469,326 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
 
     mrg::Renderer renderer(mock_display_buffer);
 }
+
+namespace
+{
+struct GLRendererDamage : GLRenderer
+{
+    GLRendererDamage()
+    {
+        ON_CALL(mock_display_buffer, view_area())
+            .WillByDefault(Return(view_area));
+        ON_CALL(mock_display_buffer, buffer_age())
+            .WillByDefault(Return(1));
+        ON_CALL(mock_gl, glGetIntegerv(GL_VIEWPORT, _))
+            .WillByDefault(testing::SetArrayArgument<1>(gl_viewport, gl_viewport + 4));
+        EXPECT_CALL(*renderable, screen_position())
+            .WillRepeatedly(testing::ReturnPointee(&position));
+    }
+
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    GLint const gl_viewport[4] = {0, 0, 1920, 1080};
+    // Same size as mock_buffer, so unscaled
+    mir::geometry::Rectangle position{{100,200}, {123,456}};
+};
+}
+
+TEST_F(GLRendererDamage, repaints_everything_when_buffer_age_is_unknown)
+{
+    ON_CALL(mock_display_buffer, buffer_age())
+        .WillByDefault(Return(0));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_));
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.repainted_fraction(), testing::FloatEq(1.0f));
+}
+
+TEST_F(GLRendererDamage, repaints_everything_on_first_frame)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererDamage, scissors_to_damaged_part_of_renderable)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(*renderable, damage())
+        .WillRepeatedly(Return(mir::geometry::Rectangles{{{10,20}, {30,40}}}));
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    // GL window coordinates have the origin at the bottom left
+    EXPECT_CALL(mock_gl, glScissor(110, 1080 - 260, 30, 40));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDrawArrays(_,_,_));
+    EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.repainted_fraction(), testing::FloatEq(30.0f * 40 / (1920 * 1080)));
+}
+
+TEST_F(GLRendererDamage, unchanged_scene_repaints_nothing)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glClear(_)).Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(_,_,_)).Times(0);
+    EXPECT_CALL(mock_display_buffer, swap_buffers());
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.repainted_fraction(), testing::FloatEq(0.0f));
+}
+
+TEST_F(GLRendererDamage, moving_a_renderable_damages_old_and_new_positions)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    position.top_left = {500, 600};
+
+    EXPECT_CALL(mock_gl, glScissor(100, 1080 - 656, 123, 456));
+    EXPECT_CALL(mock_gl, glScissor(500, 1080 - 1056, 123, 456));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererDamage, removing_a_renderable_damages_where_it_was)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glScissor(100, 1080 - 656, 123, 456));
+    EXPECT_CALL(mock_gl, glDrawArrays(_,_,_)).Times(0);
+    renderer.render({});
+}
+
+TEST_F(GLRendererDamage, repaints_damage_of_every_frame_since_buffer_was_drawn)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(*renderable, damage())
+        .WillOnce(Return(mir::geometry::Rectangles{{{0,0}, {10,10}}}))
+        .WillOnce(Return(mir::geometry::Rectangles{{{20,20}, {10,10}}}));
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_display_buffer, buffer_age())
+        .WillRepeatedly(Return(2));
+
+    EXPECT_CALL(mock_gl, glScissor(100, 1080 - 210, 10, 10));
+    EXPECT_CALL(mock_gl, glScissor(120, 1080 - 230, 10, 10));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererDamage, repaints_everything_when_buffer_is_older_than_history)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_display_buffer, buffer_age())
+        .WillRepeatedly(Return(3));
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererDamage, repaints_everything_after_being_suspended)
+{
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+
+    renderer.suspend();
+
+    EXPECT_CALL(mock_gl, glScissor(_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, counts_draw_calls)
+{
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.draw_calls(), Eq(1u));
+}
+
+namespace
+{
+struct GLRendererBatching : GLRenderer
+{
+    GLRendererBatching()
+    {
+        ON_CALL(mock_display_buffer, view_area())
+            .WillByDefault(Return(view_area));
+    }
+
+    std::shared_ptr<mtd::FakeRenderable> renderable_at(
+        mir::geometry::Rectangle const& position, float alpha = 1.0f, bool shaped = false)
+    {
+        auto const result = std::make_shared<mtd::FakeRenderable>(position, alpha, !shaped);
+        result->set_buffer(mock_buffer);
+        return result;
+    }
+
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+};
+}
+
+TEST_F(GLRendererBatching, draws_neighbouring_renderables_in_one_call)
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 18));
+    renderer.render({
+        renderable_at({{0,0}, {100,100}}),
+        renderable_at({{200,0}, {100,100}}),
+        renderable_at({{400,0}, {100,100}})});
+
+    EXPECT_THAT(renderer.draw_calls(), Eq(1u));
+}
+
+TEST_F(GLRendererBatching, keeps_overlapping_renderables_in_stacking_order)
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 6));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 6, 6));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 12, 6));
+    renderer.render({
+        renderable_at({{0,0}, {100,100}}),
+        renderable_at({{50,50}, {100,100}}, 1.0f, true),
+        renderable_at({{100,100}, {100,100}})});
+
+    EXPECT_THAT(renderer.draw_calls(), Eq(3u));
+}
+
+TEST_F(GLRendererBatching, draws_renderables_out_of_order_when_nothing_overlaps)
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 12));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 12, 6));
+    renderer.render({
+        renderable_at({{0,0}, {100,100}}),
+        renderable_at({{500,0}, {100,100}}, 1.0f, true),
+        renderable_at({{1000,0}, {100,100}})});
+
+    EXPECT_THAT(renderer.draw_calls(), Eq(2u));
+}
+
+TEST_F(GLRendererBatching, starts_a_new_call_when_texture_units_run_out)
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    mg::RenderableList renderables;
+    for (int i = 0; i != 10; ++i)
+        renderables.push_back(renderable_at({{i * 150, 0}, {100,100}}));
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 48));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 48, 12));
+    renderer.render(renderables);
+
+    EXPECT_THAT(renderer.draw_calls(), Eq(2u));
+}
+
+TEST_F(GLRendererBatching, does_not_share_calls_between_large_renderables_and_other_textures)
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 6));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 6, 12));
+    renderer.render({
+        renderable_at(view_area),
+        renderable_at({{0,0}, {100,100}}),
+        renderable_at({{200,0}, {100,100}})});
+
+    EXPECT_THAT(renderer.draw_calls(), Eq(2u));
+}
+
+TEST_F(GLRendererBatching, uploads_one_vertex_buffer_per_frame)
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, _, _, GL_STREAM_DRAW));
+    renderer.render({
+        renderable_at({{0,0}, {100,100}}),
+        renderable_at({{50,50}, {100,100}}, 1.0f, true),
+        renderable_at({{100,100}, {100,100}})});
+}
+
+TEST_F(GLRendererBatching, avoids_src_alpha_for_rgbx_blending)  // LP: #1423462
+{
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE));
+    renderer.render({renderable_at({{0,0}, {100,100}}, 0.5f)});
+}
+
+TEST_F(GLRendererBatching, reuses_the_tessellation_of_unchanged_renderables)
+{
+    struct CountingRenderer : mrg::Renderer
+    {
+        CountingRenderer(mg::DisplayBuffer& display_buffer)
+            : Renderer(display_buffer, true)
+        {
+        }
+
+        void tessellate(std::vector<mgl::Primitive>& primitives,
+                        mg::Renderable const& renderable) const override
+        {
+            ++tessellations;
+            Renderer::tessellate(primitives, renderable);
+        }
+
+        mutable int tessellations = 0;
+    };
+
+    mir::geometry::Rectangle position{{100,200}, {123,456}};
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(testing::ReturnPointee(&position));
+
+    CountingRenderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.tessellations, Eq(1));
+
+    position.top_left = {300, 200};
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.tessellations, Eq(2));
+}
+
+TEST_F(GLRendererBatching, leaves_out_the_properties_attribute_when_the_shader_ignores_it)
+{
+    // The linker drops it from shaders that never read v_properties
+    ON_CALL(mock_gl, glGetAttribLocation(_, StrEq("properties")))
+        .WillByDefault(Return(-1));
+
+    mrg::Renderer renderer(mock_display_buffer, true);
+
+    EXPECT_CALL(mock_gl, glEnableVertexAttribArray(GLuint(-1)))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glVertexAttribPointer(GLuint(-1), _, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glDisableVertexAttribArray(GLuint(-1)))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 6));
+    renderer.render({renderable_at({{0,0}, {100,100}})});
+}
@@ -446,6 +446,15 @@ TEST_F(BasicSurfaceTest, disables_input_when_setting_input_region_with_empty_rec
     EXPECT_FALSE(surface.input_area_contains(rect.top_left));
 }
 
+TEST_F(BasicSurfaceTest, input_region_is_clipped_to_the_surface)
+{
+    surface.set_input_region({{{-10, -10}, {100, 100}}});
+
+    EXPECT_TRUE(surface.input_area_contains(rect.top_left));
+    EXPECT_FALSE(surface.input_area_contains(rect.top_left - geom::Displacement{1, 1}));
+    EXPECT_FALSE(surface.input_area_contains(rect.bottom_right()));
+}
+
 TEST_F(BasicSurfaceTest, reception_mode_is_normal_by_default)
 {
     EXPECT_EQ(mi::InputReceptionMode::normal, surface.reception_mode());
@@ -1093,3 +1102,37 @@ TEST_F(BasicSurfaceTest, notifies_when_first_visible)
     EXPECT_THAT(observer->exposes(), Eq(1));
     EXPECT_THAT(observer->hides(), Eq(0));
 }
+
+TEST_F(BasicSurfaceTest, renderable_opaque_region_is_the_buffers_in_screen_coordinates)
+{
+    using namespace testing;
+    geom::Displacement const d{1, 2};
+    ON_CALL(*mock_buffer_stream, lock_compositor_buffer(_))
+        .WillByDefault(Return(std::make_shared<mtd::StubBuffer>(geom::Size{3, 4})));
+    ON_CALL(*mock_buffer_stream, opaque_region_for_compositor(_))
+        .WillByDefault(Return(geom::Region{geom::Rectangle{{1, 1}, {10, 3}}}));
+
+    surface.set_streams({{ mock_buffer_stream, d, geom::Size{3, 4} }});
+
+    auto const renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(),
+        Eq(geom::Region{geom::Rectangle{rect.top_left + d + geom::Displacement{1, 1}, {2, 3}}}));
+}
+
+TEST_F(BasicSurfaceTest, renderable_opaque_region_is_scaled_with_the_buffer)
+{
+    using namespace testing;
+    ON_CALL(*mock_buffer_stream, lock_compositor_buffer(_))
+        .WillByDefault(Return(std::make_shared<mtd::StubBuffer>(geom::Size{6, 8})));
+    // Rounded inwards, as the half pixels at the edges aren't wholly opaque
+    ON_CALL(*mock_buffer_stream, opaque_region_for_compositor(_))
+        .WillByDefault(Return(geom::Region{geom::Rectangle{{1, 2}, {4, 5}}}));
+
+    surface.set_streams({{ mock_buffer_stream, {}, geom::Size{3, 4} }});
+
+    auto const renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(),
+        Eq(geom::Region{geom::Rectangle{rect.top_left + geom::Displacement{1, 1}, {1, 2}}}));
+}
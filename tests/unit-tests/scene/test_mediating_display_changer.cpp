@@ -36,6 +36,7 @@
 #include "mir/test/doubles/fake_alarm_factory.h"
 
 #include <mutex>
+#include <thread>
 #include <boost/throw_exception.hpp>
 
 #include <gmock/gmock.h>
@@ -126,6 +127,7 @@ struct StubDisplayConfigurationObserver : mg::DisplayConfigurationObserver
 {
     void initial_configuration(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
     void configuration_applied(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
+    void configuration_timings(mg::DisplayConfigurationTimings const&) override {}
     void base_configuration_updated(std::shared_ptr<mg::DisplayConfiguration const> const&) override {}
     void session_configuration_applied(
         std::shared_ptr<mf::Session> const&,
@@ -218,6 +220,45 @@ TEST_F(MediatingDisplayChangerTest, does_not_pause_system_when_applying_new_conf
                        mt::fake_shared(conf));
 }
 
+TEST_F(MediatingDisplayChangerTest, notifies_observer_of_timings_of_each_step)
+{
+    using namespace testing;
+
+    struct MockDisplayConfigurationObserver : StubDisplayConfigurationObserver
+    {
+        MOCK_METHOD1(configuration_timings, void (mg::DisplayConfigurationTimings const& timings));
+    } display_configuration_observer;
+
+    changer = std::make_shared<ms::MediatingDisplayChanger>(
+        mt::fake_shared(mock_display),
+        mt::fake_shared(mock_compositor),
+        mt::fake_shared(mock_conf_policy),
+        mt::fake_shared(stub_session_container),
+        mt::fake_shared(session_event_sink),
+        mt::fake_shared(server_action_queue),
+        mt::fake_shared(display_configuration_observer),
+        mt::fake_shared(alarm_factory));
+
+    std::chrono::milliseconds const configure_time{10};
+    mtd::NullDisplayConfiguration conf;
+    auto session = std::make_shared<mtd::StubSession>();
+
+    ON_CALL(mock_display, apply_if_configuration_preserves_display_buffers(_))
+        .WillByDefault(Return(false));
+    ON_CALL(mock_display, configure(Ref(conf)))
+        .WillByDefault(InvokeWithoutArgs([&] { std::this_thread::sleep_for(configure_time); }));
+
+    mg::DisplayConfigurationTimings timings;
+    EXPECT_CALL(display_configuration_observer, configuration_timings(_))
+        .WillOnce(SaveArg<0>(&timings));
+
+    session_event_sink.handle_focus_change(session);
+    changer->configure(session, mt::fake_shared(conf));
+
+    EXPECT_TRUE(timings.compositor_stopped);
+    EXPECT_THAT(timings.configuring_display, Ge(configure_time));
+}
+
 TEST_F(MediatingDisplayChangerTest, sends_error_when_applying_new_configuration_for_focused_session_fails)
 {
     using namespace testing;
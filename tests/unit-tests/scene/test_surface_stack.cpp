@@ -30,6 +30,9 @@
 #include "mir/test/doubles/stub_buffer_stream_factory.h"
 #include "mir/test/doubles/stub_renderable.h"
 #include "mir/test/doubles/mock_buffer_stream.h"
+#include "mir/test/doubles/stub_display_configuration.h"
+#include "mir/graphics/display_configuration_observer.h"
+#include "mir/observer_registrar.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -84,6 +87,31 @@ struct MockSceneObserver : public ms::Observer
     MOCK_METHOD0(end_observation, void());
 };
 
+// Reports outputs covering the given rectangles, as soon as an observer registers
+struct StubDisplayConfigurationRegistrar : mir::ObserverRegistrar<mg::DisplayConfigurationObserver>
+{
+    StubDisplayConfigurationRegistrar(std::vector<geom::Rectangle> const& outputs)
+        : config{std::make_shared<mtd::StubDisplayConfig>(outputs)}
+    {
+    }
+
+    void register_interest(std::weak_ptr<mg::DisplayConfigurationObserver> const& observer) override
+    {
+        observer.lock()->initial_configuration(config);
+    }
+
+    void register_interest(std::weak_ptr<mg::DisplayConfigurationObserver> const& observer, mir::Executor&) override
+    {
+        register_interest(observer);
+    }
+
+    void unregister_interest(mg::DisplayConfigurationObserver const&) override
+    {
+    }
+
+    std::shared_ptr<mtd::StubDisplayConfig> const config;
+};
+
 struct SurfaceStack : public ::testing::Test
 {
     void SetUp()
@@ -986,6 +1014,106 @@ TEST_F(SurfaceStack, returns_top_visible_surface_under_cursor)
     EXPECT_THAT(stack.surface_at(cursor_over_none).get(), IsNull());
 }
 
+TEST_F(SurfaceStack, surface_under_cursor_follows_moves_and_resizes)
+{
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    stub_surface2->move_to({1000, 1000});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1050, 1050}), Eq(stub_surface2));
+
+    stub_surface2->move_to({-600, -600});
+
+    EXPECT_THAT(stack.surface_at({1050, 1050}).get(), IsNull());
+    EXPECT_THAT(stack.surface_at({-550, -550}), Eq(stub_surface2));
+
+    stub_surface2->resize({700, 700});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+
+    stub_surface2->resize({10, 10});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_under_cursor_follows_stacking_order)
+{
+    geom::Point const cursor{100, 100};
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+    stack.add_surface(stub_surface3, default_params.input_mode);
+
+    stub_surface1->resize({900, 900});
+    stub_surface2->resize({900, 900});
+    stub_surface3->resize({900, 900});
+
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface3));
+
+    stack.raise(stub_surface1);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+
+    stack.raise({stub_surface2, stub_surface3});
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface3));
+
+    stack.remove_surface(stub_surface3);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface2));
+
+    stub_surface2->set_hidden(true);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_under_cursor_respects_input_region)
+{
+    geom::Point const cursor{100, 100};
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->resize({900, 900});
+    stub_surface2->resize({900, 900});
+    stub_surface2->set_input_region({{{0, 0}, {50, 50}}});
+
+    EXPECT_THAT(stack.surface_at({10, 10}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_under_cursor_is_found_anywhere_on_a_surface_much_larger_than_the_outputs)
+{
+    StubDisplayConfigurationRegistrar registrar{{{{0, 0}, {1000, 1000}}, {{1000, 0}, {1000, 1000}}}};
+    ms::SurfaceStack bounded_stack{report, mt::fake_shared(registrar)};
+
+    bounded_stack.add_surface(stub_surface1, default_params.input_mode);
+    bounded_stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->move_to({-1000000, -1000000});
+    stub_surface1->resize({2000000, 2000000});
+    stub_surface2->move_to({1500, 500});
+    stub_surface2->resize({1000, 1000});
+
+    EXPECT_THAT(bounded_stack.surface_at({500, 500}), Eq(stub_surface1));
+    EXPECT_THAT(bounded_stack.surface_at({1600, 600}), Eq(stub_surface2));
+    // Off the outputs, where the stack keeps no index
+    EXPECT_THAT(bounded_stack.surface_at({2400, 1400}), Eq(stub_surface2));
+    EXPECT_THAT(bounded_stack.surface_at({-5000, 5000}), Eq(stub_surface1));
+    EXPECT_THAT(bounded_stack.surface_at({1000000, 0}).get(), IsNull());
+}
+
+TEST_F(SurfaceStack, input_surface_at_is_surface_at)
+{
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stub_surface1->resize({100, 100});
+
+    mi::Scene& input_scene = stack;
+
+    EXPECT_THAT(input_scene.input_surface_at({50, 50}), Eq(stub_surface1));
+    EXPECT_THAT(input_scene.input_surface_at({150, 50}).get(), IsNull());
+}
+
 TEST_F(SurfaceStack, raise_surfaces_to_top)
 {
     stack.add_surface(stub_surface1, default_params.input_mode);
@@ -1027,3 +1155,123 @@ TEST_F(SurfaceStack, raise_surfaces_to_top)
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream3)));
 }
+
+TEST_F(SurfaceStack, reuses_the_scene_elements_of_a_registered_compositor_while_nothing_changes)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    std::vector<mc::SceneElement*> first_frame;
+    for (auto const& element : stack.scene_elements_for(compositor_id))
+        first_frame.push_back(element.get());
+
+    std::vector<mc::SceneElement*> second_frame;
+    for (auto const& element : stack.scene_elements_for(compositor_id))
+        second_frame.push_back(element.get());
+
+    EXPECT_THAT(first_frame.size(), Eq(2u));
+    EXPECT_THAT(second_frame, Eq(first_frame));
+}
+
+TEST_F(SurfaceStack, takes_a_new_snapshot_when_a_surface_or_the_stack_changes)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+
+    auto const top_left_in_next_frame = [this]
+        {
+            auto const elements = stack.scene_elements_for(compositor_id);
+            return elements.back()->renderable()->screen_position().top_left;
+        };
+
+    top_left_in_next_frame();
+    stub_surface1->move_to({10, 20});
+    EXPECT_THAT(top_left_in_next_frame(), Eq(geom::Point{10, 20}));
+
+    stub_surface1->set_alpha(0.5f);
+    EXPECT_THAT(stack.scene_elements_for(compositor_id).back()->renderable()->alpha(), Eq(0.5f));
+
+    stub_surface2->move_to({30, 40});
+    stack.add_surface(stub_surface2, default_params.input_mode);
+    EXPECT_THAT(top_left_in_next_frame(), Eq(geom::Point{30, 40}));
+
+    stub_surface2->set_hidden(true);
+    EXPECT_THAT(top_left_in_next_frame(), Eq(geom::Point{10, 20}));
+}
+
+TEST_F(SurfaceStack, takes_a_new_snapshot_when_a_stream_first_posts_a_frame)
+{
+    using namespace testing;
+
+    auto const stream = std::make_shared<mc::Stream>(geom::Size{1, 1}, mir_pixel_format_abgr_8888);
+    stub_surface1->set_streams({{stub_buffer_stream1, {0, 0}, {}}, {stream, {0, 0}, {}}});
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+
+    EXPECT_THAT(stack.scene_elements_for(compositor_id), ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+
+    post_a_frame(*stream);
+
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id),
+        ElementsAre(SceneElementForStream(stub_buffer_stream1), SceneElementForStream(stream)));
+}
+
+TEST_F(SurfaceStack, gives_buffers_back_when_each_frame_is_dropped)
+{
+    using namespace testing;
+
+    auto const buffer = std::make_shared<mtd::StubBuffer>();
+    auto const mock_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    EXPECT_CALL(*mock_stream, lock_compositor_buffer(compositor_id))
+        .Times(2)
+        .WillRepeatedly(Return(buffer));
+
+    auto const surface = std::make_shared<ms::BasicSurface>(
+        std::string("stub"),
+        geom::Rectangle{geom::Point{3, 4},geom::Size{1, 2}},
+        mir_pointer_unconfined,
+        std::list<ms::StreamInfo> { { mock_stream, {}, {} } },
+        std::shared_ptr<mg::CursorImage>(),
+        report);
+    stack.register_compositor(compositor_id);
+    stack.add_surface(surface, default_params.input_mode);
+
+    auto const use_count_without_frames = buffer.use_count();
+
+    for (int frame = 0; frame != 2; ++frame)
+    {
+        mg::RenderableList renderables;
+        {
+            auto const elements = stack.scene_elements_for(compositor_id);
+            ASSERT_THAT(elements.size(), Eq(1u));
+            renderables.push_back(elements.front()->renderable());
+        }
+        renderables.front()->buffer();
+        EXPECT_THAT(buffer.use_count(), Gt(use_count_without_frames));
+
+        renderables.clear();
+        EXPECT_THAT(buffer.use_count(), Eq(use_count_without_frames));
+    }
+}
+
+TEST_F(SurfaceStack, takes_a_new_snapshot_while_the_last_frame_is_still_in_use)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+
+    auto const first_frame = stack.scene_elements_for(compositor_id);
+    auto const second_frame = stack.scene_elements_for(compositor_id);
+
+    ASSERT_THAT(first_frame.size(), Eq(1u));
+    ASSERT_THAT(second_frame.size(), Eq(1u));
+    EXPECT_THAT(second_frame.front().get(), Ne(first_frame.front().get()));
+}